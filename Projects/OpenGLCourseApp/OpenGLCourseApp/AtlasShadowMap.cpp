@@ -0,0 +1,87 @@
+#include "AtlasShadowMap.h"
+
+AtlasShadowMap::AtlasShadowMap(ShadowAtlas* atlas) : ShadowMap()
+{
+	this->atlas = atlas;
+
+	tileX = 0;
+	tileY = 0;
+	tileSize = 0;
+	importance = 1.0f;
+
+	filterMode = SHADOW_FILTER_PCF; // The atlas only holds depth. Variance shadow maps need their own moments texture.
+}
+
+bool AtlasShadowMap::Init(unsigned int width, unsigned int height)
+{
+	shadowWidth = width;
+	shadowHeight = height;
+
+	atlas->AddShadowMap(this);
+
+	return true;
+}
+
+void AtlasShadowMap::Write()
+{
+	atlas->Write();
+
+	glViewport(tileX, tileY, tileSize, tileSize);
+
+	// Clearing the depth only clears our tile, not the other lights' tiles.
+	glScissor(tileX, tileY, tileSize, tileSize);
+	glEnable(GL_SCISSOR_TEST);
+}
+
+void AtlasShadowMap::Read(GLenum textureUnit)
+{
+	atlas->Read(textureUnit);
+}
+
+GLuint AtlasShadowMap::GetShadowWidth()
+{
+	return tileSize;
+}
+
+GLuint AtlasShadowMap::GetShadowHeight()
+{
+	return tileSize;
+}
+
+glm::vec4 AtlasShadowMap::GetTileRect()
+{
+	GLfloat atlasSize = (GLfloat)atlas->GetAtlasSize();
+	return glm::vec4(tileX / atlasSize, tileY / atlasSize, tileSize / atlasSize, tileSize / atlasSize);
+}
+
+size_t AtlasShadowMap::GetMemoryUsage()
+{
+	return 0;
+}
+
+void AtlasShadowMap::SetImportance(GLfloat importance)
+{
+	this->importance = importance;
+}
+
+GLfloat AtlasShadowMap::GetImportance()
+{
+	return importance;
+}
+
+GLuint AtlasShadowMap::GetMaximumSize()
+{
+	return shadowWidth > shadowHeight ? shadowWidth : shadowHeight;
+}
+
+void AtlasShadowMap::SetTile(GLuint x, GLuint y, GLuint size)
+{
+	tileX = x;
+	tileY = y;
+	tileSize = size;
+}
+
+AtlasShadowMap::~AtlasShadowMap()
+{
+	atlas->RemoveShadowMap(this);
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "ShadowMap.h"
+#include "ShadowAtlas.h"
+
+// A 2D shadow map living in a tile of a ShadowAtlas, instead of in its own texture and frame buffer.
+// The tile can change size and place every frame, see ShadowAtlas::Pack.
+class AtlasShadowMap : public ShadowMap
+{
+	public:
+		AtlasShadowMap(ShadowAtlas* atlas);
+
+		// No texture is made here, the size is only the biggest tile this map may get.
+		bool Init(unsigned int width, unsigned int height);
+
+		// Binds the atlas, and limits the viewport and the scissor to our tile.
+		void Write();
+
+		void Read(GLenum textureUnit);
+
+		GLuint GetShadowWidth();
+		GLuint GetShadowHeight();
+
+		glm::vec4 GetTileRect();
+
+		size_t GetMemoryUsage(); // 0, the texture belongs to the atlas.
+
+		void SetImportance(GLfloat importance);
+		GLfloat GetImportance();
+		GLuint GetMaximumSize();
+
+		void SetTile(GLuint x, GLuint y, GLuint size);
+
+		~AtlasShadowMap();
+
+	private:
+		ShadowAtlas* atlas;
+
+		GLuint tileX, tileY, tileSize; // In texels. Size 0 when the map got no tile this frame.
+		GLfloat importance; // Between 0 and 1. How much of the screen the light's shadow covers.
+};
@@ -0,0 +1,780 @@
+#include "Benchmarks.h"
+
+#include "ClusterGrid.h"
+#include "LightManager.h"
+#include "ThreadPool.h"
+#include "MeshFile.h"
+#include "MeshProcessing.h"
+#include "MeshOptimizer.h"
+#include "Mesh.h"
+#include "IndexCodec.h"
+#include "MeshSimplifier.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+bool Benchmarks::Run(int argc, char** argv)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--benchmark-clusters") == 0)
+		{
+			ClusterAssignment();
+			return true;
+		}
+		if (strcmp(argv[i], "--benchmark-lights") == 0)
+		{
+			LightUpdate();
+			return true;
+		}
+		if (strcmp(argv[i], "--benchmark-meshes") == 0)
+		{
+			MeshLoading();
+			return true;
+		}
+		if (strcmp(argv[i], "--benchmark-normals") == 0)
+		{
+			NormalGeneration();
+			return true;
+		}
+		if (strcmp(argv[i], "--benchmark-mesh-optimizer") == 0)
+		{
+			MeshOptimization();
+			return true;
+		}
+		if (strcmp(argv[i], "--benchmark-vertex-formats") == 0)
+		{
+			VertexPacking();
+			return true;
+		}
+		if (strcmp(argv[i], "--benchmark-indices") == 0)
+		{
+			IndexCompression();
+			return true;
+		}
+		if (strcmp(argv[i], "--benchmark-lods") == 0)
+		{
+			LevelOfDetail();
+			return true;
+		}
+	}
+	return false;
+}
+
+double Benchmarks::MillisecondsSince(std::chrono::high_resolution_clock::time_point start)
+{
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+	return elapsed.count();
+}
+
+void Benchmarks::ClusterAssignment()
+{
+	const GLfloat fieldOfView = 45.0f * 3.14159265f / 180.0f;
+	const GLfloat aspect = 1366.0f / 768.0f;
+	const GLfloat nearPlane = 0.1f, farPlane = 100.0f;
+	const int repeats = 10;
+
+	ThreadPool threadPool;
+	threadPool.Init();
+
+	ClusterGrid clusterGrid;
+	clusterGrid.BuildClusters(fieldOfView, aspect, nearPlane, farPlane, 1366, 768);
+
+	printf("Light to cluster assignment, %dx%dx%d clusters, %u threads.\n", CLUSTER_GRID_X, CLUSTER_GRID_Y, CLUSTER_GRID_Z, threadPool.GetThreadCount());
+	printf("%8s %12s %12s %9s %12s %6s\n", "Lights", "Scalar ms", "SIMD+MT ms", "Speedup", "Indices", "Same");
+
+	for (unsigned int count = 1024; count <= 65536; count *= 2)
+	{
+		// Random lights in front of the camera, in view space. Radii from our attenuation values, between 0.5 and 3 units.
+		srand(count);
+		std::vector<GLfloat> x(count), y(count), z(count), radius(count);
+		GLfloat tanHalfFov = tanf(fieldOfView * 0.5f);
+		for (unsigned int i = 0; i < count; i++)
+		{
+			GLfloat distance = nearPlane + (farPlane - nearPlane) * rand() / RAND_MAX;
+			x[i] = distance * tanHalfFov * aspect * (2.0f * rand() / RAND_MAX - 1.0f);
+			y[i] = distance * tanHalfFov * (2.0f * rand() / RAND_MAX - 1.0f);
+			z[i] = -distance;
+			radius[i] = 0.5f + 2.5f * rand() / RAND_MAX;
+		}
+
+		clusterGrid.SetThreadPool(nullptr);
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		clusterGrid.AssignLightsReference(x.data(), y.data(), z.data(), radius.data(), count);
+		double scalarTime = MillisecondsSince(start);
+		std::vector<GLuint> referenceRanges = clusterGrid.GetClusterRanges();
+		std::vector<GLuint> referenceIndices = clusterGrid.GetLightIndices();
+
+		clusterGrid.SetThreadPool(&threadPool);
+		clusterGrid.AssignLights(x.data(), y.data(), z.data(), radius.data(), count); // Warming up the threads and the memory.
+		start = std::chrono::high_resolution_clock::now();
+		for (int r = 0; r < repeats; r++)
+		{
+			clusterGrid.AssignLights(x.data(), y.data(), z.data(), radius.data(), count);
+		}
+		double simdTime = MillisecondsSince(start) / repeats;
+
+		bool same = referenceRanges == clusterGrid.GetClusterRanges() && referenceIndices == clusterGrid.GetLightIndices();
+		printf("%8u %12.3f %12.3f %8.1fx %12u %6s\n", count, scalarTime, simdTime, scalarTime / simdTime,
+			clusterGrid.GetIndexCount(), same ? "yes" : "NO");
+	}
+}
+
+void Benchmarks::LightUpdate()
+{
+	const glm::vec3 boundsMin(-50.0f, 0.0f, -50.0f), boundsMax(50.0f, 10.0f, 50.0f);
+	const glm::mat4 viewMatrix = glm::lookAt(glm::vec3(0.0f, 5.0f, 60.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	const GLfloat deltaTime = 1.0f / 60.0f;
+	const int repeats = 20;
+
+	printf("Per frame light update: move, view space transform, pack for upload.\n");
+	printf("%8s %14s %14s %9s %6s\n", "Lights", "Objects ms", "Planes ms", "Speedup", "Same");
+
+	for (unsigned int count = 1024; count <= 65536; count *= 2)
+	{
+		srand(count);
+		LightManager manager(count);
+		std::vector<PointLight> objects;
+		std::vector<glm::vec3> velocities;
+		objects.reserve(count);
+		for (unsigned int i = 0; i < count; i++)
+		{
+			glm::vec3 position = boundsMin + (boundsMax - boundsMin) * glm::vec3((GLfloat)rand() / RAND_MAX, (GLfloat)rand() / RAND_MAX, (GLfloat)rand() / RAND_MAX);
+			glm::vec3 colour((GLfloat)rand() / RAND_MAX, (GLfloat)rand() / RAND_MAX, (GLfloat)rand() / RAND_MAX);
+			glm::vec3 velocity = glm::vec3((GLfloat)rand() / RAND_MAX, (GLfloat)rand() / RAND_MAX, (GLfloat)rand() / RAND_MAX) * 2.0f - 1.0f;
+
+			objects.push_back(PointLight(1, 1, 0.01f, 1.0f, colour.r, colour.g, colour.b, 0.0f, 0.8f,
+				position.x, position.y, position.z, 1.0f, 2.0f, 20.0f));
+			velocities.push_back(velocity);
+			manager.SetVelocity(manager.AddPointLight(position, colour, 0.0f, 0.8f, 1.0f, 2.0f, 20.0f), velocity);
+		}
+
+		// The way ClusterGrid used to do it: one light at a time, gathering from each object into the arrays the GPU and the clusters read.
+		// PointLight can't move, so the move is done on a copy of its position, the way a SetPosition would.
+		std::vector<glm::vec3> positions(count);
+		for (unsigned int i = 0; i < count; i++)
+		{
+			positions[i] = objects[i].GetPosition();
+		}
+		std::vector<glm::vec4> lightData(count * 3);
+		std::vector<GLfloat> objectX(count), objectY(count), objectZ(count), objectRadius(count);
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		for (int r = 0; r < repeats; r++)
+		{
+			for (unsigned int i = 0; i < count; i++)
+			{
+				PointLight& light = objects[i];
+				glm::vec3 position = positions[i] + velocities[i] * deltaTime;
+				for (int axis = 0; axis < 3; axis++)
+				{
+					if (position[axis] < boundsMin[axis] || boundsMax[axis] < position[axis])
+					{
+						velocities[i][axis] = -velocities[i][axis];
+					}
+				}
+				positions[i] = glm::clamp(position, boundsMin, boundsMax);
+
+				glm::vec3 attenuation = light.GetAttenuation();
+				lightData[i * 3] = glm::vec4(positions[i], light.GetRadius());
+				lightData[i * 3 + 1] = glm::vec4(light.GetColour(), light.GetAmbientIntensity());
+				lightData[i * 3 + 2] = glm::vec4(light.GetDiffuseIntensity(), attenuation.x, attenuation.y, attenuation.z);
+
+				glm::vec3 viewPosition = glm::vec3(viewMatrix * glm::vec4(positions[i], 1.0f));
+				objectX[i] = viewPosition.x;
+				objectY[i] = viewPosition.y;
+				objectZ[i] = viewPosition.z;
+				objectRadius[i] = light.GetRadius();
+			}
+		}
+		double objectTime = MillisecondsSince(start) / repeats;
+
+		// The LightManager: three SIMD passes, then one memcpy.
+		std::vector<GLfloat> x(count), y(count), z(count);
+		std::vector<GLfloat> gpuData(manager.GetGPUDataSize() / sizeof(GLfloat));
+		start = std::chrono::high_resolution_clock::now();
+		for (int r = 0; r < repeats; r++)
+		{
+			manager.Integrate(deltaTime, boundsMin, boundsMax);
+			manager.TransformPositions(viewMatrix, x.data(), y.data(), z.data());
+			manager.CopyGPUData(gpuData.data());
+		}
+		double planeTime = MillisecondsSince(start) / repeats;
+
+		// Both moved the lights the same number of times, so they should be in the same place.
+		bool same = true;
+		for (unsigned int i = 0; i < count && same; i++)
+		{
+			same = fabsf(x[i] - objectX[i]) < 1e-3f && fabsf(y[i] - objectY[i]) < 1e-3f && fabsf(z[i] - objectZ[i]) < 1e-3f &&
+				manager.GetPlane(LIGHT_RADIUS)[i] == objectRadius[i];
+		}
+		printf("%8u %14.3f %14.3f %8.1fx %6s\n", count, objectTime, planeTime, objectTime / planeTime, same ? "yes" : "NO");
+	}
+}
+
+bool Benchmarks::WriteTextMesh(const char* fileLocation, const std::vector<GLfloat>& vertices, const std::vector<unsigned int>& indices)
+{
+	FILE* file = fopen(fileLocation, "w");
+	if (!file)
+	{
+		return false;
+	}
+
+	fprintf(file, "%u %u\n", (unsigned int)vertices.size() / 8, (unsigned int)indices.size());
+	for (size_t i = 0; i < vertices.size(); i += 8)
+	{
+		fprintf(file, "%g %g %g %g %g %g %g %g\n", vertices[i], vertices[i + 1], vertices[i + 2], vertices[i + 3],
+			vertices[i + 4], vertices[i + 5], vertices[i + 6], vertices[i + 7]);
+	}
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		fprintf(file, "%u %u %u\n", indices[i], indices[i + 1], indices[i + 2]);
+	}
+	fclose(file);
+
+	return true;
+}
+
+bool Benchmarks::ReadTextMesh(const char* fileLocation, std::vector<GLfloat>& vertices, std::vector<unsigned int>& indices)
+{
+	FILE* file = fopen(fileLocation, "r");
+	if (!file)
+	{
+		return false;
+	}
+
+	// A line at a time, each number read with strtof/strtoul. About as quick as a simple text parser gets without tricks.
+	char line[256];
+	unsigned int vertexCount = 0, indexCount = 0;
+	if (!fgets(line, sizeof(line), file) || sscanf(line, "%u %u", &vertexCount, &indexCount) != 2)
+	{
+		fclose(file);
+		return false;
+	}
+	vertices.resize((size_t)vertexCount * 8);
+	indices.resize(indexCount);
+
+	for (unsigned int i = 0; i < vertexCount && fgets(line, sizeof(line), file); i++)
+	{
+		char* position = line;
+		for (int value = 0; value < 8; value++)
+		{
+			vertices[(size_t)i * 8 + value] = strtof(position, &position);
+		}
+	}
+	for (unsigned int i = 0; i < indexCount && fgets(line, sizeof(line), file); i += 3)
+	{
+		char* position = line;
+		for (int value = 0; value < 3; value++)
+		{
+			indices[i + value] = (unsigned int)strtoul(position, &position, 10);
+		}
+	}
+	fclose(file);
+
+	return true;
+}
+
+void Benchmarks::MeshLoading()
+{
+	const char* textLocation = "benchmark_mesh.txt";
+	const char* binaryLocation = "benchmark_mesh.mesh";
+	const int repeats = 5;
+
+	printf("Mesh loading, text parsing against a mapped .mesh file. Times include reading every value once, as glBufferData would.\n");
+	printf("%9s %11s %11s %11s %11s %9s %6s\n", "Vertices", "Text KB", "Binary KB", "Text ms", "Binary ms", "Speedup", "Same");
+
+	for (unsigned int side = 64; side <= 1024; side *= 2)
+	{
+		// A flat grid, side x side vertices, 2 triangles per square.
+		std::vector<GLfloat> vertices;
+		vertices.reserve((size_t)side * side * 8);
+		for (unsigned int z = 0; z < side; z++)
+		{
+			for (unsigned int x = 0; x < side; x++)
+			{
+				GLfloat u = (GLfloat)x / (side - 1), v = (GLfloat)z / (side - 1);
+				GLfloat vertex[8] = { u * 20.0f - 10.0f, sinf(u * 12.0f) * cosf(v * 9.0f), v * 20.0f - 10.0f, u, v, 0.0f, -1.0f, 0.0f };
+				vertices.insert(vertices.end(), vertex, vertex + 8);
+			}
+		}
+		std::vector<unsigned int> indices;
+		indices.reserve((size_t)(side - 1) * (side - 1) * 6);
+		for (unsigned int z = 0; z + 1 < side; z++)
+		{
+			for (unsigned int x = 0; x + 1 < side; x++)
+			{
+				unsigned int a = z * side + x, b = a + side;
+				unsigned int quad[6] = { a, b, a + 1, a + 1, b, b + 1 };
+				indices.insert(indices.end(), quad, quad + 6);
+			}
+		}
+
+		if (!WriteTextMesh(textLocation, vertices, indices) ||
+			!MeshFile::Save(binaryLocation, vertices.data(), indices.data(), (unsigned int)vertices.size(), (unsigned int)indices.size()))
+		{
+			printf("Failed to write the benchmark meshes.\n");
+			return;
+		}
+
+		// Summing every value stands in for glBufferData reading them, and keeps the compiler from skipping the work.
+		// For the mapped file, it is also what makes the OS bring the pages in.
+		double textSum = 0.0, binarySum = 0.0;
+		std::vector<GLfloat> textVertices;
+		std::vector<unsigned int> textIndices;
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		for (int r = 0; r < repeats; r++)
+		{
+			ReadTextMesh(textLocation, textVertices, textIndices);
+			textSum = 0.0;
+			for (size_t i = 0; i < textVertices.size(); i++)
+			{
+				textSum += textVertices[i];
+			}
+			for (size_t i = 0; i < textIndices.size(); i++)
+			{
+				textSum += textIndices[i];
+			}
+		}
+		double textTime = MillisecondsSince(start) / repeats;
+
+		bool same = true;
+		start = std::chrono::high_resolution_clock::now();
+		for (int r = 0; r < repeats; r++)
+		{
+			MeshFile file;
+			if (!file.Open(binaryLocation))
+			{
+				same = false;
+				break;
+			}
+			const GLfloat* fileVertices = file.GetVertices();
+			const unsigned int* fileIndices = file.GetIndices();
+			binarySum = 0.0;
+			for (unsigned int i = 0; i < file.GetVertexCount(); i++)
+			{
+				binarySum += fileVertices[i];
+			}
+			for (unsigned int i = 0; i < file.GetIndexCount(); i++)
+			{
+				binarySum += fileIndices[i];
+			}
+		}
+		double binaryTime = MillisecondsSince(start) / repeats;
+
+		// Text loses some precision with %g, so the sums only have to be close.
+		same = same && textIndices == indices && fabs(textSum - binarySum) <= 1e-3 * fabs(binarySum) + 1.0;
+
+		FILE* file = fopen(textLocation, "rb");
+		fseek(file, 0, SEEK_END);
+		long textSize = ftell(file);
+		fclose(file);
+		file = fopen(binaryLocation, "rb");
+		fseek(file, 0, SEEK_END);
+		long binarySize = ftell(file);
+		fclose(file);
+
+		printf("%9u %11.1f %11.1f %11.3f %11.3f %8.1fx %6s\n", side * side, textSize / 1024.0, binarySize / 1024.0,
+			textTime, binaryTime, textTime / binaryTime, same ? "yes" : "NO");
+	}
+
+	remove(textLocation);
+	remove(binaryLocation);
+}
+
+void Benchmarks::NormalGeneration()
+{
+	const int repeats = 5;
+
+	ThreadPool threadPool;
+	threadPool.Init();
+
+	printf("Vertex normals, %u threads, %u lanes.\n", threadPool.GetThreadCount(), LANE_COUNT);
+	printf("Threads: the threaded path, whatever the size. Kept adj: the same with the vertex adjacency built once beforehand,\n");
+	printf("like a mesh whose vertices move every frame would. Speedup is of Threads over 1 thread, for picking MeshProcessing::PARALLEL_MIN_TRIANGLES.\n");
+	printf("Area and Angle: the other weightings, on one thread like the importer runs them.\n");
+	printf("%9s %12s %12s %12s %12s %9s %11s %11s %6s\n", "Vertices", "Course ms", "1 thread ms", "Threads ms", "Kept adj ms", "Speedup",
+		"Area ms", "Angle ms", "Same");
+
+	for (unsigned int side = 64; side <= 1024; side *= 2)
+	{
+		// A bumpy grid, side x side vertices, normals at 0. Every inside vertex is used by 6 triangles.
+		std::vector<GLfloat> vertices;
+		vertices.reserve((size_t)side * side * 8);
+		for (unsigned int z = 0; z < side; z++)
+		{
+			for (unsigned int x = 0; x < side; x++)
+			{
+				GLfloat u = (GLfloat)x / (side - 1), v = (GLfloat)z / (side - 1);
+				GLfloat vertex[8] = { u * 20.0f - 10.0f, sinf(u * 12.0f) * cosf(v * 9.0f), v * 20.0f - 10.0f, u, v, 0.0f, 0.0f, 0.0f };
+				vertices.insert(vertices.end(), vertex, vertex + 8);
+			}
+		}
+		std::vector<unsigned int> indices;
+		indices.reserve((size_t)(side - 1) * (side - 1) * 6);
+		for (unsigned int z = 0; z + 1 < side; z++)
+		{
+			for (unsigned int x = 0; x + 1 < side; x++)
+			{
+				unsigned int a = z * side + x, b = a + side;
+				unsigned int quad[6] = { a, b, a + 1, a + 1, b, b + 1 };
+				indices.insert(indices.end(), quad, quad + 6);
+			}
+		}
+		unsigned int vertexCount = (unsigned int)vertices.size(), indexCount = (unsigned int)indices.size();
+
+		// The course's version adds to the normals, so it starts from a fresh copy every time.
+		std::vector<GLfloat> reference;
+		double referenceTime = 0.0;
+		for (int r = 0; r < repeats; r++)
+		{
+			reference = vertices;
+			std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+			MeshProcessing::CalcAverageNormalsReference(indices.data(), indexCount, reference.data(), vertexCount, 8, 5);
+			referenceTime += MillisecondsSince(start);
+		}
+		referenceTime /= repeats;
+
+		std::vector<GLfloat> result = vertices;
+		bool same = true;
+		// With a thread pool, always the threaded path. The default threshold would have everything on one thread.
+		auto timeNormals = [&](NormalWeighting weighting, ThreadPool* pool, const MeshProcessing::VertexAdjacency* adjacency)
+		{
+			MeshProcessing::CalcNormals(indices.data(), indexCount, result.data(), vertexCount, 8, 5, weighting, pool, adjacency, 0); // Warming up.
+			std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+			for (int r = 0; r < repeats; r++)
+			{
+				MeshProcessing::CalcNormals(indices.data(), indexCount, result.data(), vertexCount, 8, 5, weighting, pool, adjacency, 0);
+			}
+			double time = MillisecondsSince(start) / repeats;
+
+			for (size_t i = 0; i < result.size() && same && weighting == NORMAL_WEIGHT_EQUAL; i++)
+			{
+				same = fabsf(result[i] - reference[i]) < 1e-4f;
+			}
+			return time;
+		};
+		MeshProcessing::VertexAdjacency adjacency;
+		MeshProcessing::BuildVertexAdjacency(indices.data(), indexCount, vertexCount / 8, adjacency);
+
+		double areaTime = timeNormals(NORMAL_WEIGHT_AREA, nullptr, nullptr);
+		double angleTime = timeNormals(NORMAL_WEIGHT_ANGLE, nullptr, nullptr);
+		double singleTime = timeNormals(NORMAL_WEIGHT_EQUAL, nullptr, nullptr);
+		double threadedTime = timeNormals(NORMAL_WEIGHT_EQUAL, &threadPool, nullptr);
+		double keptTime = timeNormals(NORMAL_WEIGHT_EQUAL, &threadPool, &adjacency);
+
+		printf("%9u %12.3f %12.3f %12.3f %12.3f %8.1fx %11.3f %11.3f %6s\n", side * side, referenceTime, singleTime, threadedTime, keptTime,
+			singleTime / threadedTime, areaTime, angleTime, same ? "yes" : "NO");
+	}
+}
+
+void Benchmarks::MakeShuffledTorus(unsigned int rings, std::vector<GLfloat>& vertices, std::vector<unsigned int>& indices)
+{
+	// A torus seen from the side covers itself, so its triangle order matters for overdraw. rings x sides quads.
+	unsigned int sides = rings / 2;
+	vertices.clear();
+	for (unsigned int ring = 0; ring < rings; ring++)
+	{
+		GLfloat around = 6.2831853f * ring / rings;
+		for (unsigned int side = 0; side < sides; side++)
+		{
+			GLfloat tube = 6.2831853f * side / sides;
+			GLfloat radius = 2.0f + 0.7f * cosf(tube);
+			GLfloat vertex[8] = { radius * cosf(around), 0.7f * sinf(tube), radius * sinf(around), (GLfloat)ring / rings, (GLfloat)side / sides,
+				cosf(tube) * cosf(around), sinf(tube), cosf(tube) * sinf(around) };
+			vertices.insert(vertices.end(), vertex, vertex + 8);
+		}
+	}
+	indices.clear();
+	for (unsigned int ring = 0; ring < rings; ring++)
+	{
+		for (unsigned int side = 0; side < sides; side++)
+		{
+			unsigned int a = ring * sides + side, b = ((ring + 1) % rings) * sides + side;
+			unsigned int c = ring * sides + (side + 1) % sides, d = ((ring + 1) % rings) * sides + (side + 1) % sides;
+			unsigned int quad[6] = { a, c, b, b, c, d };
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+
+	// Shuffling the triangles, then the vertices.
+	srand(rings);
+	unsigned int triangleCount = (unsigned int)indices.size() / 3, vertexCount = (unsigned int)vertices.size() / 8;
+	for (unsigned int i = triangleCount - 1; i > 0; i--)
+	{
+		unsigned int j = (unsigned int)(((unsigned long long)rand() * (RAND_MAX + 1ull) + rand()) % (i + 1));
+		std::swap_ranges(indices.begin() + i * 3, indices.begin() + i * 3 + 3, indices.begin() + j * 3);
+	}
+	std::vector<unsigned int> shuffle(vertexCount);
+	for (unsigned int i = 0; i < vertexCount; i++)
+	{
+		shuffle[i] = i;
+	}
+	for (unsigned int i = vertexCount - 1; i > 0; i--)
+	{
+		std::swap(shuffle[i], shuffle[((unsigned long long)rand() * (RAND_MAX + 1ull) + rand()) % (i + 1)]);
+	}
+	std::vector<GLfloat> shuffled(vertices.size());
+	for (unsigned int i = 0; i < vertexCount; i++)
+	{
+		std::copy(vertices.begin() + i * 8, vertices.begin() + i * 8 + 8, shuffled.begin() + shuffle[i] * 8);
+	}
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		indices[i] = shuffle[indices[i]];
+	}
+	vertices.swap(shuffled);
+}
+
+void Benchmarks::MeshOptimization()
+{
+	printf("Mesh optimizer. Each torus as shuffled, after OptimizeVertexCache alone, and after all 3 steps.\n");
+	printf("%10s %-10s %8s %8s %10s %9s %10s\n", "Triangles", "Order", "ACMR", "ATVR", "Overfetch", "Overdraw", "Time ms");
+
+	for (unsigned int rings = 32; rings <= 512; rings *= 2)
+	{
+		std::vector<GLfloat> vertices;
+		std::vector<unsigned int> indices;
+		MakeShuffledTorus(rings, vertices, indices);
+		unsigned int triangleCount = (unsigned int)indices.size() / 3, vertexCount = (unsigned int)vertices.size() / 8;
+
+		unsigned int indexCount = (unsigned int)indices.size();
+		MeshOptimizer::Stats stats = MeshOptimizer::Analyze(indices.data(), indexCount, vertices.data(), (unsigned int)vertices.size(), 8);
+		printf("%10u %-10s %8.3f %8.3f %10.2f %9.2f %10s\n", triangleCount, "shuffled", stats.acmr, stats.atvr, stats.overfetch, stats.overdraw, "");
+
+		std::vector<unsigned int> clusters;
+		std::vector<unsigned int> cacheOnly = indices;
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		MeshOptimizer::OptimizeVertexCache(cacheOnly.data(), indexCount, vertexCount, clusters);
+		double cacheTime = MillisecondsSince(start);
+		stats = MeshOptimizer::Analyze(cacheOnly.data(), indexCount, vertices.data(), (unsigned int)vertices.size(), 8);
+		printf("%10s %-10s %8.3f %8.3f %10.2f %9.2f %10.2f\n", "", "cache", stats.acmr, stats.atvr, stats.overfetch, stats.overdraw, cacheTime);
+
+		start = std::chrono::high_resolution_clock::now();
+		MeshOptimizer::OptimizeVertexCache(indices.data(), indexCount, vertexCount, clusters);
+		MeshOptimizer::OptimizeOverdraw(indices.data(), indexCount, vertices.data(), (unsigned int)vertices.size(), 8, clusters);
+		vertices.resize(MeshOptimizer::OptimizeVertexFetch(indices.data(), indexCount, vertices.data(), (unsigned int)vertices.size(), 8));
+		double allTime = MillisecondsSince(start);
+		stats = MeshOptimizer::Analyze(indices.data(), indexCount, vertices.data(), (unsigned int)vertices.size(), 8);
+		printf("%10s %-10s %8.3f %8.3f %10.2f %9.2f %10.2f\n", "", "all 3", stats.acmr, stats.atvr, stats.overfetch, stats.overdraw, allTime);
+	}
+}
+
+void Benchmarks::VertexPacking()
+{
+	const unsigned int side = 1024;
+	const int repeats = 5;
+
+	// Same bumpy grid as NormalGeneration, 20 units across, with its UVs tiled 4 times.
+	std::vector<GLfloat> vertices;
+	vertices.reserve((size_t)side * side * 8);
+	for (unsigned int z = 0; z < side; z++)
+	{
+		for (unsigned int x = 0; x < side; x++)
+		{
+			GLfloat u = (GLfloat)x / (side - 1), v = (GLfloat)z / (side - 1);
+			GLfloat vertex[8] = { u * 20.0f - 10.0f, sinf(u * 12.0f) * cosf(v * 9.0f), v * 20.0f - 10.0f, u * 4.0f, v * 4.0f, 0.0f, 0.0f, 0.0f };
+			vertices.insert(vertices.end(), vertex, vertex + 8);
+		}
+	}
+	std::vector<unsigned int> indices;
+	for (unsigned int z = 0; z + 1 < side; z++)
+	{
+		for (unsigned int x = 0; x + 1 < side; x++)
+		{
+			unsigned int a = z * side + x, b = a + side;
+			unsigned int quad[6] = { a, b, a + 1, a + 1, b, b + 1 };
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+	unsigned int vertexCount = (unsigned int)vertices.size();
+	MeshProcessing::CalcNormals(indices.data(), (unsigned int)indices.size(), vertices.data(), vertexCount, 8, 5);
+
+	glm::vec3 minimum(vertices[0], vertices[1], vertices[2]), maximum = minimum;
+	for (unsigned int i = 0; i < vertexCount; i += 8)
+	{
+		minimum = glm::min(minimum, glm::vec3(vertices[i], vertices[i + 1], vertices[i + 2]));
+		maximum = glm::max(maximum, glm::vec3(vertices[i], vertices[i + 1], vertices[i + 2]));
+	}
+
+	printf("Vertex formats, %u vertices.\n", vertexCount / 8);
+	printf("Bytes: per vertex, all of it for the lit passes and only the position for the depth passes (see Mesh::RenderMeshDepth).\n");
+	printf("%-18s %7s %7s %9s %9s %14s %10s %14s\n", "Format", "Bytes", "Depth", "Buffer MB", "Pack ms", "Position error", "UV error", "Normal error");
+	printf("%-18s %7u %7u %9.1f %9s %14s %10s %14s\n", "float", 32u, 12u, vertexCount * 4 / 1048576.0, "", "0", "0", "0");
+
+	const VertexFormat formats[] = { VERTEX_FORMAT_PACKED_OCTAHEDRAL, VERTEX_FORMAT_PACKED_10_10_10 };
+	const char* names[] = { "packed octahedral", "packed 10_10_10" };
+	for (int f = 0; f < 2; f++)
+	{
+		std::vector<Mesh::PackedPosition> positions;
+		std::vector<Mesh::PackedAttributes> packed;
+		Mesh::PackVertices(vertices.data(), vertexCount, formats[f], minimum, maximum - minimum, positions, packed); // Warming up.
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		for (int r = 0; r < repeats; r++)
+		{
+			Mesh::PackVertices(vertices.data(), vertexCount, formats[f], minimum, maximum - minimum, positions, packed);
+		}
+		double packTime = MillisecondsSince(start) / repeats;
+
+		// Decoding like shader.vert does. The GPU turns the normalized integers into floats the same way.
+		GLfloat positionError = 0.0f, uvError = 0.0f, normalError = 0.0f;
+		for (size_t i = 0; i < packed.size(); i++)
+		{
+			const GLfloat* vertex = &vertices[i * 8];
+			const Mesh::PackedAttributes& p = packed[i];
+			const GLushort* q = positions[i].position;
+			glm::vec3 position = minimum + glm::vec3(q[0], q[1], q[2]) / 65535.0f * (maximum - minimum);
+			positionError = std::max(positionError, glm::length(position - glm::vec3(vertex[0], vertex[1], vertex[2])));
+
+			glm::vec2 uv = glm::unpackHalf2x16(p.uv);
+			uvError = std::max(uvError, std::max(std::abs(uv.x - vertex[3]), std::abs(uv.y - vertex[4])));
+
+			glm::vec3 normal;
+			if (formats[f] == VERTEX_FORMAT_PACKED_OCTAHEDRAL)
+			{
+				glm::vec2 folded = glm::unpackSnorm2x16(p.normal);
+				normal = glm::vec3(folded, 1.0f - std::abs(folded.x) - std::abs(folded.y));
+				GLfloat t = std::max(-normal.z, 0.0f);
+				normal.x += normal.x >= 0.0f ? -t : t;
+				normal.y += normal.y >= 0.0f ? -t : t;
+			}
+			else
+			{
+				normal = glm::vec3(glm::unpackSnorm3x10_1x2(p.normal));
+			}
+			GLfloat cosine = glm::dot(glm::normalize(normal), glm::vec3(vertex[5], vertex[6], vertex[7]));
+			normalError = std::max(normalError, acosf(std::min(cosine, 1.0f)) * 57.2957795f);
+		}
+		size_t vertexSize = sizeof(Mesh::PackedPosition) + sizeof(Mesh::PackedAttributes);
+		printf("%-18s %7u %7u %9.1f %9.3f %14.6f %10.6f %13.4f\n", names[f], (unsigned int)vertexSize, (unsigned int)sizeof(Mesh::PackedPosition),
+			packed.size() * vertexSize / 1048576.0, packTime, positionError, uvError, normalError);
+	}
+}
+
+void Benchmarks::IndexCompression()
+{
+	const int repeats = 10;
+
+	printf("Index buffers. GPU: bytes with the index type Mesh picks, its draw calls and the vertices it copies to split into 16 bit ranges.\n");
+	printf("File: bytes once encoded by IndexCodec.\n");
+#if defined(__AVX__)
+	const char* decoder = "4 at a time";
+#else
+	const char* decoder = "one at a time, no AVX";
+#endif
+	printf("Decode times are for all the indices: one at a time, then what Decode does here (%s).\n", decoder);
+	printf("%10s %-10s %9s %8s %7s %8s %10s %10s %8s %10s %10s %10s %6s\n", "Triangles", "Order", "32 bit KB", "Type", "Draws", "Copies", "GPU KB", "File KB",
+		"Bits", "Encode ms", "Scalar ms", "Decode ms", "Same");
+
+	for (unsigned int rings = 64; rings <= 1024; rings *= 2)
+	{
+		std::vector<GLfloat> vertices;
+		std::vector<unsigned int> indices;
+		MakeShuffledTorus(rings, vertices, indices);
+		unsigned int indexCount = (unsigned int)indices.size();
+
+		for (int optimized = 0; optimized < 2; optimized++)
+		{
+			if (optimized)
+			{
+				std::vector<unsigned int> clusters;
+				MeshOptimizer::OptimizeVertexCache(indices.data(), indexCount, (unsigned int)vertices.size() / 8, clusters);
+				MeshOptimizer::OptimizeOverdraw(indices.data(), indexCount, vertices.data(), (unsigned int)vertices.size(), 8, clusters);
+				vertices.resize(MeshOptimizer::OptimizeVertexFetch(indices.data(), indexCount, vertices.data(), (unsigned int)vertices.size(), 8));
+			}
+
+			// 16 bytes per vertex, like the packed vertex formats.
+			std::vector<Mesh::IndexRange> ranges;
+			std::vector<GLuint> lodRanges;
+			std::vector<unsigned int> vertexRemap;
+			std::vector<GLushort> rangeIndices;
+			bool shortIndices = Mesh::SplitIndexRanges(indices.data(), indexCount, std::vector<Mesh::Lod>(1, Mesh::Lod{ 0, indexCount, 0.0f }),
+				(unsigned int)vertices.size() / 8, 16, ranges, lodRanges, vertexRemap, rangeIndices);
+			size_t gpuSize = (size_t)indexCount * (shortIndices ? sizeof(GLushort) : sizeof(GLuint));
+			int copies = shortIndices && !vertexRemap.empty() ? (int)vertexRemap.size() - (int)vertices.size() / 8 : 0;
+
+			std::vector<unsigned char> encoded;
+			std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+			for (int r = 0; r < repeats; r++)
+			{
+				IndexCodec::Encode(indices.data(), indexCount, encoded);
+			}
+			double encodeTime = MillisecondsSince(start) / repeats;
+
+			std::vector<unsigned int> scalar(indexCount), decoded(indexCount);
+			bool same = true;
+			start = std::chrono::high_resolution_clock::now();
+			for (int r = 0; r < repeats; r++)
+			{
+				same = IndexCodec::DecodeReference(encoded.data(), encoded.size(), scalar.data(), indexCount) && same;
+			}
+			double scalarTime = MillisecondsSince(start) / repeats;
+
+			start = std::chrono::high_resolution_clock::now();
+			for (int r = 0; r < repeats; r++)
+			{
+				same = IndexCodec::Decode(encoded.data(), encoded.size(), decoded.data(), indexCount) && same;
+			}
+			double decodeTime = MillisecondsSince(start) / repeats;
+			same = same && scalar == indices && decoded == indices;
+
+			char triangles[16] = "";
+			if (!optimized)
+			{
+				snprintf(triangles, sizeof(triangles), "%u", indexCount / 3);
+			}
+			printf("%10s %-10s %9.1f %8s %7u %8d %10.1f %10.1f %8.2f %10.3f %10.3f %10.3f %6s\n", triangles,
+				optimized ? "optimized" : "shuffled", indexCount * 4 / 1024.0, shortIndices ? "16 bit" : "32 bit",
+				shortIndices ? (unsigned int)ranges.size() : 1u, copies, gpuSize / 1024.0, encoded.size() / 1024.0, encoded.size() * 8.0 / indexCount,
+				encodeTime, scalarTime, decodeTime, same ? "yes" : "NO");
+		}
+	}
+}
+
+void Benchmarks::LevelOfDetail()
+{
+	printf("Levels of detail. Error is what MeshSimplifier reports, Measured the furthest a simplified triangle is from the real torus, in units.\n");
+	printf("The torus is 5.4 units across.\n");
+	printf("%10s %10s %10s %10s %10s %10s\n", "Triangles", "Target", "Kept", "ms", "Error", "Measured");
+
+	for (unsigned int rings = 64; rings <= 512; rings *= 2)
+	{
+		std::vector<GLfloat> vertices;
+		std::vector<unsigned int> indices;
+		MakeShuffledTorus(rings, vertices, indices);
+		unsigned int indexCount = (unsigned int)indices.size();
+
+		std::vector<unsigned int> simplified(indexCount);
+		char triangles[16];
+		snprintf(triangles, sizeof(triangles), "%u", indexCount / 3);
+		for (unsigned int target = indexCount / 2; target / 3 >= LOD_MIN_TRIANGLES; target /= 2)
+		{
+			target -= target % 3;
+			GLfloat error = 0.0f;
+			std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+			unsigned int kept = MeshSimplifier::Simplify(simplified.data(), indices.data(), indexCount, vertices.data(), (unsigned int)vertices.size(), 8,
+				target, &error);
+			double time = MillisecondsSince(start);
+
+			// Distance to a torus of radius 2 around the middle and 0.7 around the tube, at the center of each triangle and of its edges.
+			GLfloat measured = 0.0f;
+			for (unsigned int i = 0; i < kept; i += 3)
+			{
+				glm::vec3 corners[3];
+				for (unsigned int k = 0; k < 3; k++)
+				{
+					const GLfloat* vertex = &vertices[simplified[i + k] * 8];
+					corners[k] = glm::vec3(vertex[0], vertex[1], vertex[2]);
+				}
+				glm::vec3 samples[4] = { (corners[0] + corners[1] + corners[2]) / 3.0f, (corners[0] + corners[1]) * 0.5f,
+					(corners[1] + corners[2]) * 0.5f, (corners[2] + corners[0]) * 0.5f };
+				for (unsigned int k = 0; k < 4; k++)
+				{
+					GLfloat around = sqrtf(samples[k].x * samples[k].x + samples[k].z * samples[k].z) - 2.0f;
+					measured = std::max(measured, fabsf(sqrtf(around * around + samples[k].y * samples[k].y) - 0.7f));
+				}
+			}
+
+			printf("%10s %10u %10u %10.1f %10.4f %10.4f\n", triangles, target / 3, kept / 3, time, error, measured);
+			triangles[0] = '\0'; // Only on the first line of each torus.
+		}
+	}
+}
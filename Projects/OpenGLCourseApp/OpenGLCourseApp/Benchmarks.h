@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <cmath>
+#include <chrono>
+
+#include <GL/glew.h>
+
+// Timings of the CPU side of the engine, run from the command line instead of opening the window.
+// e.g. OpenGLCourseApp.exe --benchmark-clusters, --benchmark-lights, --benchmark-meshes, --benchmark-normals, --benchmark-mesh-optimizer
+// --benchmark-vertex-formats, --benchmark-indices or --benchmark-lods
+class Benchmarks
+{
+	public:
+		// Runs the benchmark named by the command line. Returns false if there was none to run.
+		static bool Run(int argc, char** argv);
+
+		// Light to cluster assignment, from 1k to 64k lights, against the 16x9x24 grid.
+		// Compares the one light at a time version with the SIMD, multithreaded one, and checks they give the same lists.
+		static void ClusterAssignment();
+
+		// Per frame light work, from 1k to 64k lights: moving them, going to view space, and packing them for the GPU.
+		// Compares an array of PointLight objects with the planes of a LightManager.
+		static void LightUpdate();
+
+		// Loading grid meshes of 4k to 1M vertices: parsing them from a text file against mapping a .mesh file (see MeshFile).
+		// Both files were just written, so they are in the OS file cache. This is the parsing and copying, not the disk.
+		static void MeshLoading();
+
+		// Vertex normals of bumpy grid meshes, 4k to 1M vertices. The course's CalcAverageNormals against MeshProcessing::CalcNormals
+		// on one thread and on the thread pool, and what the area and angle weightings cost. Checks the equal weighting gives the same normals.
+		static void NormalGeneration();
+
+		// Tori of 1k to 256k triangles, with their triangles and vertices shuffled like an imported model's can be.
+		// ACMR, ATVR, overfetch and overdraw (see MeshOptimizer) as they are, after OptimizeVertexCache alone, and after all 3 steps.
+		static void MeshOptimization();
+
+		// A bumpy grid of 1M vertices in every VertexFormat: bytes per vertex for the lit and depth passes, how long packing takes,
+		// and the largest error of the positions (in units), UVs and normals (in degrees) once decoded like the shaders do.
+		static void VertexPacking();
+
+		// Shuffled tori of 4k to 1M triangles, and the same after MeshOptimizer. Index bytes on the GPU (16 bit ranges or 32 bit, see Mesh::SplitIndexRanges)
+		// and in a .mesh file (see IndexCodec), and how fast the file's indices decode, one at a time and 4 at a time.
+		static void IndexCompression();
+
+		// Tori of 4k to 256k triangles simplified by MeshSimplifier to half, a quarter... of their triangles. How long it takes, the error it
+		// reports and how far the simplified triangles really are from the torus, at their centers and the middle of their edges.
+		static void LevelOfDetail();
+
+	private:
+		static double MillisecondsSince(std::chrono::high_resolution_clock::time_point start);
+
+		// A torus of rings x rings / 2 quads, 8 floats per vertex, with its triangles and vertices in a random order.
+		static void MakeShuffledTorus(unsigned int rings, std::vector<GLfloat>& vertices, std::vector<unsigned int>& indices);
+
+		// The text version of a mesh: a line with the counts, one line per vertex with its 8 values, one line per triangle.
+		static bool WriteTextMesh(const char* fileLocation, const std::vector<GLfloat>& vertices, const std::vector<unsigned int>& indices);
+		static bool ReadTextMesh(const char* fileLocation, std::vector<GLfloat>& vertices, std::vector<unsigned int>& indices);
+};
@@ -0,0 +1,409 @@
+#include "ClusterGrid.h"
+
+#include "SimdLanes.h"
+
+static const int TILES_PER_SLICE = CLUSTER_GRID_X * CLUSTER_GRID_Y;
+static const int CLUSTER_COUNT = CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z;
+
+ClusterGrid::ClusterGrid()
+{
+	nearPlane = 0.0f;
+	farPlane = 0.0f;
+	tileWidth = 0.0f;
+	tileHeight = 0.0f;
+	depthScale = 0.0f;
+	depthBias = 0.0f;
+	for (int z = 0; z <= CLUSTER_GRID_Z; z++)
+	{
+		sliceDistances[z] = 0.0f;
+	}
+
+	threadPool = nullptr;
+	inputX = nullptr;
+	inputY = nullptr;
+	inputZ = nullptr;
+	inputRadius = nullptr;
+
+	lightCount = 0;
+	lightStride = 0;
+	overflowReported = false;
+}
+
+bool ClusterGrid::Init(GLfloat fieldOfView, GLfloat aspect, GLfloat nearPlane, GLfloat farPlane, GLuint screenWidth, GLuint screenHeight,
+	ThreadPool* threadPool)
+{
+	BuildClusters(fieldOfView, aspect, nearPlane, farPlane, screenWidth, screenHeight);
+	SetThreadPool(threadPool);
+
+	// Written every frame, read by shader.frag as buffer textures.
+	return lightBuffer.Init(MAX_CLUSTERED_LIGHTS * LIGHT_PLANE_COUNT * sizeof(GLfloat), GL_R32F) && // LightManager's planes, one float per texel.
+		rangeBuffer.Init(CLUSTER_COUNT * 2 * sizeof(GLuint), GL_RG32UI) &&
+		indexBuffer.Init(MAX_CLUSTER_LIGHT_INDICES * sizeof(GLuint), GL_R32UI);
+}
+
+void ClusterGrid::BuildClusters(GLfloat fieldOfView, GLfloat aspect, GLfloat nearPlane, GLfloat farPlane, GLuint screenWidth, GLuint screenHeight)
+{
+	this->nearPlane = nearPlane;
+	this->farPlane = farPlane;
+
+	tileWidth = (GLfloat)screenWidth / CLUSTER_GRID_X;
+	tileHeight = (GLfloat)screenHeight / CLUSTER_GRID_Y;
+
+	// Slice k starts at nearPlane * (farPlane / nearPlane)^(k / CLUSTER_GRID_Z). Taking the log of that and solving for k gives these.
+	GLfloat logDepthRange = logf(farPlane / nearPlane);
+	depthScale = CLUSTER_GRID_Z / logDepthRange;
+	depthBias = CLUSTER_GRID_Z * logf(nearPlane) / logDepthRange;
+
+	for (int z = 0; z <= CLUSTER_GRID_Z; z++)
+	{
+		sliceDistances[z] = nearPlane * powf(farPlane / nearPlane, (GLfloat)z / CLUSTER_GRID_Z);
+	}
+
+	// Building the bounding box of every cluster, from the corners of its tile at the near and far distance of its slice.
+	GLfloat tanHalfFov = tanf(fieldOfView * 0.5f);
+	clusterMinX.resize(CLUSTER_COUNT);
+	clusterMinY.resize(CLUSTER_COUNT);
+	clusterMinZ.resize(CLUSTER_COUNT);
+	clusterMaxX.resize(CLUSTER_COUNT);
+	clusterMaxY.resize(CLUSTER_COUNT);
+	clusterMaxZ.resize(CLUSTER_COUNT);
+	for (int z = 0; z < CLUSTER_GRID_Z; z++)
+	{
+		for (int y = 0; y < CLUSTER_GRID_Y; y++)
+		{
+			for (int x = 0; x < CLUSTER_GRID_X; x++)
+			{
+				// Edges of the tile, between -1 and 1 on screen.
+				GLfloat left = -1.0f + 2.0f * x / CLUSTER_GRID_X;
+				GLfloat right = -1.0f + 2.0f * (x + 1) / CLUSTER_GRID_X;
+				GLfloat bottom = -1.0f + 2.0f * y / CLUSTER_GRID_Y;
+				GLfloat top = -1.0f + 2.0f * (y + 1) / CLUSTER_GRID_Y;
+
+				glm::vec3 boxMin(1e30f), boxMax(-1e30f);
+				for (int d = 0; d < 2; d++)
+				{
+					// The camera looks down -z in view space.
+					GLfloat distance = sliceDistances[z + d];
+					GLfloat halfWidth = distance * tanHalfFov * aspect;
+					GLfloat halfHeight = distance * tanHalfFov;
+					glm::vec3 cornerA(left * halfWidth, bottom * halfHeight, -distance);
+					glm::vec3 cornerB(right * halfWidth, top * halfHeight, -distance);
+					boxMin = glm::min(boxMin, glm::min(cornerA, cornerB));
+					boxMax = glm::max(boxMax, glm::max(cornerA, cornerB));
+				}
+
+				int clusterIndex = x + y * CLUSTER_GRID_X + z * TILES_PER_SLICE;
+				clusterMinX[clusterIndex] = boxMin.x;
+				clusterMinY[clusterIndex] = boxMin.y;
+				clusterMinZ[clusterIndex] = boxMin.z;
+				clusterMaxX[clusterIndex] = boxMax.x;
+				clusterMaxY[clusterIndex] = boxMax.y;
+				clusterMaxZ[clusterIndex] = boxMax.z;
+			}
+		}
+	}
+}
+
+void ClusterGrid::SetThreadPool(ThreadPool* threadPool)
+{
+	this->threadPool = threadPool;
+}
+
+int ClusterGrid::CalcDepthSlice(GLfloat distance)
+{
+	int slice = (int)floorf(logf(distance) * depthScale - depthBias);
+	return std::min(std::max(slice, 0), CLUSTER_GRID_Z - 1);
+}
+
+void ClusterGrid::Update(LightManager* lights, glm::mat4 viewMatrix)
+{
+	// The light buffer has room for a LightManager of MAX_CLUSTERED_LIGHTS, the default. A bigger one lights nothing.
+	lightCount = lights->GetGPUDataSize() <= (size_t)lightBuffer.GetCapacity() ? lights->GetLightCount() : 0;
+	lightX.resize(lights->GetLightCount());
+	lightY.resize(lights->GetLightCount());
+	lightZ.resize(lights->GetLightCount());
+	lights->TransformPositions(viewMatrix, lightX.data(), lightY.data(), lightZ.data());
+
+	AssignLights(lightX.data(), lightY.data(), lightZ.data(), lights->GetPlane(LIGHT_RADIUS), lightCount);
+
+	if (lightIndices.size() > (size_t)MAX_CLUSTER_LIGHT_INDICES && !overflowReported)
+	{
+		printf("Cluster light lists are full: %u entries for %d places. Some lights are skipped.\n", (unsigned int)lightIndices.size(), MAX_CLUSTER_LIGHT_INDICES);
+		overflowReported = true;
+	}
+
+	// Uploading, each buffer in one go, straight into memory the GPU is not reading.
+	// The lights are already laid out the way the shaders read them.
+	if (lightCount > 0)
+	{
+		void* mapped = lightBuffer.Map(lights->GetGPUDataSize());
+		if (mapped)
+		{
+			lights->CopyGPUData(mapped);
+			lightBuffer.Unmap();
+		}
+		lightStride = lights->GetStride();
+	}
+
+	GLuint* mappedRanges = (GLuint*)rangeBuffer.Map(clusterRanges.size() * sizeof(GLuint));
+	if (mappedRanges)
+	{
+		// Cutting the lists that go past the end of the index buffer.
+		for (int c = 0; c < CLUSTER_COUNT; c++)
+		{
+			GLuint start = std::min(clusterRanges[c * 2], (GLuint)MAX_CLUSTER_LIGHT_INDICES);
+			mappedRanges[c * 2] = start;
+			mappedRanges[c * 2 + 1] = std::min(clusterRanges[c * 2 + 1], (GLuint)MAX_CLUSTER_LIGHT_INDICES - start);
+		}
+		rangeBuffer.Unmap();
+	}
+
+	size_t uploadedIndices = std::min(lightIndices.size(), (size_t)MAX_CLUSTER_LIGHT_INDICES);
+	void* mappedIndices = indexBuffer.Map(uploadedIndices * sizeof(GLuint));
+	if (mappedIndices)
+	{
+		memcpy(mappedIndices, lightIndices.data(), uploadedIndices * sizeof(GLuint));
+		indexBuffer.Unmap();
+	}
+}
+
+void ClusterGrid::AssignLights(const GLfloat* x, const GLfloat* y, const GLfloat* z, const GLfloat* radius, unsigned int count)
+{
+	inputX = x;
+	inputY = y;
+	inputZ = z;
+	inputRadius = radius;
+
+	// Slices share nothing, so each task writes its own results.
+	if (threadPool)
+	{
+		threadPool->ParallelFor(CLUSTER_GRID_Z, [this, count](unsigned int slice) { AssignSlice(slice, count); });
+	}
+	else
+	{
+		for (int slice = 0; slice < CLUSTER_GRID_Z; slice++)
+		{
+			AssignSlice(slice, count);
+		}
+	}
+
+	// Putting the slices one after the other. Clusters are numbered slice by slice, so each slice is one block.
+	clusterRanges.resize(CLUSTER_COUNT * 2);
+	GLuint offset = 0;
+	for (int slice = 0; slice < CLUSTER_GRID_Z; slice++)
+	{
+		for (int tile = 0; tile < TILES_PER_SLICE; tile++)
+		{
+			int c = tile + slice * TILES_PER_SLICE;
+			clusterRanges[c * 2] = offset;
+			clusterRanges[c * 2 + 1] = slices[slice].counts[tile];
+			offset += slices[slice].counts[tile];
+		}
+	}
+
+	lightIndices.resize(offset);
+	for (int slice = 0; slice < CLUSTER_GRID_Z; slice++)
+	{
+		if (!slices[slice].indices.empty())
+		{
+			memcpy(&lightIndices[clusterRanges[slice * TILES_PER_SLICE * 2]], slices[slice].indices.data(), slices[slice].indices.size() * sizeof(GLuint));
+		}
+	}
+}
+
+void ClusterGrid::AssignSlice(int z, unsigned int count)
+{
+	SliceResult& slice = slices[z];
+	slice.candidates.clear();
+	slice.candidateX.clear();
+	slice.candidateY.clear();
+	slice.candidateZ.clear();
+	slice.candidateRadius.clear();
+
+	// First, only keeping the lights whose depth range touches this slice.
+	FloatLanes zero = SetLanes(0.0f);
+	FloatLanes sliceNear = SetLanes(sliceDistances[z]);
+	FloatLanes sliceFar = SetLanes(sliceDistances[z + 1]);
+	unsigned int i = 0;
+	for (; i + LANE_COUNT <= count; i += LANE_COUNT)
+	{
+		FloatLanes distance = SubLanes(zero, LoadLanes(inputZ + i)); // The camera looks down -z.
+		FloatLanes radius = LoadLanes(inputRadius + i);
+		int mask = MaskLanes(AndLanes(AndLanes(
+			LessEqualLanes(SubLanes(distance, radius), sliceFar),
+			LessEqualLanes(sliceNear, AddLanes(distance, radius))),
+			LessLanes(zero, radius)));
+
+		for (unsigned int lane = 0; lane < LANE_COUNT; lane++)
+		{
+			if (mask & (1 << lane))
+			{
+				slice.candidates.push_back(i + lane);
+			}
+		}
+	}
+	for (; i < count; i++) // The last few, that don't fill the lanes.
+	{
+		GLfloat distance = -inputZ[i];
+		if (distance - inputRadius[i] <= sliceDistances[z + 1] && sliceDistances[z] <= distance + inputRadius[i] && inputRadius[i] > 0.0f)
+		{
+			slice.candidates.push_back(i);
+		}
+	}
+
+	for (size_t c = 0; c < slice.candidates.size(); c++)
+	{
+		GLuint light = slice.candidates[c];
+		slice.candidateX.push_back(inputX[light]);
+		slice.candidateY.push_back(inputY[light]);
+		slice.candidateZ.push_back(inputZ[light]);
+		slice.candidateRadius.push_back(inputRadius[light]);
+	}
+	// Filling the last lanes with lights far away that reach nothing.
+	while (slice.candidateX.size() % LANE_COUNT != 0)
+	{
+		slice.candidateX.push_back(1e30f);
+		slice.candidateY.push_back(1e30f);
+		slice.candidateZ.push_back(1e30f);
+		slice.candidateRadius.push_back(0.0f);
+	}
+
+	// Then testing them against the box of every cluster of the slice.
+	slice.counts.assign(TILES_PER_SLICE, 0);
+	slice.indices.clear();
+	for (int tile = 0; tile < TILES_PER_SLICE; tile++)
+	{
+		int c = tile + z * TILES_PER_SLICE;
+		FloatLanes minX = SetLanes(clusterMinX[c]), minY = SetLanes(clusterMinY[c]), minZ = SetLanes(clusterMinZ[c]);
+		FloatLanes maxX = SetLanes(clusterMaxX[c]), maxY = SetLanes(clusterMaxY[c]), maxZ = SetLanes(clusterMaxZ[c]);
+
+		for (size_t j = 0; j < slice.candidateX.size(); j += LANE_COUNT)
+		{
+			FloatLanes x = LoadLanes(&slice.candidateX[j]);
+			FloatLanes y = LoadLanes(&slice.candidateY[j]);
+			FloatLanes lightZ = LoadLanes(&slice.candidateZ[j]);
+			FloatLanes radius = LoadLanes(&slice.candidateRadius[j]);
+
+			// Closest point of the box to the center of the sphere, and how far it is.
+			FloatLanes dx = SubLanes(MaxLanes(minX, MinLanes(x, maxX)), x);
+			FloatLanes dy = SubLanes(MaxLanes(minY, MinLanes(y, maxY)), y);
+			FloatLanes dz = SubLanes(MaxLanes(minZ, MinLanes(lightZ, maxZ)), lightZ);
+			FloatLanes distanceSquared = AddLanes(AddLanes(MulLanes(dx, dx), MulLanes(dy, dy)), MulLanes(dz, dz));
+			int mask = MaskLanes(LessEqualLanes(distanceSquared, MulLanes(radius, radius)));
+
+			for (unsigned int lane = 0; mask != 0 && lane < LANE_COUNT; lane++)
+			{
+				if (mask & (1 << lane))
+				{
+					slice.indices.push_back(slice.candidates[j + lane]);
+					slice.counts[tile]++;
+				}
+			}
+		}
+	}
+}
+
+void ClusterGrid::AssignLightsReference(const GLfloat* x, const GLfloat* y, const GLfloat* z, const GLfloat* radius, unsigned int count)
+{
+	// (cluster, light) pairs, in the order we find them. Sorted into per cluster lists below.
+	std::vector<GLuint> pairClusters, pairLights;
+	std::vector<GLuint> clusterCounts(CLUSTER_COUNT, 0);
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		glm::vec3 viewPosition(x[i], y[i], z[i]);
+		GLfloat distance = -viewPosition.z;
+		if (radius[i] <= 0.0f || distance + radius[i] < nearPlane || distance - radius[i] > farPlane)
+		{
+			continue; // Nothing to light in front of the camera.
+		}
+
+		for (int c = 0; c < CLUSTER_COUNT; c++)
+		{
+			glm::vec3 boxMin(clusterMinX[c], clusterMinY[c], clusterMinZ[c]);
+			glm::vec3 boxMax(clusterMaxX[c], clusterMaxY[c], clusterMaxZ[c]);
+			glm::vec3 offset = glm::clamp(viewPosition, boxMin, boxMax) - viewPosition;
+			if (glm::dot(offset, offset) <= radius[i] * radius[i])
+			{
+				pairClusters.push_back(c);
+				pairLights.push_back(i);
+				clusterCounts[c]++;
+			}
+		}
+	}
+
+	clusterRanges.resize(CLUSTER_COUNT * 2);
+	GLuint offset = 0;
+	for (int c = 0; c < CLUSTER_COUNT; c++)
+	{
+		clusterRanges[c * 2] = offset;
+		clusterRanges[c * 2 + 1] = clusterCounts[c];
+		offset += clusterCounts[c];
+	}
+
+	// Filling the lists. clusterCounts is reused as how far along each list we are.
+	lightIndices.resize(offset);
+	std::fill(clusterCounts.begin(), clusterCounts.end(), 0);
+	for (size_t p = 0; p < pairLights.size(); p++)
+	{
+		GLuint c = pairClusters[p];
+		lightIndices[clusterRanges[c * 2] + clusterCounts[c]] = pairLights[p];
+		clusterCounts[c]++;
+	}
+}
+
+void ClusterGrid::Read(GLenum textureUnit)
+{
+	lightBuffer.Read(textureUnit);
+	rangeBuffer.Read(textureUnit + 1);
+	indexBuffer.Read(textureUnit + 2);
+}
+
+GLfloat ClusterGrid::GetTileWidth()
+{
+	return tileWidth;
+}
+
+GLfloat ClusterGrid::GetTileHeight()
+{
+	return tileHeight;
+}
+
+GLfloat ClusterGrid::GetDepthScale()
+{
+	return depthScale;
+}
+
+GLfloat ClusterGrid::GetDepthBias()
+{
+	return depthBias;
+}
+
+unsigned int ClusterGrid::GetLightCount()
+{
+	return lightCount;
+}
+
+unsigned int ClusterGrid::GetLightStride()
+{
+	return lightStride;
+}
+
+unsigned int ClusterGrid::GetIndexCount()
+{
+	return (unsigned int)lightIndices.size();
+}
+
+const std::vector<GLuint>& ClusterGrid::GetClusterRanges()
+{
+	return clusterRanges;
+}
+
+const std::vector<GLuint>& ClusterGrid::GetLightIndices()
+{
+	return lightIndices;
+}
+
+ClusterGrid::~ClusterGrid()
+{
+}
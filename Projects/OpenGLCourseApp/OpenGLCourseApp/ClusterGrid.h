@@ -0,0 +1,108 @@
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "CommonValues.h"
+#include "LightManager.h"
+#include "ThreadPool.h"
+#include "StreamingBuffer.h"
+
+// Clustered forward lighting. The camera frustum is cut in a grid of small boxes (clusters, or froxels), and every point light is
+// put in the list of each cluster its attenuation radius reaches. shader.frag finds the cluster of its fragment and only loops
+// over that list, so the cost of a fragment depends on how many lights are near it, not on how many lights there are.
+// Depth slices get exponentially thicker, so clusters stay roughly cube shaped far away.
+//
+// The assignment runs on the CPU, one depth slice per task on a ThreadPool, testing 8 lights at a time with AVX
+// (4 with SSE if the compiler isn't allowed AVX). Lights are read as separate arrays of x, y, z and radius for that.
+class ClusterGrid
+{
+	public:
+		ClusterGrid();
+
+		// Has to match the projection matrix of the camera. Without a thread pool, everything runs on the calling thread.
+		bool Init(GLfloat fieldOfView, GLfloat aspect, GLfloat nearPlane, GLfloat farPlane, GLuint screenWidth, GLuint screenHeight,
+			ThreadPool* threadPool = nullptr);
+
+		// The CPU side of Init, without any OpenGL. Enough to call AssignLights.
+		void BuildClusters(GLfloat fieldOfView, GLfloat aspect, GLfloat nearPlane, GLfloat farPlane, GLuint screenWidth, GLuint screenHeight);
+		void SetThreadPool(ThreadPool* threadPool);
+
+		// Puts the lights in the clusters they reach and uploads them and the lists. Call once per frame, after the lights and the camera moved.
+		void Update(LightManager* lights, glm::mat4 viewMatrix);
+
+		// Fills the cluster lists from view space light positions and radii. The SIMD, multithreaded version.
+		void AssignLights(const GLfloat* x, const GLfloat* y, const GLfloat* z, const GLfloat* radius, unsigned int count);
+		// Same result, one light and one cluster at a time. To check and time AssignLights against.
+		void AssignLightsReference(const GLfloat* x, const GLfloat* y, const GLfloat* z, const GLfloat* radius, unsigned int count);
+
+		// Binds the 3 buffer textures, on 3 texture units in a row starting at textureUnit.
+		void Read(GLenum textureUnit);
+
+		GLfloat GetTileWidth();
+		GLfloat GetTileHeight();
+
+		// Depth slice of a view space distance: log(distance) * depthScale - depthBias.
+		GLfloat GetDepthScale();
+		GLfloat GetDepthBias();
+
+		unsigned int GetLightCount(); // Lights uploaded by the last Update.
+		unsigned int GetLightStride(); // Texels between two planes of the light buffer. See LightManager::GetStride.
+		unsigned int GetIndexCount(); // Entries in all the cluster lists, from the last assignment.
+
+		// 2 per cluster: where its list starts in GetLightIndices, and how many lights are in it.
+		const std::vector<GLuint>& GetClusterRanges();
+		const std::vector<GLuint>& GetLightIndices();
+
+		~ClusterGrid();
+
+	private:
+		GLfloat nearPlane, farPlane;
+		GLfloat tileWidth, tileHeight; // In pixels.
+		GLfloat depthScale, depthBias;
+		GLfloat sliceDistances[CLUSTER_GRID_Z + 1]; // Where each depth slice starts, in front of the camera.
+
+		// Bounding box of each cluster in view space, one array per axis. Only depends on the projection, so built once.
+		std::vector<GLfloat> clusterMinX, clusterMinY, clusterMinZ, clusterMaxX, clusterMaxY, clusterMaxZ;
+
+		// Light positions in view space, worked out by Update. The radii are read straight from the LightManager.
+		std::vector<GLfloat> lightX, lightY, lightZ;
+
+		// What AssignLights was given, for the tasks.
+		const GLfloat* inputX;
+		const GLfloat* inputY;
+		const GLfloat* inputZ;
+		const GLfloat* inputRadius;
+
+		// What one task (one depth slice) found.
+		struct SliceResult
+		{
+			std::vector<GLuint> counts; // Lights in each cluster of the slice.
+			std::vector<GLuint> indices; // The lists of the slice's clusters, one after the other.
+
+			// Lights reaching the slice at all, packed together for the tests against each cluster.
+			std::vector<GLuint> candidates;
+			std::vector<GLfloat> candidateX, candidateY, candidateZ, candidateRadius;
+		};
+		SliceResult slices[CLUSTER_GRID_Z];
+
+		// What gets uploaded every frame.
+		std::vector<GLuint> clusterRanges;
+		std::vector<GLuint> lightIndices;
+
+		StreamingBuffer lightBuffer, rangeBuffer, indexBuffer;
+		ThreadPool* threadPool;
+
+		unsigned int lightCount, lightStride;
+		bool overflowReported; // Only complaining once when the index buffer is full.
+
+		int CalcDepthSlice(GLfloat distance);
+		void AssignSlice(int z, unsigned int count);
+};
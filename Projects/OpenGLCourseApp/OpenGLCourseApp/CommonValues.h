@@ -1,3 +1,102 @@
 #pragma once
 
-const int MAX_POINT_LIGHTS = 3;
\ No newline at end of file
+#include <stddef.h>
+
+const int MAX_POINT_LIGHTS = 3;
+
+// Clustered lighting. The camera frustum is cut in CLUSTER_GRID_X * CLUSTER_GRID_Y tiles on screen, and CLUSTER_GRID_Z depth slices.
+// Have to be the same values as in shader.frag.
+const int CLUSTER_GRID_X = 16;
+const int CLUSTER_GRID_Y = 9;
+const int CLUSTER_GRID_Z = 24;
+const int MAX_CLUSTERED_LIGHTS = 4096; // Unshadowed point lights, on top of the MAX_POINT_LIGHTS shadowed ones.
+const int MAX_CLUSTER_LIGHT_INDICES = CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z * 64; // Room in the per cluster light lists, all clusters together.
+
+// Materials live in one uniform buffer, see MaterialTable. A draw picks its material with the materialIndex vertex attribute.
+const int MAX_MATERIALS = 64; // Has to be the same value as in shader.frag and gbuffer.frag.
+const unsigned int MATERIAL_INDEX_ATTRIBUTE = 3; // After position, tex coordinates and normal. Has to match the shaders' layout locations.
+const unsigned int MATERIAL_BLOCK_BINDING = 0; // Uniform buffer binding point of the MaterialBlock.
+const unsigned int MATERIAL_TEXTURE_SIZE = 512; // Every material texture is resized to this, to fit in one TextureArray.
+
+// How Mesh stores its vertices on the GPU. Meshes are always made from 8 floats per vertex (position, UV, normal), and packed when uploaded.
+// The packed formats keep positions as 16 bits per axis in the mesh's box and UVs as half floats, 16 bytes per vertex instead of 32.
+// Every vertex shader that reads meshes decodes them, with the attributes Mesh::RenderMesh sets (see the ATTRIBUTE values below).
+enum VertexFormat
+{
+	VERTEX_FORMAT_FLOAT = 0, // 32 bytes. Float everything, like the course did.
+	VERTEX_FORMAT_PACKED_OCTAHEDRAL = 1, // 16 bytes. The normal folded onto an octahedron, 2 x 16 bits.
+	VERTEX_FORMAT_PACKED_10_10_10 = 2 // 16 bytes. The normal in GL_INT_2_10_10_10_REV, 10 bits per axis.
+};
+
+const VertexFormat VERTEX_FORMAT = VERTEX_FORMAT_PACKED_OCTAHEDRAL; // Format given to every new mesh.
+const unsigned int POSITION_SCALE_ATTRIBUTE = 4; // Size of the mesh's box. Packed positions are 0 to 1 in it.
+const unsigned int POSITION_OFFSET_ATTRIBUTE = 5; // Corner of the mesh's box.
+const unsigned int OCTAHEDRAL_NORMAL_ATTRIBUTE = 6; // 1 when the normal attribute holds an octahedral normal, 0 when it is x, y, z.
+
+// Meshes use 16 bit indices, half the bytes of 32 bit ones for the GPU to read. Past 65536 vertices, the triangles are cut into ranges
+// of up to 65536 vertices each, drawn one call each. Only if the ranges average at least this many triangles,
+// otherwise the extra draw calls cost more than the bytes saved and the mesh keeps 32 bit indices. See Mesh::SplitIndexRanges.
+const unsigned int MIN_INDEX_RANGE_TRIANGLES = 4096;
+
+// Levels of detail, see MeshSimplifier. Each level has about half the triangles of the one before, down to LOD_MIN_TRIANGLES.
+const unsigned int MAX_LODS = 8; // Levels per mesh, the full mesh included.
+const unsigned int LOD_MIN_TRIANGLES = 64;
+// Each object is drawn with the fewest triangles whose error, projected on the screen, stays under this many pixels. See Mesh::SelectLod.
+const float LOD_PIXEL_ERROR = 1.0f;
+// Shadow passes allow this many times more. A shadow is blurry and seen second hand, the mesh's outline against the light is all it shows.
+const float SHADOW_LOD_ERROR_SCALE = 4.0f;
+
+// How textures are kept on the GPU. The block compressed formats store 4x4 texels per block, see TextureCooker.
+enum TextureCompression
+{
+	TEXTURE_COMPRESSION_NONE = 0, // Plain RGBA8. 4 bytes per texel.
+	TEXTURE_COMPRESSION_BC1 = 1, // DXT1. RGB, 8 bytes per block: half a byte per texel.
+	TEXTURE_COMPRESSION_BC3 = 2 // DXT5. RGBA, 16 bytes per block: a byte per texel.
+};
+
+const TextureCompression MATERIAL_TEXTURE_COMPRESSION = TEXTURE_COMPRESSION_BC1; // The scene's textures have no use for alpha.
+
+// Texture streaming, see TextureStreamer. Textures start at a small level and get their finer levels once they are seen up close,
+// as long as everything fits in the budget.
+const size_t TEXTURE_MEMORY_BUDGET = 64 * 1024 * 1024; // Bytes of video memory the streamed textures may use.
+const unsigned int TEXTURE_STREAMING_FIRST_LEVEL = 4; // 32x32 for 512x512 layers.
+
+// Frames in a row TextureLoader tries to map a pixel buffer for the same chunk before it gives up on the layer.
+// The layer then keeps showing the placeholder.
+const unsigned int TEXTURE_UPLOAD_MAP_TRIES = 8;
+
+// How much each triangle counts towards the normals of its corners, see MeshProcessing::CalcNormals.
+enum NormalWeighting
+{
+	NORMAL_WEIGHT_EQUAL = 0, // Every triangle the same. What the course's CalcAverageNormals did.
+	NORMAL_WEIGHT_AREA = 1, // Bigger triangles count more, so thin bevels don't bend the normals of the big faces next to them.
+	NORMAL_WEIGHT_ANGLE = 2 // By the triangle's angle at that corner. The result doesn't depend on how a surface was cut into triangles.
+};
+
+// A point light stops at the distance where it adds less than this to every colour channel. See PointLight::CalcAttenuationRadius.
+// 1/256 is one step of an 8 bit colour channel, so past the radius the light could change a pixel by one step at most.
+const float LIGHT_CHANNEL_CUTOFF = 1.0f / 256.0f;
+
+// The highest specular intensity a material can have. Material clamps to it.
+// The light radius counts on it, since a highlight can be brighter than the diffuse light around it.
+const float MAX_SPECULAR_INTENSITY = 4.0f;
+
+// How a shadow map is stored and filtered. Values have to match the ones in shader.frag.
+enum ShadowFilterMode
+{
+	SHADOW_FILTER_PCF = 0, // Plain depth map. shader.frag takes 9 (directional) or 20 (omni) samples around the point.
+	SHADOW_FILTER_VSM = 1 // Variance shadow map. Depth moments, blurred and mipmapped once per update. shader.frag takes a single sample.
+};
+
+const ShadowFilterMode SHADOW_FILTER_MODE = SHADOW_FILTER_PCF; // Filter mode given to every new shadow map.
+
+// Precision of the shadow map textures. Lower tiers take less video memory and less bandwidth to write and read.
+// See ShadowMap::GetFormat for the formats of each tier, and ShadowMap::PrintQualityReport for what they cost.
+enum ShadowQuality
+{
+	SHADOW_QUALITY_LOW = 0, // 16 bit depth everywhere.
+	SHADOW_QUALITY_MEDIUM = 1, // 24 bit depth for directional maps, 16 bit linear distance for omni maps.
+	SHADOW_QUALITY_HIGH = 2 // 32 bit float depth everywhere.
+};
+
+const ShadowQuality SHADOW_QUALITY = SHADOW_QUALITY_MEDIUM; // Quality tier given to every new shadow map.
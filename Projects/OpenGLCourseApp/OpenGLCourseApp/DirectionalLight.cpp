@@ -1,5 +1,7 @@
 #include "DirectionalLight.h"
 
+#include "ShadowAtlas.h"
+
 DirectionalLight::DirectionalLight() : Light()
 {
 	direction = glm::vec3(0.0f, -1.0f, 0.0f); // by default, pointing straigth down.
@@ -24,6 +26,19 @@ glm::mat4 DirectionalLight::CalculateLightTransform()
 		glm::vec3(0.0f, 1.0f, 0.0f)); // could add a check to make sure this Up is correct if we are looking straight up or straight down.
 }
 
+GLfloat DirectionalLight::CalcShadowImportance(glm::vec3 cameraPosition, GLfloat fieldOfView)
+{
+	// Bounding sphere of the box lightProj covers. Has to match the values of glm::ortho in the constructor.
+	GLfloat halfWidth = 20.0f, nearPlane = 0.1f, farPlane = 100.0f;
+	GLfloat halfDepth = (farPlane - nearPlane) * 0.5f;
+
+	glm::vec3 lightDirection = glm::normalize(direction);
+	glm::vec3 center = -direction + lightDirection * (nearPlane + halfDepth); // The light "sits" at -direction, see CalculateLightTransform.
+	GLfloat radius = sqrtf(halfWidth * halfWidth * 2.0f + halfDepth * halfDepth);
+
+	return ShadowAtlas::CalcScreenImportance(center, radius, cameraPosition, fieldOfView);
+}
+
 void DirectionalLight::UseLight(GLfloat ambientIntensityLocation, GLfloat ambientColourLocation, GLfloat diffuseIntensityLocation, GLfloat directionLocation)
 {
 	glUniform3f(ambientColourLocation, colour.x, colour.y, colour.z);
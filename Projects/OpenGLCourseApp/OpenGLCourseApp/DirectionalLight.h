@@ -13,6 +13,9 @@ class DirectionalLight : public Light
 
         glm::mat4 CalculateLightTransform();
 
+        // How much of the screen this light's shadow covers, between 0 and 1. Used to size its tile in a ShadowAtlas.
+        GLfloat CalcShadowImportance(glm::vec3 cameraPosition, GLfloat fieldOfView);
+
         // NOTE: For location variables, it should be GLuint. Float works but is not... appropriate.
         void UseLight(GLfloat ambientIntensityLocation, GLfloat ambientColourLocation,
             GLfloat diffuseIntensityLocation, GLfloat directionLocation);
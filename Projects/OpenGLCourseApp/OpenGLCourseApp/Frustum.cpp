@@ -0,0 +1,48 @@
+#include "Frustum.h"
+
+Frustum::Frustum()
+{
+	for (size_t i = 0; i < 6; i++)
+	{
+		planes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f); // Everything is inside until Update is called.
+	}
+}
+
+void Frustum::Update(glm::mat4 viewProjection)
+{
+	// A point is inside when -w <= x, y, z <= w in clip space. Each of those 6 checks is a plane, made by adding or
+	// subtracting a row of the matrix to the last row. glm is column major, so a row is m[0][i], m[1][i], m[2][i], m[3][i].
+	glm::vec4 rowX(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+	glm::vec4 rowY(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+	glm::vec4 rowZ(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+	glm::vec4 rowW(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+	planes[0] = rowW + rowX; // Left
+	planes[1] = rowW - rowX; // Right
+	planes[2] = rowW + rowY; // Bottom
+	planes[3] = rowW - rowY; // Top
+	planes[4] = rowW + rowZ; // Near
+	planes[5] = rowW - rowZ; // Far
+
+	// Normalizing, so the plane equation gives a real distance we can compare to a radius.
+	for (size_t i = 0; i < 6; i++)
+	{
+		planes[i] /= glm::length(glm::vec3(planes[i]));
+	}
+}
+
+bool Frustum::SphereVisible(glm::vec3 center, GLfloat radius)
+{
+	for (size_t i = 0; i < 6; i++)
+	{
+		if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius)
+		{
+			return false; // Completely behind one of the planes.
+		}
+	}
+	return true;
+}
+
+Frustum::~Frustum()
+{
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+// The 6 planes of what a camera can see. Used to skip things that are off screen.
+class Frustum
+{
+	public:
+		Frustum();
+
+		// Takes the planes out of projection * view.
+		void Update(glm::mat4 viewProjection);
+
+		// True if any part of the sphere can be inside the frustum. Can say true for a few spheres that are just outside the corners.
+		bool SphereVisible(glm::vec3 center, GLfloat radius);
+
+		~Frustum();
+
+	private:
+		glm::vec4 planes[6]; // xyz is the normal, pointing inside. w is the distance. Left, right, bottom, top, near, far.
+};
@@ -0,0 +1,105 @@
+#include "GBuffer.h"
+
+GBuffer::GBuffer()
+{
+	FBO = 0;
+	albedoMap = 0;
+	normalMap = 0;
+	depthMap = 0;
+	width = 0;
+	height = 0;
+}
+
+bool GBuffer::Init(unsigned int width, unsigned int height)
+{
+	this->width = width;
+	this->height = height;
+
+	glGenFramebuffers(1, &FBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+
+	// Nearest filtering everywhere. Each pixel only reads its own texel, so nothing gets blended between objects.
+	glGenTextures(1, &albedoMap);
+	glBindTexture(GL_TEXTURE_2D, albedoMap);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, albedoMap, 0);
+
+	glGenTextures(1, &normalMap);
+	glBindTexture(GL_TEXTURE_2D, normalMap);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normalMap, 0);
+
+	glGenTextures(1, &depthMap);
+	glBindTexture(GL_TEXTURE_2D, depthMap);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthMap, 0);
+
+	// gbuffer.frag writes to both colour attachments.
+	GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glDrawBuffers(2, drawBuffers);
+
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		printf("G-buffer Framebuffer Error: %i\n", status);
+		return false;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	return true;
+}
+
+void GBuffer::Write()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+}
+
+void GBuffer::Read(GLenum textureUnit)
+{
+	glActiveTexture(textureUnit);
+	glBindTexture(GL_TEXTURE_2D, albedoMap);
+	glActiveTexture(textureUnit + 1);
+	glBindTexture(GL_TEXTURE_2D, normalMap);
+	glActiveTexture(textureUnit + 2);
+	glBindTexture(GL_TEXTURE_2D, depthMap);
+}
+
+void GBuffer::BlitDepth()
+{
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, FBO);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+GLuint GBuffer::GetWidth()
+{
+	return width;
+}
+
+GLuint GBuffer::GetHeight()
+{
+	return height;
+}
+
+GBuffer::~GBuffer()
+{
+	if (FBO)
+	{
+		glDeleteFramebuffers(1, &FBO);
+	}
+	if (albedoMap)
+	{
+		glDeleteTextures(1, &albedoMap);
+		glDeleteTextures(1, &normalMap);
+		glDeleteTextures(1, &depthMap);
+	}
+}
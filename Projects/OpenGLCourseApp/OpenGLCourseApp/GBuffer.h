@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdio.h>
+
+#include <GL/glew.h>
+
+// Geometry buffer for deferred shading. The scene is drawn once into it, storing what the lighting needs for every pixel.
+// The lights are then drawn on top of it, each only over the pixels it reaches, instead of shading every fragment of every object.
+// Albedo:   RGBA8.   rgb is the colour of theTexture, a is the material shininess / 256.
+// Normal:   RGBA16F. xyz is the world space normal, w the material specular intensity.
+// Depth:    DEPTH24_STENCIL8. The world position is rebuilt from it. Same format as the window, so it can be blitted there.
+class GBuffer
+{
+	public:
+		GBuffer();
+
+		bool Init(unsigned int width, unsigned int height);
+
+		void Write();
+
+		// Binds albedo, normal and depth on 3 texture units in a row, starting at textureUnit.
+		void Read(GLenum textureUnit);
+
+		// Copies the depth into the window's frame buffer, so light volumes can be depth tested against the scene.
+		void BlitDepth();
+
+		GLuint GetWidth();
+		GLuint GetHeight();
+
+		~GBuffer();
+
+	private:
+		GLuint FBO;
+		GLuint albedoMap, normalMap, depthMap;
+		GLuint width, height;
+};
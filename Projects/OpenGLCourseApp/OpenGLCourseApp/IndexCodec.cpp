@@ -0,0 +1,136 @@
+#include "IndexCodec.h"
+
+// Zigzag: the sign goes in the lowest bit, so small negative differences stay small numbers.
+static inline unsigned int ZigzagEncode(unsigned int delta)
+{
+	return (delta << 1) ^ (0u - (delta >> 31));
+}
+
+static inline unsigned int ZigzagDecode(unsigned int value)
+{
+	return (value >> 1) ^ (0u - (value & 1));
+}
+
+void IndexCodec::Encode(const unsigned int* indices, unsigned int indexCount, std::vector<unsigned char>& encoded)
+{
+	size_t controlSize = ((size_t)indexCount + 3) / 4;
+	encoded.assign(controlSize, 0);
+	encoded.reserve(controlSize + (size_t)indexCount * 2);
+
+	unsigned int previous = 0;
+	for (unsigned int i = 0; i < indexCount; i++)
+	{
+		// Differences wrap around like unsigned numbers do, and decoding wraps them back the same way.
+		unsigned int value = ZigzagEncode(indices[i] - previous);
+		previous = indices[i];
+
+		unsigned int length = value < (1u << 8) ? 1 : value < (1u << 16) ? 2 : value < (1u << 24) ? 3 : 4;
+		encoded[i / 4] |= (unsigned char)((length - 1) << ((i % 4) * 2));
+		for (unsigned int b = 0; b < length; b++)
+		{
+			encoded.push_back((unsigned char)(value >> (b * 8)));
+		}
+	}
+}
+
+bool IndexCodec::DecodeScalar(const unsigned char* controls, const unsigned char* values, const unsigned char* end, unsigned int* indices,
+	unsigned int first, unsigned int indexCount, unsigned int previous)
+{
+	for (unsigned int i = first; i < indexCount; i++)
+	{
+		unsigned int length = ((controls[i / 4] >> ((i % 4) * 2)) & 3) + 1;
+		if ((size_t)(end - values) < length)
+		{
+			return false;
+		}
+
+		unsigned int value = 0;
+		for (unsigned int b = 0; b < length; b++)
+		{
+			value |= (unsigned int)values[b] << (b * 8);
+		}
+		values += length;
+
+		previous += ZigzagDecode(value);
+		indices[i] = previous;
+	}
+
+	// Bytes left over mean the counts don't match the data.
+	return values == end;
+}
+
+bool IndexCodec::DecodeReference(const unsigned char* data, size_t size, unsigned int* indices, unsigned int indexCount)
+{
+	size_t controlSize = ((size_t)indexCount + 3) / 4;
+	if (size < controlSize)
+	{
+		return false;
+	}
+	return DecodeScalar(data, data + controlSize, data + size, indices, 0, indexCount, 0);
+}
+
+#if defined(__AVX__)
+// For each control byte, where each of the 4 values' bytes are in the next 16 bytes of data. 0x80 makes a byte 0.
+struct DecodeTables
+{
+	__m128i shuffles[256];
+	unsigned char lengths[256]; // Data bytes the 4 values take.
+
+	DecodeTables()
+	{
+		for (unsigned int control = 0; control < 256; control++)
+		{
+			unsigned char shuffle[16];
+			unsigned char source = 0;
+			for (unsigned int lane = 0; lane < 4; lane++)
+			{
+				unsigned int length = ((control >> (lane * 2)) & 3) + 1;
+				for (unsigned int b = 0; b < 4; b++)
+				{
+					shuffle[lane * 4 + b] = b < length ? source++ : 0x80;
+				}
+			}
+			shuffles[control] = _mm_loadu_si128((const __m128i*)shuffle);
+			lengths[control] = source;
+		}
+	}
+};
+#endif
+
+bool IndexCodec::Decode(const unsigned char* data, size_t size, unsigned int* indices, unsigned int indexCount)
+{
+#if defined(__AVX__)
+	static const DecodeTables tables; // Made on the first call. C++11 makes that safe from several threads.
+
+	size_t controlSize = ((size_t)indexCount + 3) / 4;
+	if (size < controlSize)
+	{
+		return false;
+	}
+	const unsigned char* values = data + controlSize;
+	const unsigned char* end = data + size;
+
+	const __m128i one = _mm_set1_epi32(1);
+	__m128i previous = _mm_setzero_si128(); // The last index decoded, in all 4 lanes.
+	unsigned int group = 0;
+	// Whole groups of 4, while there are 16 bytes to load. The rest goes one at a time, so nothing is read past the end.
+	for (; group < indexCount / 4 && end - values >= 16; group++)
+	{
+		unsigned char control = data[group];
+		__m128i value = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)values), tables.shuffles[control]);
+		values += tables.lengths[control];
+
+		__m128i delta = _mm_xor_si128(_mm_srli_epi32(value, 1), _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(value, one)));
+		// Running sum across the lanes: each lane adds the one before it, then the 2 before that.
+		delta = _mm_add_epi32(delta, _mm_slli_si128(delta, 4));
+		delta = _mm_add_epi32(delta, _mm_slli_si128(delta, 8));
+		__m128i result = _mm_add_epi32(delta, previous);
+		_mm_storeu_si128((__m128i*)(indices + group * 4), result);
+		previous = _mm_shuffle_epi32(result, _MM_SHUFFLE(3, 3, 3, 3));
+	}
+
+	return DecodeScalar(data, values, end, indices, group * 4, indexCount, (unsigned int)_mm_cvtsi128_si32(previous));
+#else
+	return DecodeReference(data, size, indices, indexCount);
+#endif
+}
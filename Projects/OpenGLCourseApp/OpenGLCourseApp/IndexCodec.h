@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+// Squeezes index buffers for storing on disk (see MeshFile). Under 1.5 bytes per index for a mesh in MeshOptimizer's order, instead of 4.
+//
+// Each index is stored as the difference from the one before, which is small when triangles near each other share vertices.
+// Differences can be negative, so they are zigzagged: 0, -1, 1, -2, 2... become 0, 1, 2, 3, 4..., small either way.
+// Then each value takes only the bytes it needs, 1 to 4, with its length in 2 bits of a control byte (Stream VByte, Lemire and Kurz, 2017).
+// All the control bytes come first, then all the value bytes. One control byte covers 4 values, so with SSSE3 (any AVX CPU) they are
+// decoded 4 at a time: one shuffle moves each value's bytes into its own lane, and 2 shifted adds undo the differences.
+class IndexCodec
+{
+	public:
+		static void Encode(const unsigned int* indices, unsigned int indexCount, std::vector<unsigned char>& encoded);
+
+		// Fails when data isn't exactly indexCount encoded indices.
+		static bool Decode(const unsigned char* data, size_t size, unsigned int* indices, unsigned int indexCount);
+
+		// One value at a time. What Decode does when there is no SSSE3, and for the last values. Kept for the benchmark.
+		static bool DecodeReference(const unsigned char* data, size_t size, unsigned int* indices, unsigned int indexCount);
+
+	private:
+		// Decodes values first to indexCount - 1, carrying on from previous. controls and values point where value first's bytes are.
+		static bool DecodeScalar(const unsigned char* controls, const unsigned char* values, const unsigned char* end, unsigned int* indices,
+			unsigned int first, unsigned int indexCount, unsigned int previous);
+};
@@ -11,6 +11,7 @@ Light::Light()
 
 	shadowHeight = 0;
 	shadowWidth = 0;
+	castsShadows = true;
 }
 
 Light::Light(GLfloat pShadowWidth, GLfloat pShadowHeight,
@@ -26,6 +27,7 @@ Light::Light(GLfloat pShadowWidth, GLfloat pShadowHeight,
 	this->shadowWidth = pShadowWidth;
 
 	shadowMap = 0;
+	castsShadows = true;
 }
 
 void Light::InitShadowMap()
@@ -40,11 +42,63 @@ void Light::InitShadowMap()
 	shadowMap->Init(shadowWidth, shadowHeight);
 }
 
+void Light::InitShadowMap(ShadowAtlas* atlas)
+{
+	if (shadowWidth == 0 ||
+		shadowHeight == 0)
+	{
+		throw std::invalid_argument("Shadow map has no height or width!!!");
+	}
+	shadowMap = new AtlasShadowMap(atlas);
+
+	shadowMap->Init(shadowWidth, shadowHeight);
+}
+
 ShadowMap* Light::GetShadowMap()
 {
 	return shadowMap;
 }
 
+void Light::SetShadowMap(ShadowMap* newShadowMap)
+{
+	shadowMap = newShadowMap;
+}
+
+GLuint Light::GetShadowWidth()
+{
+	return (GLuint)shadowWidth;
+}
+
+GLuint Light::GetShadowHeight()
+{
+	return (GLuint)shadowHeight;
+}
+
+void Light::SetCastsShadows(bool casts)
+{
+	castsShadows = casts;
+}
+
+bool Light::GetCastsShadows()
+{
+	return castsShadows;
+}
+
+glm::vec3 Light::GetColour()
+{
+	return colour;
+}
+
+GLfloat Light::GetAmbientIntensity()
+{
+	return ambientIntensity;
+}
+
+GLfloat Light::GetDiffuseIntensity()
+{
+	return diffuseIntensity;
+}
+
 Light::~Light() 
 {
 }
@@ -7,6 +7,7 @@
 #include <stdexcept>
 
 #include "ShadowMap.h"
+#include "AtlasShadowMap.h"
 
 class Light
 {
@@ -17,7 +18,19 @@ class Light
 		~Light();
 
 		void InitShadowMap();
+		void InitShadowMap(ShadowAtlas* atlas); // Shadow map in a tile of the atlas, instead of its own texture.
 		ShadowMap* GetShadowMap();
+		void SetShadowMap(ShadowMap* newShadowMap); // For maps owned by someone else, like a ShadowMapPool. The light won't delete it.
+
+		GLuint GetShadowWidth();
+		GLuint GetShadowHeight();
+
+		void SetCastsShadows(bool casts);
+		bool GetCastsShadows();
+
+		glm::vec3 GetColour();
+		GLfloat GetAmbientIntensity();
+		GLfloat GetDiffuseIntensity();
 
 	protected:
 		glm::vec3 colour; // Here, those values dont really represent color. They represent HOW MUCH of each color is shown when the light hits them.
@@ -30,5 +43,6 @@ class Light
 		ShadowMap* shadowMap;
 		GLfloat shadowWidth;
 		GLfloat shadowHeight;
+		bool castsShadows; // False to never give this light a shadow map.
 };
 
@@ -0,0 +1,270 @@
+#include "LightManager.h"
+
+#include "SimdLanes.h"
+
+static const unsigned int STARTING_STRIDE = 64;
+
+const GLuint LightManager::INVALID_SLOT;
+
+LightManager::LightManager(unsigned int maxLights)
+{
+	this->maxLights = maxLights;
+	lightCount = 0;
+	stride = 0;
+}
+
+GLfloat* LightManager::Plane(int plane)
+{
+	return &planes[plane * stride];
+}
+
+void LightManager::Grow()
+{
+	unsigned int newStride = stride == 0 ? std::min(STARTING_STRIDE, maxLights) : std::min(stride * 2, maxLights);
+
+	// Each plane moves to its new start. The unused end of each plane is left at 0.
+	std::vector<GLfloat> newPlanes(LIGHT_PLANE_COUNT * newStride, 0.0f);
+	for (int plane = 0; plane < LIGHT_PLANE_COUNT; plane++)
+	{
+		if (lightCount > 0)
+		{
+			memcpy(&newPlanes[plane * newStride], Plane(plane), lightCount * sizeof(GLfloat));
+		}
+	}
+	planes.swap(newPlanes);
+	stride = newStride;
+
+	velocityX.resize(stride, 0.0f);
+	velocityY.resize(stride, 0.0f);
+	velocityZ.resize(stride, 0.0f);
+	lightSlots.resize(stride, INVALID_SLOT);
+}
+
+LightHandle LightManager::AddPointLight(glm::vec3 position, glm::vec3 colour, GLfloat ambientIntensity, GLfloat diffuseIntensity,
+	GLfloat constant, GLfloat linear, GLfloat exponent)
+{
+	LightHandle handle = { INVALID_SLOT, 0 };
+	if (lightCount >= maxLights)
+	{
+		return handle;
+	}
+	if (lightCount >= stride)
+	{
+		Grow();
+	}
+
+	// New lights go at the end.
+	unsigned int light = lightCount++;
+	Plane(LIGHT_POSITION_X)[light] = position.x;
+	Plane(LIGHT_POSITION_Y)[light] = position.y;
+	Plane(LIGHT_POSITION_Z)[light] = position.z;
+	Plane(LIGHT_RADIUS)[light] = PointLight::CalcAttenuationRadius(colour, ambientIntensity, diffuseIntensity, constant, linear, exponent);
+	Plane(LIGHT_COLOUR_R)[light] = colour.r;
+	Plane(LIGHT_COLOUR_G)[light] = colour.g;
+	Plane(LIGHT_COLOUR_B)[light] = colour.b;
+	Plane(LIGHT_AMBIENT_INTENSITY)[light] = ambientIntensity;
+	Plane(LIGHT_DIFFUSE_INTENSITY)[light] = diffuseIntensity;
+	Plane(LIGHT_CONSTANT)[light] = constant;
+	Plane(LIGHT_LINEAR)[light] = linear;
+	Plane(LIGHT_EXPONENT)[light] = exponent;
+	velocityX[light] = 0.0f;
+	velocityY[light] = 0.0f;
+	velocityZ[light] = 0.0f;
+
+	// Reusing a free slot if there is one.
+	if (!freeSlots.empty())
+	{
+		handle.slot = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else
+	{
+		handle.slot = (GLuint)slotLights.size();
+		slotLights.push_back(0);
+		slotGenerations.push_back(0);
+	}
+	handle.generation = slotGenerations[handle.slot];
+	slotLights[handle.slot] = light;
+	lightSlots[light] = handle.slot;
+
+	return handle;
+}
+
+void LightManager::RemovePointLight(LightHandle handle)
+{
+	if (!IsValid(handle))
+	{
+		return;
+	}
+
+	// Moving the last light into the hole, so the planes stay packed.
+	unsigned int light = slotLights[handle.slot];
+	unsigned int last = lightCount - 1;
+	if (light != last)
+	{
+		for (int plane = 0; plane < LIGHT_PLANE_COUNT; plane++)
+		{
+			Plane(plane)[light] = Plane(plane)[last];
+		}
+		velocityX[light] = velocityX[last];
+		velocityY[light] = velocityY[last];
+		velocityZ[light] = velocityZ[last];
+
+		lightSlots[light] = lightSlots[last];
+		slotLights[lightSlots[light]] = light;
+	}
+	lightCount--;
+
+	slotGenerations[handle.slot]++; // Old handles to this slot are no longer valid.
+	freeSlots.push_back(handle.slot);
+}
+
+bool LightManager::IsValid(LightHandle handle)
+{
+	// Removing bumps the generation, so a free slot never matches a handle that is still around.
+	return handle.slot < slotGenerations.size() && slotGenerations[handle.slot] == handle.generation;
+}
+
+glm::vec3 LightManager::GetPosition(LightHandle handle)
+{
+	if (!IsValid(handle))
+	{
+		return glm::vec3(0.0f, 0.0f, 0.0f);
+	}
+	unsigned int light = slotLights[handle.slot];
+	return glm::vec3(Plane(LIGHT_POSITION_X)[light], Plane(LIGHT_POSITION_Y)[light], Plane(LIGHT_POSITION_Z)[light]);
+}
+
+void LightManager::SetPosition(LightHandle handle, glm::vec3 position)
+{
+	if (!IsValid(handle))
+	{
+		return;
+	}
+	unsigned int light = slotLights[handle.slot];
+	Plane(LIGHT_POSITION_X)[light] = position.x;
+	Plane(LIGHT_POSITION_Y)[light] = position.y;
+	Plane(LIGHT_POSITION_Z)[light] = position.z;
+}
+
+void LightManager::SetVelocity(LightHandle handle, glm::vec3 velocity)
+{
+	if (!IsValid(handle))
+	{
+		return;
+	}
+	unsigned int light = slotLights[handle.slot];
+	velocityX[light] = velocity.x;
+	velocityY[light] = velocity.y;
+	velocityZ[light] = velocity.z;
+}
+
+// One axis of Integrate. Past a side of the box, the light is put back on it and turned around.
+static void IntegrateAxis(GLfloat* position, GLfloat* velocity, unsigned int count, GLfloat deltaTime, GLfloat boundsMin, GLfloat boundsMax)
+{
+	FloatLanes zero = SetLanes(0.0f);
+	FloatLanes time = SetLanes(deltaTime);
+	FloatLanes low = SetLanes(boundsMin);
+	FloatLanes high = SetLanes(boundsMax);
+
+	unsigned int i = 0;
+	for (; i + LANE_COUNT <= count; i += LANE_COUNT)
+	{
+		FloatLanes v = LoadLanes(velocity + i);
+		FloatLanes p = AddLanes(LoadLanes(position + i), MulLanes(v, time));
+		FloatLanes outside = OrLanes(LessLanes(p, low), LessLanes(high, p));
+		StoreLanes(velocity + i, SelectLanes(outside, SubLanes(zero, v), v));
+		StoreLanes(position + i, MinLanes(MaxLanes(p, low), high));
+	}
+	for (; i < count; i++) // The last few, that don't fill the lanes.
+	{
+		GLfloat p = position[i] + velocity[i] * deltaTime;
+		if (p < boundsMin || boundsMax < p)
+		{
+			velocity[i] = -velocity[i];
+		}
+		position[i] = std::min(std::max(p, boundsMin), boundsMax);
+	}
+}
+
+void LightManager::Integrate(GLfloat deltaTime, glm::vec3 boundsMin, glm::vec3 boundsMax)
+{
+	if (lightCount == 0)
+	{
+		return;
+	}
+
+	IntegrateAxis(Plane(LIGHT_POSITION_X), velocityX.data(), lightCount, deltaTime, boundsMin.x, boundsMax.x);
+	IntegrateAxis(Plane(LIGHT_POSITION_Y), velocityY.data(), lightCount, deltaTime, boundsMin.y, boundsMax.y);
+	IntegrateAxis(Plane(LIGHT_POSITION_Z), velocityZ.data(), lightCount, deltaTime, boundsMin.z, boundsMax.z);
+}
+
+void LightManager::TransformPositions(const glm::mat4& matrix, GLfloat* x, GLfloat* y, GLfloat* z)
+{
+	if (lightCount == 0)
+	{
+		return;
+	}
+
+	const GLfloat* inX = Plane(LIGHT_POSITION_X);
+	const GLfloat* inY = Plane(LIGHT_POSITION_Y);
+	const GLfloat* inZ = Plane(LIGHT_POSITION_Z);
+
+	// glm matrices are column major: matrix[column][row].
+	FloatLanes m[4][3];
+	for (int column = 0; column < 4; column++)
+	{
+		for (int row = 0; row < 3; row++)
+		{
+			m[column][row] = SetLanes(matrix[column][row]);
+		}
+	}
+
+	unsigned int i = 0;
+	for (; i + LANE_COUNT <= lightCount; i += LANE_COUNT)
+	{
+		FloatLanes px = LoadLanes(inX + i), py = LoadLanes(inY + i), pz = LoadLanes(inZ + i);
+		StoreLanes(x + i, AddLanes(AddLanes(MulLanes(m[0][0], px), MulLanes(m[1][0], py)), AddLanes(MulLanes(m[2][0], pz), m[3][0])));
+		StoreLanes(y + i, AddLanes(AddLanes(MulLanes(m[0][1], px), MulLanes(m[1][1], py)), AddLanes(MulLanes(m[2][1], pz), m[3][1])));
+		StoreLanes(z + i, AddLanes(AddLanes(MulLanes(m[0][2], px), MulLanes(m[1][2], py)), AddLanes(MulLanes(m[2][2], pz), m[3][2])));
+	}
+	for (; i < lightCount; i++)
+	{
+		glm::vec3 transformed = glm::vec3(matrix * glm::vec4(inX[i], inY[i], inZ[i], 1.0f));
+		x[i] = transformed.x;
+		y[i] = transformed.y;
+		z[i] = transformed.z;
+	}
+}
+
+const GLfloat* LightManager::GetPlane(LightPlane plane)
+{
+	return stride > 0 ? Plane(plane) : nullptr;
+}
+
+unsigned int LightManager::GetLightCount()
+{
+	return lightCount;
+}
+
+unsigned int LightManager::GetStride()
+{
+	return stride;
+}
+
+size_t LightManager::GetGPUDataSize()
+{
+	return planes.size() * sizeof(GLfloat);
+}
+
+void LightManager::CopyGPUData(void* destination)
+{
+	if (!planes.empty())
+	{
+		memcpy(destination, planes.data(), planes.size() * sizeof(GLfloat));
+	}
+}
+
+LightManager::~LightManager()
+{
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "CommonValues.h"
+#include "PointLight.h"
+
+// The values of a light, one array (plane) each. Have to be the same values as in shader.frag and deferred_point.*
+enum LightPlane
+{
+	LIGHT_POSITION_X = 0,
+	LIGHT_POSITION_Y,
+	LIGHT_POSITION_Z,
+	LIGHT_RADIUS,
+	LIGHT_COLOUR_R,
+	LIGHT_COLOUR_G,
+	LIGHT_COLOUR_B,
+	LIGHT_AMBIENT_INTENSITY,
+	LIGHT_DIFFUSE_INTENSITY,
+	LIGHT_CONSTANT,
+	LIGHT_LINEAR,
+	LIGHT_EXPONENT,
+	LIGHT_PLANE_COUNT
+};
+
+// Names a light of a LightManager. Stays valid while the light exists, even when removing other lights moves it around.
+struct LightHandle
+{
+	GLuint slot;
+	GLuint generation; // Goes up every time the slot is reused, so handles to a removed light are refused.
+};
+
+// Lots of unshadowed point lights, stored as structure of arrays: all the x positions together, then all the y positions...
+// Going over thousands of lights then reads whole cache lines of useful values, and 8 lights fit in one AVX register.
+//
+// The planes sit one after the other in a single block, with the same layout the GPU reads from the cluster light buffer.
+// So uploading every light is one memcpy, no packing.
+class LightManager
+{
+	public:
+		// Never holds more than maxLights, AddPointLight refuses past that.
+		LightManager(unsigned int maxLights = MAX_CLUSTERED_LIGHTS);
+
+		// Returns a handle with slot INVALID_SLOT when full.
+		LightHandle AddPointLight(glm::vec3 position, glm::vec3 colour, GLfloat ambientIntensity, GLfloat diffuseIntensity,
+			GLfloat constant, GLfloat linear, GLfloat exponent);
+		void RemovePointLight(LightHandle handle);
+		bool IsValid(LightHandle handle);
+
+		glm::vec3 GetPosition(LightHandle handle);
+		void SetPosition(LightHandle handle, glm::vec3 position);
+		void SetVelocity(LightHandle handle, glm::vec3 velocity); // In units per second, used by Integrate.
+
+		// Moves every light by its velocity. Lights bounce off the sides of the box. 8 lights at a time (4 with SSE).
+		void Integrate(GLfloat deltaTime, glm::vec3 boundsMin, glm::vec3 boundsMax);
+
+		// Writes every light position multiplied by matrix, e.g. in view space. Same lanes as Integrate.
+		void TransformPositions(const glm::mat4& matrix, GLfloat* x, GLfloat* y, GLfloat* z);
+
+		const GLfloat* GetPlane(LightPlane plane); // GetLightCount values, then unused space up to GetStride.
+		unsigned int GetLightCount();
+		unsigned int GetStride(); // Values from the start of one plane to the start of the next.
+
+		// All the planes, as the GPU reads them.
+		size_t GetGPUDataSize(); // In bytes.
+		void CopyGPUData(void* destination);
+
+		static const GLuint INVALID_SLOT = 0xFFFFFFFF;
+
+		~LightManager();
+
+	private:
+		std::vector<GLfloat> planes; // LIGHT_PLANE_COUNT planes of stride values, one after the other.
+		std::vector<GLfloat> velocityX, velocityY, velocityZ; // Only the CPU needs these, so they are not in planes.
+
+		unsigned int lightCount, stride, maxLights;
+
+		// Handles point at a slot, the slot at where the light is in the planes. Removing a light moves the last one into its place.
+		std::vector<GLuint> slotLights; // Slot to light.
+		std::vector<GLuint> slotGenerations;
+		std::vector<GLuint> lightSlots; // Light to slot, to fix the slot of the light that moved.
+		std::vector<GLuint> freeSlots;
+
+		GLfloat* Plane(int plane);
+		void Grow(); // Doubles stride. Every plane moves, handles stay the same.
+};
@@ -8,7 +8,7 @@ Material::Material()
 
 Material::Material(GLfloat specIntensity, GLfloat shine)
 {
-	specularIntensity = specIntensity;
+	specularIntensity = std::min(specIntensity, MAX_SPECULAR_INTENSITY); // The light radius is worked out for this much at most. See PointLight::CalcAttenuationRadius.
 	shininess = shine;
 }
 
@@ -17,3 +17,13 @@ void Material::UseMaterial(GLuint specularIntensityLocation, GLuint shininessLoc
 	glUniform1f(specularIntensityLocation, specularIntensity);
 	glUniform1f(shininessLocation, shininess);
 }
+
+GLfloat Material::GetSpecularIntensity()
+{
+	return specularIntensity;
+}
+
+GLfloat Material::GetShininess()
+{
+	return shininess;
+}
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <algorithm>
+
 #include <GL/glew.h>
 
+#include "CommonValues.h"
+
 
 class Material
 {
@@ -10,6 +14,9 @@ class Material
 		Material(GLfloat specIntensity, GLfloat shine);
 
 		void UseMaterial(GLuint specularIntensityLocation, GLuint shininessLocation);
+
+		GLfloat GetSpecularIntensity();
+		GLfloat GetShininess();
 	private:
 		GLfloat specularIntensity; // How bright the light is on the material.
 		GLfloat shininess; // How smooth the surface is protrayed as. Smaller = more spread out light (rough surface). Higher = Bright and intense points of light, like metal
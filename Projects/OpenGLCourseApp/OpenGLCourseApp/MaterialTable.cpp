@@ -0,0 +1,76 @@
+#include "MaterialTable.h"
+
+MaterialTable::MaterialTable()
+{
+	UBO = 0;
+}
+
+bool MaterialTable::Init()
+{
+	// One vec4 per material, as std140 lays out an array of vec4 in the shaders.
+	glGenBuffers(1, &UBO);
+	glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+	glBufferData(GL_UNIFORM_BUFFER, MAX_MATERIALS * sizeof(glm::vec4), nullptr, GL_STATIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	return UBO != 0;
+}
+
+GLuint MaterialTable::AddMaterial(Material* material, GLuint textureLayer)
+{
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		if (entries[i].material == material && entries[i].textureLayer == textureLayer)
+		{
+			return (GLuint)i;
+		}
+	}
+
+	if (entries.size() >= (size_t)MAX_MATERIALS)
+	{
+		printf("Material table is full, %d materials. Using material 0 instead.\n", MAX_MATERIALS);
+		return 0;
+	}
+
+	Entry entry = { material, textureLayer };
+	entries.push_back(entry);
+	return (GLuint)(entries.size() - 1);
+}
+
+void MaterialTable::Upload(TextureArray* textures)
+{
+	// x: specular intensity, y: shininess, z: texture layer. w is unused.
+	std::vector<glm::vec4> data(entries.size());
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		GLuint textureLayer = textures ? textures->GetVisibleLayer(entries[i].textureLayer) : entries[i].textureLayer;
+		data[i] = glm::vec4(entries[i].material->GetSpecularIntensity(), entries[i].material->GetShininess(), (GLfloat)textureLayer, 0.0f);
+	}
+
+	glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+	if (!data.empty())
+	{
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, data.size() * sizeof(glm::vec4), data.data());
+	}
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	glBindBufferBase(GL_UNIFORM_BUFFER, MATERIAL_BLOCK_BINDING, UBO);
+}
+
+void MaterialTable::UseMaterial(GLuint materialIndex)
+{
+	glVertexAttribI1ui(MATERIAL_INDEX_ATTRIBUTE, materialIndex);
+}
+
+unsigned int MaterialTable::GetMaterialCount()
+{
+	return (unsigned int)entries.size();
+}
+
+MaterialTable::~MaterialTable()
+{
+	if (UBO)
+	{
+		glDeleteBuffers(1, &UBO);
+	}
+}
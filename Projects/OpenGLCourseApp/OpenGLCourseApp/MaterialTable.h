@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdio.h>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "CommonValues.h"
+#include "Material.h"
+#include "TextureArray.h"
+
+// Every material of the scene, in one uniform buffer the shaders read as MaterialBlock.
+// A draw only says which material it uses, by index, with the materialIndex vertex attribute. That is vertex state, not a uniform,
+// so going from one material to another between draws costs no glUniform calls at all.
+class MaterialTable
+{
+	public:
+		MaterialTable();
+
+		bool Init();
+
+		// Gives the index of the material with this texture in the table, adding it if it isn't there yet. 0 when the table is full.
+		// textureLayer is the layer of the texture in the TextureArray the shaders sample.
+		GLuint AddMaterial(Material* material, GLuint textureLayer);
+
+		// Copies the materials to the uniform buffer and binds it on MATERIAL_BLOCK_BINDING. Call after adding or changing materials.
+		// With textures, layers that are still loading point to its placeholder instead, so call it again when a layer is ready.
+		void Upload(TextureArray* textures = nullptr);
+
+		// Which material the next draws use. Sets the materialIndex attribute, which has no array, so every vertex gets this value.
+		static void UseMaterial(GLuint materialIndex);
+
+		unsigned int GetMaterialCount();
+
+		~MaterialTable();
+
+	private:
+		GLuint UBO;
+		struct Entry
+		{
+			Material* material;
+			GLuint textureLayer;
+		};
+		std::vector<Entry> entries;
+};
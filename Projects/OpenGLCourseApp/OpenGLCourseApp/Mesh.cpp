@@ -3,53 +3,163 @@
 Mesh::Mesh()
 {
 	VAO = 0;
+	depthVAO = 0;
 	VBO = 0;
 	IBO = 0;
 	indexCount = 0;
+	indexType = GL_UNSIGNED_INT;
+	boundingCenter = glm::vec3(0.0f, 0.0f, 0.0f);
+	boundingRadius = 0.0f;
+	uvDensity = 0.0f;
+	vertexFormat = VERTEX_FORMAT_FLOAT;
+	positionOffset = glm::vec3(0.0f, 0.0f, 0.0f);
+	positionScale = glm::vec3(1.0f, 1.0f, 1.0f);
 }
 
-void Mesh::CreateMesh(GLfloat *vertices, unsigned int *indices, unsigned int numOfVertices, unsigned int numOfIndices)
+void Mesh::CreateMesh(const GLfloat *vertices, const unsigned int *indices, unsigned int numOfVertices, unsigned int numOfIndices, VertexFormat format,
+	const Lod* lodLevels, unsigned int lodCount)
 {
 	indexCount = numOfIndices;
+	vertexFormat = format;
+	if (lodCount > 0)
+	{
+		lods.assign(lodLevels, lodLevels + lodCount);
+	}
+	else
+	{
+		lods.assign(1, Lod{ 0, numOfIndices, 0.0f });
+	}
+	CalcSurfaceInfo(vertices, indices + lods[0].firstIndex, numOfVertices, lods[0].indexCount);
+	if (format == VERTEX_FORMAT_FLOAT)
+	{
+		positionOffset = glm::vec3(0.0f, 0.0f, 0.0f);
+		positionScale = glm::vec3(1.0f, 1.0f, 1.0f);
+	}
 
 	glGenVertexArrays(1, &VAO);
 	glBindVertexArray(VAO);
 
+	// 16 bit indices when the mesh is small enough, or splits into big enough ranges. The vertices some ranges share are copied into each.
+	std::vector<GLushort> shortIndices;
+	std::vector<unsigned int> vertexRemap;
+	std::vector<GLfloat> splitVertices;
+	if (SplitIndexRanges(indices, numOfIndices, lods, numOfVertices / 8, GetVertexSize(), indexRanges, lodRanges, vertexRemap, shortIndices))
+	{
+		indexType = GL_UNSIGNED_SHORT;
+		if (!vertexRemap.empty())
+		{
+			splitVertices.resize(vertexRemap.size() * 8);
+			for (size_t i = 0; i < vertexRemap.size(); i++)
+			{
+				std::copy(vertices + vertexRemap[i] * 8, vertices + vertexRemap[i] * 8 + 8, splitVertices.begin() + i * 8);
+			}
+			// From here on, the vertex buffer is made from the copies.
+			vertices = splitVertices.data();
+			numOfVertices = (unsigned int)splitVertices.size();
+		}
+	}
+	else
+	{
+		indexType = GL_UNSIGNED_INT;
+		indexRanges.clear();
+		lodRanges.assign(1, 0);
+		for (size_t lod = 0; lod < lods.size(); lod++)
+		{
+			indexRanges.push_back(IndexRange{ (GLsizei)lods[lod].indexCount, lods[lod].firstIndex, 0 });
+			lodRanges.push_back((GLuint)indexRanges.size());
+		}
+	}
+
 	glGenBuffers(1, &IBO);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices[0]) * numOfIndices, indices, GL_STATIC_DRAW);
+	if (indexType == GL_UNSIGNED_SHORT)
+	{
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort) * shortIndices.size(), shortIndices.data(), GL_STATIC_DRAW);
+	}
+	else
+	{
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices[0]) * numOfIndices, indices, GL_STATIC_DRAW);
+	}
 
 	glGenBuffers(1, &VBO);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices[0]) * numOfVertices, vertices, GL_STATIC_DRAW);
-
-	glVertexAttribPointer(0, // Position
-		3, 
-		GL_FLOAT, 
-		GL_FALSE, 
-		sizeof(vertices[0]) * 8, // Skip 8 values as the Stride, because each of our value has 5 values in the array..
-		0);
-	glEnableVertexAttribArray(0);
 
-	// Now we tell it how to handle the UV coords.
-	glVertexAttribPointer(1, // Tex coordinates
-		2, // 2 values in our UV coords.
-		GL_FLOAT,
-		GL_FALSE,
-		sizeof(vertices[0]) * 8, // Skip 8 values as the Stride before we reach next uv coord
-		(void*)(sizeof(vertices[0]) * 3) // Offset. Where to start for uv coords.
-	);
-	glEnableVertexAttribArray(1);
-
-	// Now we tell it how to handle the normal coords.
-	glVertexAttribPointer(2, // Normal coordinates
-		3, // our coordinates have x,y,z
-		GL_FLOAT,
-		GL_FALSE,
-		sizeof(vertices[0]) * 8, // Skip 8 values as the Stride before we reach next normal coord
-		(void*)(sizeof(vertices[0]) * 5) // Offset. Where to start for normal coords.
-	);
-	glEnableVertexAttribArray(2);
+	// The positions of every vertex first, then their UVs and normals. The passes that only write depth read the positions alone,
+	// through depthVAO, instead of reading whole vertices and throwing most of them away.
+	unsigned int vertexCount = numOfVertices / 8;
+	std::vector<GLfloat> floatPositions, floatAttributes;
+	std::vector<PackedPosition> packedPositions;
+	std::vector<PackedAttributes> packedAttributes;
+	const void* positionData;
+	const void* attributeData;
+	if (format == VERTEX_FORMAT_FLOAT)
+	{
+		floatPositions.resize(vertexCount * 3);
+		floatAttributes.resize(vertexCount * 5);
+		for (unsigned int i = 0; i < vertexCount; i++)
+		{
+			std::copy(vertices + i * 8, vertices + i * 8 + 3, floatPositions.begin() + i * 3);
+			std::copy(vertices + i * 8 + 3, vertices + i * 8 + 8, floatAttributes.begin() + i * 5);
+		}
+		positionData = floatPositions.data();
+		attributeData = floatAttributes.data();
+	}
+	else
+	{
+		PackVertices(vertices, numOfVertices, format, positionOffset, positionScale, packedPositions, packedAttributes);
+		positionData = packedPositions.data();
+		attributeData = packedAttributes.data();
+	}
+	GLsizeiptr positionBytes = (GLsizeiptr)GetPositionSize() * vertexCount;
+	GLsizeiptr attributeBytes = (GLsizeiptr)(GetVertexSize() - GetPositionSize()) * vertexCount;
+	glBufferData(GL_ARRAY_BUFFER, positionBytes + attributeBytes, nullptr, GL_STATIC_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, positionBytes, positionData);
+	glBufferSubData(GL_ARRAY_BUFFER, positionBytes, attributeBytes, attributeData);
+
+	UsePositionAttribute();
+
+	if (format == VERTEX_FORMAT_FLOAT)
+	{
+		// Now we tell it how to handle the UV coords.
+		glVertexAttribPointer(1, // Tex coordinates
+			2, // 2 values in our UV coords.
+			GL_FLOAT,
+			GL_FALSE,
+			sizeof(vertices[0]) * 5, // Skip 5 values as the Stride before we reach next uv coord: the UV and normal of a vertex.
+			(void*)positionBytes // Offset. Where to start for uv coords: after all the positions.
+		);
+		glEnableVertexAttribArray(1);
+
+		// Now we tell it how to handle the normal coords.
+		glVertexAttribPointer(2, // Normal coordinates
+			3, // our coordinates have x,y,z
+			GL_FLOAT,
+			GL_FALSE,
+			sizeof(vertices[0]) * 5, // Skip 5 values as the Stride before we reach next normal coord
+			(void*)(positionBytes + sizeof(vertices[0]) * 2) // Offset. Where to start for normal coords: after the first UV.
+		);
+		glEnableVertexAttribArray(2);
+	}
+	else
+	{
+		glVertexAttribPointer(1, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedAttributes), (void*)(positionBytes + offsetof(PackedAttributes, uv)));
+		glEnableVertexAttribArray(1);
+		if (format == VERTEX_FORMAT_PACKED_OCTAHEDRAL)
+		{
+			glVertexAttribPointer(2, 2, GL_SHORT, GL_TRUE, sizeof(PackedAttributes), (void*)(positionBytes + offsetof(PackedAttributes, normal)));
+		}
+		else
+		{
+			glVertexAttribPointer(2, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedAttributes), (void*)(positionBytes + offsetof(PackedAttributes, normal)));
+		}
+		glEnableVertexAttribArray(2);
+	}
+
+	// Same buffers, positions only.
+	glGenVertexArrays(1, &depthVAO);
+	glBindVertexArray(depthVAO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
+	UsePositionAttribute();
 
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
@@ -57,11 +167,400 @@ void Mesh::CreateMesh(GLfloat *vertices, unsigned int *indices, unsigned int num
 	glBindVertexArray(0);
 }
 
-void Mesh::RenderMesh()
+void Mesh::UsePositionAttribute()
+{
+	if (vertexFormat == VERTEX_FORMAT_FLOAT)
+	{
+		glVertexAttribPointer(0, // Position
+			3,
+			GL_FLOAT,
+			GL_FALSE,
+			sizeof(GLfloat) * 3, // Positions are next to each other, so the stride is just one position.
+			0);
+	}
+	else
+	{
+		// Normalized: the shader gets 0 to 1 instead of the integers.
+		glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedPosition), 0);
+	}
+	glEnableVertexAttribArray(0);
+}
+
+void Mesh::CalcSurfaceInfo(const GLfloat* vertices, const unsigned int* indices, unsigned int numOfVertices, unsigned int numOfIndices)
+{
+	unsigned int vertexCount = numOfVertices / 8;
+	if (vertexCount == 0)
+	{
+		return;
+	}
+
+	// Center of the box around the vertices, then the furthest vertex from it.
+	glm::vec3 minimum(vertices[0], vertices[1], vertices[2]), maximum = minimum;
+	for (unsigned int i = 1; i < vertexCount; i++)
+	{
+		glm::vec3 position(vertices[i * 8], vertices[i * 8 + 1], vertices[i * 8 + 2]);
+		minimum = glm::min(minimum, position);
+		maximum = glm::max(maximum, position);
+	}
+	boundingCenter = (minimum + maximum) * 0.5f;
+	positionOffset = minimum;
+	positionScale = maximum - minimum;
+	boundingRadius = 0.0f;
+	for (unsigned int i = 0; i < vertexCount; i++)
+	{
+		glm::vec3 position(vertices[i * 8], vertices[i * 8 + 1], vertices[i * 8 + 2]);
+		boundingRadius = std::max(boundingRadius, glm::length(position - boundingCenter));
+	}
+
+	// Area the triangles cover in UV space against the area they cover in model space. Areas are squared lengths, hence the root.
+	GLfloat surfaceArea = 0.0f, uvArea = 0.0f;
+	for (unsigned int i = 0; i + 2 < numOfIndices; i += 3)
+	{
+		const GLfloat* a = &vertices[indices[i] * 8];
+		const GLfloat* b = &vertices[indices[i + 1] * 8];
+		const GLfloat* c = &vertices[indices[i + 2] * 8];
+		glm::vec3 edge1(b[0] - a[0], b[1] - a[1], b[2] - a[2]), edge2(c[0] - a[0], c[1] - a[1], c[2] - a[2]);
+		surfaceArea += glm::length(glm::cross(edge1, edge2)) * 0.5f;
+		uvArea += std::abs((b[3] - a[3]) * (c[4] - a[4]) - (c[3] - a[3]) * (b[4] - a[4])) * 0.5f;
+	}
+	uvDensity = surfaceArea > 0.0f ? sqrtf(uvArea / surfaceArea) : 0.0f;
+}
+
+glm::vec3 Mesh::GetBoundingCenter()
+{
+	return boundingCenter;
+}
+
+GLfloat Mesh::GetBoundingRadius()
+{
+	return boundingRadius;
+}
+
+GLfloat Mesh::GetUVDensity()
+{
+	return uvDensity;
+}
+
+VertexFormat Mesh::GetVertexFormat()
+{
+	return vertexFormat;
+}
+
+GLsizei Mesh::GetVertexSize()
+{
+	return vertexFormat == VERTEX_FORMAT_FLOAT ? sizeof(GLfloat) * 8 : sizeof(PackedPosition) + sizeof(PackedAttributes);
+}
+
+GLsizei Mesh::GetPositionSize()
+{
+	return vertexFormat == VERTEX_FORMAT_FLOAT ? sizeof(GLfloat) * 3 : sizeof(PackedPosition);
+}
+
+GLenum Mesh::GetIndexType()
+{
+	return indexType;
+}
+
+GLsizei Mesh::GetIndexSize()
+{
+	return indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+}
+
+GLsizei Mesh::GetIndexRangeCount()
+{
+	return (GLsizei)indexRanges.size();
+}
+
+GLuint Mesh::GetLodCount()
+{
+	return (GLuint)lods.size();
+}
+
+GLuint Mesh::GetLodTriangleCount(GLuint lod)
+{
+	return lod < lods.size() ? lods[lod].indexCount / 3 : 0;
+}
+
+GLuint Mesh::SelectLod(GLfloat pixelsPerUnit, GLfloat maxPixelError)
+{
+	// Errors only grow from one level to the next.
+	GLuint lod = 0;
+	while (lod + 1 < lods.size() && lods[lod + 1].error * pixelsPerUnit <= maxPixelError)
+	{
+		lod++;
+	}
+	return lod;
+}
+
+glm::vec2 Mesh::EncodeOctahedral(glm::vec3 normal)
+{
+	GLfloat length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+	if (length == 0.0f)
+	{
+		return glm::vec2(0.0f, 0.0f);
+	}
+	normal /= length;
+
+	glm::vec2 folded(normal.x, normal.y);
+	if (normal.z < 0.0f)
+	{
+		folded.x = (1.0f - std::abs(normal.y)) * (normal.x >= 0.0f ? 1.0f : -1.0f);
+		folded.y = (1.0f - std::abs(normal.x)) * (normal.y >= 0.0f ? 1.0f : -1.0f);
+	}
+	return folded;
+}
+
+void Mesh::PackVertices(const GLfloat* vertices, unsigned int numOfVertices, VertexFormat format, glm::vec3 positionOffset, glm::vec3 positionScale,
+	std::vector<PackedPosition>& positions, std::vector<PackedAttributes>& attributes)
+{
+	unsigned int vertexCount = numOfVertices / 8;
+	positions.resize(vertexCount);
+	attributes.resize(vertexCount);
+
+	// Flat along an axis, the scale is 0 and every vertex is at the offset.
+	glm::vec3 toUnit(positionScale.x > 0.0f ? 1.0f / positionScale.x : 0.0f, positionScale.y > 0.0f ? 1.0f / positionScale.y : 0.0f,
+		positionScale.z > 0.0f ? 1.0f / positionScale.z : 0.0f);
+	for (unsigned int i = 0; i < vertexCount; i++)
+	{
+		const GLfloat* vertex = &vertices[i * 8];
+		PackedPosition& position = positions[i];
+		PackedAttributes& out = attributes[i];
+
+		glm::vec3 unit = glm::clamp((glm::vec3(vertex[0], vertex[1], vertex[2]) - positionOffset) * toUnit, 0.0f, 1.0f);
+		position.position[0] = (GLushort)(unit.x * 65535.0f + 0.5f);
+		position.position[1] = (GLushort)(unit.y * 65535.0f + 0.5f);
+		position.position[2] = (GLushort)(unit.z * 65535.0f + 0.5f);
+		position.position[3] = 0;
+
+		out.uv = glm::packHalf2x16(glm::vec2(vertex[3], vertex[4]));
+
+		glm::vec3 normal(vertex[5], vertex[6], vertex[7]);
+		if (format == VERTEX_FORMAT_PACKED_OCTAHEDRAL)
+		{
+			out.normal = glm::packSnorm2x16(EncodeOctahedral(normal));
+		}
+		else
+		{
+			GLfloat length = glm::length(normal);
+			out.normal = glm::packSnorm3x10_1x2(glm::vec4(length > 0.0f ? normal / length : normal, 0.0f));
+		}
+	}
+}
+
+void Mesh::UseVertexDecode()
+{
+	glVertexAttrib3f(POSITION_SCALE_ATTRIBUTE, positionScale.x, positionScale.y, positionScale.z);
+	glVertexAttrib3f(POSITION_OFFSET_ATTRIBUTE, positionOffset.x, positionOffset.y, positionOffset.z);
+	glVertexAttrib1f(OCTAHEDRAL_NORMAL_ATTRIBUTE, vertexFormat == VERTEX_FORMAT_PACKED_OCTAHEDRAL ? 1.0f : 0.0f);
+}
+
+bool Mesh::SplitIndexRanges(const unsigned int* indices, unsigned int numOfIndices, const std::vector<Lod>& lods, unsigned int vertexCount,
+	GLsizei vertexSize, std::vector<IndexRange>& ranges, std::vector<GLuint>& lodRanges, std::vector<unsigned int>& vertexRemap,
+	std::vector<GLushort>& shortIndices)
+{
+	const unsigned int maxRangeVertices = 65536;
+	ranges.clear();
+	lodRanges.assign(1, 0);
+	vertexRemap.clear();
+	shortIndices.assign(numOfIndices, 0);
+
+	if (vertexCount <= maxRangeVertices)
+	{
+		std::copy(indices, indices + numOfIndices, shortIndices.begin());
+		for (size_t lod = 0; lod < lods.size(); lod++)
+		{
+			GLuint triangleIndices = lods[lod].indexCount - lods[lod].indexCount % 3;
+			if (triangleIndices > 0)
+			{
+				ranges.push_back(IndexRange{ (GLsizei)triangleIndices, lods[lod].firstIndex, 0 });
+			}
+			lodRanges.push_back((GLuint)ranges.size());
+		}
+		return true;
+	}
+
+	// The vertex buffer is cut into windows of up to 65536 vertices, each drawn from its own base vertex. A vertex can be in several, copied.
+	// Which window first and last took each old vertex, and where it is in them.
+	std::vector<unsigned int> firstWindow(vertexCount, UINT_MAX), lastWindow(vertexCount, UINT_MAX);
+	std::vector<GLushort> firstWindowIndex(vertexCount), lastWindowIndex(vertexCount);
+	std::vector<unsigned int> windowBases;
+	auto windowIndex = [&](unsigned int vertex, unsigned int window)
+	{
+		return firstWindow[vertex] == window ? firstWindowIndex[vertex] : lastWindowIndex[vertex];
+	};
+	// A window that already has all 3 corners of a triangle, or UINT_MAX.
+	auto findWindow = [&](const unsigned int* corners)
+	{
+		unsigned int candidates[2] = { firstWindow[corners[0]], lastWindow[corners[0]] };
+		for (unsigned int k = 0; k < 2; k++)
+		{
+			unsigned int window = candidates[k];
+			bool hasAll = window != UINT_MAX;
+			for (unsigned int corner = 1; corner < 3 && hasAll; corner++)
+			{
+				hasAll = firstWindow[corners[corner]] == window || lastWindow[corners[corner]] == window;
+			}
+			if (hasAll)
+			{
+				return window;
+			}
+		}
+		return UINT_MAX;
+	};
+
+	size_t allIndices = 0;
+	bool rangesBigEnough = true;
+	std::vector<unsigned int> triangleWindows, windowTriangles, copiedTriangles;
+	for (size_t lod = 0; lod < lods.size(); lod++)
+	{
+		// Every level has ranges of its own, so it can be drawn alone. written is where its next triangle goes in shortIndices.
+		unsigned int start = lods[lod].firstIndex;
+		unsigned int end = start + lods[lod].indexCount - lods[lod].indexCount % 3;
+		unsigned int written = start;
+		copiedTriangles.clear();
+
+		// The lower levels use vertices the full detail one has already laid out. Their triangles that fit in one of its windows are drawn
+		// from it, grouped by window, and copy nothing. Windows with too few of a level's triangles aren't worth a draw call, so those get copied.
+		triangleWindows.assign((end - start) / 3, UINT_MAX);
+		windowTriangles.assign(windowBases.size(), 0);
+		for (unsigned int i = start; lod > 0 && i < end; i += 3)
+		{
+			unsigned int window = findWindow(indices + i);
+			triangleWindows[(i - start) / 3] = window;
+			if (window != UINT_MAX)
+			{
+				windowTriangles[window]++;
+			}
+		}
+		for (unsigned int window = 0; window < windowBases.size(); window++)
+		{
+			if (windowTriangles[window] < MIN_INDEX_RANGE_TRIANGLES)
+			{
+				continue;
+			}
+			unsigned int first = written;
+			for (unsigned int i = start; i < end; i += 3)
+			{
+				if (triangleWindows[(i - start) / 3] == window)
+				{
+					for (unsigned int corner = 0; corner < 3; corner++)
+					{
+						shortIndices[written++] = windowIndex(indices[i + corner], window);
+					}
+				}
+			}
+			ranges.push_back(IndexRange{ (GLsizei)(written - first), first, (GLint)windowBases[window] });
+		}
+		for (unsigned int i = start; i < end; i += 3)
+		{
+			unsigned int window = triangleWindows[(i - start) / 3];
+			if (window == UINT_MAX || windowTriangles[window] < MIN_INDEX_RANGE_TRIANGLES)
+			{
+				copiedTriangles.push_back(i);
+			}
+		}
+
+		// The rest, all of the full detail level, in their order, into new windows.
+		unsigned int first = written;
+		unsigned int window = (unsigned int)windowBases.size();
+		windowBases.push_back((unsigned int)vertexRemap.size());
+		for (size_t k = 0; k < copiedTriangles.size(); k++)
+		{
+			const unsigned int* corners = indices + copiedTriangles[k];
+			unsigned int a = corners[0], b = corners[1], c = corners[2];
+			unsigned int newVertices = (lastWindow[a] != window) + (lastWindow[b] != window && b != a) + (lastWindow[c] != window && c != a && c != b);
+			if (vertexRemap.size() - windowBases[window] + newVertices > maxRangeVertices)
+			{
+				// This triangle starts the next window.
+				ranges.push_back(IndexRange{ (GLsizei)(written - first), first, (GLint)windowBases[window] });
+				first = written;
+				window++;
+				windowBases.push_back((unsigned int)vertexRemap.size());
+			}
+
+			for (unsigned int corner = 0; corner < 3; corner++)
+			{
+				unsigned int vertex = corners[corner];
+				if (lastWindow[vertex] != window)
+				{
+					if (firstWindow[vertex] == UINT_MAX)
+					{
+						firstWindow[vertex] = window;
+						firstWindowIndex[vertex] = (GLushort)(vertexRemap.size() - windowBases[window]);
+					}
+					lastWindow[vertex] = window;
+					lastWindowIndex[vertex] = (GLushort)(vertexRemap.size() - windowBases[window]);
+					vertexRemap.push_back(vertex);
+				}
+				shortIndices[written++] = lastWindowIndex[vertex];
+			}
+		}
+		if (written > first)
+		{
+			ranges.push_back(IndexRange{ (GLsizei)(written - first), first, (GLint)windowBases[window] });
+		}
+
+		// The last range gets whatever is left, so it can be small.
+		GLuint levelRanges = (GLuint)ranges.size() - lodRanges.back();
+		rangesBigEnough = rangesBigEnough && (levelRanges <= 1 || (end - start) / 3 / (levelRanges - 1) >= MIN_INDEX_RANGE_TRIANGLES);
+		lodRanges.push_back((GLuint)ranges.size());
+		allIndices += end - start;
+	}
+
+	// Vertices no triangle uses are gone, so there can be fewer than before.
+	double copiedBytes = ((double)vertexRemap.size() - vertexCount) * vertexSize;
+	double savedBytes = (double)allIndices * (sizeof(GLuint) - sizeof(GLushort));
+	return copiedBytes < savedBytes && rangesBigEnough;
+}
+
+void Mesh::DrawIndexRanges(GLuint lod, GLsizei instanceCount)
+{
+	if (lods.empty())
+	{
+		return;
+	}
+	lod = std::min(lod, (GLuint)lods.size() - 1);
+	for (GLuint i = lodRanges[lod]; i < lodRanges[lod + 1]; i++)
+	{
+		const IndexRange& range = indexRanges[i];
+		void* offset = (void*)((size_t)range.firstIndex * GetIndexSize()); // Bytes into the index buffer.
+		if (instanceCount == 1)
+		{
+			glDrawElementsBaseVertex(GL_TRIANGLES, range.indexCount, indexType, offset, range.baseVertex);
+		}
+		else
+		{
+			glDrawElementsInstancedBaseVertex(GL_TRIANGLES, range.indexCount, indexType, offset, instanceCount, range.baseVertex);
+		}
+	}
+}
+
+void Mesh::RenderMesh(GLuint lod)
+{
+	UseVertexDecode();
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
+	DrawIndexRanges(lod, 1);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+}
+
+void Mesh::RenderMeshDepth(GLuint lod)
+{
+	UseVertexDecode();
+	glBindVertexArray(depthVAO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
+	DrawIndexRanges(lod, 1);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+}
+
+void Mesh::RenderMeshInstanced(GLsizei instanceCount)
 {
+	UseVertexDecode();
 	glBindVertexArray(VAO);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
-	glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+	DrawIndexRanges(0, instanceCount);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
 }
@@ -86,7 +585,23 @@ void Mesh::ClearMesh()
 		VAO = 0;
 	}
 
+	if (depthVAO != 0)
+	{
+		glDeleteVertexArrays(1, &depthVAO);
+		depthVAO = 0;
+	}
+
 	indexCount = 0;
+	indexType = GL_UNSIGNED_INT;
+	indexRanges.clear();
+	lods.clear();
+	lodRanges.clear();
+	boundingCenter = glm::vec3(0.0f, 0.0f, 0.0f);
+	boundingRadius = 0.0f;
+	uvDensity = 0.0f;
+	vertexFormat = VERTEX_FORMAT_FLOAT;
+	positionOffset = glm::vec3(0.0f, 0.0f, 0.0f);
+	positionScale = glm::vec3(1.0f, 1.0f, 1.0f);
 }
 
 
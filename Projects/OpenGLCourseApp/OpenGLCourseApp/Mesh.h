@@ -2,19 +2,119 @@
 
 #include <GL\glew.h>
 
+#include <algorithm>
+#include <climits>
+#include <vector>
+
+#include <glm\glm.hpp>
+#include <glm\gtc\packing.hpp>
+
+#include "CommonValues.h"
+
 class Mesh
 {
 public:
+	// A vertex of the packed formats, 16 bytes, in 2 parts: the vertex buffer has every position, then every UV and normal. See VertexFormat.
+	struct PackedPosition
+	{
+		GLushort position[4]; // 0 to 65535 across the mesh's box. The 4th is padding, attributes start on 4 bytes.
+	};
+	struct PackedAttributes
+	{
+		GLuint uv; // 2 half floats.
+		GLuint normal; // 2 signed 16 bit octahedral coordinates, or GL_INT_2_10_10_10_REV.
+	};
+
+	// Part of the index buffer, drawn with its own base vertex so its indices fit in 16 bits. See SplitIndexRanges.
+	struct IndexRange
+	{
+		GLsizei indexCount;
+		GLuint firstIndex;
+		GLint baseVertex; // The GPU adds it to every index of the range.
+	};
+
+	// One level of detail: where its indices are, and how far its surface is from the full mesh's, at most, in model space. See MeshSimplifier.
+	struct Lod
+	{
+		GLuint firstIndex;
+		GLuint indexCount;
+		GLfloat error;
+	};
+
 	Mesh();
 
-	void CreateMesh(GLfloat *vertices, unsigned int *indices, unsigned int numOfVertices, unsigned int numOfIndices);
-	void RenderMesh();
+	// vertices are 8 floats each: position, UV and normal. They are packed into format on the way to the GPU.
+	// indices can hold several levels of detail one after the other, lodCount of them described by lodLevels, finest first. Without lodLevels, it is one level.
+	void CreateMesh(const GLfloat *vertices, const unsigned int *indices, unsigned int numOfVertices, unsigned int numOfIndices,
+		VertexFormat format = VERTEX_FORMAT, const Lod* lodLevels = nullptr, unsigned int lodCount = 0);
+	void RenderMesh(GLuint lod = 0);
+	// Reads nothing but the positions, for passes that only write depth: shadow maps and the depth pre-pass.
+	// 12 bytes per vertex instead of 32 with floats, 8 instead of 16 packed.
+	void RenderMeshDepth(GLuint lod = 0);
+	void RenderMeshInstanced(GLsizei instanceCount); // Draws the mesh instanceCount times in one call. Shaders tell them apart with gl_InstanceID.
 	void ClearMesh();
 
+	// Sphere around every vertex, in model space.
+	glm::vec3 GetBoundingCenter();
+	GLfloat GetBoundingRadius();
+	// How many UV units cover one model space unit, on average over the surface. Times a texture's size, that is its texels per unit.
+	GLfloat GetUVDensity();
+
+	VertexFormat GetVertexFormat();
+	GLsizei GetVertexSize(); // Bytes per vertex in the vertex buffer.
+	GLsizei GetPositionSize(); // Bytes per vertex that RenderMeshDepth reads.
+	GLenum GetIndexType(); // GL_UNSIGNED_SHORT, unless the mesh couldn't be split into ranges. See MIN_INDEX_RANGE_TRIANGLES.
+	GLsizei GetIndexSize(); // Bytes per index.
+	GLsizei GetIndexRangeCount(); // Draw calls per render, every level of detail together.
+
+	GLuint GetLodCount();
+	GLuint GetLodTriangleCount(GLuint lod);
+	// The coarsest level whose error, times pixelsPerUnit (how many pixels one model space unit takes on screen), is at most maxPixelError.
+	GLuint SelectLod(GLfloat pixelsPerUnit, GLfloat maxPixelError);
+
+	// Packs vertices (8 floats each) with their positions stored in the box from positionOffset, positionScale big.
+	static void PackVertices(const GLfloat* vertices, unsigned int numOfVertices, VertexFormat format, glm::vec3 positionOffset, glm::vec3 positionScale,
+		std::vector<PackedPosition>& positions, std::vector<PackedAttributes>& attributes);
+	// The normal folded onto the octahedron |x| + |y| + |z| = 1, then its lower half unfolded around the upper one. -1 to 1 on both axes.
+	static glm::vec2 EncodeOctahedral(glm::vec3 normal);
+	// Cuts the triangles of the first level of detail, in their order, into ranges of up to 65536 different vertices, so each range's indices
+	// fit in 16 bits counted from its own base vertex. A vertex used by several ranges is copied into each. The lower levels' triangles are
+	// drawn from those same vertices where they can, grouped by range, and the rest copied the same way. vertexRemap gets the old vertex
+	// of each vertex of the new vertex buffer, and shortIndices the indices into it, each level's triangles in its own part, in the order of
+	// its ranges. lodRanges gets the first range of each level, and one past the last.
+	// A mesh of up to 65536 vertices is a single range per level and keeps its vertices and triangles as they are, vertexRemap empty.
+	// False when 16 bit indices don't pay off: the copies take more bytes (vertexSize each) than the indices save, or a level's ranges
+	// but the last average fewer than MIN_INDEX_RANGE_TRIANGLES triangles. See MeshOptimizer for an order where both are rare.
+	static bool SplitIndexRanges(const unsigned int* indices, unsigned int numOfIndices, const std::vector<Lod>& lods, unsigned int vertexCount,
+		GLsizei vertexSize, std::vector<IndexRange>& ranges, std::vector<GLuint>& lodRanges, std::vector<unsigned int>& vertexRemap,
+		std::vector<GLushort>& shortIndices);
+
 	~Mesh();
 
 private:
 	GLuint VAO, VBO, IBO;
+	GLuint depthVAO; // Only the position attribute.
 	GLsizei indexCount;
+	GLenum indexType;
+	std::vector<IndexRange> indexRanges; // With 32 bit indices, one per level of detail, from vertex 0.
+	std::vector<Lod> lods;
+	std::vector<GLuint> lodRanges; // The first of indexRanges of each level, and one past the last.
+
+	glm::vec3 boundingCenter;
+	GLfloat boundingRadius;
+	GLfloat uvDensity;
+
+	VertexFormat vertexFormat;
+	glm::vec3 positionOffset, positionScale; // The box packed positions are stored in. 0 and 1 for floats, so shaders decode both the same way.
+
+	// Sets the attributes vertex shaders decode this mesh's vertices with. They aren't in the vertex buffer, so every draw sets them.
+	void UseVertexDecode();
+	// Points attribute 0 of the bound vertex array at the positions in VBO.
+	void UsePositionAttribute();
+	// Draws the index ranges of a level with the bound vertex array. instanceCount 1 draws without instancing.
+	void DrawIndexRanges(GLuint lod, GLsizei instanceCount);
+
+	// Fills the bounding sphere, the box of the positions and UV density from the vertices (8 values each: position, UV, normal).
+	void CalcSurfaceInfo(const GLfloat* vertices, const unsigned int* indices, unsigned int numOfVertices, unsigned int numOfIndices);
 };
 
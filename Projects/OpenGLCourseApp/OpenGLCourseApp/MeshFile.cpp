@@ -0,0 +1,323 @@
+#include "MeshFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+const GLuint MeshFile::MAGIC;
+const GLuint MeshFile::VERSION;
+const GLuint MeshFile::MAX_ATTRIBUTES;
+const GLuint MeshFile::BLOB_ALIGNMENT;
+
+MeshFile::MeshFile()
+{
+	data = nullptr;
+	size = 0;
+	header = nullptr;
+#ifdef _WIN32
+	fileHandle = nullptr;
+	mappingHandle = nullptr;
+#else
+	fileDescriptor = -1;
+#endif
+}
+
+MeshFile::Header MeshFile::MakeHeader(unsigned int vertexCount, unsigned int indexCount)
+{
+	Header fileHeader = {};
+	fileHeader.magic = MAGIC;
+	fileHeader.version = VERSION;
+	fileHeader.vertexCount = vertexCount;
+	fileHeader.indexCount = indexCount;
+	fileHeader.vertexStride = sizeof(GLfloat) * 8;
+	fileHeader.attributeCount = 3;
+	fileHeader.attributes[0] = { 0, 3, GL_FLOAT, 0 }; // Position
+	fileHeader.attributes[1] = { 1, 2, GL_FLOAT, sizeof(GLfloat) * 3 }; // UV
+	fileHeader.attributes[2] = { 2, 3, GL_FLOAT, sizeof(GLfloat) * 5 }; // Normal
+
+	// The blobs start on the next aligned byte after what comes before them.
+	// Worked out in 64 bits, a big vertexCount times the stride doesn't fit in a GLuint. Save checks the results fit before writing them.
+	uint64_t vertexOffset = (sizeof(Header) + BLOB_ALIGNMENT - 1) / BLOB_ALIGNMENT * BLOB_ALIGNMENT;
+	uint64_t vertexSize = (uint64_t)vertexCount * fileHeader.vertexStride;
+	uint64_t indexOffset = (vertexOffset + vertexSize + BLOB_ALIGNMENT - 1) / BLOB_ALIGNMENT * BLOB_ALIGNMENT;
+	fileHeader.vertexOffset = (GLuint)vertexOffset;
+	fileHeader.vertexSize = (GLuint)vertexSize;
+	fileHeader.indexOffset = (GLuint)indexOffset;
+	fileHeader.indexSize = 0;
+	return fileHeader;
+}
+
+bool MeshFile::Save(const char* fileLocation, const GLfloat* vertices, const unsigned int* indices, unsigned int numOfVertices, unsigned int numOfIndices,
+	const Mesh::Lod* lods, unsigned int lodCount)
+{
+	Header fileHeader = MakeHeader(numOfVertices / 8, numOfIndices);
+	if (lodCount > MAX_LODS)
+	{
+		return false;
+	}
+	if (lodCount > 0)
+	{
+		fileHeader.lodCount = lodCount;
+		std::copy(lods, lods + lodCount, fileHeader.lods);
+	}
+	else
+	{
+		fileHeader.lodCount = 1;
+		fileHeader.lods[0] = Mesh::Lod{ 0, numOfIndices, 0.0f };
+	}
+	std::vector<unsigned char> encodedIndices;
+	IndexCodec::Encode(indices, numOfIndices, encodedIndices);
+
+	// Offsets and sizes in the header are 32 bits. A mesh that ends past 4 GB can't be described.
+	uint64_t vertexSize = (uint64_t)(numOfVertices / 8) * fileHeader.vertexStride;
+	uint64_t fileEnd = (uint64_t)fileHeader.vertexOffset + vertexSize + BLOB_ALIGNMENT + encodedIndices.size();
+	if (fileEnd > UINT32_MAX)
+	{
+		printf("%s would be too big for a mesh file.\n", fileLocation);
+		return false;
+	}
+	fileHeader.indexSize = (GLuint)encodedIndices.size();
+
+	FILE* file = fopen(fileLocation, "wb");
+	if (!file)
+	{
+		return false;
+	}
+
+	// Zeros for the padding in front of each blob.
+	static const unsigned char padding[BLOB_ALIGNMENT] = {};
+	bool written = fwrite(&fileHeader, sizeof(fileHeader), 1, file) == 1 &&
+		fwrite(padding, 1, fileHeader.vertexOffset - sizeof(fileHeader), file) == fileHeader.vertexOffset - sizeof(fileHeader) &&
+		fwrite(vertices, 1, fileHeader.vertexSize, file) == fileHeader.vertexSize &&
+		fwrite(padding, 1, fileHeader.indexOffset - fileHeader.vertexOffset - fileHeader.vertexSize, file) == fileHeader.indexOffset - fileHeader.vertexOffset - fileHeader.vertexSize &&
+		fwrite(encodedIndices.data(), 1, fileHeader.indexSize, file) == fileHeader.indexSize;
+	fclose(file);
+
+	return written;
+}
+
+bool MeshFile::Open(const char* fileLocation)
+{
+	Close();
+	if (!MapFile(fileLocation))
+	{
+		return false;
+	}
+	if (!CheckHeader(fileLocation))
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+bool MeshFile::MapFile(const char* fileLocation)
+{
+#ifdef _WIN32
+	fileHandle = CreateFileA(fileLocation, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+	{
+		fileHandle = nullptr;
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+	{
+		return false;
+	}
+	size = (size_t)fileSize.QuadPart;
+
+	mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mappingHandle)
+	{
+		return false;
+	}
+	data = (const unsigned char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	return data != nullptr;
+#else
+	fileDescriptor = open(fileLocation, O_RDONLY);
+	if (fileDescriptor < 0)
+	{
+		return false;
+	}
+
+	struct stat fileInfo;
+	if (fstat(fileDescriptor, &fileInfo) != 0 || fileInfo.st_size == 0)
+	{
+		return false;
+	}
+	size = (size_t)fileInfo.st_size;
+
+	void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	if (mapping == MAP_FAILED)
+	{
+		return false;
+	}
+	data = (const unsigned char*)mapping;
+	madvise(mapping, size, MADV_WILLNEED); // Everything will be read, so the OS can start reading it all in now.
+	return true;
+#endif
+}
+
+bool MeshFile::CheckHeader(const char* fileLocation)
+{
+	if (size < sizeof(Header))
+	{
+		printf("%s is too small to be a mesh file.\n", fileLocation);
+		return false;
+	}
+	header = (const Header*)data;
+
+	if (header->magic != MAGIC || header->version != VERSION)
+	{
+		printf("%s is not a mesh file we can read.\n", fileLocation);
+		return false;
+	}
+
+	// Mesh::CreateMesh only knows our one vertex format.
+	Header expected = MakeHeader(header->vertexCount, header->indexCount);
+	if (header->vertexStride != expected.vertexStride || header->attributeCount != expected.attributeCount ||
+		memcmp(header->attributes, expected.attributes, sizeof(Attribute) * expected.attributeCount) != 0)
+	{
+		printf("%s has a vertex format we can't draw.\n", fileLocation);
+		return false;
+	}
+
+	// Blobs inside the file, aligned, after the header, the indices after the vertices, and the vertices the size their count says.
+	// In 64 bits, so a damaged vertexCount can't overflow into a size that looks right.
+	uint64_t vertexSize = (uint64_t)header->vertexCount * header->vertexStride;
+	uint64_t vertexEnd = (uint64_t)header->vertexOffset + vertexSize;
+	if (header->vertexOffset % BLOB_ALIGNMENT != 0 || header->indexOffset % BLOB_ALIGNMENT != 0 ||
+		header->vertexOffset < sizeof(Header) || header->vertexSize != vertexSize || vertexEnd > size ||
+		header->indexOffset < vertexEnd || (uint64_t)header->indexOffset + header->indexSize > size ||
+		header->indexCount % 3 != 0)
+	{
+		printf("%s is damaged.\n", fileLocation);
+		return false;
+	}
+
+	// Levels of whole triangles, inside the indices.
+	bool lodsFit = header->lodCount >= 1 && header->lodCount <= MAX_LODS;
+	for (GLuint i = 0; lodsFit && i < header->lodCount; i++)
+	{
+		const Mesh::Lod& lod = header->lods[i];
+		lodsFit = lod.indexCount % 3 == 0 && lod.firstIndex <= header->indexCount && lod.indexCount <= header->indexCount - lod.firstIndex &&
+			lod.error >= 0.0f;
+	}
+	if (!lodsFit)
+	{
+		printf("%s has damaged levels of detail.\n", fileLocation);
+		return false;
+	}
+
+	indices.resize(header->indexCount);
+	if (!IndexCodec::Decode(data + header->indexOffset, header->indexSize, indices.data(), header->indexCount))
+	{
+		printf("%s has damaged indices.\n", fileLocation);
+		return false;
+	}
+
+	// An index past the last vertex would have the GPU read outside the buffer.
+	unsigned int largest = 0;
+	for (GLuint i = 0; i < header->indexCount; i++)
+	{
+		largest = std::max(largest, indices[i]);
+	}
+	if (header->indexCount > 0 && largest >= header->vertexCount)
+	{
+		printf("%s has indices past its last vertex.\n", fileLocation);
+		return false;
+	}
+
+	return true;
+}
+
+const GLfloat* MeshFile::GetVertices()
+{
+	return header ? (const GLfloat*)(data + header->vertexOffset) : nullptr;
+}
+
+const unsigned int* MeshFile::GetIndices()
+{
+	return header ? indices.data() : nullptr;
+}
+
+unsigned int MeshFile::GetVertexCount()
+{
+	return header ? header->vertexCount * 8 : 0;
+}
+
+unsigned int MeshFile::GetIndexCount()
+{
+	return header ? header->indexCount : 0;
+}
+
+const Mesh::Lod* MeshFile::GetLods()
+{
+	return header ? header->lods : nullptr;
+}
+
+unsigned int MeshFile::GetLodCount()
+{
+	return header ? header->lodCount : 0;
+}
+
+Mesh* MeshFile::LoadMesh(const char* fileLocation)
+{
+	MeshFile file;
+	if (!file.Open(fileLocation))
+	{
+		return nullptr;
+	}
+
+	Mesh* mesh = new Mesh();
+	mesh->CreateMesh(file.GetVertices(), file.GetIndices(), file.GetVertexCount(), file.GetIndexCount(), VERTEX_FORMAT, file.GetLods(), file.GetLodCount());
+	return mesh; // The buffers have their own copy now. The file is unmapped on the way out.
+}
+
+void MeshFile::Close()
+{
+#ifdef _WIN32
+	if (data)
+	{
+		UnmapViewOfFile(data);
+	}
+	if (mappingHandle)
+	{
+		CloseHandle(mappingHandle);
+	}
+	if (fileHandle)
+	{
+		CloseHandle(fileHandle);
+	}
+	fileHandle = nullptr;
+	mappingHandle = nullptr;
+#else
+	if (data)
+	{
+		munmap((void*)data, size);
+	}
+	if (fileDescriptor >= 0)
+	{
+		close(fileDescriptor);
+	}
+	fileDescriptor = -1;
+#endif
+	data = nullptr;
+	size = 0;
+	header = nullptr;
+	indices.clear();
+}
+
+MeshFile::~MeshFile()
+{
+	Close();
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+
+#include <GL/glew.h>
+
+#include "IndexCodec.h"
+#include "Mesh.h"
+
+// Our own binary mesh file (.mesh), made to be loaded without reading or parsing anything.
+// A small header, a description of the vertex format, then the vertices exactly as glBufferData wants them and the indices,
+// each starting on a 16 byte boundary. The file is memory mapped, and the vertices go straight from the mapping to Mesh::CreateMesh,
+// so nothing is copied on the way other than the vertex packing (see VertexFormat) and the driver's upload. The OS reads the pages in as they are touched.
+// The indices are squeezed by IndexCodec, under 1.5 bytes each instead of 4, and decoded into memory when the file is opened.
+// They can hold several levels of detail one after the other (see MeshSimplifier), listed in the header.
+//
+// Values are stored as they are in memory (little endian), since that is all we run on.
+class MeshFile
+{
+	public:
+		MeshFile();
+
+		// Writes a mesh with our usual vertex format: position, UV and normal, 8 floats per vertex. numOfVertices counts floats, like Mesh::CreateMesh.
+		// lods and lodCount as Mesh::CreateMesh takes them, up to MAX_LODS.
+		static bool Save(const char* fileLocation, const GLfloat* vertices, const unsigned int* indices, unsigned int numOfVertices, unsigned int numOfIndices,
+			const Mesh::Lod* lods = nullptr, unsigned int lodCount = 0);
+
+		// Maps a file and checks it: header, vertex format, that the blobs fit in the file and that every index points at a vertex.
+		bool Open(const char* fileLocation);
+		void Close();
+
+		// Vertices are straight into the mapping, indices are the decoded ones. Only valid until Close.
+		const GLfloat* GetVertices();
+		const unsigned int* GetIndices();
+		unsigned int GetVertexCount(); // Floats, like Mesh::CreateMesh.
+		unsigned int GetIndexCount(); // Every level of detail together.
+		const Mesh::Lod* GetLods();
+		unsigned int GetLodCount();
+
+		// Opens a file, makes a mesh from it and closes it again. nullptr if the file isn't there or isn't a mesh we can read.
+		static Mesh* LoadMesh(const char* fileLocation);
+
+		~MeshFile();
+
+	private:
+		static const GLuint MAGIC = 0x4853454D; // "MESH"
+		static const GLuint VERSION = 3; // 2: indices encoded by IndexCodec. 3: levels of detail.
+		static const GLuint MAX_ATTRIBUTES = 8;
+		static const GLuint BLOB_ALIGNMENT = 16;
+
+		// One vertex attribute, as glVertexAttribPointer takes it.
+		struct Attribute
+		{
+			GLuint location;
+			GLuint components;
+			GLenum type;
+			GLuint offset; // Bytes from the start of the vertex.
+		};
+
+		struct Header
+		{
+			GLuint magic;
+			GLuint version;
+			GLuint vertexCount; // Vertices, not floats.
+			GLuint indexCount;
+			GLuint vertexStride; // Bytes per vertex.
+			GLuint attributeCount;
+			Attribute attributes[MAX_ATTRIBUTES];
+			GLuint vertexOffset, vertexSize; // Where the blobs are in the file, in bytes.
+			GLuint indexOffset, indexSize; // indexSize is the encoded size.
+			GLuint lodCount;
+			Mesh::Lod lods[MAX_LODS]; // Where each level's indices are, among all of them.
+		};
+
+		// The vertex format Mesh::CreateMesh sets up. Files have to match it. Everything but the index blob's size, which depends on the indices.
+		static Header MakeHeader(unsigned int vertexCount, unsigned int indexCount);
+
+		const unsigned char* data;
+		size_t size;
+		const Header* header;
+		std::vector<unsigned int> indices;
+
+#ifdef _WIN32
+		void* fileHandle;
+		void* mappingHandle;
+#else
+		int fileDescriptor;
+#endif
+
+		bool MapFile(const char* fileLocation);
+		bool CheckHeader(const char* fileLocation);
+};
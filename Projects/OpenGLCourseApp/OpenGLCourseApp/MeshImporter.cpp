@@ -0,0 +1,1304 @@
+#include "MeshImporter.h"
+
+// glTF binary container bits.
+static const unsigned int GLB_MAGIC = 0x46546C67; // "glTF"
+static const unsigned int GLB_CHUNK_JSON = 0x4E4F534A; // "JSON"
+static const unsigned int GLB_CHUNK_BIN = 0x004E4942; // "BIN\0"
+static const int GLTF_TRIANGLES = 4;
+static const int GLTF_BYTE = 5120, GLTF_UNSIGNED_BYTE = 5121, GLTF_SHORT = 5122, GLTF_UNSIGNED_SHORT = 5123, GLTF_UNSIGNED_INT = 5125, GLTF_FLOAT = 5126;
+
+static const size_t OBJ_CHUNK_SIZE = 256 * 1024; // Bytes of text per task.
+static const unsigned int NO_VERTEX = 0xFFFFFFFF;
+
+bool MeshImporter::Run(int argc, char** argv)
+{
+	int first = 0;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--check-import") == 0)
+		{
+			CheckNormals();
+			return true;
+		}
+		if (strcmp(argv[i], "--import-mesh") == 0)
+		{
+			first = i + 1;
+			break;
+		}
+	}
+	if (first == 0)
+	{
+		return false;
+	}
+
+	if (argc - first < 2)
+	{
+		printf("Usage: --import-mesh <model.obj|model.glb> <destination.mesh>\n");
+		return true;
+	}
+
+	ThreadPool threadPool;
+	threadPool.Init();
+
+	std::vector<GLfloat> vertices;
+	std::vector<unsigned int> indices;
+	std::vector<Mesh::Lod> lods;
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	if (!Import(argv[first], vertices, indices, lods, &threadPool))
+	{
+		return true;
+	}
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+	printf("Imported %s: %u vertices, %u triangles in %.1f ms on %u threads\n", argv[first], (unsigned int)(vertices.size() / 8),
+		lods[0].indexCount / 3, elapsed.count(), threadPool.GetThreadCount());
+
+	if (!MeshFile::Save(argv[first + 1], vertices.data(), indices.data(), (unsigned int)vertices.size(), (unsigned int)indices.size(),
+		lods.data(), (unsigned int)lods.size()))
+	{
+		printf("Failed to write: %s\n", argv[first + 1]);
+	}
+	return true;
+}
+
+bool MeshImporter::CheckNormals()
+{
+	// A quad lying flat at y = 0, counter clockwise seen from above, so it faces up. As 2 triangles of a fan, like any OBJ polygon.
+	const GLfloat quad[4][3] = { { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f } };
+	const unsigned int quadIndices[6] = { 0, 1, 2, 0, 2, 3 };
+
+	const char* objWithNormals = "v 0 0 0\nv 0 0 1\nv 1 0 1\nv 1 0 0\nvn 0 1 0\nf 1//1 2//1 3//1 4//1\n";
+	const char* objWithoutNormals = "v 0 0 0\nv 0 0 1\nv 1 0 1\nv 1 0 0\nf 1 2 3 4\n";
+
+	// The same quad as a .glb: positions, normals, then the indices, in the binary chunk.
+	auto makeGLB = [&](bool withNormals)
+	{
+		std::string text = "{\"asset\":{\"version\":\"2.0\"},\"buffers\":[{\"byteLength\":120}],"
+			"\"bufferViews\":[{\"buffer\":0,\"byteOffset\":0,\"byteLength\":48},{\"buffer\":0,\"byteOffset\":48,\"byteLength\":48},"
+			"{\"buffer\":0,\"byteOffset\":96,\"byteLength\":24}],"
+			"\"accessors\":[{\"bufferView\":0,\"componentType\":5126,\"count\":4,\"type\":\"VEC3\"},"
+			"{\"bufferView\":1,\"componentType\":5126,\"count\":4,\"type\":\"VEC3\"},"
+			"{\"bufferView\":2,\"componentType\":5125,\"count\":6,\"type\":\"SCALAR\"}],"
+			"\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0";
+		text += withNormals ? ",\"NORMAL\":1}" : "}";
+		text += ",\"indices\":2}]}]}";
+		while (text.size() % 4 != 0)
+		{
+			text += ' ';
+		}
+
+		std::vector<unsigned char> binary(120);
+		const GLfloat up[3] = { 0.0f, 1.0f, 0.0f };
+		for (unsigned int v = 0; v < 4; v++)
+		{
+			memcpy(&binary[v * 12], quad[v], 12);
+			memcpy(&binary[48 + v * 12], up, 12);
+		}
+		memcpy(&binary[96], quadIndices, 24);
+
+		unsigned int header[5] = { GLB_MAGIC, 2, (unsigned int)(20 + text.size() + 8 + binary.size()), (unsigned int)text.size(), GLB_CHUNK_JSON };
+		unsigned int binaryHeader[2] = { (unsigned int)binary.size(), GLB_CHUNK_BIN };
+		std::vector<unsigned char> file((const unsigned char*)header, (const unsigned char*)header + sizeof(header));
+		file.insert(file.end(), text.begin(), text.end());
+		file.insert(file.end(), (const unsigned char*)binaryHeader, (const unsigned char*)binaryHeader + sizeof(binaryHeader));
+		file.insert(file.end(), binary.begin(), binary.end());
+		return file;
+	};
+
+	// Every vertex should come out facing down, (0, -1, 0), like the floor in main.cpp's MakeFloor.
+	auto check = [](const char* name, bool imported, const std::vector<GLfloat>& vertices)
+	{
+		bool facingDown = imported && !vertices.empty();
+		for (size_t v = 0; facingDown && v < vertices.size() / 8; v++)
+		{
+			const GLfloat* normal = &vertices[v * 8 + 5];
+			facingDown = fabsf(normal[0]) < 0.001f && fabsf(normal[1] + 1.0f) < 0.001f && fabsf(normal[2]) < 0.001f;
+		}
+		printf("  %-26s %s\n", name, facingDown ? "OK" : "WRONG");
+		return facingDown;
+	};
+
+	printf("Normals of an imported quad facing +Y:\n");
+	std::vector<GLfloat> vertices;
+	std::vector<unsigned int> indices;
+	bool passed = check("OBJ, normals in the file", ImportOBJ(objWithNormals, strlen(objWithNormals), vertices, indices), vertices);
+	passed = check("OBJ, calculated normals", ImportOBJ(objWithoutNormals, strlen(objWithoutNormals), vertices, indices), vertices) && passed;
+	std::vector<unsigned char> glb = makeGLB(true);
+	passed = check("glTF, normals in the file", ImportGLB(glb.data(), glb.size(), vertices, indices), vertices) && passed;
+	glb = makeGLB(false);
+	passed = check("glTF, calculated normals", ImportGLB(glb.data(), glb.size(), vertices, indices), vertices) && passed;
+	return passed;
+}
+
+void MeshImporter::FlipNormals(GLfloat* vertices, unsigned int vertexCount, ThreadPool* threadPool)
+{
+	MeshProcessing::RunBlocks(vertexCount, 16384, threadPool, [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int v = begin; v < end; v++)
+		{
+			for (unsigned int i = 5; i < 8; i++)
+			{
+				vertices[(size_t)v * 8 + i] = -vertices[(size_t)v * 8 + i];
+			}
+		}
+	});
+}
+
+bool MeshImporter::ReadFile(const char* fileLocation, std::vector<char>& contents)
+{
+	FILE* file = fopen(fileLocation, "rb");
+	if (!file)
+	{
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	contents.resize(size > 0 ? (size_t)size : 0);
+	bool read = size >= 0 && fread(contents.data(), 1, contents.size(), file) == contents.size();
+	fclose(file);
+
+	return read;
+}
+
+bool MeshImporter::Import(const char* fileLocation, std::vector<GLfloat>& vertices, std::vector<unsigned int>& indices, std::vector<Mesh::Lod>& lods,
+	ThreadPool* threadPool)
+{
+	std::string extension = fileLocation;
+	size_t dot = extension.find_last_of('.');
+	extension = dot == std::string::npos ? "" : extension.substr(dot);
+	for (size_t i = 0; i < extension.size(); i++)
+	{
+		extension[i] = (char)tolower((unsigned char)extension[i]);
+	}
+	if (extension != ".obj" && extension != ".glb")
+	{
+		printf("%s: only .obj and .glb models can be imported.\n", fileLocation);
+		return false;
+	}
+
+	std::vector<char> contents;
+	if (!ReadFile(fileLocation, contents))
+	{
+		printf("Failed to find: %s\n", fileLocation);
+		return false;
+	}
+
+	bool imported = extension == ".obj" ? ImportOBJ(contents.data(), contents.size(), vertices, indices, threadPool) :
+		ImportGLB((const unsigned char*)contents.data(), contents.size(), vertices, indices, threadPool);
+	if (!imported)
+	{
+		printf("Failed to import: %s\n", fileLocation);
+		return false;
+	}
+
+	// Whatever order the modelling program left the triangles in, into one the GPU draws faster.
+	MeshOptimizer::Optimize(vertices, indices, 8, fileLocation);
+	MeshSimplifier::BuildLodChain(indices, vertices.data(), (unsigned int)vertices.size(), 8, lods, fileLocation);
+	return true;
+}
+
+Mesh* MeshImporter::LoadMesh(const char* fileLocation, ThreadPool* threadPool)
+{
+	std::vector<GLfloat> vertices;
+	std::vector<unsigned int> indices;
+	std::vector<Mesh::Lod> lods;
+	if (!Import(fileLocation, vertices, indices, lods, threadPool) || indices.empty())
+	{
+		return nullptr;
+	}
+
+	Mesh* mesh = new Mesh();
+	mesh->CreateMesh(vertices.data(), indices.data(), (unsigned int)vertices.size(), (unsigned int)indices.size(), VERTEX_FORMAT,
+		lods.data(), (unsigned int)lods.size());
+	return mesh;
+}
+
+// ---- OBJ ----
+
+const char* MeshImporter::ParseFloat(const char* c, const char* end, GLfloat& value)
+{
+	// strtof is correct to the last bit but slow, and needs the text to end with a 0. Digits into a double, then the exponent, is plenty for floats.
+	static const double powersOf10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+		1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+	while (c < end && (*c == ' ' || *c == '\t'))
+	{
+		c++;
+	}
+
+	bool negative = false;
+	if (c < end && (*c == '-' || *c == '+'))
+	{
+		negative = *c == '-';
+		c++;
+	}
+
+	double mantissa = 0.0;
+	int exponent = 0;
+	while (c < end && *c >= '0' && *c <= '9')
+	{
+		mantissa = mantissa * 10.0 + (*c - '0');
+		c++;
+	}
+	if (c < end && *c == '.')
+	{
+		c++;
+		while (c < end && *c >= '0' && *c <= '9')
+		{
+			mantissa = mantissa * 10.0 + (*c - '0');
+			exponent--;
+			c++;
+		}
+	}
+	if (c < end && (*c == 'e' || *c == 'E'))
+	{
+		c++;
+		bool negativeExponent = false;
+		if (c < end && (*c == '-' || *c == '+'))
+		{
+			negativeExponent = *c == '-';
+			c++;
+		}
+		int written = 0;
+		while (c < end && *c >= '0' && *c <= '9')
+		{
+			written = std::min(written * 10 + (*c - '0'), 1000);
+			c++;
+		}
+		exponent += negativeExponent ? -written : written;
+	}
+
+	// Dividing by an exact power of 10 rounds better than multiplying by an inexact 1e-n.
+	if (exponent < 0)
+	{
+		mantissa = exponent >= -22 ? mantissa / powersOf10[-exponent] : mantissa * std::pow(10.0, exponent);
+	}
+	else if (exponent > 0)
+	{
+		mantissa = exponent <= 22 ? mantissa * powersOf10[exponent] : mantissa * std::pow(10.0, exponent);
+	}
+
+	value = (GLfloat)(negative ? -mantissa : mantissa);
+	return c;
+}
+
+const char* MeshImporter::ParseInt(const char* c, const char* end, int& value, bool& found)
+{
+	bool negative = false;
+	if (c < end && (*c == '-' || *c == '+'))
+	{
+		negative = *c == '-';
+		c++;
+	}
+
+	long long number = 0;
+	found = false;
+	while (c < end && *c >= '0' && *c <= '9')
+	{
+		number = std::min(number * 10 + (*c - '0'), 0x7FFFFFFFLL);
+		found = true;
+		c++;
+	}
+
+	value = (int)(negative ? -number : number);
+	return c;
+}
+
+void MeshImporter::ParseObjChunk(ObjChunk& chunk)
+{
+	std::vector<Corner> polygon;
+	const char* c = chunk.start;
+	const char* end = chunk.end;
+	chunk.failed = false;
+
+	while (c < end)
+	{
+		const char* lineEnd = (const char*)memchr(c, '\n', end - c);
+		if (!lineEnd)
+		{
+			lineEnd = end;
+		}
+
+		while (c < lineEnd && (*c == ' ' || *c == '\t'))
+		{
+			c++;
+		}
+
+		if (lineEnd - c >= 2 && c[0] == 'v' && (c[1] == ' ' || c[1] == '\t'))
+		{
+			GLfloat x, y, z;
+			c = ParseFloat(c + 1, lineEnd, x);
+			c = ParseFloat(c, lineEnd, y);
+			ParseFloat(c, lineEnd, z);
+			chunk.positions.push_back(x);
+			chunk.positions.push_back(y);
+			chunk.positions.push_back(z);
+		}
+		else if (lineEnd - c >= 3 && c[0] == 'v' && c[1] == 't' && (c[2] == ' ' || c[2] == '\t'))
+		{
+			GLfloat u, v;
+			c = ParseFloat(c + 2, lineEnd, u);
+			ParseFloat(c, lineEnd, v);
+			chunk.uvs.push_back(u);
+			chunk.uvs.push_back(v);
+		}
+		else if (lineEnd - c >= 3 && c[0] == 'v' && c[1] == 'n' && (c[2] == ' ' || c[2] == '\t'))
+		{
+			GLfloat x, y, z;
+			c = ParseFloat(c + 2, lineEnd, x);
+			c = ParseFloat(c, lineEnd, y);
+			ParseFloat(c, lineEnd, z);
+			chunk.normals.push_back(x);
+			chunk.normals.push_back(y);
+			chunk.normals.push_back(z);
+		}
+		else if (lineEnd - c >= 2 && c[0] == 'f' && (c[1] == ' ' || c[1] == '\t'))
+		{
+			// Corners are "p", "p/t", "p//n" or "p/t/n". Indices start at 1, and negative ones count back from the last one read.
+			int counts[3] = { (int)chunk.positions.size() / 3, (int)chunk.uvs.size() / 2, (int)chunk.normals.size() / 3 };
+			polygon.clear();
+			c++;
+			while (true)
+			{
+				while (c < lineEnd && (*c == ' ' || *c == '\t'))
+				{
+					c++;
+				}
+				if (c >= lineEnd || *c == '\r' || *c == '#')
+				{
+					break;
+				}
+
+				int values[3] = { 0, 0, 0 };
+				bool found[3] = { false, false, false };
+				c = ParseInt(c, lineEnd, values[0], found[0]);
+				for (int k = 1; k < 3 && c < lineEnd && *c == '/'; k++)
+				{
+					c = ParseInt(c + 1, lineEnd, values[k], found[k]);
+				}
+				if (!found[0] || (c < lineEnd && *c != ' ' && *c != '\t' && *c != '\r'))
+				{
+					chunk.failed = true;
+					return;
+				}
+
+				Corner corner;
+				corner.relative = 0;
+				int* indices[3] = { &corner.position, &corner.uv, &corner.normal };
+				for (int k = 0; k < 3; k++)
+				{
+					if (!found[k] || values[k] == 0)
+					{
+						*indices[k] = -1;
+					}
+					else if (values[k] > 0)
+					{
+						*indices[k] = values[k] - 1;
+					}
+					else
+					{
+						*indices[k] = counts[k] + values[k];
+						corner.relative |= 1 << k;
+					}
+				}
+				polygon.push_back(corner);
+			}
+
+			for (size_t i = 1; i + 1 < polygon.size(); i++)
+			{
+				chunk.corners.push_back(polygon[0]);
+				chunk.corners.push_back(polygon[i]);
+				chunk.corners.push_back(polygon[i + 1]);
+			}
+		}
+
+		c = lineEnd + 1;
+	}
+}
+
+void MeshImporter::WeldCorners(const std::vector<Corner>& corners, std::vector<unsigned int>& cornerVertices, std::vector<unsigned int>& firstCorners,
+	ThreadPool* threadPool)
+{
+	unsigned int cornerCount = (unsigned int)corners.size();
+	auto sameVertex = [](const Corner& a, const Corner& b)
+	{
+		return a.position == b.position && a.uv == b.uv && a.normal == b.normal;
+	};
+
+	std::vector<unsigned int> hashes(cornerCount);
+	MeshProcessing::RunBlocks(cornerCount, 65536, threadPool, [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int i = begin; i < end; i++)
+		{
+			unsigned int hash = (unsigned int)corners[i].position * 0x9E3779B1u ^ (unsigned int)(corners[i].uv + 1) * 0x85EBCA77u ^
+				(unsigned int)(corners[i].normal + 1) * 0xC2B2AE3Du;
+			hash ^= hash >> 15;
+			hash *= 0x2C1B3C6Du;
+			hash ^= hash >> 12;
+			hashes[i] = hash;
+		}
+	});
+
+	// The hash decides which thread welds a corner, so the same vertex always ends up in the same table and no table is shared.
+	// Each thread goes over every corner, but only hashes the ones that are its own.
+	unsigned int partitionCount = threadPool ? threadPool->GetThreadCount() : 1;
+	std::vector<std::vector<unsigned int>> partitionFirsts(partitionCount); // First corner using each vertex of a partition.
+	std::vector<unsigned int> localVertices(cornerCount);
+
+	auto weldPartition = [&](unsigned int partition)
+	{
+		std::vector<unsigned int>& firsts = partitionFirsts[partition];
+		unsigned int capacity = 1024;
+		std::vector<unsigned int> table(capacity, NO_VERTEX); // Open addressing, holding vertex numbers.
+
+		for (unsigned int i = 0; i < cornerCount; i++)
+		{
+			if (hashes[i] % partitionCount != partition)
+			{
+				continue;
+			}
+
+			// Kept at most half full, so the searches stay short.
+			if (firsts.size() * 2 >= capacity)
+			{
+				capacity *= 2;
+				table.assign(capacity, NO_VERTEX);
+				for (unsigned int vertex = 0; vertex < firsts.size(); vertex++)
+				{
+					unsigned int slot = (hashes[firsts[vertex]] / partitionCount) & (capacity - 1);
+					while (table[slot] != NO_VERTEX)
+					{
+						slot = (slot + 1) & (capacity - 1);
+					}
+					table[slot] = vertex;
+				}
+			}
+
+			unsigned int slot = (hashes[i] / partitionCount) & (capacity - 1);
+			while (table[slot] != NO_VERTEX && !sameVertex(corners[firsts[table[slot]]], corners[i]))
+			{
+				slot = (slot + 1) & (capacity - 1);
+			}
+			if (table[slot] == NO_VERTEX)
+			{
+				table[slot] = (unsigned int)firsts.size();
+				firsts.push_back(i);
+			}
+			localVertices[i] = table[slot];
+		}
+	};
+
+	if (threadPool)
+	{
+		threadPool->ParallelFor(partitionCount, weldPartition);
+	}
+	else
+	{
+		weldPartition(0);
+	}
+
+	std::vector<unsigned int> partitionStarts(partitionCount, 0);
+	unsigned int vertexCount = 0;
+	for (unsigned int partition = 0; partition < partitionCount; partition++)
+	{
+		partitionStarts[partition] = vertexCount;
+		vertexCount += (unsigned int)partitionFirsts[partition].size();
+	}
+
+	// Numbered by first use rather than by partition, so triangles next to each other in the file use vertices next to each other in memory.
+	std::vector<unsigned int> renumber(vertexCount, NO_VERTEX);
+	cornerVertices.resize(cornerCount);
+	firstCorners.clear();
+	firstCorners.reserve(vertexCount);
+	for (unsigned int i = 0; i < cornerCount; i++)
+	{
+		unsigned int vertex = partitionStarts[hashes[i] % partitionCount] + localVertices[i];
+		if (renumber[vertex] == NO_VERTEX)
+		{
+			renumber[vertex] = (unsigned int)firstCorners.size();
+			firstCorners.push_back(i);
+		}
+		cornerVertices[i] = renumber[vertex];
+	}
+}
+
+bool MeshImporter::ImportOBJ(const char* text, size_t size, std::vector<GLfloat>& vertices, std::vector<unsigned int>& indices, ThreadPool* threadPool)
+{
+	// Cutting the text into chunks that end at the end of a line.
+	std::vector<ObjChunk> chunks((size + OBJ_CHUNK_SIZE - 1) / OBJ_CHUNK_SIZE);
+	const char* end = text + size;
+	const char* start = text;
+	for (size_t i = 0; i < chunks.size(); i++)
+	{
+		const char* chunkEnd = std::min(text + (i + 1) * OBJ_CHUNK_SIZE, end);
+		if (chunkEnd < end)
+		{
+			const char* newline = (const char*)memchr(chunkEnd, '\n', end - chunkEnd);
+			chunkEnd = newline ? newline + 1 : end;
+		}
+		chunks[i].start = std::min(start, chunkEnd);
+		chunks[i].end = chunkEnd;
+		start = chunkEnd;
+	}
+
+	unsigned int chunkCount = (unsigned int)chunks.size();
+	auto parseChunk = [&](unsigned int i)
+	{
+		ParseObjChunk(chunks[i]);
+	};
+	if (threadPool)
+	{
+		threadPool->ParallelFor(chunkCount, parseChunk);
+	}
+	else
+	{
+		for (unsigned int i = 0; i < chunkCount; i++)
+		{
+			parseChunk(i);
+		}
+	}
+
+	// Where each chunk's values start once they are all put together.
+	std::vector<int> positionStarts(chunkCount), uvStarts(chunkCount), normalStarts(chunkCount);
+	std::vector<size_t> cornerStarts(chunkCount);
+	int positionCount = 0, uvCount = 0, normalCount = 0;
+	size_t cornerCount = 0;
+	for (unsigned int i = 0; i < chunkCount; i++)
+	{
+		if (chunks[i].failed)
+		{
+			printf("OBJ face with a corner that isn't a number.\n");
+			return false;
+		}
+		positionStarts[i] = positionCount;
+		uvStarts[i] = uvCount;
+		normalStarts[i] = normalCount;
+		cornerStarts[i] = cornerCount;
+		positionCount += (int)chunks[i].positions.size() / 3;
+		uvCount += (int)chunks[i].uvs.size() / 2;
+		normalCount += (int)chunks[i].normals.size() / 3;
+		cornerCount += chunks[i].corners.size();
+	}
+
+	std::vector<GLfloat> positions((size_t)positionCount * 3), uvs((size_t)uvCount * 2), normals((size_t)normalCount * 3);
+	std::vector<Corner> corners(cornerCount);
+	std::atomic<bool> badIndex(false), missingNormals(false);
+	auto gatherChunk = [&](unsigned int i)
+	{
+		ObjChunk& chunk = chunks[i];
+		std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + (size_t)positionStarts[i] * 3);
+		std::copy(chunk.uvs.begin(), chunk.uvs.end(), uvs.begin() + (size_t)uvStarts[i] * 2);
+		std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + (size_t)normalStarts[i] * 3);
+
+		for (size_t c = 0; c < chunk.corners.size(); c++)
+		{
+			Corner corner = chunk.corners[c];
+			corner.position += (corner.relative & 1) ? positionStarts[i] : 0;
+			corner.uv += (corner.relative & 2) ? uvStarts[i] : 0;
+			corner.normal += (corner.relative & 4) ? normalStarts[i] : 0;
+			corner.relative = 0;
+
+			if (corner.position < 0 || corner.position >= positionCount || corner.uv < -1 || corner.uv >= uvCount ||
+				corner.normal < -1 || corner.normal >= normalCount)
+			{
+				badIndex = true;
+			}
+			if (corner.normal < 0)
+			{
+				missingNormals = true;
+			}
+			corners[cornerStarts[i] + c] = corner;
+		}
+
+		// Done with the chunk's own copy.
+		std::vector<Corner>().swap(chunk.corners);
+	};
+	if (threadPool)
+	{
+		threadPool->ParallelFor(chunkCount, gatherChunk);
+	}
+	else
+	{
+		for (unsigned int i = 0; i < chunkCount; i++)
+		{
+			gatherChunk(i);
+		}
+	}
+	if (badIndex)
+	{
+		printf("OBJ face pointing at a vertex that isn't in the file.\n");
+		return false;
+	}
+
+	std::vector<unsigned int> firstCorners;
+	WeldCorners(corners, indices, firstCorners, threadPool);
+
+	unsigned int vertexCount = (unsigned int)firstCorners.size();
+	bool keepNormals = !missingNormals; // If any corner is missing one, they are all calculated afterwards.
+	vertices.resize((size_t)vertexCount * 8);
+	MeshProcessing::RunBlocks(vertexCount, 16384, threadPool, [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int v = begin; v < end; v++)
+		{
+			const Corner& corner = corners[firstCorners[v]];
+			GLfloat* vertex = &vertices[(size_t)v * 8];
+			vertex[0] = positions[corner.position * 3];
+			vertex[1] = positions[corner.position * 3 + 1];
+			vertex[2] = positions[corner.position * 3 + 2];
+			// OBJ has V going up from the bottom of the image. Our textures start at the top row.
+			vertex[3] = corner.uv >= 0 ? uvs[corner.uv * 2] : 0.0f;
+			vertex[4] = corner.uv >= 0 ? 1.0f - uvs[corner.uv * 2 + 1] : 0.0f;
+			// OBJ normals point out of the surface. Ours point in (see FlipNormals).
+			vertex[5] = keepNormals ? -normals[corner.normal * 3] : 0.0f;
+			vertex[6] = keepNormals ? -normals[corner.normal * 3 + 1] : 0.0f;
+			vertex[7] = keepNormals ? -normals[corner.normal * 3 + 2] : 0.0f;
+		}
+	});
+
+	if (missingNormals)
+	{
+		MeshProcessing::CalcNormals(indices.data(), (unsigned int)indices.size(), vertices.data(), (unsigned int)vertices.size(), 8, 5,
+			NORMAL_WEIGHT_ANGLE, threadPool);
+		FlipNormals(vertices.data(), vertexCount, threadPool);
+	}
+
+	return true;
+}
+
+// ---- glTF ----
+
+const MeshImporter::JsonValue* MeshImporter::JsonValue::Get(const char* key) const
+{
+	for (size_t i = 0; i < keys.size(); i++)
+	{
+		if (keys[i] == key)
+		{
+			return &items[i];
+		}
+	}
+	return nullptr;
+}
+
+double MeshImporter::JsonValue::GetNumber(const char* key, double fallback) const
+{
+	const JsonValue* value = Get(key);
+	return value && (value->type == JSON_NUMBER || value->type == JSON_BOOL) ? value->number : fallback;
+}
+
+bool MeshImporter::ParseJson(const char*& c, const char* end, JsonValue& value, unsigned int depth)
+{
+	auto skipSpace = [&]()
+	{
+		while (c < end && (*c == ' ' || *c == '\t' || *c == '\n' || *c == '\r'))
+		{
+			c++;
+		}
+	};
+	auto parseString = [&](std::string& text)
+	{
+		c++; // The opening quote.
+		while (c < end && *c != '"')
+		{
+			if (*c == '\\' && c + 1 < end)
+			{
+				c++;
+				switch (*c)
+				{
+					case 'n': text += '\n'; break;
+					case 't': text += '\t'; break;
+					case 'r': text += '\r'; break;
+					case 'b': text += '\b'; break;
+					case 'f': text += '\f'; break;
+					case 'u':
+					{
+						// Only used for names, which we don't look at. Anything outside ASCII becomes a '?'.
+						unsigned int code = c + 4 < end ? (unsigned int)strtoul(std::string(c + 1, c + 5).c_str(), nullptr, 16) : 0;
+						text += code < 128 ? (char)code : '?';
+						c += 4;
+						break;
+					}
+					default: text += *c; break; // \" \\ and \/
+				}
+			}
+			else
+			{
+				text += *c;
+			}
+			c++;
+		}
+		if (c >= end)
+		{
+			return false;
+		}
+		c++; // The closing quote.
+		return true;
+	};
+
+	if (depth > 64)
+	{
+		return false; // Nothing in a glTF file is nested that deep.
+	}
+
+	skipSpace();
+	if (c >= end)
+	{
+		return false;
+	}
+
+	if (*c == '{')
+	{
+		value.type = JsonValue::JSON_OBJECT;
+		c++;
+		skipSpace();
+		if (c < end && *c == '}')
+		{
+			c++;
+			return true;
+		}
+		while (c < end)
+		{
+			skipSpace();
+			std::string key;
+			if (c >= end || *c != '"' || !parseString(key))
+			{
+				return false;
+			}
+			skipSpace();
+			if (c >= end || *c != ':')
+			{
+				return false;
+			}
+			c++;
+			value.keys.push_back(key);
+			value.items.push_back(JsonValue());
+			if (!ParseJson(c, end, value.items.back(), depth + 1))
+			{
+				return false;
+			}
+			skipSpace();
+			if (c < end && *c == ',')
+			{
+				c++;
+			}
+			else if (c < end && *c == '}')
+			{
+				c++;
+				return true;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		return false;
+	}
+
+	if (*c == '[')
+	{
+		value.type = JsonValue::JSON_ARRAY;
+		c++;
+		skipSpace();
+		if (c < end && *c == ']')
+		{
+			c++;
+			return true;
+		}
+		while (c < end)
+		{
+			value.items.push_back(JsonValue());
+			if (!ParseJson(c, end, value.items.back(), depth + 1))
+			{
+				return false;
+			}
+			skipSpace();
+			if (c < end && *c == ',')
+			{
+				c++;
+			}
+			else if (c < end && *c == ']')
+			{
+				c++;
+				return true;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		return false;
+	}
+
+	if (*c == '"')
+	{
+		value.type = JsonValue::JSON_STRING;
+		return parseString(value.text);
+	}
+
+	if (end - c >= 4 && strncmp(c, "true", 4) == 0)
+	{
+		value.type = JsonValue::JSON_BOOL;
+		value.number = 1.0;
+		c += 4;
+		return true;
+	}
+	if (end - c >= 5 && strncmp(c, "false", 5) == 0)
+	{
+		value.type = JsonValue::JSON_BOOL;
+		value.number = 0.0;
+		c += 5;
+		return true;
+	}
+	if (end - c >= 4 && strncmp(c, "null", 4) == 0)
+	{
+		value.type = JsonValue::JSON_NULL;
+		c += 4;
+		return true;
+	}
+
+	// A number. The text given to us always ends with a 0, so strtod can't read past it.
+	char* numberEnd = nullptr;
+	value.type = JsonValue::JSON_NUMBER;
+	value.number = strtod(c, &numberEnd);
+	if (numberEnd == c)
+	{
+		return false;
+	}
+	c = numberEnd;
+	return true;
+}
+
+bool MeshImporter::FindAccessorData(const JsonValue& view, const JsonValue& description, size_t binarySize, size_t elementSize,
+	size_t& count, size_t& start, size_t& stride)
+{
+	// Every number straight from the JSON is checked before it is used. None can be past the end of the binary chunk,
+	// so adding two of them can't overflow.
+	auto readSize = [&](const JsonValue& value, const char* key, size_t& result)
+	{
+		double number = value.GetNumber(key, 0);
+		result = number >= 0.0 && number <= (double)binarySize ? (size_t)number : 0;
+		return number >= 0.0 && number <= (double)binarySize;
+	};
+	size_t viewStart, viewLength, offset;
+	if (!readSize(description, "count", count) || !readSize(view, "byteOffset", viewStart) || !readSize(view, "byteLength", viewLength) ||
+		!readSize(view, "byteStride", stride) || !readSize(description, "byteOffset", offset))
+	{
+		return false;
+	}
+
+	// Elements can be further apart than their size (interleaved vertices), not closer.
+	stride = stride ? stride : elementSize;
+	size_t viewEnd = viewStart + viewLength;
+	start = viewStart + offset;
+	if (stride < elementSize || viewEnd > binarySize || start > viewEnd)
+	{
+		return false;
+	}
+
+	// The last element, start + stride * (count - 1) + elementSize, has to end inside the view. Divided instead of multiplied, which can't overflow.
+	return count == 0 || (elementSize <= viewEnd - start && count - 1 <= (viewEnd - start - elementSize) / stride);
+}
+
+bool MeshImporter::ReadAccessor(const JsonValue& json, const unsigned char* binary, size_t binarySize, int accessor, unsigned int components,
+	size_t maxCount, std::vector<GLfloat>& values)
+{
+	const JsonValue* accessors = json.Get("accessors");
+	const JsonValue* bufferViews = json.Get("bufferViews");
+	if (!accessors || accessor < 0 || accessor >= (int)accessors->items.size())
+	{
+		return false;
+	}
+	const JsonValue& description = accessors->items[accessor];
+
+	const JsonValue* type = description.Get("type");
+	unsigned int typeComponents = 0;
+	if (type && type->text == "SCALAR") typeComponents = 1;
+	if (type && type->text == "VEC2") typeComponents = 2;
+	if (type && type->text == "VEC3") typeComponents = 3;
+	if (type && type->text == "VEC4") typeComponents = 4;
+	if (typeComponents < components || description.Get("sparse"))
+	{
+		return false;
+	}
+
+	int componentType = (int)description.GetNumber("componentType", 0);
+	bool normalized = description.GetNumber("normalized", 0) != 0.0;
+	size_t componentSize = componentType == GLTF_BYTE || componentType == GLTF_UNSIGNED_BYTE ? 1 :
+		componentType == GLTF_SHORT || componentType == GLTF_UNSIGNED_SHORT ? 2 :
+		componentType == GLTF_UNSIGNED_INT || componentType == GLTF_FLOAT ? 4 : 0;
+	if (componentSize == 0)
+	{
+		return false;
+	}
+
+	int bufferView = (int)description.GetNumber("bufferView", -1);
+	if (bufferView < 0)
+	{
+		// No data means all zeros. Nothing in the file says how many is sensible, so it can't be more than maxCount.
+		double count = description.GetNumber("count", 0);
+		if (count < 0.0 || count > (double)maxCount)
+		{
+			return false;
+		}
+		values.assign((size_t)count * components, 0.0f);
+		return true;
+	}
+	if (!bufferViews || bufferView >= (int)bufferViews->items.size() || bufferViews->items[bufferView].GetNumber("buffer", 0) != 0)
+	{
+		return false; // Only the buffer inside the .glb, not other files.
+	}
+
+	// Checked to be inside the binary chunk before anything is allocated for it.
+	size_t count, start, stride;
+	if (!FindAccessorData(bufferViews->items[bufferView], description, binarySize, componentSize * typeComponents, count, start, stride))
+	{
+		return false;
+	}
+	values.assign(count * components, 0.0f);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const unsigned char* element = binary + start + stride * i;
+		for (unsigned int k = 0; k < components; k++)
+		{
+			const unsigned char* component = element + componentSize * k;
+			GLfloat value = 0.0f;
+			switch (componentType)
+			{
+				case GLTF_FLOAT: memcpy(&value, component, 4); break;
+				case GLTF_UNSIGNED_BYTE: value = normalized ? component[0] / 255.0f : component[0]; break;
+				case GLTF_BYTE: value = normalized ? std::max((signed char)component[0] / 127.0f, -1.0f) : (signed char)component[0]; break;
+				case GLTF_UNSIGNED_SHORT:
+				{
+					unsigned short number;
+					memcpy(&number, component, 2);
+					value = normalized ? number / 65535.0f : number;
+					break;
+				}
+				case GLTF_SHORT:
+				{
+					short number;
+					memcpy(&number, component, 2);
+					value = normalized ? std::max(number / 32767.0f, -1.0f) : number;
+					break;
+				}
+				case GLTF_UNSIGNED_INT:
+				{
+					unsigned int number;
+					memcpy(&number, component, 4);
+					value = (GLfloat)number;
+					break;
+				}
+			}
+			values[i * components + k] = value;
+		}
+	}
+	return true;
+}
+
+bool MeshImporter::ReadIndices(const JsonValue& json, const unsigned char* binary, size_t binarySize, int accessor, std::vector<unsigned int>& values)
+{
+	const JsonValue* accessors = json.Get("accessors");
+	const JsonValue* bufferViews = json.Get("bufferViews");
+	if (!accessors || accessor < 0 || accessor >= (int)accessors->items.size())
+	{
+		return false;
+	}
+	const JsonValue& description = accessors->items[accessor];
+
+	int componentType = (int)description.GetNumber("componentType", 0);
+	size_t componentSize = componentType == GLTF_UNSIGNED_BYTE ? 1 : componentType == GLTF_UNSIGNED_SHORT ? 2 : componentType == GLTF_UNSIGNED_INT ? 4 : 0;
+	int bufferView = (int)description.GetNumber("bufferView", -1);
+	if (componentSize == 0 || !bufferViews || bufferView < 0 || bufferView >= (int)bufferViews->items.size() ||
+		bufferViews->items[bufferView].GetNumber("buffer", 0) != 0)
+	{
+		return false;
+	}
+
+	size_t count, start, stride;
+	if (!FindAccessorData(bufferViews->items[bufferView], description, binarySize, componentSize, count, start, stride))
+	{
+		return false;
+	}
+
+	values.resize(count);
+	const unsigned char* data = binary + start;
+	for (size_t i = 0; i < count; i++)
+	{
+		if (componentSize == 1)
+		{
+			values[i] = data[i * stride];
+		}
+		else if (componentSize == 2)
+		{
+			unsigned short index;
+			memcpy(&index, data + i * stride, 2);
+			values[i] = index;
+		}
+		else
+		{
+			memcpy(&values[i], data + i * stride, 4);
+		}
+	}
+	return true;
+}
+
+glm::mat4 MeshImporter::GetNodeMatrix(const JsonValue& node)
+{
+	const JsonValue* matrix = node.Get("matrix");
+	if (matrix && matrix->items.size() == 16)
+	{
+		// Column by column, like glm.
+		glm::mat4 result;
+		for (int i = 0; i < 16; i++)
+		{
+			result[i / 4][i % 4] = (GLfloat)matrix->items[i].number;
+		}
+		return result;
+	}
+
+	glm::vec3 translation(0.0f), scale(1.0f);
+	glm::quat rotation(1.0f, 0.0f, 0.0f, 0.0f);
+	const JsonValue* values = node.Get("translation");
+	if (values && values->items.size() == 3)
+	{
+		translation = glm::vec3(values->items[0].number, values->items[1].number, values->items[2].number);
+	}
+	values = node.Get("rotation");
+	if (values && values->items.size() == 4)
+	{
+		// glTF stores x, y, z, w. glm's constructor takes w first.
+		rotation = glm::quat((GLfloat)values->items[3].number, (GLfloat)values->items[0].number, (GLfloat)values->items[1].number, (GLfloat)values->items[2].number);
+	}
+	values = node.Get("scale");
+	if (values && values->items.size() == 3)
+	{
+		scale = glm::vec3(values->items[0].number, values->items[1].number, values->items[2].number);
+	}
+
+	return glm::translate(glm::mat4(1.0f), translation) * glm::mat4_cast(rotation) * glm::scale(glm::mat4(1.0f), scale);
+}
+
+bool MeshImporter::AddMesh(const JsonValue& json, const unsigned char* binary, size_t binarySize, int mesh, const glm::mat4& matrix,
+	std::vector<GLfloat>& vertices, std::vector<unsigned int>& indices, ThreadPool* threadPool)
+{
+	const JsonValue* meshes = json.Get("meshes");
+	if (!meshes || mesh < 0 || mesh >= (int)meshes->items.size())
+	{
+		return false;
+	}
+	const JsonValue* primitives = meshes->items[mesh].Get("primitives");
+	if (!primitives)
+	{
+		return true;
+	}
+
+	glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(matrix)));
+	bool mirrored = glm::determinant(glm::mat3(matrix)) < 0.0f; // Turns the triangles inside out, so their corners have to be swapped back.
+
+	for (size_t p = 0; p < primitives->items.size(); p++)
+	{
+		const JsonValue& primitive = primitives->items[p];
+		const JsonValue* attributes = primitive.Get("attributes");
+		if ((int)primitive.GetNumber("mode", GLTF_TRIANGLES) != GLTF_TRIANGLES || !attributes || !attributes->Get("POSITION"))
+		{
+			continue; // Lines and points, or nothing to draw.
+		}
+
+		std::vector<GLfloat> positions, normals, uvs;
+		// Positions have to be in the file. Normals and UVs without data can't be more than there are positions.
+		if (!ReadAccessor(json, binary, binarySize, (int)attributes->GetNumber("POSITION", -1), 3, 0, positions))
+		{
+			return false;
+		}
+		size_t positionCount = positions.size() / 3;
+		bool hasNormals = attributes->Get("NORMAL") != nullptr;
+		bool hasUVs = attributes->Get("TEXCOORD_0") != nullptr;
+		if ((hasNormals && !ReadAccessor(json, binary, binarySize, (int)attributes->GetNumber("NORMAL", -1), 3, positionCount, normals)) ||
+			(hasUVs && !ReadAccessor(json, binary, binarySize, (int)attributes->GetNumber("TEXCOORD_0", -1), 2, positionCount, uvs)))
+		{
+			return false;
+		}
+
+		unsigned int vertexCount = (unsigned int)(positions.size() / 3);
+		if (normals.size() != positions.size())
+		{
+			hasNormals = false;
+		}
+		if (uvs.size() / 2 != vertexCount)
+		{
+			hasUVs = false;
+		}
+
+		std::vector<unsigned int> primitiveIndices;
+		if (primitive.Get("indices"))
+		{
+			if (!ReadIndices(json, binary, binarySize, (int)primitive.GetNumber("indices", -1), primitiveIndices))
+			{
+				return false;
+			}
+		}
+		else
+		{
+			primitiveIndices.resize(vertexCount);
+			for (unsigned int i = 0; i < vertexCount; i++)
+			{
+				primitiveIndices[i] = i;
+			}
+		}
+		primitiveIndices.resize(primitiveIndices.size() / 3 * 3);
+		for (size_t i = 0; i < primitiveIndices.size(); i++)
+		{
+			if (primitiveIndices[i] >= vertexCount)
+			{
+				return false;
+			}
+		}
+		if (mirrored)
+		{
+			for (size_t i = 0; i < primitiveIndices.size(); i += 3)
+			{
+				std::swap(primitiveIndices[i + 1], primitiveIndices[i + 2]);
+			}
+		}
+
+		size_t base = vertices.size() / 8;
+		vertices.resize((base + vertexCount) * 8);
+		GLfloat* destination = &vertices[base * 8];
+		MeshProcessing::RunBlocks(vertexCount, 16384, threadPool, [&](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int v = begin; v < end; v++)
+			{
+				glm::vec3 position = glm::vec3(matrix * glm::vec4(positions[v * 3], positions[v * 3 + 1], positions[v * 3 + 2], 1.0f));
+				glm::vec3 normal(0.0f);
+				if (hasNormals)
+				{
+					normal = normalMatrix * glm::vec3(normals[v * 3], normals[v * 3 + 1], normals[v * 3 + 2]);
+					GLfloat length = glm::length(normal);
+					normal = length > 0.0f ? normal / length : normal;
+				}
+
+				GLfloat* vertex = &destination[v * 8];
+				vertex[0] = position.x;
+				vertex[1] = position.y;
+				vertex[2] = position.z;
+				vertex[3] = hasUVs ? uvs[v * 2] : 0.0f;
+				vertex[4] = hasUVs ? uvs[v * 2 + 1] : 0.0f; // glTF UVs already start at the top of the image, like ours.
+				// glTF normals point out of the surface. Ours point in (see FlipNormals).
+				vertex[5] = -normal.x;
+				vertex[6] = -normal.y;
+				vertex[7] = -normal.z;
+			}
+		});
+
+		if (!hasNormals)
+		{
+			MeshProcessing::CalcNormals(primitiveIndices.data(), (unsigned int)primitiveIndices.size(), destination, vertexCount * 8, 8, 5,
+				NORMAL_WEIGHT_ANGLE, threadPool);
+			FlipNormals(destination, vertexCount, threadPool);
+		}
+
+		for (size_t i = 0; i < primitiveIndices.size(); i++)
+		{
+			indices.push_back((unsigned int)base + primitiveIndices[i]);
+		}
+	}
+	return true;
+}
+
+bool MeshImporter::AddNode(const JsonValue& json, const unsigned char* binary, size_t binarySize, int node, const glm::mat4& parent,
+	std::vector<GLfloat>& vertices, std::vector<unsigned int>& indices, ThreadPool* threadPool, unsigned int depth)
+{
+	const JsonValue* nodes = json.Get("nodes");
+	if (!nodes || node < 0 || node >= (int)nodes->items.size() || depth > 64)
+	{
+		return false; // Not there, or children that loop back on themselves.
+	}
+
+	const JsonValue& description = nodes->items[node];
+	glm::mat4 matrix = parent * GetNodeMatrix(description);
+	if (description.Get("mesh") && !AddMesh(json, binary, binarySize, (int)description.GetNumber("mesh", -1), matrix, vertices, indices, threadPool))
+	{
+		return false;
+	}
+
+	const JsonValue* children = description.Get("children");
+	for (size_t i = 0; children && i < children->items.size(); i++)
+	{
+		if (!AddNode(json, binary, binarySize, (int)children->items[i].number, matrix, vertices, indices, threadPool, depth + 1))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool MeshImporter::ImportGLB(const unsigned char* data, size_t size, std::vector<GLfloat>& vertices, std::vector<unsigned int>& indices, ThreadPool* threadPool)
+{
+	// 12 byte header, then chunks of length, type and data. The JSON chunk comes first, the binary one (if any) straight after.
+	unsigned int header[5];
+	if (size < sizeof(header))
+	{
+		return false;
+	}
+	memcpy(header, data, sizeof(header));
+	if (header[0] != GLB_MAGIC || header[1] != 2 || header[4] != GLB_CHUNK_JSON || 20 + (size_t)header[3] > size)
+	{
+		printf("Not a glTF 2.0 binary file.\n");
+		return false;
+	}
+
+	std::string text((const char*)data + 20, header[3]);
+	const unsigned char* binary = nullptr;
+	size_t binarySize = 0;
+	size_t binaryChunk = (20 + (size_t)header[3] + 3) / 4 * 4;
+	if (binaryChunk + 8 <= size)
+	{
+		unsigned int chunkHeader[2];
+		memcpy(chunkHeader, data + binaryChunk, sizeof(chunkHeader));
+		if (chunkHeader[1] == GLB_CHUNK_BIN)
+		{
+			binary = data + binaryChunk + 8;
+			binarySize = std::min((size_t)chunkHeader[0], size - binaryChunk - 8);
+		}
+	}
+
+	JsonValue json;
+	const char* c = text.c_str();
+	if (!ParseJson(c, text.c_str() + text.size(), json, 0) || json.type != JsonValue::JSON_OBJECT)
+	{
+		printf("Bad JSON in the glTF file.\n");
+		return false;
+	}
+
+	vertices.clear();
+	indices.clear();
+
+	// The default scene's nodes, with their transforms. A file without scenes just gets every mesh as it is.
+	const JsonValue* scenes = json.Get("scenes");
+	int scene = (int)json.GetNumber("scene", 0);
+	if (scenes && scene >= 0 && scene < (int)scenes->items.size())
+	{
+		const JsonValue* roots = scenes->items[scene].Get("nodes");
+		for (size_t i = 0; roots && i < roots->items.size(); i++)
+		{
+			if (!AddNode(json, binary, binarySize, (int)roots->items[i].number, glm::mat4(1.0f), vertices, indices, threadPool, 0))
+			{
+				return false;
+			}
+		}
+	}
+	else
+	{
+		const JsonValue* meshes = json.Get("meshes");
+		for (size_t i = 0; meshes && i < meshes->items.size(); i++)
+		{
+			if (!AddMesh(json, binary, binarySize, (int)i, glm::mat4(1.0f), vertices, indices, threadPool))
+			{
+				return false;
+			}
+		}
+	}
+
+	return !indices.empty();
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Mesh.h"
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+#include "MeshProcessing.h"
+#include "MeshSimplifier.h"
+#include "ThreadPool.h"
+
+// Reads models made in other programs: Wavefront OBJ (.obj) and binary glTF 2.0 (.glb).
+// What comes out is our usual vertex format, position, UV and normal, 8 floats per vertex, ready for Mesh::CreateMesh.
+//
+// OBJ is text, and the slow part is reading the numbers. The file is cut into chunks at line ends and each thread parses its own chunks.
+// OBJ faces point at positions, UVs and normals separately, so the corners that use the same three become one vertex ("welding"),
+// found with hash tables. Polygons with more than 3 corners are cut into triangles as a fan.
+//
+// A .glb file is a JSON description followed by the binary data, already with one index per vertex, so there is nothing to weld.
+// Every mesh of the default scene is read, moved to where its node puts it.
+//
+// Files without normals get them from MeshProcessing::CalcNormals, weighted by the angle at each corner.
+// Normals are turned around on the way in, file or calculated: OBJ and glTF have them pointing out of the surface, our lighting
+// (CalcLightByDirection in lighting.glsl) wants them pointing in, like the floor's (0, -1, 0). --check-import checks that.
+// Then MeshOptimizer reorders the triangles and vertices for the GPU's caches, and prints how much that helped,
+// and MeshSimplifier adds lower levels of detail for drawing the model from further away.
+// e.g. OpenGLCourseApp.exe --import-mesh Models/teapot.obj Models/teapot.mesh converts a file to our own format (see MeshFile).
+class MeshImporter
+{
+	public:
+		// Converts the file named by the command line. Returns false if there was nothing to convert.
+		static bool Run(int argc, char** argv);
+
+		// Picks the format from the extension. vertices gets 8 floats per vertex, indices 3 per triangle, every level of detail one after the other.
+		// lods gets where each level is in indices, the full detail one first.
+		static bool Import(const char* fileLocation, std::vector<GLfloat>& vertices, std::vector<unsigned int>& indices, std::vector<Mesh::Lod>& lods,
+			ThreadPool* threadPool = nullptr);
+
+		// Imports a file and makes a mesh of it. nullptr if it couldn't be read.
+		static Mesh* LoadMesh(const char* fileLocation, ThreadPool* threadPool = nullptr);
+
+		static bool ImportOBJ(const char* text, size_t size, std::vector<GLfloat>& vertices, std::vector<unsigned int>& indices, ThreadPool* threadPool = nullptr);
+		static bool ImportGLB(const unsigned char* data, size_t size, std::vector<GLfloat>& vertices, std::vector<unsigned int>& indices, ThreadPool* threadPool = nullptr);
+
+		// Imports a quad facing +Y as OBJ and as glTF, with and without normals in the file, and checks each comes out facing (0, -1, 0).
+		// Prints OK or WRONG for each. e.g. OpenGLCourseApp.exe --check-import
+		static bool CheckNormals();
+
+	private:
+		// One face corner of an OBJ file: which position, UV and normal it uses, from 0. -1 when it has no UV or normal.
+		struct Corner
+		{
+			int position, uv, normal;
+			unsigned char relative; // Bit per index, set when it counts from the start of its chunk (a negative OBJ index).
+		};
+
+		// What a thread got out of its part of an OBJ file.
+		struct ObjChunk
+		{
+			const char* start;
+			const char* end;
+			std::vector<GLfloat> positions, uvs, normals;
+			std::vector<Corner> corners; // 3 per triangle.
+			bool failed;
+		};
+
+		// Just enough JSON for glTF.
+		struct JsonValue
+		{
+			enum Type { JSON_NULL, JSON_BOOL, JSON_NUMBER, JSON_STRING, JSON_ARRAY, JSON_OBJECT };
+			Type type = JSON_NULL;
+			double number = 0.0;
+			std::string text;
+			std::vector<JsonValue> items; // Array items, or object values.
+			std::vector<std::string> keys; // Object keys, one per item.
+
+			const JsonValue* Get(const char* key) const; // nullptr if there is no such key.
+			double GetNumber(const char* key, double fallback) const;
+		};
+
+		static bool ReadFile(const char* fileLocation, std::vector<char>& contents);
+
+		// Turns the normals of vertices around, 8 floats per vertex. From the outward normals of the files (and of CalcNormals
+		// on their counter clockwise triangles) to our inward ones.
+		static void FlipNormals(GLfloat* vertices, unsigned int vertexCount, ThreadPool* threadPool);
+
+		static void ParseObjChunk(ObjChunk& chunk);
+		static const char* ParseFloat(const char* c, const char* end, GLfloat& value);
+		static const char* ParseInt(const char* c, const char* end, int& value, bool& found);
+
+		// Gives each different position/UV/normal triplet one vertex, numbered in the order they are first used.
+		static void WeldCorners(const std::vector<Corner>& corners, std::vector<unsigned int>& cornerVertices, std::vector<unsigned int>& firstCorners,
+			ThreadPool* threadPool);
+
+		static bool ParseJson(const char*& c, const char* end, JsonValue& value, unsigned int depth);
+
+		// Where an accessor's elements are in the binary chunk: count of them, the first at start, stride bytes apart.
+		// False if any of them would be outside its buffer view or the chunk, or the numbers make no sense.
+		static bool FindAccessorData(const JsonValue& view, const JsonValue& description, size_t binarySize, size_t elementSize,
+			size_t& count, size_t& start, size_t& stride);
+		// Reads an accessor as floats, components per element. Normalized integers become 0 to 1.
+		// An accessor with no data is all zeros, and may have at most maxCount elements.
+		static bool ReadAccessor(const JsonValue& json, const unsigned char* binary, size_t binarySize, int accessor, unsigned int components,
+			size_t maxCount, std::vector<GLfloat>& values);
+		static bool ReadIndices(const JsonValue& json, const unsigned char* binary, size_t binarySize, int accessor, std::vector<unsigned int>& values);
+
+		static glm::mat4 GetNodeMatrix(const JsonValue& node);
+		static bool AddMesh(const JsonValue& json, const unsigned char* binary, size_t binarySize, int mesh, const glm::mat4& matrix,
+			std::vector<GLfloat>& vertices, std::vector<unsigned int>& indices, ThreadPool* threadPool);
+		static bool AddNode(const JsonValue& json, const unsigned char* binary, size_t binarySize, int node, const glm::mat4& parent,
+			std::vector<GLfloat>& vertices, std::vector<unsigned int>& indices, ThreadPool* threadPool, unsigned int depth);
+};
@@ -0,0 +1,428 @@
+#include "MeshOptimizer.h"
+
+const unsigned int MeshOptimizer::VERTEX_CACHE_SIZE;
+const unsigned int MeshOptimizer::FETCH_LINE_SIZE;
+const unsigned int MeshOptimizer::FETCH_CACHE_LINES;
+const int MeshOptimizer::OVERDRAW_SIZE;
+
+static const unsigned int NO_VERTEX = 0xFFFFFFFF;
+
+// The vertex cache is simulated with a clock that ticks on every miss. A vertex is in the cache while fewer than VERTEX_CACHE_SIZE
+// vertices went in after it: time - cacheTimes[vertex] <= VERTEX_CACHE_SIZE. Moving the clock on by VERTEX_CACHE_SIZE + 1 empties it.
+
+void MeshOptimizer::Optimize(std::vector<GLfloat>& vertices, std::vector<unsigned int>& indices, unsigned int vertexLength, const char* name)
+{
+	unsigned int indexCount = (unsigned int)(indices.size() / 3 * 3);
+	if (indexCount == 0)
+	{
+		return;
+	}
+
+	Stats before = Analyze(indices.data(), indexCount, vertices.data(), (unsigned int)vertices.size(), vertexLength);
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	std::vector<unsigned int> clusters;
+	OptimizeVertexCache(indices.data(), indexCount, (unsigned int)(vertices.size() / vertexLength), clusters);
+	OptimizeOverdraw(indices.data(), indexCount, vertices.data(), (unsigned int)vertices.size(), vertexLength, clusters);
+	vertices.resize(OptimizeVertexFetch(indices.data(), indexCount, vertices.data(), (unsigned int)vertices.size(), vertexLength));
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+	Stats after = Analyze(indices.data(), indexCount, vertices.data(), (unsigned int)vertices.size(), vertexLength);
+
+	printf("Optimized %s in %.1f ms, %u clusters:\n", name, elapsed.count(), (unsigned int)clusters.size());
+	PrintStats("before", before);
+	PrintStats("after", after);
+}
+
+void MeshOptimizer::OptimizeVertexCache(unsigned int* indices, unsigned int indexCount, unsigned int vertexCount, std::vector<unsigned int>& clusters)
+{
+	unsigned int triangleCount = indexCount / 3;
+	clusters.clear();
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	MeshProcessing::VertexAdjacency adjacency;
+	MeshProcessing::BuildVertexAdjacency(indices, triangleCount * 3, vertexCount, adjacency);
+	const unsigned int* cornerStarts = adjacency.cornerStarts.data();
+
+	std::vector<unsigned int> liveTriangles(vertexCount); // Triangles not drawn yet, per vertex.
+	for (unsigned int v = 0; v < vertexCount; v++)
+	{
+		liveTriangles[v] = cornerStarts[v + 1] - cornerStarts[v];
+	}
+	std::vector<unsigned int> cacheTimes(vertexCount, 0);
+	std::vector<unsigned char> drawn(triangleCount, 0);
+	std::vector<unsigned int> deadEnds; // Every vertex drawn so far, latest on top. Where to carry on from when a fan has nowhere to go.
+	std::vector<unsigned int> candidates;
+	std::vector<unsigned int> result;
+	result.reserve(triangleCount * 3);
+
+	unsigned int time = VERTEX_CACHE_SIZE + 1;
+	unsigned int cursor = 0; // Vertices before it have no triangles left. For when the dead ends run out too.
+	unsigned int fan = indices[0];
+	clusters.push_back(0);
+
+	while (fan != NO_VERTEX)
+	{
+		// Every triangle left around the fan vertex. Their corners are the candidates for the next fan.
+		candidates.clear();
+		for (unsigned int i = cornerStarts[fan]; i < cornerStarts[fan + 1]; i++)
+		{
+			unsigned int triangle = adjacency.corners[i] / 3;
+			if (drawn[triangle])
+			{
+				continue;
+			}
+			drawn[triangle] = 1;
+
+			for (unsigned int corner = 0; corner < 3; corner++)
+			{
+				unsigned int v = indices[triangle * 3 + corner];
+				result.push_back(v);
+				deadEnds.push_back(v);
+				candidates.push_back(v);
+				liveTriangles[v]--;
+				if (time - cacheTimes[v] > VERTEX_CACHE_SIZE)
+				{
+					cacheTimes[v] = time++;
+				}
+			}
+		}
+
+		// The candidate that has been in the cache longest, as long as its own fan would still fit before it falls out.
+		// Fans that wouldn't fit come after, with priority 0, in the order they were found.
+		unsigned int next = NO_VERTEX;
+		int bestPriority = -1;
+		for (size_t i = 0; i < candidates.size(); i++)
+		{
+			unsigned int v = candidates[i];
+			if (liveTriangles[v] == 0)
+			{
+				continue;
+			}
+			int priority = 0;
+			if (time - cacheTimes[v] + 2 * liveTriangles[v] <= VERTEX_CACHE_SIZE)
+			{
+				priority = (int)(time - cacheTimes[v]);
+			}
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				next = v;
+			}
+		}
+
+		if (next == NO_VERTEX)
+		{
+			// A dead end. Back to the latest vertex that still has triangles, or failing that, any vertex that does.
+			// Either way the cache has little in common with what comes next, so a new cluster starts.
+			while (!deadEnds.empty() && next == NO_VERTEX)
+			{
+				unsigned int v = deadEnds.back();
+				deadEnds.pop_back();
+				if (liveTriangles[v] > 0)
+				{
+					next = v;
+				}
+			}
+			while (next == NO_VERTEX && cursor < vertexCount)
+			{
+				if (liveTriangles[cursor] > 0)
+				{
+					next = cursor;
+				}
+				cursor++;
+			}
+			if (next != NO_VERTEX)
+			{
+				clusters.push_back((unsigned int)(result.size() / 3));
+			}
+		}
+		fan = next;
+	}
+
+	std::copy(result.begin(), result.end(), indices);
+}
+
+GLfloat MeshOptimizer::CalcACMR(const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount)
+{
+	std::vector<unsigned int> cacheTimes(vertexCount, 0);
+	unsigned int time = VERTEX_CACHE_SIZE + 1;
+	for (unsigned int i = 0; i < indexCount; i++)
+	{
+		if (time - cacheTimes[indices[i]] > VERTEX_CACHE_SIZE)
+		{
+			cacheTimes[indices[i]] = time++;
+		}
+	}
+	unsigned int misses = time - (VERTEX_CACHE_SIZE + 1);
+	return indexCount >= 3 ? (GLfloat)misses / (indexCount / 3) : 0.0f;
+}
+
+void MeshOptimizer::OptimizeOverdraw(unsigned int* indices, unsigned int indexCount, const GLfloat* vertices, unsigned int vertexCount,
+	unsigned int vertexLength, const std::vector<unsigned int>& clusters, GLfloat threshold)
+{
+	unsigned int triangleCount = indexCount / 3;
+	unsigned int verticesInMesh = vertexCount / vertexLength;
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	// Cutting every cluster again wherever the part so far does about as well as the whole mesh. The part after the cut starts
+	// with an empty cache, which only costs a little, and smaller clusters can be sorted more finely.
+	GLfloat meshACMR = CalcACMR(indices, triangleCount * 3, verticesInMesh);
+	std::vector<unsigned int> starts;
+	std::vector<unsigned int> cacheTimes(verticesInMesh, 0);
+	unsigned int time = VERTEX_CACHE_SIZE + 1;
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		unsigned int end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+		unsigned int start = clusters[c];
+		unsigned int misses = 0;
+		time += VERTEX_CACHE_SIZE + 1;
+		starts.push_back(start);
+		for (unsigned int triangle = clusters[c]; triangle < end; triangle++)
+		{
+			for (unsigned int corner = 0; corner < 3; corner++)
+			{
+				unsigned int v = indices[triangle * 3 + corner];
+				if (time - cacheTimes[v] > VERTEX_CACHE_SIZE)
+				{
+					cacheTimes[v] = time++;
+					misses++;
+				}
+			}
+			if (triangle + 1 < end && misses <= threshold * meshACMR * (triangle + 1 - start))
+			{
+				start = triangle + 1;
+				misses = 0;
+				time += VERTEX_CACHE_SIZE + 1;
+				starts.push_back(start);
+			}
+		}
+	}
+	starts.push_back(triangleCount);
+
+	// Where each cluster is and which way it faces, from its triangles weighted by area. The cross product's length is twice the area.
+	unsigned int clusterCount = (unsigned int)starts.size() - 1;
+	std::vector<glm::vec3> centers(clusterCount), normals(clusterCount);
+	glm::vec3 meshCenter(0.0f);
+	GLfloat meshArea = 0.0f;
+	for (unsigned int c = 0; c < clusterCount; c++)
+	{
+		glm::vec3 center(0.0f), normal(0.0f);
+		GLfloat area = 0.0f;
+		for (unsigned int triangle = starts[c]; triangle < starts[c + 1]; triangle++)
+		{
+			const GLfloat* a = &vertices[(size_t)indices[triangle * 3] * vertexLength];
+			const GLfloat* b = &vertices[(size_t)indices[triangle * 3 + 1] * vertexLength];
+			const GLfloat* d = &vertices[(size_t)indices[triangle * 3 + 2] * vertexLength];
+			glm::vec3 pa(a[0], a[1], a[2]), pb(b[0], b[1], b[2]), pd(d[0], d[1], d[2]);
+			glm::vec3 cross = glm::cross(pb - pa, pd - pa);
+			GLfloat triangleArea = glm::length(cross);
+			center += (pa + pb + pd) * (triangleArea / 3.0f);
+			normal += cross;
+			area += triangleArea;
+		}
+		meshCenter += center;
+		meshArea += area;
+		centers[c] = area > 0.0f ? center / area : center;
+		GLfloat normalLength = glm::length(normal);
+		normals[c] = normalLength > 0.0f ? normal / normalLength : normal;
+	}
+	if (meshArea > 0.0f)
+	{
+		meshCenter /= meshArea;
+	}
+
+	// Clusters further out along their own normal are more likely to cover the others than be covered. Those go first.
+	std::vector<GLfloat> keys(clusterCount);
+	std::vector<unsigned int> order(clusterCount);
+	for (unsigned int c = 0; c < clusterCount; c++)
+	{
+		keys[c] = glm::dot(centers[c] - meshCenter, normals[c]);
+		order[c] = c;
+	}
+	std::stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) { return keys[a] > keys[b]; });
+
+	std::vector<unsigned int> result;
+	result.reserve(triangleCount * 3);
+	for (unsigned int i = 0; i < clusterCount; i++)
+	{
+		result.insert(result.end(), indices + starts[order[i]] * 3, indices + starts[order[i] + 1] * 3);
+	}
+	std::copy(result.begin(), result.end(), indices);
+}
+
+unsigned int MeshOptimizer::OptimizeVertexFetch(unsigned int* indices, unsigned int indexCount, GLfloat* vertices, unsigned int vertexCount,
+	unsigned int vertexLength)
+{
+	unsigned int verticesInMesh = vertexCount / vertexLength;
+	std::vector<unsigned int> remap(verticesInMesh, NO_VERTEX);
+	unsigned int nextVertex = 0;
+	for (unsigned int i = 0; i < indexCount; i++)
+	{
+		unsigned int& newIndex = remap[indices[i]];
+		if (newIndex == NO_VERTEX)
+		{
+			newIndex = nextVertex++;
+		}
+		indices[i] = newIndex;
+	}
+
+	std::vector<GLfloat> reordered((size_t)nextVertex * vertexLength);
+	for (unsigned int v = 0; v < verticesInMesh; v++)
+	{
+		if (remap[v] != NO_VERTEX)
+		{
+			std::copy(vertices + (size_t)v * vertexLength, vertices + (size_t)(v + 1) * vertexLength, reordered.begin() + (size_t)remap[v] * vertexLength);
+		}
+	}
+	std::copy(reordered.begin(), reordered.end(), vertices);
+
+	return nextVertex * vertexLength;
+}
+
+GLfloat MeshOptimizer::CalcOverdraw(const unsigned int* indices, unsigned int indexCount, const GLfloat* vertices, unsigned int vertexCount,
+	unsigned int vertexLength)
+{
+	unsigned int verticesInMesh = vertexCount / vertexLength;
+	if (verticesInMesh == 0 || indexCount < 3)
+	{
+		return 1.0f;
+	}
+
+	glm::vec3 minimum(vertices[0], vertices[1], vertices[2]), maximum = minimum;
+	for (unsigned int v = 1; v < verticesInMesh; v++)
+	{
+		glm::vec3 position(vertices[(size_t)v * vertexLength], vertices[(size_t)v * vertexLength + 1], vertices[(size_t)v * vertexLength + 2]);
+		minimum = glm::min(minimum, position);
+		maximum = glm::max(maximum, position);
+	}
+	glm::vec3 extent = maximum - minimum;
+	GLfloat scale = (OVERDRAW_SIZE - 1) / std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-6f));
+
+	// Looking along each axis, both ways, at the mesh squeezed into the depth buffer. Back faces are culled, like when we draw.
+	std::vector<GLfloat> depths(OVERDRAW_SIZE * OVERDRAW_SIZE);
+	unsigned long long shaded = 0, covered = 0;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		int uAxis = (axis + 1) % 3, vAxis = (axis + 2) % 3;
+		for (int direction = -1; direction <= 1; direction += 2)
+		{
+			std::fill(depths.begin(), depths.end(), 1e30f);
+			for (unsigned int i = 0; i + 2 < indexCount; i += 3)
+			{
+				glm::vec3 p[3];
+				for (int corner = 0; corner < 3; corner++)
+				{
+					const GLfloat* position = &vertices[(size_t)indices[i + corner] * vertexLength];
+					p[corner] = (glm::vec3(position[0], position[1], position[2]) - minimum) * scale;
+				}
+				// The camera looks towards +axis * direction, so a front face's normal points the other way.
+				glm::vec3 normal = glm::cross(p[1] - p[0], p[2] - p[0]);
+				if (normal[axis] * direction >= 0.0f)
+				{
+					continue;
+				}
+
+				GLfloat u[3], v[3], z[3];
+				for (int corner = 0; corner < 3; corner++)
+				{
+					u[corner] = p[corner][uAxis];
+					v[corner] = p[corner][vAxis];
+					z[corner] = p[corner][axis] * direction;
+				}
+				GLfloat area = (u[1] - u[0]) * (v[2] - v[0]) - (u[2] - u[0]) * (v[1] - v[0]);
+				if (area == 0.0f)
+				{
+					continue;
+				}
+
+				// Pixel centers inside the triangle, where all 3 edge functions have the same sign as its area.
+				int minU = std::max((int)std::ceil(std::min(std::min(u[0], u[1]), u[2]) - 0.5f), 0);
+				int maxU = std::min((int)std::floor(std::max(std::max(u[0], u[1]), u[2]) - 0.5f), OVERDRAW_SIZE - 1);
+				int minV = std::max((int)std::ceil(std::min(std::min(v[0], v[1]), v[2]) - 0.5f), 0);
+				int maxV = std::min((int)std::floor(std::max(std::max(v[0], v[1]), v[2]) - 0.5f), OVERDRAW_SIZE - 1);
+				for (int y = minV; y <= maxV; y++)
+				{
+					for (int x = minU; x <= maxU; x++)
+					{
+						GLfloat px = x + 0.5f, py = y + 0.5f;
+						GLfloat w0 = ((u[2] - u[1]) * (py - v[1]) - (px - u[1]) * (v[2] - v[1])) / area;
+						GLfloat w1 = ((u[0] - u[2]) * (py - v[2]) - (px - u[2]) * (v[0] - v[2])) / area;
+						GLfloat w2 = 1.0f - w0 - w1;
+						if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+						{
+							continue;
+						}
+						GLfloat depth = w0 * z[0] + w1 * z[1] + w2 * z[2];
+						GLfloat& stored = depths[y * OVERDRAW_SIZE + x];
+						if (depth < stored)
+						{
+							stored = depth;
+							shaded++;
+						}
+					}
+				}
+			}
+			for (size_t p = 0; p < depths.size(); p++)
+			{
+				covered += depths[p] < 1e30f ? 1 : 0;
+			}
+		}
+	}
+	return covered > 0 ? (GLfloat)((double)shaded / covered) : 1.0f;
+}
+
+MeshOptimizer::Stats MeshOptimizer::Analyze(const unsigned int* indices, unsigned int indexCount, const GLfloat* vertices, unsigned int vertexCount,
+	unsigned int vertexLength)
+{
+	Stats stats = { 0.0f, 0.0f, 0.0f, 1.0f };
+	unsigned int verticesInMesh = vertexCount / vertexLength;
+	if (verticesInMesh == 0 || indexCount < 3)
+	{
+		return stats;
+	}
+
+	// Every vertex the vertex cache misses is read from the buffer, whole lines at a time, through a small fetch cache.
+	std::vector<unsigned int> cacheTimes(verticesInMesh, 0);
+	std::vector<size_t> fetchLines(FETCH_CACHE_LINES, (size_t)-1);
+	unsigned int time = VERTEX_CACHE_SIZE + 1;
+	size_t vertexSize = vertexLength * sizeof(GLfloat);
+	size_t bytesFetched = 0;
+	for (unsigned int i = 0; i < indexCount; i++)
+	{
+		unsigned int v = indices[i];
+		if (time - cacheTimes[v] <= VERTEX_CACHE_SIZE)
+		{
+			continue;
+		}
+		cacheTimes[v] = time++;
+
+		size_t firstLine = v * vertexSize / FETCH_LINE_SIZE, lastLine = ((v + 1) * vertexSize - 1) / FETCH_LINE_SIZE;
+		for (size_t line = firstLine; line <= lastLine; line++)
+		{
+			if (fetchLines[line % FETCH_CACHE_LINES] != line)
+			{
+				fetchLines[line % FETCH_CACHE_LINES] = line;
+				bytesFetched += FETCH_LINE_SIZE;
+			}
+		}
+	}
+
+	unsigned int misses = time - (VERTEX_CACHE_SIZE + 1);
+	stats.acmr = (GLfloat)misses / (indexCount / 3);
+	stats.atvr = (GLfloat)misses / verticesInMesh;
+	stats.overfetch = (GLfloat)((double)bytesFetched / (verticesInMesh * vertexSize));
+	stats.overdraw = CalcOverdraw(indices, indexCount, vertices, vertexCount, vertexLength);
+	return stats;
+}
+
+void MeshOptimizer::PrintStats(const char* label, const Stats& stats)
+{
+	printf("  %-8s ACMR %.3f, ATVR %.3f, overfetch %.2f, overdraw %.2f\n", label, stats.acmr, stats.atvr, stats.overfetch, stats.overdraw);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdio.h>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "MeshProcessing.h"
+
+// Puts a mesh's triangles and vertices in an order the GPU draws faster, without changing what it looks like. Made for imported models,
+// whose triangle order is whatever the modelling program left. Runs once, before the mesh is saved (see MeshImporter).
+//
+// The GPU remembers the last few vertices it shaded (the post-transform cache). A triangle whose corners are still in there needs no vertex
+// shading, so triangles sharing vertices should be drawn close together: OptimizeVertexCache, with Tipsify (Sander, Nehab and Barczak, 2007).
+// A pixel drawn then covered by a closer triangle was shaded for nothing, so the outside of a model should be drawn first: OptimizeOverdraw.
+// Vertices are read from memory in whole cache lines, so they should be in the buffer in the order the triangles use them: OptimizeVertexFetch.
+//
+// ACMR (average cache miss ratio) is vertices shaded per triangle: 3 at worst, around 0.6 for a big grid in a good order.
+// ATVR (average transformed vertex ratio) is vertices shaded per vertex of the mesh: 1 is the best there is, every vertex shaded once.
+class MeshOptimizer
+{
+	public:
+		struct Stats
+		{
+			GLfloat acmr;
+			GLfloat atvr;
+			GLfloat overfetch; // Bytes read from the vertex buffer, over its size. 1 is the best there is.
+			GLfloat overdraw; // Pixels shaded over pixels covered, looking at the mesh from the 6 sides of its box. 1 is the best there is.
+		};
+
+		// The 3 steps, in order. vertices can get shorter, vertices no triangle uses are dropped. Prints the stats before and after.
+		static void Optimize(std::vector<GLfloat>& vertices, std::vector<unsigned int>& indices, unsigned int vertexLength, const char* name);
+
+		// Reorders the triangles for the vertex cache. clusters gets the first triangle of each run Tipsify had to restart, for OptimizeOverdraw.
+		// vertexCount counts vertices, not floats.
+		static void OptimizeVertexCache(unsigned int* indices, unsigned int indexCount, unsigned int vertexCount, std::vector<unsigned int>& clusters);
+
+		// Cuts the clusters into smaller ones where that costs the vertex cache less than threshold times its ACMR,
+		// then draws the clusters facing out of the mesh first. Inside a cluster, the triangles keep their order.
+		static void OptimizeOverdraw(unsigned int* indices, unsigned int indexCount, const GLfloat* vertices, unsigned int vertexCount,
+			unsigned int vertexLength, const std::vector<unsigned int>& clusters, GLfloat threshold = 1.05f);
+
+		// Moves the vertices into the order the triangles first use them and renumbers the indices to match.
+		// Returns the new vertex count, in floats like vertexCount.
+		static unsigned int OptimizeVertexFetch(unsigned int* indices, unsigned int indexCount, GLfloat* vertices, unsigned int vertexCount,
+			unsigned int vertexLength);
+
+		// Simulates the vertex cache, a vertex fetch cache and a small depth buffer over the mesh.
+		static Stats Analyze(const unsigned int* indices, unsigned int indexCount, const GLfloat* vertices, unsigned int vertexCount,
+			unsigned int vertexLength);
+		static void PrintStats(const char* label, const Stats& stats);
+
+	private:
+		static const unsigned int VERTEX_CACHE_SIZE = 16; // Vertices. First in, first out, like most GPUs.
+		static const unsigned int FETCH_LINE_SIZE = 64; // Bytes.
+		static const unsigned int FETCH_CACHE_LINES = 256; // 16 KB, direct mapped.
+		static const int OVERDRAW_SIZE = 256; // Pixels across the depth buffer used to measure overdraw.
+
+		// Vertices shaded per triangle, with the cache starting empty.
+		static GLfloat CalcACMR(const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount);
+		static GLfloat CalcOverdraw(const unsigned int* indices, unsigned int indexCount, const GLfloat* vertices, unsigned int vertexCount,
+			unsigned int vertexLength);
+};
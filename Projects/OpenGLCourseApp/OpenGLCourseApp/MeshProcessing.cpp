@@ -0,0 +1,354 @@
+#include "MeshProcessing.h"
+
+const unsigned int MeshProcessing::PARALLEL_MIN_TRIANGLES;
+
+void MeshProcessing::RunBlocks(unsigned int count, unsigned int blockSize, ThreadPool* threadPool, const std::function<void(unsigned int, unsigned int)>& work)
+{
+	unsigned int blockCount = (count + blockSize - 1) / blockSize;
+	auto runBlock = [&](unsigned int block)
+	{
+		work(block * blockSize, std::min((block + 1) * blockSize, count));
+	};
+
+	if (threadPool)
+	{
+		threadPool->ParallelFor(blockCount, runBlock);
+	}
+	else
+	{
+		for (unsigned int block = 0; block < blockCount; block++)
+		{
+			runBlock(block);
+		}
+	}
+}
+
+FloatLanes MeshProcessing::AcosLanes(FloatLanes x)
+{
+	// Abramowitz and Stegun 4.4.45, for 0 to 1. Negative values use acos(-x) = pi - acos(x).
+	FloatLanes zero = SetLanes(0.0f);
+	FloatLanes absolute = MaxLanes(x, SubLanes(zero, x));
+	FloatLanes polynomial = AddLanes(SetLanes(0.0742610f), MulLanes(absolute, SetLanes(-0.0187293f)));
+	polynomial = AddLanes(SetLanes(-0.2121144f), MulLanes(absolute, polynomial));
+	polynomial = AddLanes(SetLanes(1.5707288f), MulLanes(absolute, polynomial));
+	FloatLanes result = MulLanes(SqrtLanes(MaxLanes(SubLanes(SetLanes(1.0f), absolute), zero)), polynomial);
+	return SelectLanes(LessLanes(x, zero), SubLanes(SetLanes(3.14159265f), result), result);
+}
+
+void MeshProcessing::BuildVertexAdjacency(const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount, VertexAdjacency& adjacency)
+{
+	// Counting the corners of each vertex, then where each vertex's list starts, then filling the lists.
+	// Filled in corner order, so a vertex always adds up its triangles in the same order, whatever the number of threads.
+	adjacency.cornerStarts.assign(vertexCount + 1, 0);
+	adjacency.corners.resize(indexCount);
+	unsigned int* starts = adjacency.cornerStarts.data();
+	for (unsigned int i = 0; i < indexCount; i++)
+	{
+		starts[indices[i] + 1]++;
+	}
+	for (unsigned int v = 0; v < vertexCount; v++)
+	{
+		starts[v + 1] += starts[v];
+	}
+	// Each vertex's start moves along as its list fills, ending up where the next list starts. Moving them back afterwards gives the starts again.
+	unsigned int* corners = adjacency.corners.data();
+	for (unsigned int i = 0; i < indexCount; i++)
+	{
+		corners[starts[indices[i]]++] = i;
+	}
+	for (unsigned int v = vertexCount; v > 0; v--)
+	{
+		starts[v] = starts[v - 1];
+	}
+	starts[0] = 0;
+}
+
+void MeshProcessing::TransposeCorners(const unsigned int* indices, const GLfloat* vertices, unsigned int vertexLength, unsigned int begin,
+	unsigned int end, GLfloat* corners)
+{
+	unsigned int paddedCount = (end - begin + LANE_COUNT - 1) / LANE_COUNT * LANE_COUNT;
+	for (unsigned int i = 0; i < paddedCount; i++)
+	{
+		unsigned int triangle = std::min(begin + i, end - 1); // Past the end repeats the last triangle, so the last lanes have something to work on.
+		for (unsigned int corner = 0; corner < 3; corner++)
+		{
+			const GLfloat* position = &vertices[(size_t)indices[triangle * 3 + corner] * vertexLength];
+			corners[(corner * 3) * paddedCount + i] = position[0];
+			corners[(corner * 3 + 1) * paddedCount + i] = position[1];
+			corners[(corner * 3 + 2) * paddedCount + i] = position[2];
+		}
+	}
+}
+
+void MeshProcessing::CalcFaceNormalLanes(const GLfloat* corners, unsigned int stride, unsigned int first, NormalWeighting weighting,
+	GLfloat results[6][LANE_COUNT])
+{
+	// Straight loads, TransposeCorners already put each coordinate of the triangles next to each other.
+	FloatLanes zero = SetLanes(0.0f), one = SetLanes(1.0f);
+	FloatLanes ax = LoadLanes(&corners[first]), ay = LoadLanes(&corners[stride + first]), az = LoadLanes(&corners[stride * 2 + first]);
+	FloatLanes bx = LoadLanes(&corners[stride * 3 + first]), by = LoadLanes(&corners[stride * 4 + first]), bz = LoadLanes(&corners[stride * 5 + first]);
+	FloatLanes cx = LoadLanes(&corners[stride * 6 + first]), cy = LoadLanes(&corners[stride * 7 + first]), cz = LoadLanes(&corners[stride * 8 + first]);
+
+	// The 2 lines leaving the first corner, and their cross product. Its length is twice the triangle's area.
+	FloatLanes e1x = SubLanes(bx, ax), e1y = SubLanes(by, ay), e1z = SubLanes(bz, az);
+	FloatLanes e2x = SubLanes(cx, ax), e2y = SubLanes(cy, ay), e2z = SubLanes(cz, az);
+	FloatLanes nx = SubLanes(MulLanes(e1y, e2z), MulLanes(e1z, e2y));
+	FloatLanes ny = SubLanes(MulLanes(e1z, e2x), MulLanes(e1x, e2z));
+	FloatLanes nz = SubLanes(MulLanes(e1x, e2y), MulLanes(e1y, e2x));
+
+	if (weighting != NORMAL_WEIGHT_AREA)
+	{
+		// Down to length 1. Triangles with no area have no direction, and count for nothing.
+		FloatLanes length = SqrtLanes(AddLanes(AddLanes(MulLanes(nx, nx), MulLanes(ny, ny)), MulLanes(nz, nz)));
+		FloatLanes hasArea = LessLanes(zero, length);
+		FloatLanes scale = SelectLanes(hasArea, DivLanes(one, SelectLanes(hasArea, length, one)), zero);
+		nx = MulLanes(nx, scale);
+		ny = MulLanes(ny, scale);
+		nz = MulLanes(nz, scale);
+	}
+	StoreLanes(results[0], nx);
+	StoreLanes(results[1], ny);
+	StoreLanes(results[2], nz);
+
+	if (weighting != NORMAL_WEIGHT_ANGLE)
+	{
+		return;
+	}
+
+	// The angle at each corner, between its 2 lines: acos of their dot product over their lengths.
+	FloatLanes e3x = SubLanes(cx, bx), e3y = SubLanes(cy, by), e3z = SubLanes(cz, bz);
+	FloatLanes length1 = AddLanes(AddLanes(MulLanes(e1x, e1x), MulLanes(e1y, e1y)), MulLanes(e1z, e1z));
+	FloatLanes length2 = AddLanes(AddLanes(MulLanes(e2x, e2x), MulLanes(e2y, e2y)), MulLanes(e2z, e2z));
+	FloatLanes length3 = AddLanes(AddLanes(MulLanes(e3x, e3x), MulLanes(e3y, e3y)), MulLanes(e3z, e3z));
+	FloatLanes dotA = AddLanes(AddLanes(MulLanes(e1x, e2x), MulLanes(e1y, e2y)), MulLanes(e1z, e2z)); // At a: b - a and c - a.
+	FloatLanes dotB = SubLanes(zero, AddLanes(AddLanes(MulLanes(e1x, e3x), MulLanes(e1y, e3y)), MulLanes(e1z, e3z))); // At b: a - b and c - b.
+	FloatLanes dotC = AddLanes(AddLanes(MulLanes(e2x, e3x), MulLanes(e2y, e3y)), MulLanes(e2z, e3z)); // At c: a - c and b - c.
+
+	FloatLanes dots[3] = { dotA, dotB, dotC };
+	FloatLanes lengths[3] = { MulLanes(length1, length2), MulLanes(length1, length3), MulLanes(length2, length3) };
+	for (int corner = 0; corner < 3; corner++)
+	{
+		FloatLanes hasLength = LessLanes(zero, lengths[corner]);
+		FloatLanes cosine = DivLanes(dots[corner], SqrtLanes(SelectLanes(hasLength, lengths[corner], one)));
+		cosine = MinLanes(MaxLanes(cosine, SetLanes(-1.0f)), one);
+		StoreLanes(results[3 + corner], SelectLanes(hasLength, AcosLanes(cosine), zero));
+	}
+}
+
+void MeshProcessing::CalcNormals(const unsigned int* indices, unsigned int indexCount, GLfloat* vertices, unsigned int vertexCount,
+	unsigned int vertexLength, unsigned int normalOffset, NormalWeighting weighting, ThreadPool* threadPool, const VertexAdjacency* adjacency,
+	unsigned int parallelMinTriangles)
+{
+	const unsigned int blockSize = 4096; // Vertices or triangles per task. A multiple of LANE_COUNT.
+	unsigned int triangleCount = indexCount / 3;
+	unsigned int verticesInMesh = vertexCount / vertexLength;
+	bool byAngle = weighting == NORMAL_WEIGHT_ANGLE;
+
+	auto normalizeBlock = [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int v = begin; v < end; v++)
+		{
+			GLfloat* normal = &vertices[(size_t)v * vertexLength + normalOffset];
+			GLfloat length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			GLfloat scale = length > 0.0f ? 1.0f / length : 0.0f;
+			normal[0] *= scale;
+			normal[1] *= scale;
+			normal[2] *= scale;
+		}
+	};
+
+	// On one thread, each triangle's normal is added straight to its vertices. Nothing else to allocate or fill.
+	bool parallel = threadPool && threadPool->GetThreadCount() > 1 && triangleCount >= parallelMinTriangles;
+	if (!parallel)
+	{
+		for (unsigned int v = 0; v < verticesInMesh; v++)
+		{
+			GLfloat* normal = &vertices[(size_t)v * vertexLength + normalOffset];
+			normal[0] = normal[1] = normal[2] = 0.0f;
+		}
+
+		if (!byAngle)
+		{
+			// The course's way, one triangle at a time. Lanes don't help here: the time goes into reading the scattered vertices,
+			// and putting them into lanes first costs more than the lanes save on a cross product.
+			for (unsigned int triangle = 0; triangle < triangleCount; triangle++)
+			{
+				const GLfloat* a = &vertices[(size_t)indices[triangle * 3] * vertexLength];
+				const GLfloat* b = &vertices[(size_t)indices[triangle * 3 + 1] * vertexLength];
+				const GLfloat* c = &vertices[(size_t)indices[triangle * 3 + 2] * vertexLength];
+				glm::vec3 normal = glm::cross(glm::vec3(b[0] - a[0], b[1] - a[1], b[2] - a[2]), glm::vec3(c[0] - a[0], c[1] - a[1], c[2] - a[2]));
+				if (weighting == NORMAL_WEIGHT_EQUAL)
+				{
+					// Triangles with no area have no direction, and count for nothing.
+					GLfloat length = glm::length(normal);
+					normal *= length > 0.0f ? 1.0f / length : 0.0f;
+				}
+				for (unsigned int corner = 0; corner < 3; corner++)
+				{
+					GLfloat* vertexNormal = &vertices[(size_t)indices[triangle * 3 + corner] * vertexLength + normalOffset];
+					vertexNormal[0] += normal.x;
+					vertexNormal[1] += normal.y;
+					vertexNormal[2] += normal.z;
+				}
+			}
+		}
+		else
+		{
+			// The 3 arccos per triangle are worth doing in lanes.
+			RunBlocks(triangleCount, blockSize, nullptr, [&](unsigned int begin, unsigned int end)
+			{
+				std::vector<GLfloat> corners((size_t)blockSize * 9);
+				unsigned int stride = (end - begin + LANE_COUNT - 1) / LANE_COUNT * LANE_COUNT;
+				TransposeCorners(indices, vertices, vertexLength, begin, end, corners.data());
+
+				GLfloat results[6][LANE_COUNT];
+				for (unsigned int first = begin; first < end; first += LANE_COUNT)
+				{
+					unsigned int count = std::min(LANE_COUNT, end - first);
+					CalcFaceNormalLanes(corners.data(), stride, first - begin, weighting, results);
+					for (unsigned int lane = 0; lane < count; lane++)
+					{
+						for (unsigned int corner = 0; corner < 3; corner++)
+						{
+							GLfloat angle = results[3 + corner][lane];
+							GLfloat* normal = &vertices[(size_t)indices[(first + lane) * 3 + corner] * vertexLength + normalOffset];
+							normal[0] += results[0][lane] * angle;
+							normal[1] += results[1][lane] * angle;
+							normal[2] += results[2][lane] * angle;
+						}
+					}
+				}
+			});
+		}
+		normalizeBlock(0, verticesInMesh);
+		return;
+	}
+
+	VertexAdjacency builtAdjacency;
+	if (!adjacency)
+	{
+		BuildVertexAdjacency(indices, triangleCount * 3, verticesInMesh, builtAdjacency);
+		adjacency = &builtAdjacency;
+	}
+
+	// Triangle normals, x y z next to each other, so a vertex reads each of its triangles from one place.
+	// With angle weighting, every corner gets its own copy, already multiplied by its angle.
+	std::vector<GLfloat> normals((size_t)(byAngle ? indexCount : triangleCount) * 3);
+	GLfloat* normalData = normals.data();
+	RunBlocks(triangleCount, blockSize, threadPool, [&](unsigned int begin, unsigned int end)
+	{
+		// The block's corner positions, transposed once, so the lanes load them instead of gathering them one float at a time.
+		std::vector<GLfloat> corners((size_t)blockSize * 9);
+		unsigned int stride = (end - begin + LANE_COUNT - 1) / LANE_COUNT * LANE_COUNT;
+		TransposeCorners(indices, vertices, vertexLength, begin, end, corners.data());
+
+		GLfloat results[6][LANE_COUNT];
+		for (unsigned int first = begin; first < end; first += LANE_COUNT)
+		{
+			unsigned int count = std::min(LANE_COUNT, end - first);
+			CalcFaceNormalLanes(corners.data(), stride, first - begin, weighting, results);
+			for (unsigned int lane = 0; lane < count; lane++)
+			{
+				if (!byAngle)
+				{
+					GLfloat* normal = &normalData[(size_t)(first + lane) * 3];
+					normal[0] = results[0][lane];
+					normal[1] = results[1][lane];
+					normal[2] = results[2][lane];
+					continue;
+				}
+				for (unsigned int corner = 0; corner < 3; corner++)
+				{
+					GLfloat* normal = &normalData[((size_t)(first + lane) * 3 + corner) * 3];
+					GLfloat angle = results[3 + corner][lane];
+					normal[0] = results[0][lane] * angle;
+					normal[1] = results[1][lane] * angle;
+					normal[2] = results[2][lane] * angle;
+				}
+			}
+		}
+	});
+
+	// Each vertex gathers from its own triangles. Nothing is shared, so no locks.
+	const unsigned int* cornerStarts = adjacency->cornerStarts.data();
+	const unsigned int* vertexCorners = adjacency->corners.data();
+	RunBlocks(verticesInMesh, blockSize, threadPool, [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int v = begin; v < end; v++)
+		{
+			GLfloat sumX = 0.0f, sumY = 0.0f, sumZ = 0.0f;
+			for (unsigned int i = cornerStarts[v]; i < cornerStarts[v + 1]; i++)
+			{
+				const GLfloat* normal = &normalData[(size_t)(byAngle ? vertexCorners[i] : vertexCorners[i] / 3) * 3];
+				sumX += normal[0];
+				sumY += normal[1];
+				sumZ += normal[2];
+			}
+			GLfloat* normal = &vertices[(size_t)v * vertexLength + normalOffset];
+			normal[0] = sumX;
+			normal[1] = sumY;
+			normal[2] = sumZ;
+		}
+		normalizeBlock(begin, end);
+	});
+}
+
+void MeshProcessing::CalcAverageNormalsReference(const unsigned int* indices, unsigned int indiceCount, GLfloat* vertices, unsigned int verticeCount,
+	unsigned int vertexLength, unsigned int normalOffset)
+{
+	// Jumping from triangle to triangle, in the indices table.
+	for (size_t i = 0; i < indiceCount; i += 3)
+	{
+		// vertexLength represents how many values there are in a vertex. In our case, it's 8.
+		// By doing this multiplication, we get straigth to the x,y,z values of a vertex in the vertices[] array.
+		unsigned int in0 = indices[i] * vertexLength;
+		unsigned int in1 = indices[i + 1] * vertexLength;
+		unsigned int in2 = indices[i + 2] * vertexLength;
+
+		// So our above code points to the start of each of the 3 vertex value used in a face.
+
+		// Now, for each vertex, we create 2 lines leading from it, and we do the cross product. This will give us the perfect normal for each vertex!
+		// Creating first line
+		glm::vec3 v1(vertices[in1] - vertices[in0], // Subtracting x values
+			vertices[in1 + 1] - vertices[in0 + 1], // Subtracting y values
+			vertices[in1 + 2] - vertices[in0 + 2] // Subtracting z values
+			);
+		glm::vec3 v2(vertices[in2] - vertices[in0], // Subtracting x values
+			vertices[in2 + 1] - vertices[in0 + 1], // Subtracting y values
+			vertices[in2 + 2] - vertices[in0 + 2] // Subtracting z values
+		);
+		glm::vec3 normal = glm::cross(v1, v2); // Getting the normal
+		normal = glm::normalize(normal); // Normalizing because we just want the direction.
+
+		// Going to the normal values
+		in0 += normalOffset;
+		in1 += normalOffset;
+		in2 += normalOffset;
+
+		// Everytime a vertex is used in one of those normal, we add its X value. Because we are computing the average of all the normals we come up with.
+		vertices[in0] += normal.x;
+		vertices[in0 + 1] += normal.y;
+		vertices[in0 + 2] += normal.z;
+
+		vertices[in1] += normal.x;
+		vertices[in1 + 1] += normal.y;
+		vertices[in1 + 2] += normal.z;
+
+		vertices[in2] += normal.x;
+		vertices[in2 + 1] += normal.y;
+		vertices[in2 + 2] += normal.z;
+	}
+
+	for (size_t i = 0; i < verticeCount / vertexLength; i++)
+	{
+		// Normal offset for this individual vertex
+		unsigned int nOffset = i * vertexLength + normalOffset;
+		glm::vec3 vec(vertices[nOffset], vertices[nOffset + 1], vertices[nOffset + 2]);
+		// Normalizing the normal vector.
+		vec = glm::normalize(vec);
+
+		vertices[nOffset] = vec.x;
+		vertices[nOffset + 1] = vec.y;
+		vertices[nOffset + 2] = vec.z;
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+#include <climits>
+#include <algorithm>
+#include <functional>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "CommonValues.h"
+#include "SimdLanes.h"
+#include "ThreadPool.h"
+
+// Work on mesh data before it goes to Mesh::CreateMesh. Vertices are interleaved, vertexLength floats each, like everywhere else.
+class MeshProcessing
+{
+	public:
+		// For every vertex, the triangle corners that use it, as compressed sparse rows:
+		// the corners of vertex v are corners[cornerStarts[v]] up to, not including, corners[cornerStarts[v + 1]]. A corner is triangle * 3 + 0, 1 or 2.
+		struct VertexAdjacency
+		{
+			std::vector<unsigned int> cornerStarts;
+			std::vector<unsigned int> corners;
+		};
+
+		// Only depends on the indices, so a mesh whose vertices move can build it once and keep it.
+		static void BuildVertexAdjacency(const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount, VertexAdjacency& adjacency);
+
+		// Meshes with at least this many triangles have their normals worked out on the thread pool, when CalcNormals is given one.
+		// Off for now: measured on one core, the threaded path was 3 to 4 times slower than one thread at every size (--benchmark-normals).
+		// Until a run on more cores shows where it starts being faster, everything goes through the one thread loop.
+		static const unsigned int PARALLEL_MIN_TRIANGLES = UINT_MAX;
+
+		// Sets the normal of every vertex from the triangles using it, replacing what was there. Vertices no triangle uses get (0, 0, 0).
+		// On one thread, each triangle's normal is added straight to its vertices, one triangle at a time.
+		// With a thread pool and at least parallelMinTriangles triangles, two threads could add to the same vertex, so the triangle normals are kept instead,
+		// and each vertex adds up its own through the vertex adjacency (built here if none is given). Then everything except building the adjacency
+		// runs in parallel. Triangle normals are worked out LANE_COUNT triangles at a time there, and for angle weighting: the x of all
+		// their first corners in one FloatLanes, their y in another, and so on.
+		static void CalcNormals(const unsigned int* indices, unsigned int indexCount, GLfloat* vertices, unsigned int vertexCount,
+			unsigned int vertexLength, unsigned int normalOffset, NormalWeighting weighting = NORMAL_WEIGHT_EQUAL, ThreadPool* threadPool = nullptr,
+			const VertexAdjacency* adjacency = nullptr, unsigned int parallelMinTriangles = PARALLEL_MIN_TRIANGLES);
+
+		// The course's CalcAverageNormals, as it was in main.cpp: one triangle at a time, adding its normal to its 3 vertices.
+		// Normals have to start at 0. Kept for the benchmark.
+		static void CalcAverageNormalsReference(const unsigned int* indices, unsigned int indiceCount, GLfloat* vertices, unsigned int verticeCount,
+			unsigned int vertexLength, unsigned int normalOffset);
+
+		// Runs work(begin, end) over 0 to count, in blocks of blockSize, on the thread pool's threads when there is one.
+		static void RunBlocks(unsigned int count, unsigned int blockSize, ThreadPool* threadPool, const std::function<void(unsigned int, unsigned int)>& work);
+
+	private:
+
+		// The corner positions of triangles begin to end - 1 as 9 arrays: x of every first corner, then y, z, then the second corner's...
+		// Each array is end - begin rounded up to LANE_COUNT long, the last triangle repeated to fill it.
+		static void TransposeCorners(const unsigned int* indices, const GLfloat* vertices, unsigned int vertexLength, unsigned int begin,
+			unsigned int end, GLfloat* corners);
+
+		// Normals of LANE_COUNT triangles from first on, out of corners from TransposeCorners (stride is the length of its arrays).
+		// Normals in results[0] to [2], one lane per triangle. With angle weighting, the angle at each corner in results[3] to [5].
+		// With area weighting, the normals aren't normalized.
+		static void CalcFaceNormalLanes(const GLfloat* corners, unsigned int stride, unsigned int first, NormalWeighting weighting,
+			GLfloat results[6][LANE_COUNT]);
+
+		// arccos to about 0.0001 radians, LANE_COUNT at a time.
+		static FloatLanes AcosLanes(FloatLanes x);
+};
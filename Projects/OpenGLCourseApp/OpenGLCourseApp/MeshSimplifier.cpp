@@ -0,0 +1,758 @@
+#include "MeshSimplifier.h"
+
+const unsigned int MeshSimplifier::DIMENSIONS;
+const GLfloat MeshSimplifier::UV_WEIGHT = 0.05f;
+const GLfloat MeshSimplifier::NORMAL_WEIGHT = 0.05f;
+const GLfloat MeshSimplifier::LOD_REDUCTION = 0.5f;
+
+unsigned int MeshSimplifier::Simplify(unsigned int* destination, const unsigned int* indices, unsigned int indexCount, const GLfloat* vertices,
+	unsigned int vertexCount, unsigned int vertexLength, unsigned int targetIndexCount, GLfloat* error)
+{
+	std::vector<unsigned int> targets(1, targetIndexCount);
+	std::vector<std::vector<unsigned int>> output;
+	std::vector<GLfloat> errors;
+	Run(indices, indexCount, vertices, vertexCount, vertexLength, targets, output, errors);
+
+	std::copy(output[0].begin(), output[0].end(), destination);
+	if (error)
+	{
+		*error = errors[0];
+	}
+	return (unsigned int)output[0].size();
+}
+
+void MeshSimplifier::BuildLodChain(std::vector<unsigned int>& indices, const GLfloat* vertices, unsigned int vertexCount, unsigned int vertexLength,
+	std::vector<Mesh::Lod>& lods, const char* name)
+{
+	unsigned int indexCount = (unsigned int)(indices.size() / 3 * 3);
+	indices.resize(indexCount);
+	lods.assign(1, Mesh::Lod{ 0, indexCount, 0.0f });
+
+	// Halving the triangles from one level to the next.
+	std::vector<unsigned int> targets;
+	unsigned int triangles = indexCount / 3;
+	while (targets.size() + 1 < MAX_LODS)
+	{
+		triangles = (unsigned int)(triangles * LOD_REDUCTION);
+		if (triangles < LOD_MIN_TRIANGLES)
+		{
+			break;
+		}
+		targets.push_back(triangles * 3);
+	}
+	if (targets.empty())
+	{
+		return;
+	}
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	std::vector<std::vector<unsigned int>> output;
+	std::vector<GLfloat> errors;
+	Run(indices.data(), indexCount, vertices, vertexCount, vertexLength, targets, output, errors);
+
+	std::vector<unsigned int> clusters;
+	for (size_t i = 0; i < output.size(); i++)
+	{
+		// Stuck on locked vertices. A level barely smaller than the one before isn't worth its memory.
+		unsigned int levelCount = (unsigned int)output[i].size();
+		if (levelCount == 0 || levelCount > lods.back().indexCount * 0.85f)
+		{
+			break;
+		}
+
+		MeshOptimizer::OptimizeVertexCache(output[i].data(), levelCount, vertexCount / vertexLength, clusters);
+		lods.push_back(Mesh::Lod{ (GLuint)indices.size(), levelCount, errors[i] });
+		indices.insert(indices.end(), output[i].begin(), output[i].end());
+	}
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+	printf("Simplified %s in %.1f ms, %u levels:\n", name, elapsed.count(), (unsigned int)lods.size());
+	for (size_t i = 0; i < lods.size(); i++)
+	{
+		printf("  LOD %u: %8u triangles, error %g\n", (unsigned int)i, lods[i].indexCount / 3, lods[i].error);
+	}
+}
+
+void MeshSimplifier::Run(const unsigned int* indices, unsigned int indexCount, const GLfloat* vertices, unsigned int vertexCount,
+	unsigned int vertexLength, const std::vector<unsigned int>& targets, std::vector<std::vector<unsigned int>>& output, std::vector<GLfloat>& errors)
+{
+	unsigned int vertexTotal = vertexCount / vertexLength;
+	unsigned int triangleCount = indexCount / 3;
+	output.assign(targets.size(), std::vector<unsigned int>());
+	errors.assign(targets.size(), 0.0f);
+
+	// Positions moved and scaled into a unit sphere, so the weights of UVs and normals mean the same whatever the mesh's size.
+	glm::vec3 minimum(0.0f), maximum(0.0f);
+	for (unsigned int v = 0; v < vertexTotal; v++)
+	{
+		glm::vec3 position(vertices[v * vertexLength], vertices[v * vertexLength + 1], vertices[v * vertexLength + 2]);
+		minimum = v == 0 ? position : glm::min(minimum, position);
+		maximum = v == 0 ? position : glm::max(maximum, position);
+	}
+	glm::vec3 center = (minimum + maximum) * 0.5f;
+	GLfloat radius = glm::length(maximum - minimum) * 0.5f;
+	if (radius <= 0.0f)
+	{
+		radius = 1.0f;
+	}
+
+	std::vector<GLfloat> points((size_t)vertexTotal * DIMENSIONS);
+	for (unsigned int v = 0; v < vertexTotal; v++)
+	{
+		const GLfloat* vertex = vertices + (size_t)v * vertexLength;
+		GLfloat* point = &points[(size_t)v * DIMENSIONS];
+		for (unsigned int i = 0; i < 3; i++)
+		{
+			point[i] = (vertex[i] - center[i]) / radius;
+		}
+		point[3] = vertex[3] * UV_WEIGHT;
+		point[4] = vertex[4] * UV_WEIGHT;
+		for (unsigned int i = 5; i < 8; i++)
+		{
+			point[i] = vertex[i] * NORMAL_WEIGHT;
+		}
+	}
+
+	// Triangles with a corner twice draw nothing, so they go straight away.
+	std::vector<unsigned int> triangles(indices, indices + triangleCount * 3);
+	std::vector<unsigned char> liveTriangles(triangleCount, 1);
+	unsigned int liveIndices = 0;
+	std::vector<Quadric> quadrics(vertexTotal, Quadric());
+	// Where vertex to is from vertex from.
+	auto calcOffset = [&](unsigned int from, unsigned int to, double* offset)
+	{
+		for (unsigned int i = 0; i < DIMENSIONS; i++)
+		{
+			offset[i] = (double)points[(size_t)to * DIMENSIONS + i] - points[(size_t)from * DIMENSIONS + i];
+		}
+	};
+	std::vector<std::vector<unsigned int>> vertexTriangles(vertexTotal);
+	for (unsigned int t = 0; t < triangleCount; t++)
+	{
+		const unsigned int* corners = &triangles[t * 3];
+		if (corners[0] == corners[1] || corners[1] == corners[2] || corners[2] == corners[0])
+		{
+			liveTriangles[t] = 0;
+			continue;
+		}
+		liveIndices += 3;
+
+		double p[3][DIMENSIONS];
+		for (unsigned int corner = 0; corner < 3; corner++)
+		{
+			for (unsigned int i = 0; i < DIMENSIONS; i++)
+			{
+				p[corner][i] = points[(size_t)corners[corner] * DIMENSIONS + i];
+			}
+			vertexTriangles[corners[corner]].push_back(t);
+		}
+		glm::dvec3 edge1(p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2]);
+		glm::dvec3 edge2(p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2]);
+		double area = glm::length(glm::cross(edge1, edge2)) * 0.5;
+		// Made for each corner with the triangle measured from that corner.
+		for (unsigned int corner = 0; corner < 3; corner++)
+		{
+			double q[3][DIMENSIONS];
+			for (unsigned int k = 0; k < 3; k++)
+			{
+				for (unsigned int i = 0; i < DIMENSIONS; i++)
+				{
+					q[k][i] = p[k][i] - p[corner][i];
+				}
+			}
+			AddQuadric(quadrics[corners[corner]], MakeTriangleQuadric(q[0], q[1], q[2], area));
+		}
+	}
+
+	// Locking the vertices of edges that don't have exactly 2 triangles: open borders, seams, and places where more than 2 meet.
+	std::vector<unsigned char> locked(vertexTotal, 0);
+	std::vector<unsigned long long> edges;
+	edges.reserve(liveIndices);
+	for (unsigned int t = 0; t < triangleCount; t++)
+	{
+		if (!liveTriangles[t])
+		{
+			continue;
+		}
+		for (unsigned int corner = 0; corner < 3; corner++)
+		{
+			unsigned long long a = triangles[t * 3 + corner], b = triangles[t * 3 + (corner + 1) % 3];
+			edges.push_back(a < b ? (a << 32) | b : (b << 32) | a);
+		}
+	}
+	std::sort(edges.begin(), edges.end());
+	for (size_t i = 0; i < edges.size();)
+	{
+		size_t end = i;
+		while (end < edges.size() && edges[end] == edges[i])
+		{
+			end++;
+		}
+		if (end - i != 2)
+		{
+			locked[edges[i] >> 32] = 1;
+			locked[edges[i] & 0xFFFFFFFF] = 1;
+		}
+		i = end;
+	}
+	edges.clear();
+	edges.shrink_to_fit();
+
+	std::vector<unsigned char> removed(vertexTotal, 0);
+	std::vector<unsigned int> versions(vertexTotal, 0);
+	std::priority_queue<Collapse> queue;
+
+	// Queues the cheaper way of merging a and b that moves an unlocked vertex.
+	auto calcCost = [&](unsigned int from, unsigned int to)
+	{
+		double offset[DIMENSIONS];
+		calcOffset(from, to, offset);
+		return locked[from] ? HUGE_VAL : CalcError(quadrics[from], quadrics[to], offset);
+	};
+	auto queueEdge = [&](unsigned int a, unsigned int b)
+	{
+		double forward = calcCost(a, b);
+		double backward = calcCost(b, a);
+		if (forward == HUGE_VAL && backward == HUGE_VAL)
+		{
+			return;
+		}
+		Collapse collapse = { (GLfloat)std::min(forward, backward), a, b, versions[a], versions[b] };
+		queue.push(collapse);
+	};
+
+	for (unsigned int t = 0; t < triangleCount; t++)
+	{
+		if (!liveTriangles[t])
+		{
+			continue;
+		}
+		// Each edge between 2 triangles is a < b in one of them and b < a in the other, so it is queued once.
+		// Border edges can be missed, but their vertices are locked anyway.
+		for (unsigned int corner = 0; corner < 3; corner++)
+		{
+			unsigned int a = triangles[t * 3 + corner], b = triangles[t * 3 + (corner + 1) % 3];
+			if (a < b)
+			{
+				queueEdge(a, b);
+			}
+		}
+	}
+
+	// Stamps for marking vertices without clearing an array every time.
+	std::vector<unsigned int> neighbourMarks(vertexTotal, 0), countedMarks(vertexTotal, 0);
+	unsigned int stamp = 0;
+
+	auto triangleHas = [&](unsigned int t, unsigned int v)
+	{
+		return triangles[t * 3] == v || triangles[t * 3 + 1] == v || triangles[t * 3 + 2] == v;
+	};
+
+	// Whether merging v into t keeps the mesh in one piece the way it was, and doesn't flip any triangle.
+	auto canCollapse = [&](unsigned int v, unsigned int t)
+	{
+		// The vertices next to both have to be exactly the far corners of the triangles they share.
+		// Any other would get 2 edges to t, joining parts of the mesh that weren't joined before.
+		stamp++;
+		for (size_t i = 0; i < vertexTriangles[t].size(); i++)
+		{
+			unsigned int triangle = vertexTriangles[t][i];
+			for (unsigned int corner = 0; corner < 3 && liveTriangles[triangle]; corner++)
+			{
+				neighbourMarks[triangles[triangle * 3 + corner]] = stamp;
+			}
+		}
+		unsigned int shared = 0, common = 0;
+		for (size_t i = 0; i < vertexTriangles[v].size(); i++)
+		{
+			unsigned int triangle = vertexTriangles[v][i];
+			if (!liveTriangles[triangle])
+			{
+				continue;
+			}
+			shared += triangleHas(triangle, t);
+			for (unsigned int corner = 0; corner < 3; corner++)
+			{
+				unsigned int other = triangles[triangle * 3 + corner];
+				if (other != v && other != t && neighbourMarks[other] == stamp && countedMarks[other] != stamp)
+				{
+					countedMarks[other] = stamp;
+					common++;
+				}
+			}
+		}
+		if (shared == 0 || common != shared)
+		{
+			return false;
+		}
+
+		// The triangles that stay, before and after v moves to t. Turning more than 75 degrees is a fold.
+		glm::vec3 target(points[(size_t)t * DIMENSIONS], points[(size_t)t * DIMENSIONS + 1], points[(size_t)t * DIMENSIONS + 2]);
+		for (size_t i = 0; i < vertexTriangles[v].size(); i++)
+		{
+			unsigned int triangle = vertexTriangles[v][i];
+			if (!liveTriangles[triangle] || triangleHas(triangle, t))
+			{
+				continue;
+			}
+			glm::vec3 corners[3], moved[3];
+			for (unsigned int corner = 0; corner < 3; corner++)
+			{
+				const GLfloat* point = &points[(size_t)triangles[triangle * 3 + corner] * DIMENSIONS];
+				corners[corner] = glm::vec3(point[0], point[1], point[2]);
+				moved[corner] = triangles[triangle * 3 + corner] == v ? target : corners[corner];
+			}
+			glm::vec3 before = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+			glm::vec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+			if (glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after))
+			{
+				return false;
+			}
+		}
+		return true;
+	};
+
+	// Every live triangle, in the order they came in, which MeshOptimizer already made a good one.
+	auto writeLiveTriangles = [&](std::vector<unsigned int>& destination)
+	{
+		destination.clear();
+		destination.reserve(liveIndices);
+		for (unsigned int t = 0; t < triangleCount; t++)
+		{
+			if (liveTriangles[t])
+			{
+				destination.insert(destination.end(), triangles.begin() + t * 3, triangles.begin() + t * 3 + 3);
+			}
+		}
+	};
+
+	// The error of a level is measured once it is written, against the original triangles, sorted into a grid once for every level.
+	// A level is never reported better than the one before, since Mesh::SelectLod counts on errors only growing.
+	TriangleGrid originalGrid;
+	BuildTriangleGrid(originalGrid, indices, triangleCount, vertices, vertexLength, minimum, maximum);
+	auto writeLevel = [&](size_t target)
+	{
+		writeLiveTriangles(output[target]);
+		errors[target] = MeasureError(originalGrid, indices, triangleCount, vertices, vertexTotal, vertexLength, output[target],
+			target > 0 ? errors[target - 1] : 0.0f);
+	};
+
+	size_t target = 0;
+	while (target < targets.size())
+	{
+		if (liveIndices <= targets[target])
+		{
+			writeLevel(target);
+			target++;
+			continue;
+		}
+		if (queue.empty())
+		{
+			break;
+		}
+
+		Collapse collapse = queue.top();
+		queue.pop();
+		unsigned int a = collapse.from, b = collapse.to;
+		if (removed[a] || removed[b] || versions[a] != collapse.fromVersion || versions[b] != collapse.toVersion)
+		{
+			continue;
+		}
+
+		// Whichever way is cheaper and allowed.
+		double forward = calcCost(a, b);
+		double backward = calcCost(b, a);
+		if (backward < forward)
+		{
+			std::swap(a, b);
+			std::swap(forward, backward);
+		}
+		unsigned int v = a, t = b;
+		if (forward == HUGE_VAL || !canCollapse(v, t))
+		{
+			if (backward == HUGE_VAL || !canCollapse(b, a))
+			{
+				continue;
+			}
+			v = b;
+			t = a;
+		}
+
+		// v's triangles either had t too, and are gone, or move over to t.
+		for (size_t i = 0; i < vertexTriangles[v].size(); i++)
+		{
+			unsigned int triangle = vertexTriangles[v][i];
+			if (!liveTriangles[triangle])
+			{
+				continue;
+			}
+			if (triangleHas(triangle, t))
+			{
+				liveTriangles[triangle] = 0;
+				liveIndices -= 3;
+				continue;
+			}
+			for (unsigned int corner = 0; corner < 3; corner++)
+			{
+				if (triangles[triangle * 3 + corner] == v)
+				{
+					triangles[triangle * 3 + corner] = t;
+				}
+			}
+			vertexTriangles[t].push_back(triangle);
+		}
+		std::vector<unsigned int>().swap(vertexTriangles[v]);
+		std::vector<unsigned int>& around = vertexTriangles[t];
+		around.erase(std::remove_if(around.begin(), around.end(), [&](unsigned int triangle) { return !liveTriangles[triangle]; }), around.end());
+
+		// v's quadric, moved over to t.
+		double offset[DIMENSIONS];
+		calcOffset(v, t, offset);
+		ShiftQuadric(quadrics[v], offset);
+		AddQuadric(quadrics[t], quadrics[v]);
+		removed[v] = 1;
+		versions[t]++;
+
+		// t's quadric changed, so every merge with t is queued again.
+		stamp++;
+		for (size_t i = 0; i < around.size(); i++)
+		{
+			for (unsigned int corner = 0; corner < 3; corner++)
+			{
+				unsigned int other = triangles[around[i] * 3 + corner];
+				if (other != t && neighbourMarks[other] != stamp)
+				{
+					neighbourMarks[other] = stamp;
+					queueEdge(t, other);
+				}
+			}
+		}
+	}
+
+	// Targets it couldn't get down to get the fewest triangles it could.
+	for (; target < targets.size(); target++)
+	{
+		writeLevel(target);
+	}
+}
+
+GLfloat MeshSimplifier::MeasureError(const TriangleGrid& original, const unsigned int* indices, unsigned int triangleCount, const GLfloat* vertices,
+	unsigned int vertexTotal, unsigned int vertexLength, const std::vector<unsigned int>& level, GLfloat atLeast)
+{
+	unsigned int levelTriangles = (unsigned int)(level.size() / 3);
+	if (triangleCount == 0 || levelTriangles == 0)
+	{
+		return atLeast;
+	}
+	auto position = [&](unsigned int v)
+	{
+		const GLfloat* vertex = &vertices[(size_t)v * vertexLength];
+		return glm::vec3(vertex[0], vertex[1], vertex[2]);
+	};
+
+	// Over the same box as the original's, which has every vertex in it.
+	TriangleGrid simplified;
+	BuildTriangleGrid(simplified, level.data(), levelTriangles, vertices, vertexLength, original.origin,
+		original.origin + glm::vec3(original.size[0], original.size[1], original.size[2]) * original.cellSize);
+
+	// A point closer than the furthest found so far can't change the result, so CalcNearestDistance can stop there.
+	GLfloat furthest = atLeast;
+
+	// From the level to the original surface, at the center of each triangle and of its edges. Its corners are original vertices.
+	for (unsigned int i = 0; i < levelTriangles; i++)
+	{
+		glm::vec3 a = position(level[i * 3]), b = position(level[i * 3 + 1]), c = position(level[i * 3 + 2]);
+		glm::vec3 samples[4] = { (a + b + c) / 3.0f, (a + b) * 0.5f, (b + c) * 0.5f, (c + a) * 0.5f };
+		for (unsigned int s = 0; s < 4; s++)
+		{
+			furthest = std::max(furthest, CalcNearestDistance(original, samples[s], indices, vertices, vertexLength, furthest));
+		}
+	}
+
+	// From the original surface to the level, at the vertices merged away. The ones still in the level are on it.
+	std::vector<unsigned char> measured(vertexTotal, 0);
+	for (size_t i = 0; i < level.size(); i++)
+	{
+		measured[level[i]] = 1;
+	}
+	for (size_t i = 0; i < (size_t)triangleCount * 3; i++)
+	{
+		unsigned int v = indices[i];
+		if (!measured[v])
+		{
+			measured[v] = 1;
+			furthest = std::max(furthest, CalcNearestDistance(simplified, position(v), level.data(), vertices, vertexLength, furthest));
+		}
+	}
+
+	return furthest;
+}
+
+void MeshSimplifier::BuildTriangleGrid(TriangleGrid& grid, const unsigned int* indices, unsigned int triangleCount, const GLfloat* vertices,
+	unsigned int vertexLength, glm::vec3 minimum, glm::vec3 maximum)
+{
+	// A surface fills about a square of the cells of a cube, so this puts a few triangles in each cell it goes through,
+	// with at most 27 cells per triangle overall so big meshes don't get a huge grid of mostly empty cells.
+	GLfloat extent = std::max(std::max(maximum.x - minimum.x, maximum.y - minimum.y), maximum.z - minimum.z);
+	GLfloat cellsAcross = std::min(sqrtf(triangleCount * 0.5f), cbrtf(triangleCount * 27.0f));
+	grid.cellSize = extent > 0.0f ? extent / std::max(cellsAcross, 1.0f) : 1.0f;
+	grid.origin = minimum;
+	for (unsigned int i = 0; i < 3; i++)
+	{
+		grid.size[i] = std::max((int)((maximum[i] - minimum[i]) / grid.cellSize) + 1, 1);
+	}
+
+	// Each triangle goes in every cell its bounding box touches. Counted first, then filled, in compressed sparse rows like
+	// MeshProcessing::VertexAdjacency: the triangles of cell c go from starts[c] up to starts[c + 1].
+	size_t cellCount = (size_t)grid.size[0] * grid.size[1] * grid.size[2];
+	grid.starts.assign(cellCount + 1, 0);
+	auto forCells = [&](unsigned int t, const std::function<void(size_t)>& work)
+	{
+		glm::ivec3 low(INT_MAX), high(INT_MIN);
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			const GLfloat* vertex = &vertices[(size_t)indices[t * 3 + k] * vertexLength];
+			glm::ivec3 cell = grid.CellOf(glm::vec3(vertex[0], vertex[1], vertex[2]));
+			low = glm::min(low, cell);
+			high = glm::max(high, cell);
+		}
+		for (int z = low.z; z <= high.z; z++)
+		{
+			for (int y = low.y; y <= high.y; y++)
+			{
+				for (int x = low.x; x <= high.x; x++)
+				{
+					work(((size_t)z * grid.size[1] + y) * grid.size[0] + x);
+				}
+			}
+		}
+	};
+	for (unsigned int t = 0; t < triangleCount; t++)
+	{
+		forCells(t, [&](size_t cell) { grid.starts[cell + 1]++; });
+	}
+	for (size_t c = 0; c < cellCount; c++)
+	{
+		grid.starts[c + 1] += grid.starts[c];
+	}
+	grid.triangles.resize(grid.starts[cellCount]);
+	std::vector<unsigned int> fill(grid.starts.begin(), grid.starts.end() - 1);
+	for (unsigned int t = 0; t < triangleCount; t++)
+	{
+		forCells(t, [&](size_t cell) { grid.triangles[fill[cell]++] = t; });
+	}
+}
+
+GLfloat MeshSimplifier::CalcNearestDistance(const TriangleGrid& grid, glm::vec3 point, const unsigned int* indices, const GLfloat* vertices,
+	unsigned int vertexLength, GLfloat enough)
+{
+	auto position = [&](unsigned int v)
+	{
+		const GLfloat* vertex = &vertices[(size_t)v * vertexLength];
+		return glm::vec3(vertex[0], vertex[1], vertex[2]);
+	};
+
+	// Searching the cells in shells around point's cell: first its own, then the 26 around it, and so on.
+	// Anything past shell r is at least r cells away, so once something closer than that is found, nothing further out can beat it.
+	glm::ivec3 center = grid.CellOf(point);
+	int largestShell = std::max(std::max(grid.size[0], grid.size[1]), grid.size[2]);
+	GLfloat nearest = HUGE_VALF;
+	for (int r = 0; r <= largestShell; r++)
+	{
+		glm::ivec3 low = glm::max(center - r, glm::ivec3(0)), high = glm::min(center + r, glm::ivec3(grid.size[0], grid.size[1], grid.size[2]) - 1);
+		for (int z = low.z; z <= high.z; z++)
+		{
+			for (int y = low.y; y <= high.y; y++)
+			{
+				for (int x = low.x; x <= high.x; x++)
+				{
+					// Only the shell itself, the cells inside it were searched already.
+					if (std::max(std::max(abs(x - center.x), abs(y - center.y)), abs(z - center.z)) != r)
+					{
+						continue;
+					}
+					size_t cell = ((size_t)z * grid.size[1] + y) * grid.size[0] + x;
+					for (unsigned int j = grid.starts[cell]; j < grid.starts[cell + 1]; j++)
+					{
+						unsigned int t = grid.triangles[j];
+						nearest = std::min(nearest, CalcPointTriangleDistance(point, position(indices[t * 3]), position(indices[t * 3 + 1]),
+							position(indices[t * 3 + 2])));
+					}
+				}
+			}
+		}
+		// Close enough to not matter to whoever asked, or nothing left out there can be closer.
+		if (nearest <= enough || nearest <= r * grid.cellSize)
+		{
+			break;
+		}
+	}
+	return nearest;
+}
+
+GLfloat MeshSimplifier::CalcPointTriangleDistance(glm::vec3 p, glm::vec3 a, glm::vec3 b, glm::vec3 c)
+{
+	// Finding which part of the triangle is closest: a corner, an edge, or the inside (Ericson, Real-Time Collision Detection, 5.1.5).
+	glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+	GLfloat d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+	if (d1 <= 0.0f && d2 <= 0.0f)
+	{
+		return glm::length(p - a);
+	}
+	glm::vec3 bp = p - b;
+	GLfloat d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+	if (d3 >= 0.0f && d4 <= d3)
+	{
+		return glm::length(p - b);
+	}
+	GLfloat vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+	{
+		return glm::length(p - (a + ab * (d1 / (d1 - d3))));
+	}
+	glm::vec3 cp = p - c;
+	GLfloat d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+	if (d6 >= 0.0f && d5 <= d6)
+	{
+		return glm::length(p - c);
+	}
+	GLfloat vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+	{
+		return glm::length(p - (a + ac * (d2 / (d2 - d6))));
+	}
+	GLfloat va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+	{
+		return glm::length(p - (b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)))));
+	}
+	GLfloat denominator = va + vb + vc;
+	if (denominator <= 0.0f)
+	{
+		return glm::length(p - a); // No area. Its corners are all there is to it.
+	}
+	return glm::length(p - (a + ab * (vb / denominator) + ac * (vc / denominator)));
+}
+
+MeshSimplifier::Quadric MeshSimplifier::MakeTriangleQuadric(const double* p0, const double* p1, const double* p2, double area)
+{
+	Quadric quadric = {};
+
+	// Two directions across the triangle, at right angles and of length 1: e1 along the first edge, e2 the rest of the second.
+	double e1[DIMENSIONS], e2[DIMENSIONS];
+	double length1 = 0.0;
+	for (unsigned int i = 0; i < DIMENSIONS; i++)
+	{
+		e1[i] = p1[i] - p0[i];
+		length1 += e1[i] * e1[i];
+	}
+	length1 = sqrt(length1);
+	if (length1 <= 1e-12 || area <= 0.0)
+	{
+		return quadric;
+	}
+	double along = 0.0;
+	for (unsigned int i = 0; i < DIMENSIONS; i++)
+	{
+		e1[i] /= length1;
+		along += (p2[i] - p0[i]) * e1[i];
+	}
+	double length2 = 0.0;
+	for (unsigned int i = 0; i < DIMENSIONS; i++)
+	{
+		e2[i] = p2[i] - p0[i] - along * e1[i];
+		length2 += e2[i] * e2[i];
+	}
+	length2 = sqrt(length2);
+	if (length2 <= 1e-12)
+	{
+		return quadric;
+	}
+
+	// The squared distance from x to the triangle's plane is |x - p0|^2 - ((x - p0).e1)^2 - ((x - p0).e2)^2.
+	// Multiplied out: A = I - e1 e1^T - e2 e2^T, b = (p0.e1) e1 + (p0.e2) e2 - p0, c = p0.p0 - (p0.e1)^2 - (p0.e2)^2.
+	double p0e1 = 0.0, p0e2 = 0.0, p0p0 = 0.0;
+	for (unsigned int i = 0; i < DIMENSIONS; i++)
+	{
+		e2[i] /= length2;
+		p0e1 += p0[i] * e1[i];
+		p0e2 += p0[i] * e2[i];
+		p0p0 += p0[i] * p0[i];
+	}
+	unsigned int k = 0;
+	for (unsigned int row = 0; row < DIMENSIONS; row++)
+	{
+		for (unsigned int column = row; column < DIMENSIONS; column++)
+		{
+			quadric.a[k++] = (GLfloat)(area * ((row == column ? 1.0 : 0.0) - e1[row] * e1[column] - e2[row] * e2[column]));
+		}
+		quadric.b[row] = (GLfloat)(area * (p0e1 * e1[row] + p0e2 * e2[row] - p0[row]));
+	}
+	quadric.c = (GLfloat)(area * (p0p0 - p0e1 * p0e1 - p0e2 * p0e2));
+	quadric.weight = (GLfloat)area;
+	return quadric;
+}
+
+void MeshSimplifier::AddQuadric(Quadric& quadric, const Quadric& other)
+{
+	for (unsigned int i = 0; i < DIMENSIONS * (DIMENSIONS + 1) / 2; i++)
+	{
+		quadric.a[i] += other.a[i];
+	}
+	for (unsigned int i = 0; i < DIMENSIONS; i++)
+	{
+		quadric.b[i] += other.b[i];
+	}
+	quadric.c += other.c;
+	quadric.weight += other.weight;
+}
+
+void MeshSimplifier::ShiftQuadric(Quadric& quadric, const double* offset)
+{
+	// With x = y + offset: y^T A y + 2 (A offset + b).y + (offset^T A offset + 2 b.offset + c).
+	double aOffset[DIMENSIONS] = {};
+	unsigned int k = 0;
+	for (unsigned int row = 0; row < DIMENSIONS; row++)
+	{
+		// A offset with only the upper half: each entry off the diagonal counts for its row and its column.
+		aOffset[row] += quadric.a[k] * offset[row];
+		k++;
+		for (unsigned int column = row + 1; column < DIMENSIONS; column++, k++)
+		{
+			aOffset[row] += quadric.a[k] * offset[column];
+			aOffset[column] += quadric.a[k] * offset[row];
+		}
+	}
+	double c = quadric.c;
+	for (unsigned int i = 0; i < DIMENSIONS; i++)
+	{
+		c += offset[i] * aOffset[i] + 2.0 * quadric.b[i] * offset[i];
+		quadric.b[i] = (GLfloat)(aOffset[i] + quadric.b[i]);
+	}
+	quadric.c = (GLfloat)c;
+}
+
+double MeshSimplifier::CalcError(const Quadric& from, const Quadric& to, const double* offset)
+{
+	double weight = (double)from.weight + to.weight;
+	if (weight <= 0.0)
+	{
+		return 0.0;
+	}
+
+	// to's quadric is at its own vertex already, where x is 0 and only c is left.
+	double error = (double)from.c + to.c;
+	unsigned int k = 0;
+	for (unsigned int row = 0; row < DIMENSIONS; row++)
+	{
+		// x^T A x with only the upper half: the diagonal once, everything else twice.
+		double sum = from.a[k] * offset[row];
+		k++;
+		for (unsigned int column = row + 1; column < DIMENSIONS; column++, k++)
+		{
+			sum += 2.0 * from.a[k] * offset[column];
+		}
+		error += offset[row] * sum + 2.0 * from.b[row] * offset[row];
+	}
+	return std::max(error / weight, 0.0);
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <stdio.h>
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <climits>
+#include <functional>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "Mesh.h"
+#include "MeshOptimizer.h"
+
+// Makes lower detail versions of a mesh (LODs, levels of detail) by merging vertices together, for drawing things far away with fewer triangles.
+// Runs once, when a model is imported (see MeshImporter). The levels are only index lists: every level uses the same vertex buffer.
+//
+// Merging vertex v into its neighbour t ("collapsing" the edge between them) removes the triangles that had both, and moves v's other
+// triangles over to t. Which merge goes first is picked by how far the surface would move: every vertex keeps a quadric, the sum of the
+// squared distances to the planes of the original triangles around it (Garland and Heckbert, 1997). The cheapest merge is done, its quadrics
+// added together, and again, until few enough triangles are left.
+// The vertices are points in 8 dimensions, position, UV and normal, and so are the planes (Garland and Heckbert, 1998). So merging
+// across a change of UV or normal counts as moving, and flat areas with their UVs stretched evenly go first.
+//
+// Some vertices never move: those on an open border (an edge with a single triangle), which would pull the border in, and with it the
+// vertices cut in two by a UV or normal seam, since those edges have a single triangle on each side. Merges that would flip a triangle
+// over or join two sides of the mesh that weren't touching are skipped.
+class MeshSimplifier
+{
+	public:
+		// Simplifies until at most targetIndexCount indices are left, or nothing more can be merged. destination needs room for indexCount.
+		// Returns how many indices were written. error gets how far the surface moved, at most, in the units of the positions (see MeasureError).
+		// vertexCount counts floats, like Mesh::CreateMesh. Vertices are position, UV and normal.
+		static unsigned int Simplify(unsigned int* destination, const unsigned int* indices, unsigned int indexCount, const GLfloat* vertices,
+			unsigned int vertexCount, unsigned int vertexLength, unsigned int targetIndexCount, GLfloat* error = nullptr);
+
+		// Adds the lower levels after indices, each with about half the triangles of the one before, down to LOD_MIN_TRIANGLES or MAX_LODS levels.
+		// lods gets every level, the first being indices as they were. Lower levels are reordered for the vertex cache (see MeshOptimizer).
+		// vertexCount counts floats, like Mesh::CreateMesh. Vertices are position, UV and normal.
+		// Prints how many triangles each level kept and its error, with name.
+		static void BuildLodChain(std::vector<unsigned int>& indices, const GLfloat* vertices, unsigned int vertexCount, unsigned int vertexLength,
+			std::vector<Mesh::Lod>& lods, const char* name);
+
+	private:
+		static const unsigned int DIMENSIONS = 8; // Position, UV, normal.
+		// How much UVs and normals count, against positions scaled to fit in a unit sphere. A merge between two vertices whose UVs are 1 apart
+		// costs as much as moving them 0.05 of the mesh's radius, and between normals 90 degrees apart 0.07.
+		static const GLfloat UV_WEIGHT;
+		static const GLfloat NORMAL_WEIGHT;
+		static const GLfloat LOD_REDUCTION; // Triangles of a level, over the one before.
+
+		// Squared distance to a flat piece of the 8 dimensional space: x^T A x + 2 b.x + c, summed over triangles, each weighted by its area.
+		// A is symmetric, only its upper half is kept. weight is the summed area, to turn the sum into an average.
+		// x is measured from the quadric's own vertex. From the middle of the mesh, the terms would be near 1 and the distances we are after
+		// near 0.0001, squared 1e-8, lost to the rounding of floats.
+		struct Quadric
+		{
+			GLfloat a[DIMENSIONS * (DIMENSIONS + 1) / 2];
+			GLfloat b[DIMENSIONS];
+			GLfloat c;
+			GLfloat weight;
+		};
+
+		// A merge waiting in the queue. The versions are of its vertices when it was queued. If either changed since, it is out of date.
+		struct Collapse
+		{
+			GLfloat cost;
+			unsigned int from, to;
+			unsigned int fromVersion, toVersion;
+
+			bool operator<(const Collapse& other) const { return cost > other.cost; } // Cheapest on top.
+		};
+
+		// Merges until the live indices go under each of targets in turn (largest first), and writes what is left at each one to output.
+		// errors gets how far the surface moved for each, from MeasureError. Targets that can't be reached get the least indices it got to.
+		static void Run(const unsigned int* indices, unsigned int indexCount, const GLfloat* vertices, unsigned int vertexCount,
+			unsigned int vertexLength, const std::vector<unsigned int>& targets, std::vector<std::vector<unsigned int>>& output, std::vector<GLfloat>& errors);
+
+		// The quadric of one triangle, its corners in 8 dimensions, times its area.
+		static Quadric MakeTriangleQuadric(const double* p0, const double* p1, const double* p2, double area);
+		static void AddQuadric(Quadric& quadric, const Quadric& other);
+		// Measures x from offset instead, offset being where the new vertex is from the old one.
+		static void ShiftQuadric(Quadric& quadric, const double* offset);
+		// Average squared distance of to's vertex from what the quadrics of both vertices remember. offset is to's vertex from from's.
+		// Only picks the order of the merges. An average over the planes, in the middle of the vertices, says little about the furthest
+		// the surface moved, which is what a level's error has to be.
+		static double CalcError(const Quadric& from, const Quadric& to, const double* offset);
+
+		// Triangles sorted into a grid of cubes, to find the nearest one to a point without trying them all.
+		struct TriangleGrid
+		{
+			glm::vec3 origin;
+			GLfloat cellSize;
+			int size[3]; // Cells along x, y and z.
+			std::vector<unsigned int> starts, triangles; // The triangles in cell c go from starts[c] up to starts[c + 1].
+
+			glm::ivec3 CellOf(glm::vec3 point) const
+			{
+				glm::ivec3 cell = glm::ivec3(glm::floor((point - origin) / cellSize));
+				return glm::clamp(cell, glm::ivec3(0), glm::ivec3(size[0], size[1], size[2]) - 1);
+			}
+		};
+
+		// How far level is from the original triangles, at most, in the units of the positions. Measured both ways: from the centers of
+		// the level's triangles and of their edges to the nearest original triangle, and from the original vertices merged away to the nearest
+		// triangle of the level. So a bump the level cut off counts as much as one it added.
+		// original is the grid of the original triangles (indices), over a box with every vertex in it.
+		// Never returns less than atLeast, which saves measuring anything closer than that.
+		static GLfloat MeasureError(const TriangleGrid& original, const unsigned int* indices, unsigned int triangleCount, const GLfloat* vertices,
+			unsigned int vertexTotal, unsigned int vertexLength, const std::vector<unsigned int>& level, GLfloat atLeast);
+		static void BuildTriangleGrid(TriangleGrid& grid, const unsigned int* indices, unsigned int triangleCount, const GLfloat* vertices,
+			unsigned int vertexLength, glm::vec3 minimum, glm::vec3 maximum);
+		// Distance from point to the nearest triangle of grid. Stops looking once one is found no further than enough.
+		static GLfloat CalcNearestDistance(const TriangleGrid& grid, glm::vec3 point, const unsigned int* indices, const GLfloat* vertices,
+			unsigned int vertexLength, GLfloat enough);
+		static GLfloat CalcPointTriangleDistance(glm::vec3 p, glm::vec3 a, glm::vec3 b, glm::vec3 c);
+};
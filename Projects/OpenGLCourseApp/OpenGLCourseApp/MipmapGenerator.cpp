@@ -0,0 +1,188 @@
+#include "MipmapGenerator.h"
+
+const unsigned int MipmapGenerator::LINEAR_TO_SRGB_STEPS;
+
+GLuint MipmapGenerator::CalcMipCount(GLuint width, GLuint height)
+{
+	GLuint largest = std::max(width, height);
+	GLuint count = 1;
+	while ((largest >> count) > 0)
+	{
+		count++;
+	}
+	return count;
+}
+
+GLuint MipmapGenerator::GetMipSize(GLuint size, GLuint level)
+{
+	return std::max(size >> level, 1u);
+}
+
+size_t MipmapGenerator::CalcMipChainSize(GLuint width, GLuint height, GLuint mipCount, GLuint channels)
+{
+	size_t total = 0;
+	for (GLuint level = 0; level < mipCount; level++)
+	{
+		total += (size_t)GetMipSize(width, level) * GetMipSize(height, level) * channels;
+	}
+	return total;
+}
+
+void MipmapGenerator::BuildMipmaps(unsigned char* data, GLuint width, GLuint height, GLuint mipCount, GLuint channels, ThreadPool* threadPool)
+{
+	const GLfloat* toLinear = GetSRGBToLinearTable();
+	const unsigned char* toSRGB = GetLinearToSRGBTable();
+
+	// Level 0 in linear light, 0 to 1.
+	std::vector<GLfloat> previous((size_t)width * height * channels);
+	auto convertRow = [&](unsigned int y)
+	{
+		size_t start = (size_t)y * width * channels;
+		for (size_t i = start; i < start + width * channels; i++)
+		{
+			previous[i] = (channels == 4 && i % 4 == 3) ? data[i] / 255.0f : toLinear[data[i]];
+		}
+	};
+	if (threadPool)
+	{
+		threadPool->ParallelFor(height, convertRow);
+	}
+	else
+	{
+		for (GLuint y = 0; y < height; y++)
+		{
+			convertRow(y);
+		}
+	}
+
+	std::vector<GLfloat> current;
+	unsigned char* destination = data + previous.size();
+	GLuint previousWidth = width, previousHeight = height;
+
+	for (GLuint level = 1; level < mipCount; level++)
+	{
+		GLuint levelWidth = GetMipSize(width, level), levelHeight = GetMipSize(height, level);
+		current.resize((size_t)levelWidth * levelHeight * channels);
+
+		auto buildRow = [&](unsigned int y)
+		{
+			// The 2 rows under this one. A 1 texel high level above only has 1, which is used twice.
+			// With an odd height, the last row of this level takes the 3 last rows above, so the odd one isn't dropped.
+			const GLfloat* row0 = &previous[(size_t)std::min(y * 2, previousHeight - 1) * previousWidth * channels];
+			const GLfloat* row1 = &previous[(size_t)std::min(y * 2 + 1, previousHeight - 1) * previousWidth * channels];
+			bool threeRows = previousHeight > 1 && previousHeight % 2 == 1 && y == levelHeight - 1;
+			const GLfloat* row2 = threeRows ? &previous[(size_t)(y * 2 + 2) * previousWidth * channels] : row1;
+			GLfloat rowWeight = threeRows ? 1.0f / 3.0f : 0.5f;
+
+			// Averaging the rows first, lanes at a time. Channels don't matter yet, it is the same sum for all of them.
+			GLuint rowFloats = previousWidth * channels;
+			std::vector<GLfloat> rowAverages(rowFloats);
+			GLuint i = 0;
+			FloatLanes rowWeights = SetLanes(rowWeight);
+			for (; i + LANE_COUNT <= rowFloats; i += LANE_COUNT)
+			{
+				FloatLanes sum = AddLanes(LoadLanes(&row0[i]), LoadLanes(&row1[i]));
+				if (threeRows)
+				{
+					sum = AddLanes(sum, LoadLanes(&row2[i]));
+				}
+				StoreLanes(&rowAverages[i], MulLanes(sum, rowWeights));
+			}
+			for (; i < rowFloats; i++)
+			{
+				rowAverages[i] = (row0[i] + row1[i] + (threeRows ? row2[i] : 0.0f)) * rowWeight;
+			}
+
+			// Then each pair of texels next to each other, and the last 3 for an odd width. With 4 channels, a texel is exactly one SSE register.
+			GLfloat* output = &current[(size_t)y * levelWidth * channels];
+			for (GLuint x = 0; x < levelWidth; x++)
+			{
+				GLuint x0 = std::min(x * 2, previousWidth - 1), x1 = std::min(x * 2 + 1, previousWidth - 1);
+				bool threeTexels = previousWidth > 1 && previousWidth % 2 == 1 && x == levelWidth - 1;
+				GLuint x2 = threeTexels ? x * 2 + 2 : x1;
+				GLfloat texelWeight = threeTexels ? 1.0f / 3.0f : 0.5f;
+				if (channels == 4)
+				{
+					__m128 sum = _mm_add_ps(_mm_loadu_ps(&rowAverages[x0 * 4]), _mm_loadu_ps(&rowAverages[x1 * 4]));
+					if (threeTexels)
+					{
+						sum = _mm_add_ps(sum, _mm_loadu_ps(&rowAverages[x2 * 4]));
+					}
+					_mm_storeu_ps(&output[x * 4], _mm_mul_ps(sum, _mm_set1_ps(texelWeight)));
+				}
+				else
+				{
+					for (GLuint c = 0; c < channels; c++)
+					{
+						GLfloat sum = rowAverages[x0 * channels + c] + rowAverages[x1 * channels + c] + (threeTexels ? rowAverages[x2 * channels + c] : 0.0f);
+						output[x * channels + c] = sum * texelWeight;
+					}
+				}
+			}
+
+			// Back to bytes for this level.
+			unsigned char* bytes = destination + (size_t)y * levelWidth * channels;
+			for (GLuint i = 0; i < levelWidth * channels; i++)
+			{
+				GLfloat value = std::min(std::max(output[i], 0.0f), 1.0f);
+				if (channels == 4 && i % 4 == 3)
+				{
+					bytes[i] = (unsigned char)(value * 255.0f + 0.5f);
+				}
+				else
+				{
+					bytes[i] = toSRGB[(unsigned int)(value * (LINEAR_TO_SRGB_STEPS - 1) + 0.5f)];
+				}
+			}
+		};
+
+		if (threadPool)
+		{
+			threadPool->ParallelFor(levelHeight, buildRow);
+		}
+		else
+		{
+			for (GLuint y = 0; y < levelHeight; y++)
+			{
+				buildRow(y);
+			}
+		}
+
+		destination += current.size();
+		previous.swap(current);
+		previousWidth = levelWidth;
+		previousHeight = levelHeight;
+	}
+}
+
+const GLfloat* MipmapGenerator::GetSRGBToLinearTable()
+{
+	// Filled the first time it is asked for. Statics inside functions are only set up once, even with several threads asking.
+	static std::vector<GLfloat> table = []()
+	{
+		std::vector<GLfloat> values(256);
+		for (int i = 0; i < 256; i++)
+		{
+			GLfloat srgb = i / 255.0f;
+			values[i] = srgb <= 0.04045f ? srgb / 12.92f : std::pow((srgb + 0.055f) / 1.055f, 2.4f);
+		}
+		return values;
+	}();
+	return table.data();
+}
+
+const unsigned char* MipmapGenerator::GetLinearToSRGBTable()
+{
+	static std::vector<unsigned char> table = []()
+	{
+		std::vector<unsigned char> values(LINEAR_TO_SRGB_STEPS);
+		for (unsigned int i = 0; i < LINEAR_TO_SRGB_STEPS; i++)
+		{
+			GLfloat linear = (GLfloat)i / (LINEAR_TO_SRGB_STEPS - 1);
+			GLfloat srgb = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+			values[i] = (unsigned char)(srgb * 255.0f + 0.5f);
+		}
+		return values;
+	}();
+	return table.data();
+}
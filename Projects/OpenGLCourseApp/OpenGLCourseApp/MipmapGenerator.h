@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include <GL/glew.h>
+
+#include "SimdLanes.h"
+#include "ThreadPool.h"
+
+// Builds the mipmaps of an image on the CPU, instead of glGenerateMipmap on the GPU.
+// Every driver filters glGenerateMipmap its own way, and most of them average the sRGB values as they are stored.
+// sRGB isn't linear, so that darkens every level a bit more than the last. Here colours are turned to linear light first,
+// averaged 2x2 (a box filter), and only turned back to sRGB when written. For odd sizes, the last row and column average 3 texels instead of 2,
+// so every texel above counts. Alpha is already linear and is averaged as it is.
+// Levels are kept as floats from one to the next, so the rounding of one level doesn't pile up in the next.
+class MipmapGenerator
+{
+	public:
+		static GLuint CalcMipCount(GLuint width, GLuint height); // Levels to get down to 1x1.
+		static GLuint GetMipSize(GLuint size, GLuint level); // Width or height of a level.
+		static size_t CalcMipChainSize(GLuint width, GLuint height, GLuint mipCount, GLuint channels); // Bytes of every level.
+
+		// data holds level 0 (8 bits per channel, 3 or 4 channels), with room for every other level after it, level 0 first.
+		// Fills the levels after the first. With a thread pool, the rows of each level are split across its threads.
+		static void BuildMipmaps(unsigned char* data, GLuint width, GLuint height, GLuint mipCount, GLuint channels,
+			ThreadPool* threadPool = nullptr);
+
+	private:
+		static const unsigned int LINEAR_TO_SRGB_STEPS = 65536; // Fine enough that even the darkest sRGB steps get the right byte.
+
+		static const GLfloat* GetSRGBToLinearTable(); // 256 entries, one per byte.
+		static const unsigned char* GetLinearToSRGBTable(); // LINEAR_TO_SRGB_STEPS entries, from 0 to 1 in linear light.
+};
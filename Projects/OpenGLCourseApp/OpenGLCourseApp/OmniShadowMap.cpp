@@ -2,6 +2,7 @@
 
 OmniShadowMap::OmniShadowMap() : ShadowMap()
 {
+    format = GetFormat(SHADOW_QUALITY, true);
 }
 
 bool OmniShadowMap::Init(unsigned int width, unsigned int height)
@@ -18,11 +19,11 @@ bool OmniShadowMap::Init(unsigned int width, unsigned int height)
     {
         glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, // Which side to target. Adding i will get the right axis, starting from Positive X. They are all adjacent in value.
             0, // Mipmap level
-            GL_DEPTH_COMPONENT, // Internal component
+            format.depthFormat, // Internal component. Sized, see ShadowMap::GetFormat.
             shadowWidth, // width
             shadowHeight, // height
             0, // Legacy item
-            GL_DEPTH_COMPONENT, // Format. Same as internal component
+            GL_DEPTH_COMPONENT, // Format of the data we pass. Just depth.
             GL_FLOAT, // Type of data we are passing
             nullptr // Not assigning data yet, assigned on Shadow Pass.
         );
@@ -51,12 +52,39 @@ bool OmniShadowMap::Init(unsigned int width, unsigned int height)
         GL_LINEAR // The value. Here, we could also use GL_LINEAR. It's personnal preference.
     );
 
+    if (filterMode == SHADOW_FILTER_VSM)
+    {
+        // Same as the depth cube map, but holding the normalized distance and the distance squared.
+        glGenTextures(1, &momentsMap);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, momentsMap);
+        for (size_t i = 0; i < 6; i++)
+        {
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, format.momentsFormat, shadowWidth, shadowHeight, 0, GL_RG, GL_FLOAT, nullptr);
+        }
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glGenerateMipmap(GL_TEXTURE_CUBE_MAP); // Allocating the mip levels now, so the texture is complete before the first shadow pass.
+    }
+
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, FBO);
     glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadowMap, 0);
 
-    // Disabling reading colors.
-    glDrawBuffer(GL_NONE);
-    glReadBuffer(GL_NONE);
+    if (filterMode == SHADOW_FILTER_VSM)
+    {
+        // Layered, like the depth. The geometry shader picks the face with gl_Layer for both.
+        glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, momentsMap, 0);
+        glDrawBuffer(GL_COLOR_ATTACHMENT0);
+        glReadBuffer(GL_NONE);
+    }
+    else
+    {
+        // Disabling reading colors.
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+    }
 
     GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
 
@@ -66,6 +94,14 @@ bool OmniShadowMap::Init(unsigned int width, unsigned int height)
         printf("Shadowmap Framebuffer Error: %i\n", status);
     }
 
+    if (filterMode == SHADOW_FILTER_VSM)
+    {
+        // Pointed at one face at a time when filtering, see Filter.
+        glGenFramebuffers(1, &momentsFBO);
+
+        InitBlur();
+    }
+
     return true;
 }
 
@@ -77,5 +113,49 @@ void OmniShadowMap::Write()
 void OmniShadowMap::Read(GLenum textureUnit)
 {
     glActiveTexture(textureUnit);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, shadowMap);
+    // Variance shadow maps are read through their moments, not their depth.
+    glBindTexture(GL_TEXTURE_CUBE_MAP, filterMode == SHADOW_FILTER_VSM ? momentsMap : shadowMap);
+}
+
+size_t OmniShadowMap::GetMemoryUsage()
+{
+    size_t faceTexels = (size_t)shadowWidth * shadowHeight;
+    size_t total = faceTexels * 6 * format.depthBytes;
+    if (filterMode == SHADOW_FILTER_VSM)
+    {
+        total += faceTexels * 6 * format.momentsBytes * 4 / 3; // Moments for each face, plus a third for the mipmaps.
+        total += faceTexels * format.momentsBytes * 2; // The 2 blur targets, one face big.
+    }
+    return total;
+}
+
+void OmniShadowMap::Filter(GLuint blurDirectionLocation, GLenum textureUnit)
+{
+    if (filterMode != SHADOW_FILTER_VSM)
+    {
+        return;
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, momentsFBO);
+    for (size_t i = 0; i < 6; i++)
+    {
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, momentsFBO);
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, momentsMap, 0);
+        glDrawBuffer(GL_COLOR_ATTACHMENT0);
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+
+        // The blur shader only reads 2D textures, so the face gets copied out first.
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, blurFBO[1]);
+        glBlitFramebuffer(0, 0, shadowWidth, shadowHeight, 0, 0, shadowWidth, shadowHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+        // Horizontal into the other temporary map, then vertical back into the face.
+        BlurPass(blurMap[1], blurFBO[0], 1.0f / shadowWidth, 0.0f, blurDirectionLocation, textureUnit);
+        BlurPass(blurMap[0], momentsFBO, 0.0f, 1.0f / shadowHeight, blurDirectionLocation, textureUnit);
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    // Rebuilding the mipmaps once here, instead of filtering again for every fragment that reads the map.
+    glBindTexture(GL_TEXTURE_CUBE_MAP, momentsMap);
+    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
 }
@@ -11,6 +11,11 @@ class OmniShadowMap : public ShadowMap
 		void Write();
 
 		void Read(GLenum textureUnit);
+
+		// Blurs each of the 6 faces of the moments cube map, then rebuilds its mipmaps.
+		void Filter(GLuint blurDirectionLocation, GLenum textureUnit);
+
+		size_t GetMemoryUsage();
 	private:
 };
 
@@ -6,6 +6,8 @@ PointLight::PointLight() : Light()
 	constant = 1.0f; // Prevents division by 0.
 	linear = 0.0f;
 	exponent = 0.0f;
+	farPlane = 0.0f;
+	radius = 0.0f; // No colour, lights nothing.
 }
 
 PointLight::PointLight(GLuint shadowWidth, GLuint shadowHeight,
@@ -21,17 +23,18 @@ PointLight::PointLight(GLuint shadowWidth, GLuint shadowHeight,
 	exponent = exp;
 
 	farPlane = far;
+	radius = CalcAttenuationRadius();
 
 	float aspect = (float)shadowWidth / (float)shadowHeight;  // Aspect ratio of the shadow. You want the Width and height to be equal, because we use them in a cube...
 	lightProj = glm::perspective(glm::radians(90.0f), aspect, near, far); // Only need one projection, we will realign it for each face.
 
-	shadowMap = new OmniShadowMap();
-	shadowMap->Init(shadowWidth, shadowHeight);
+	// No shadow map yet. It is given by the ShadowMapPool, only while the light is visible.
 }
 
 void PointLight::UseLight(GLfloat ambientIntensityLocation, GLfloat ambientColourLocation, GLfloat diffuseIntensityLocation, 
 	GLfloat positionLocation, 
-	GLfloat constantLocation, GLfloat linearLocation, GLfloat exponentLocation)
+	GLfloat constantLocation, GLfloat linearLocation, GLfloat exponentLocation,
+	GLfloat radiusLocation)
 {
 	glUniform3f(ambientColourLocation, colour.x, colour.y, colour.z);
 	glUniform1f(ambientIntensityLocation, ambientIntensity);
@@ -41,6 +44,7 @@ void PointLight::UseLight(GLfloat ambientIntensityLocation, GLfloat ambientColou
 	glUniform1f(constantLocation, constant);
 	glUniform1f(linearLocation, linear);
 	glUniform1f(exponentLocation, exponent);
+	glUniform1f(radiusLocation, radius);
 }
 
 std::vector<glm::mat4> PointLight::CalculateLightTransform()
@@ -75,3 +79,40 @@ glm::vec3 PointLight::GetPosition()
 {
 	return position;
 }
+
+glm::vec3 PointLight::GetAttenuation()
+{
+	return glm::vec3(constant, linear, exponent);
+}
+
+GLfloat PointLight::GetRadius()
+{
+	return radius;
+}
+
+GLfloat PointLight::CalcAttenuationRadius()
+{
+	return CalcAttenuationRadius(colour, ambientIntensity, diffuseIntensity, constant, linear, exponent);
+}
+
+GLfloat PointLight::CalcAttenuationRadius(glm::vec3 colour, GLfloat ambientIntensity, GLfloat diffuseIntensity,
+	GLfloat constant, GLfloat linear, GLfloat exponent)
+{
+	// The brightest the light gets on any colour channel, before attenuation.
+	// Not luminance: a deep blue light is dim to the eye, but still adds a full step to the blue channel far out.
+	// The specular of the shiniest material possible is added in, since shader.frag adds it on top of the diffuse light.
+	GLfloat brightestChannel = std::max(colour.x, std::max(colour.y, colour.z));
+	GLfloat brightest = brightestChannel * (ambientIntensity + diffuseIntensity + MAX_SPECULAR_INTENSITY);
+
+	// Solving exponent * d^2 + linear * d + constant = brightest / cutoff for d.
+	GLfloat target = brightest / LIGHT_CHANNEL_CUTOFF;
+	if (target <= constant)
+	{
+		return 0.0f; // Too dim to ever be seen.
+	}
+	if (exponent <= 0.0f)
+	{
+		return linear > 0.0f ? (target - constant) / linear : 1e30f; // No attenuation at all, lights everything.
+	}
+	return (-linear + sqrtf(linear * linear - 4.0f * exponent * (constant - target))) / (2.0f * exponent);
+}
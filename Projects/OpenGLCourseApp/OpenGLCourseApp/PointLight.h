@@ -1,6 +1,8 @@
 #pragma once
 #include "Light.h"
 #include <vector>
+#include <algorithm>
+#include <cmath>
 #include "OmniShadowMap.h"
 
 class PointLight :
@@ -17,18 +19,30 @@ class PointLight :
         // NOTE: For location variables, it should be GLuint. Float works but is not... appropriate.
         void UseLight(GLfloat ambientIntensityLocation, GLfloat ambientColourLocation,
             GLfloat diffuseIntensityLocation, GLfloat positionLocation,
-            GLfloat constantLocation, GLfloat linearLocation, GLfloat exponentLocation);
+            GLfloat constantLocation, GLfloat linearLocation, GLfloat exponentLocation,
+            GLfloat radiusLocation);
 
         std::vector<glm::mat4> CalculateLightTransform();
 
         GLfloat GetFarPlane();
         glm::vec3 GetPosition();
+        glm::vec3 GetAttenuation(); // x is constant, y linear, z exponent.
+
+        // Distance after which the light adds less than LIGHT_CHANNEL_CUTOFF to every colour channel. Nothing past it is lit (or shadowed) by this light.
+        // Worked out once in the constructor, GetRadius gives the stored value.
+        GLfloat CalcAttenuationRadius();
+        GLfloat GetRadius();
+
+        // Same, for light values that aren't in a PointLight. Used by LightManager.
+        static GLfloat CalcAttenuationRadius(glm::vec3 colour, GLfloat ambientIntensity, GLfloat diffuseIntensity,
+            GLfloat constant, GLfloat linear, GLfloat exponent);
 
 
     private:
         glm::vec3 position; // Where the point light is.
 
         GLfloat constant, linear, exponent; // Values controlling the attenuation of our light.
+        GLfloat radius; // Influence radius, from the attenuation. Used for culling.
 
         GLfloat farPlane; // how far away our camera can see.
 };
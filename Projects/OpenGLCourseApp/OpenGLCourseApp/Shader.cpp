@@ -70,10 +70,24 @@ std::string Shader::ReadFile(const char* fileLocation)
 		return "";
 	}
 
+	// Folder of this file. Included files are looked for next to it.
+	std::string location = fileLocation;
+	std::string folder = location.substr(0, location.find_last_of("/\\") + 1);
+
 	std::string line = "";
 	while (!fileStream.eof())
 	{
 		std::getline(fileStream, line);
+
+		// GLSL has no #include, so we do it ourselves: the line is swapped for the whole file it names.
+		// Lets the shaders share code, e.g. the lighting functions of shader.frag and the deferred shaders.
+		if (line.compare(0, 10, "#include \"") == 0)
+		{
+			std::string includeName = line.substr(10, line.find('"', 10) - 10);
+			content.append(ReadFile((folder + includeName).c_str()));
+			continue;
+		}
+
 		content.append(line + "\n");
 	}
 
@@ -188,11 +202,23 @@ GLuint Shader::GetFarPlaneLocation()
 	return uniformFarPlane;
 }
 
+GLuint Shader::GetBlurDirectionLocation()
+{
+	return uniformBlurDirection;
+}
+
 void Shader::SetDirectionalLight(DirectionalLight* dLight)
 {
 	dLight->UseLight(uniformDirectionalLight.uniformAmbientIntensity, uniformDirectionalLight.uniformColour,
 		uniformDirectionalLight.uniformDiffuseIntensity, uniformDirectionalLight.uniformDirection);
 
+	if (dLight->GetShadowMap())
+	{
+		glUniform1i(uniformDirectionalShadowFilterMode, dLight->GetShadowMap()->GetFilterMode());
+
+		glm::vec4 tile = dLight->GetShadowMap()->GetTileRect();
+		glUniform4f(uniformDirectionalShadowTile, tile.x, tile.y, tile.z, tile.w);
+	}
 
 }
 
@@ -208,10 +234,19 @@ void Shader::SetPointLights(PointLight* pLight, unsigned int lightCount, unsigne
 	{
 		pLight[i].UseLight(uniformPointLight[i].uniformAmbientIntensity, uniformPointLight[i].uniformColour, uniformPointLight[i].uniformDiffuseIntensity,
 			uniformPointLight[i].uniformPosition,
-			uniformPointLight[i].uniformConstant, uniformPointLight[i].uniformLinear, uniformPointLight[i].uniformExponent);
+			uniformPointLight[i].uniformConstant, uniformPointLight[i].uniformLinear, uniformPointLight[i].uniformExponent,
+			uniformPointLight[i].uniformRadius);
+
+		// Lights only have a shadow map while they are visible, see ShadowMapPool.
+		ShadowMap* shadowMap = pLight[i].GetShadowMap();
+		glUniform1i(uniformOmniShadowMap[i + offset].hasShadowMap, shadowMap != nullptr);
 
 		// Setting shadowmap texture values for the texture units.
-		pLight[i].GetShadowMap()->Read(GL_TEXTURE0 + textureUnit + i); // Texture unit 0, 1, 2, ... are all 1 apart.
+		if (shadowMap)
+		{
+			shadowMap->Read(GL_TEXTURE0 + textureUnit + i); // Texture unit 0, 1, 2, ... are all 1 apart.
+			glUniform1i(uniformOmniShadowMap[i + offset].filterMode, shadowMap->GetFilterMode());
+		}
 		glUniform1i(uniformOmniShadowMap[i + offset].shadowMap, textureUnit + i); // Here, we dont put GL_TEXTURE0 because this value doesnt need to be an enum once in our shader file.
 		glUniform1f(uniformOmniShadowMap[i + offset].farPlane, pLight[i].GetFarPlane());
 	}
@@ -240,6 +275,46 @@ void Shader::SetLightMatrices(std::vector<glm::mat4> lightMatrices)
 	}
 }
 
+void Shader::SetBlurSource(GLuint textureUnit)
+{
+	glUniform1i(uniformBlurSource, textureUnit);
+}
+
+void Shader::SetClusterGrid(ClusterGrid* clusterGrid, unsigned int textureUnit)
+{
+	clusterGrid->Read(GL_TEXTURE0 + textureUnit);
+	glUniform1i(uniformClusterLights, textureUnit);
+	glUniform1i(uniformClusterRanges, textureUnit + 1);
+	glUniform1i(uniformClusterLightIndices, textureUnit + 2);
+
+	glUniform2f(uniformClusterTileSize, clusterGrid->GetTileWidth(), clusterGrid->GetTileHeight());
+	glUniform2f(uniformClusterDepthParams, clusterGrid->GetDepthScale(), clusterGrid->GetDepthBias());
+	glUniform1i(uniformClusterLightStride, clusterGrid->GetLightStride());
+}
+
+void Shader::SetGBuffer(GBuffer* gBuffer, unsigned int textureUnit)
+{
+	gBuffer->Read(GL_TEXTURE0 + textureUnit);
+	glUniform1i(uniformGAlbedo, textureUnit);
+	glUniform1i(uniformGNormal, textureUnit + 1);
+	glUniform1i(uniformGDepth, textureUnit + 2);
+}
+
+void Shader::SetInverseViewProjection(glm::mat4* inverseViewProjection)
+{
+	glUniformMatrix4fv(uniformInverseViewProjection, 1, GL_FALSE, glm::value_ptr(*inverseViewProjection));
+}
+
+void Shader::SetUseClusterLights(bool useClusterLights)
+{
+	glUniform1i(uniformUseClusterLights, useClusterLights);
+}
+
+void Shader::SetLightSphere(glm::vec3 position, GLfloat radius)
+{
+	glUniform4f(uniformLightSphere, position.x, position.y, position.z, radius);
+}
+
 void Shader::UseShader()
 {
 	glUseProgram(shaderID);
@@ -300,13 +375,14 @@ void Shader::CompileProgram()
 		return;
 	}
 
+	// Not returning if this fails. Every sampler still points at texture unit 0 here, and programs mixing sampler types
+	// (2D, cube, buffer) fail validation until we set their units. Validate() is called again right before drawing.
 	glValidateProgram(shaderID);
 	glGetProgramiv(shaderID, GL_VALIDATE_STATUS, &result);
 	if (!result)
 	{
 		glGetProgramInfoLog(shaderID, sizeof(eLog), NULL, eLog);
 		printf("Error validating program: '%s'\n", eLog);
-		return;
 	}
 
 	// Setting uniform variables.
@@ -348,16 +424,45 @@ void Shader::CompileProgram()
 
 		snprintf(locationBuffer, sizeof(locationBuffer), "pointLights[%d].exponent", i); // base is the base struct in the shader.
 		uniformPointLight[i].uniformExponent = glGetUniformLocation(shaderID, locationBuffer);
+
+		snprintf(locationBuffer, sizeof(locationBuffer), "pointLights[%d].radius", i);
+		uniformPointLight[i].uniformRadius = glGetUniformLocation(shaderID, locationBuffer);
 	}
 
 	uniformTexture = glGetUniformLocation(shaderID, "theTexture");
 	uniformDirectionalLightTransform = glGetUniformLocation(shaderID, "directionalLightTransform");// Because the name of the variable, directionalLightTransform, is the same name across
 	// both our shaders (shader.vert and shadow_map.vert), we dont have to do it twice. It will be bound for both of them.
 	uniformDirectionalShadowMap = glGetUniformLocation(shaderID, "directionalShadowMap");
+	uniformDirectionalShadowFilterMode = glGetUniformLocation(shaderID, "directionalShadowFilterMode");
+	uniformDirectionalShadowTile = glGetUniformLocation(shaderID, "directionalShadowTile");
 
 	uniformOmniLightPos = glGetUniformLocation(shaderID, "lightPos");
 	uniformFarPlane = glGetUniformLocation(shaderID, "farPlane");
 
+	uniformBlurSource = glGetUniformLocation(shaderID, "blurSource");
+	uniformBlurDirection = glGetUniformLocation(shaderID, "blurDirection");
+
+	uniformClusterLights = glGetUniformLocation(shaderID, "clusterLights");
+	uniformClusterRanges = glGetUniformLocation(shaderID, "clusterRanges");
+	uniformClusterLightIndices = glGetUniformLocation(shaderID, "clusterLightIndices");
+	uniformClusterTileSize = glGetUniformLocation(shaderID, "clusterTileSize");
+	uniformClusterDepthParams = glGetUniformLocation(shaderID, "clusterDepthParams");
+	uniformClusterLightStride = glGetUniformLocation(shaderID, "clusterLightStride");
+
+	uniformGAlbedo = glGetUniformLocation(shaderID, "gAlbedo");
+	uniformGNormal = glGetUniformLocation(shaderID, "gNormal");
+	uniformGDepth = glGetUniformLocation(shaderID, "gDepth");
+	uniformInverseViewProjection = glGetUniformLocation(shaderID, "inverseViewProjection");
+	uniformUseClusterLights = glGetUniformLocation(shaderID, "useClusterLights");
+	uniformLightSphere = glGetUniformLocation(shaderID, "lightSphere");
+
+	// The material table is read from one uniform buffer, bound once by MaterialTable. Only shaders that use it have the block.
+	GLuint materialBlock = glGetUniformBlockIndex(shaderID, "MaterialBlock");
+	if (materialBlock != GL_INVALID_INDEX)
+	{
+		glUniformBlockBinding(shaderID, materialBlock, MATERIAL_BLOCK_BINDING);
+	}
+
 	for (size_t i = 0; i < 6; i++)
 	{
 		// To change the "i" inside a char array, which is used when using the GetUniformLocation methods.
@@ -380,6 +485,12 @@ void Shader::CompileProgram()
 		// Printing to a buffer
 		snprintf(locationBuffer, sizeof(locationBuffer), "omniShadowMaps[%d].farPlane", i);
 		uniformOmniShadowMap[i].farPlane = glGetUniformLocation(shaderID, locationBuffer);
+
+		snprintf(locationBuffer, sizeof(locationBuffer), "omniShadowMaps[%d].filterMode", i);
+		uniformOmniShadowMap[i].filterMode = glGetUniformLocation(shaderID, locationBuffer);
+
+		snprintf(locationBuffer, sizeof(locationBuffer), "omniShadowMaps[%d].hasShadowMap", i);
+		uniformOmniShadowMap[i].hasShadowMap = glGetUniformLocation(shaderID, locationBuffer);
 	}
 }
 
@@ -12,6 +12,8 @@
 
 #include "DirectionalLight.h"
 #include "PointLight.h"
+#include "ClusterGrid.h"
+#include "GBuffer.h"
 #include "CommonValues.h"
 
 class Shader
@@ -42,6 +44,7 @@ public:
 	GLuint GetDirectionalShadowMapLocation();
 	GLuint GetOmniLightPosLocation();
 	GLuint GetFarPlaneLocation();
+	GLuint GetBlurDirectionLocation();
 
 	void SetDirectionalLight(DirectionalLight* dLight);
 	void SetPointLights(PointLight* pLight, unsigned int lightCount, 
@@ -51,6 +54,12 @@ public:
 	void SetDirectionalShadowMap(GLuint textureUnit);
 	void SetDirectionalLightTransform(glm::mat4* lTransform);
 	void SetLightMatrices(std::vector<glm::mat4> lightMatrices);
+	void SetBlurSource(GLuint textureUnit);
+	void SetClusterGrid(ClusterGrid* clusterGrid, unsigned int textureUnit); // Uses 3 texture units, starting at textureUnit.
+	void SetGBuffer(GBuffer* gBuffer, unsigned int textureUnit); // Uses 3 texture units, starting at textureUnit.
+	void SetInverseViewProjection(glm::mat4* inverseViewProjection);
+	void SetUseClusterLights(bool useClusterLights);
+	void SetLightSphere(glm::vec3 position, GLfloat radius);
 
 	void UseShader();
 	void ClearShader();
@@ -64,8 +73,11 @@ private:
 		uniformEyePosition,
 		uniformSpecularIntensity, uniformShininess,
 		uniformTexture,
-		uniformDirectionalLightTransform, uniformDirectionalShadowMap,
-		uniformOmniLightPos, uniformFarPlane;
+		uniformDirectionalLightTransform, uniformDirectionalShadowMap, uniformDirectionalShadowFilterMode, uniformDirectionalShadowTile,
+		uniformOmniLightPos, uniformFarPlane,
+		uniformBlurSource, uniformBlurDirection,
+		uniformClusterLights, uniformClusterRanges, uniformClusterLightIndices, uniformClusterTileSize, uniformClusterDepthParams, uniformClusterLightStride,
+		uniformGAlbedo, uniformGNormal, uniformGDepth, uniformInverseViewProjection, uniformUseClusterLights, uniformLightSphere;
 
 	GLuint uniformLightMatrices[6];
 
@@ -89,11 +101,14 @@ private:
 		GLuint uniformConstant;
 		GLuint uniformLinear;
 		GLuint uniformExponent;
+		GLuint uniformRadius;
 	} uniformPointLight[MAX_POINT_LIGHTS]; // We want to handle multiple point lights.
 
 	struct {
 		GLuint shadowMap;
 		GLuint farPlane;
+		GLuint filterMode;
+		GLuint hasShadowMap;
 	} uniformOmniShadowMap[MAX_POINT_LIGHTS];
 
 	void CompileShader(const char* vertexCode, const char* fragmentCode);
@@ -0,0 +1,39 @@
+// CLUSTERED LIGHTS
+// Reading the lights LightManager puts in clusterLights. Needs lighting_types.glsl before it.
+
+// Where each value of a clustered light is in clusterLights. Have to be the same values as LightPlane in the LightManager.h file.
+const int LIGHT_POSITION_X = 0;
+const int LIGHT_POSITION_Y = 1;
+const int LIGHT_POSITION_Z = 2;
+const int LIGHT_RADIUS = 3;
+const int LIGHT_COLOUR_R = 4;
+const int LIGHT_COLOUR_G = 5;
+const int LIGHT_COLOUR_B = 6;
+const int LIGHT_AMBIENT_INTENSITY = 7;
+const int LIGHT_DIFFUSE_INTENSITY = 8;
+const int LIGHT_CONSTANT = 9;
+const int LIGHT_LINEAR = 10;
+const int LIGHT_EXPONENT = 11;
+
+uniform samplerBuffer clusterLights; // One float per texel, a plane of clusterLightStride texels per value.
+uniform int clusterLightStride;
+
+// One value of a clustered light. All the lights' values for a plane are together, clusterLightStride texels apart.
+float ClusterLightValue(int lightIndex, int plane)
+{
+	return texelFetch(clusterLights, plane * clusterLightStride + lightIndex).r;
+}
+
+PointLight GetClusterLight(int lightIndex)
+{
+	PointLight pLight;
+	pLight.base.colour = vec3(ClusterLightValue(lightIndex, LIGHT_COLOUR_R), ClusterLightValue(lightIndex, LIGHT_COLOUR_G), ClusterLightValue(lightIndex, LIGHT_COLOUR_B));
+	pLight.base.ambientIntensity = ClusterLightValue(lightIndex, LIGHT_AMBIENT_INTENSITY);
+	pLight.base.diffuseIntensity = ClusterLightValue(lightIndex, LIGHT_DIFFUSE_INTENSITY);
+	pLight.position = vec3(ClusterLightValue(lightIndex, LIGHT_POSITION_X), ClusterLightValue(lightIndex, LIGHT_POSITION_Y), ClusterLightValue(lightIndex, LIGHT_POSITION_Z));
+	pLight.constant = ClusterLightValue(lightIndex, LIGHT_CONSTANT);
+	pLight.linear = ClusterLightValue(lightIndex, LIGHT_LINEAR);
+	pLight.exponent = ClusterLightValue(lightIndex, LIGHT_EXPONENT);
+	pLight.radius = ClusterLightValue(lightIndex, LIGHT_RADIUS);
+	return pLight;
+}
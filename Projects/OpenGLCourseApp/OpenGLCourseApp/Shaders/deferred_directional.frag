@@ -0,0 +1,64 @@
+#version 330
+
+// DEFERRED DIRECTIONAL LIGHT FRAGMENT SHADER
+// Runs once for every pixel of the screen: ambient and directional light, with the directional shadow.
+// Point lights are added on top of this by deferred_point.frag.
+
+out vec4 colour;
+
+#include "lighting_types.glsl"
+
+uniform DirectionalLight directionalLight;
+
+uniform sampler2D directionalShadowMap;
+uniform int directionalShadowFilterMode; // PCF or VSM. See CommonValues.h
+uniform vec4 directionalShadowTile; // Where the light's shadow is in directionalShadowMap. See shader.frag.
+uniform mat4 directionalLightTransform;
+
+// The G-buffer. See GBuffer.h for what is in it.
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+uniform mat4 inverseViewProjection;
+
+uniform vec3 eyePosition;
+
+// What shader.frag gets from shader.vert and from uniforms. Filled from the G-buffer in main, so the shared functions of lighting.glsl work on them.
+vec3 normal;
+vec3 fragPos;
+vec4 directionalLightSpacePos;
+Material material;
+
+// World position of a pixel, from the depth the G-buffer pass left there.
+vec3 ReconstructPosition(ivec2 pixel, float depth)
+{
+	vec2 screenPos = (vec2(pixel) + 0.5) / vec2(textureSize(gDepth, 0));
+	vec4 ndc = vec4(screenPos * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0); // Back to the -1 to 1 range of the projection.
+	vec4 world = inverseViewProjection * ndc;
+	return world.xyz / world.w;
+}
+
+#include "lighting.glsl"
+#include "directional_shadow.glsl"
+
+void main()
+{
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	float depth = texelFetch(gDepth, pixel, 0).r;
+	if(depth == 1.0)
+	{
+		discard; // Nothing was drawn here. Stays the clear colour.
+	}
+	
+	vec4 albedo = texelFetch(gAlbedo, pixel, 0);
+	vec4 normalSpecular = texelFetch(gNormal, pixel, 0);
+	
+	normal = normalSpecular.xyz;
+	material.specularIntensity = normalSpecular.w;
+	material.shininess = albedo.a * 256.0;
+	fragPos = ReconstructPosition(pixel, depth);
+	directionalLightSpacePos = directionalLightTransform * vec4(fragPos, 1.0);
+	
+	float shadowFactor = CalcDirectionalShadowFactor(directionalLight);
+	colour = vec4(albedo.rgb, 1.0) * CalcLightByDirection(directionalLight.base, directionalLight.direction, shadowFactor);
+}
@@ -0,0 +1,10 @@
+#version 330
+
+// DEFERRED DIRECTIONAL LIGHT VERTEX SHADER
+
+void main()
+{	
+	// One triangle covering the whole screen, made from the vertex number. Same as shadow_blur.vert.
+	vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+}
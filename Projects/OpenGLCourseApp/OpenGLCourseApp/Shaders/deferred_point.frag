@@ -0,0 +1,77 @@
+#version 330
+
+// DEFERRED POINT LIGHT FRAGMENT SHADER
+// Runs for the pixels under one light's sphere. The result is added to what is already on screen.
+
+flat in int lightIndex; // -1 for the shadowed light in pointLights[0], otherwise the light's number in clusterLights.
+
+out vec4 colour;
+
+#include "lighting_types.glsl"
+
+// Arrays of 1, so the names match shader.frag and Shader::SetPointLights can fill them.
+uniform PointLight pointLights[1];
+uniform OmniShadowMap omniShadowMaps[1];
+
+// The G-buffer. See GBuffer.h for what is in it.
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+uniform mat4 inverseViewProjection;
+
+uniform vec3 eyePosition;
+
+// What shader.frag gets from shader.vert and from uniforms. Filled from the G-buffer in main, so the shared functions of lighting.glsl work on them.
+vec3 normal;
+vec3 fragPos;
+Material material;
+
+// World position of a pixel, from the depth the G-buffer pass left there.
+vec3 ReconstructPosition(ivec2 pixel, float depth)
+{
+	vec2 screenPos = (vec2(pixel) + 0.5) / vec2(textureSize(gDepth, 0));
+	vec4 ndc = vec4(screenPos * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0); // Back to the -1 to 1 range of the projection.
+	vec4 world = inverseViewProjection * ndc;
+	return world.xyz / world.w;
+}
+
+#include "lighting.glsl"
+#include "omni_shadow.glsl"
+#include "cluster_lights.glsl"
+
+void main()
+{
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	float depth = texelFetch(gDepth, pixel, 0).r;
+	if(depth == 1.0)
+	{
+		discard; // Nothing was drawn here.
+	}
+	
+	vec4 albedo = texelFetch(gAlbedo, pixel, 0);
+	vec4 normalSpecular = texelFetch(gNormal, pixel, 0);
+	
+	normal = normalSpecular.xyz;
+	material.specularIntensity = normalSpecular.w;
+	material.shininess = albedo.a * 256.0;
+	fragPos = ReconstructPosition(pixel, depth);
+	
+	PointLight pLight;
+	if(lightIndex < 0)
+	{
+		pLight = pointLights[0];
+	}
+	else
+	{
+		pLight = GetClusterLight(lightIndex);
+	}
+	
+	// The sphere covers pixels in front of and behind the light too. Only the ones really inside of it are lit.
+	if(length(fragPos - pLight.position) > pLight.radius)
+	{
+		discard;
+	}
+	
+	float shadowFactor = lightIndex < 0 ? CalcOmniShadowFactor(pLight, 0) : 0.0;
+	colour = vec4(albedo.rgb, 1.0) * CalcPointLight(pLight, shadowFactor);
+}
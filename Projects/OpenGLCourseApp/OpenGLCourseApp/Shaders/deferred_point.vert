@@ -0,0 +1,47 @@
+#version 330
+
+// DEFERRED POINT LIGHT VERTEX SHADER
+// Moves a unit sphere over the light, scaled to its radius. Only the pixels under the sphere get shaded for that light.
+
+layout (location = 0) in vec3 pos; // Unit sphere.
+layout (location = 4) in vec3 positionScale; // Set every draw by Mesh::RenderMesh. See shader.vert.
+layout (location = 5) in vec3 positionOffset;
+
+flat out int lightIndex; // Which light of clusterLights this is. -1 for the single shadowed light in pointLights[0].
+
+uniform mat4 projection;
+uniform mat4 view;
+
+uniform bool useClusterLights; // True: instance i draws light i of clusterLights. False: draws lightSphere.
+uniform samplerBuffer clusterLights; // One float per texel, see LightManager.h.
+uniform int clusterLightStride;
+uniform vec4 lightSphere; // xyz is the position, w the radius.
+
+// Planes of the position and radius in clusterLights. Have to be the same values as LightPlane in the LightManager.h file.
+const int LIGHT_POSITION_X = 0;
+const int LIGHT_POSITION_Y = 1;
+const int LIGHT_POSITION_Z = 2;
+const int LIGHT_RADIUS = 3;
+
+float ClusterLightValue(int lightIndex, int plane)
+{
+	return texelFetch(clusterLights, plane * clusterLightStride + lightIndex).r;
+}
+
+void main()
+{
+	vec4 sphere;
+	if(useClusterLights)
+	{
+		lightIndex = gl_InstanceID;
+		sphere = vec4(ClusterLightValue(gl_InstanceID, LIGHT_POSITION_X), ClusterLightValue(gl_InstanceID, LIGHT_POSITION_Y),
+			ClusterLightValue(gl_InstanceID, LIGHT_POSITION_Z), ClusterLightValue(gl_InstanceID, LIGHT_RADIUS));
+	}
+	else
+	{
+		lightIndex = -1;
+		sphere = lightSphere;
+	}
+	
+	gl_Position = projection * view * vec4(sphere.xyz + (positionOffset + pos * positionScale) * sphere.w, 1.0);
+}
@@ -0,0 +1,8 @@
+#version 330
+
+// DEPTH PRE-PASS FRAGMENT SHADER
+// Nothing to do, the depth is written on its own.
+
+void main()
+{
+}
@@ -0,0 +1,21 @@
+#version 330
+
+// DEPTH PRE-PASS VERTEX SHADER
+// Only fills the depth buffer, so shader.frag runs once per pixel afterwards.
+// gl_Position has to be computed exactly like in shader.vert, or GL_EQUAL would fail on some pixels.
+
+layout (location = 0) in vec3 pos;
+layout (location = 4) in vec3 positionScale; // Set every draw by Mesh::RenderMesh. See shader.vert.
+layout (location = 5) in vec3 positionOffset;
+
+invariant gl_Position; // Same math, same result, even if the compiler optimizes the two shaders differently.
+
+uniform mat4 model;
+uniform mat4 projection;
+uniform mat4 view;
+
+void main()
+{
+	vec3 position = positionOffset + pos * positionScale;
+	gl_Position = projection * view * model * vec4(position, 1.0);
+}
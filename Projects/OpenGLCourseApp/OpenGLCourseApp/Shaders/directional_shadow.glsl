@@ -0,0 +1,76 @@
+// DIRECTIONAL SHADOW
+// Needs lighting.glsl, and directionalLight, directionalLightSpacePos, directionalShadowMap, directionalShadowFilterMode and directionalShadowTile declared before it.
+
+float CalcDirectionalShadowFactor(DirectionalLight light)
+{
+	// Doing a special operation to get the coordinate system we need, to make them between -1 and 1.
+	vec3 projCoords = directionalLightSpacePos.xyz / directionalLightSpacePos.w;
+	// Converting to a 0 to 1 scale for the shadow map.
+	projCoords = (projCoords * 0.5) + 0.5;
+	
+	float currentDepth = projCoords.z; // How far away the point is from the light, forwards and backwards.
+	
+	// Outside of what the light can see, or the light got no room in the shadow atlas this frame. No shadow.
+	// (Regular shadow maps get that from their border, but tiles of an atlas have other tiles around them.)
+	if(directionalShadowTile.z <= 0.0 ||
+		projCoords.x < 0.0 || projCoords.x > 1.0 ||
+		projCoords.y < 0.0 || projCoords.y > 1.0)
+	{
+		return 0.0;
+	}
+	
+	// Moving into the light's tile. The edges of the tile, half a texel in, so linear filtering doesn't pick up the neighbour tiles.
+	vec2 tileMin = directionalShadowTile.xy + 0.5 / textureSize(directionalShadowMap, 0);
+	vec2 tileMax = directionalShadowTile.xy + directionalShadowTile.zw - 0.5 / textureSize(directionalShadowMap, 0);
+	projCoords.xy = directionalShadowTile.xy + projCoords.xy * directionalShadowTile.zw;
+	
+	if(directionalShadowFilterMode == SHADOW_FILTER_VSM)
+	{
+		if(projCoords.z > 1.0) // Beyond the far plane of our frustum, same as for PCF.
+		{
+			return 0.0;
+		}
+		vec2 moments = texture(directionalShadowMap, projCoords.xy).rg;
+		return 1.0 - ChebyshevUpperBound(moments, currentDepth);
+	}
+	
+	// Setting up the shadow bias, to avoid shadow acne phenomenon
+	vec3 newNormal = normalize(normal);
+	vec3 lightDir = normalize(directionalLight.direction); // Dunno if it's directionalLight.direction or light.direction.
+	
+	float bias = max(0.05 * (1.0 - dot(newNormal, lightDir)), 0.0005);
+	
+	// Doing PCF to make the shadows look smoother
+	float shadow = 0.0;
+	
+	// This gives us the size of 1 texel.
+	vec2 texelSize = 1.0 / textureSize(directionalShadowMap, 0);
+	// Now we want to move around to get the average of all texels around our point. to do PCF.
+	// We are iterating from -1 to 1, with 0 as our middle coordinate.
+	// Increasing our min value (-1) for x and y will give higher quality of PCF, but will be exponentially more costly on performance.
+	for(int x = -1; x <= 1; ++x)
+	{
+		for(int y = -1; y <= 1; ++y)
+		{
+			// So this goes into our shadow map, and takes the texture there at the point we are. But we add to that point our CURRENT x and y coords of the for loop (because we are evaluating points around right?)
+			// and we do that for our calculated texel size to get what ONE texel on the shadowmap is.
+			// Using orthogonal view from light source, so only XY will work on our texture. .r means first value, could use .x but standard is .r.
+			float pcfDepth = texture(directionalShadowMap, clamp(projCoords.xy + vec2(x, y) * texelSize, tileMin, tileMax)).r;
+			
+			// Adding this texel value to shadow.
+			
+			// Lifting up the point to slightly above whats on the shadowmap if they are directly on the shadow map.
+			shadow += (currentDepth - bias) > pcfDepth ? 1.0 : 0.0; // Here, 1.0 is full shadow. 0.0 is no shadow.
+		}
+	}
+	
+	// Doing the average of the pixels we went over in the previous for loop.
+	shadow /= 9.0; // 9 because 3 rows (x goes -1, 0, 1) and 3 cols (y goes -1, 0, 1). So 3x3.
+	
+	if(projCoords.z > 1.0) // If point is beyond the far plane of our frustum
+	{
+		shadow = 0.0; // No shadow. Dont do any shadows past our far plane.
+	}
+	
+	return shadow;
+}
@@ -1,8 +1,17 @@
 #version 330
 
 // SHADOW MAP FRAGMENT SHADER
-// Not currently needed for anything, so we leave empty.
+// The depth is written on its own. The moments are only kept when the shadow map is a variance shadow map,
+// otherwise the frame buffer has no colour attachment and they are thrown away.
+
+out vec2 moments;
 
 void main()
 {	
-}
\ No newline at end of file
+	float depth = gl_FragCoord.z;
+	
+	// Adding the slope of the depth over the pixel to the second moment, so surfaces at a steep angle to the light don't get acne.
+	float dx = dFdx(depth);
+	float dy = dFdy(depth);
+	moments = vec2(depth, depth * depth + 0.25 * (dx * dx + dy * dy));
+}
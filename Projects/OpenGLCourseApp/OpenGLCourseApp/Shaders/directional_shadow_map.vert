@@ -3,11 +3,13 @@
 // SHADOW MAP VERTEX SHADER
 
 layout (location = 0) in vec3 pos; // Position of a vertice
+layout (location = 4) in vec3 positionScale; // Set every draw by Mesh::RenderMesh. See shader.vert.
+layout (location = 5) in vec3 positionOffset;
 
 uniform mat4 model;
 uniform mat4 directionalLightTransform; // Point of view of the world from the light. This combines projection and view.
 
 void main()
 {	
-	gl_Position = directionalLightTransform * model * vec4(pos, 1.0);
+	gl_Position = directionalLightTransform * model * vec4(positionOffset + pos * positionScale, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,37 @@
+#version 330
+
+// G-BUFFER FRAGMENT SHADER
+// Stores what the lighting passes need. See GBuffer.h for the layout.
+
+in vec2 texCoord;
+in vec3 normal;
+flat in uint fragMaterialIndex;
+
+layout (location = 0) out vec4 gAlbedo;
+layout (location = 1) out vec4 gNormal;
+
+const int MAX_MATERIALS = 64; // Has to be the same value as in the CommonValues.h file.
+
+struct Material
+{
+	float specularIntensity;
+	float shininess;
+};
+
+uniform sampler2DArray theTexture; // Every material texture, one per layer. See TextureArray.h.
+
+layout (std140) uniform MaterialBlock
+{
+	vec4 materials[MAX_MATERIALS]; // x: specular intensity, y: shininess, z: texture layer. See MaterialTable.cpp.
+};
+
+void main()
+{
+	Material material;
+	material.specularIntensity = materials[fragMaterialIndex].x;
+	material.shininess = materials[fragMaterialIndex].y;
+	
+	// Shininess is kept in 8 bits, so it goes up to 256.
+	gAlbedo = vec4(texture(theTexture, vec3(texCoord, materials[fragMaterialIndex].z)).rgb, clamp(material.shininess / 256.0, 0.0, 1.0));
+	gNormal = vec4(normalize(normal), material.specularIntensity);
+}
@@ -0,0 +1,43 @@
+#version 330
+
+// G-BUFFER VERTEX SHADER
+// Same transforms as shader.vert, without anything the lighting needs. That is done later, per pixel.
+
+layout (location = 0) in vec3 pos;
+layout (location = 1) in vec2 tex;
+layout (location = 2) in vec3 norm;
+layout (location = 3) in uint materialIndex; // Not in the meshes. Set once per draw by MaterialTable::UseMaterial.
+layout (location = 4) in vec3 positionScale; // Set every draw by Mesh::RenderMesh. See shader.vert.
+layout (location = 5) in vec3 positionOffset;
+layout (location = 6) in float octahedralNormal;
+
+out vec2 texCoord;
+out vec3 normal;
+flat out uint fragMaterialIndex;
+
+uniform mat4 model;
+uniform mat4 projection;
+uniform mat4 view;
+
+vec3 DecodeOctahedral(vec2 folded)
+{
+	vec3 n = vec3(folded, 1.0 - abs(folded.x) - abs(folded.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return n;
+}
+
+void main()
+{
+	vec3 position = positionOffset + pos * positionScale;
+	vec3 meshNormal = octahedralNormal > 0.5 ? DecodeOctahedral(norm.xy) : norm;
+
+	gl_Position = projection * view * model * vec4(position, 1.0);
+	
+	texCoord = tex;
+	fragMaterialIndex = materialIndex;
+	
+	// See shader.vert for why the normal matrix is the transposed inverse.
+	normal = mat3(transpose(inverse(model))) * meshNormal;
+}
@@ -0,0 +1,75 @@
+// LIGHTING FUNCTIONS
+// Shared by shader.frag and the deferred shaders, so the forward and the deferred path light the same way. Spliced in by Shader::ReadFile.
+// Needs lighting_types.glsl, and normal, fragPos, material and eyePosition declared before it.
+
+// Variance shadow maps. The moments give us the mean and the variance of the depths around the point.
+// Chebyshev's inequality then gives the highest possible fraction of those depths that are behind our point, i.e. how lit it is.
+// A single (already blurred and mipmapped) fetch, instead of a loop of PCF samples.
+float ChebyshevUpperBound(vec2 moments, float currentDepth)
+{
+	if(currentDepth <= moments.x) // In front of everything around the point. Fully lit.
+	{
+		return 1.0;
+	}
+	
+	float variance = max(moments.y - (moments.x * moments.x), 0.00002); // Minimum variance, against precision issues on flat surfaces.
+	float d = currentDepth - moments.x;
+	float pMax = variance / (variance + d * d);
+	
+	// Cutting off the low end of pMax. Removes the light bleeding VSM has where shadows overlap.
+	return clamp((pMax - 0.2) / (1.0 - 0.2), 0.0, 1.0);
+}
+
+vec4 CalcLightByDirection(Light light, vec3 direction, float shadowFactor)
+{
+	vec4 ambientColour = vec4(light.colour, 1.0f) * light.ambientIntensity;
+
+	// Calculating diffuse lighting
+	
+	// Calculating the value between 0 and 1 that gives how much diffuse light there is, as in how dark the surface gets.
+	// We normalize so that the dot product ONLY takes into account the cos of the angle between the vectors. Normalizing removes the magnitude of each vector from the equation.
+	// And we want no negative values. At minimum, the factor can be 0 (dark).
+	float diffuseFactor = max(dot(normalize(normal), normalize(direction)), 0.0f);
+	
+	vec4 diffuseColor = vec4(light.colour * light.diffuseIntensity * diffuseFactor, 1.0f);
+	
+	// Initialize a specular color as "null". If used at this point, will do nothing.
+	vec4 specularColour = vec4(0, 0, 0, 0);
+	
+	// If we have diffuse lighting... Then we apply specular lighting. Can't have specular without diffuse.
+	if(diffuseFactor > 0.0f)
+	{
+		vec3 fragToEye = normalize(eyePosition - fragPos);
+		// Vector of where the light is reflected around the normal. We want light to bounce off on the other side of the normal.
+		// Reflect does this. First argument is what we want to reflect, and the second is what we are reflecting around.
+		vec3 reflectedVertex = normalize(reflect(direction, normalize(normal)));
+		
+		// Now we find the angle between those 2 vectors. This is why we normalized both of those vectors, so we can get the cos between the two.
+		float specularFactor = dot(fragToEye, reflectedVertex);
+		
+		if(specularFactor > 0.0f)
+		{
+			// Pow applies a power to a number.
+			specularFactor = pow(specularFactor, material.shininess);
+			specularColour = vec4(light.colour * material.specularIntensity * specularFactor, 1.0f);
+		}
+	}
+	
+	return (ambientColour + (1.0 - shadowFactor) * (diffuseColor + specularColour));
+}
+
+vec4 CalcPointLight(PointLight pLight, float shadowFactor)
+{
+	// Getting vector from point light to fragment.
+		vec3 direction = fragPos - pLight.position;
+		float distance = length(direction);
+		direction = normalize(direction);
+		
+		vec4 colour = CalcLightByDirection(pLight.base, direction, shadowFactor);
+		
+		// Formula to calculate attenuation. See theory.
+		float attenuation = pLight.exponent * distance * distance +
+							pLight.linear * distance +
+							pLight.constant;
+		return (colour / attenuation);
+}
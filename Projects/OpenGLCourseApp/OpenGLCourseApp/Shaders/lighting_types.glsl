@@ -0,0 +1,43 @@
+// LIGHTING TYPES
+// Constants and structs of the lights, shared by shader.frag and the deferred shaders. Spliced in by Shader::ReadFile.
+
+// Shadow filter modes. Have to be the same values as in the CommonValues.h file.
+const int SHADOW_FILTER_PCF = 0;
+const int SHADOW_FILTER_VSM = 1;
+
+struct Light
+{
+	vec3 colour;
+	float ambientIntensity;
+	float diffuseIntensity;
+};
+
+struct DirectionalLight 
+{
+	Light base; // Somewhat inheritance of the Light struct.
+	vec3 direction;
+};
+
+struct PointLight 
+{
+	Light base; // Somewhat inheritance of the Light struct.
+	vec3 position;
+	float constant;
+	float linear;
+	float exponent;
+	float radius; // Nothing further than this is lit. See PointLight::CalcAttenuationRadius.
+};
+
+struct OmniShadowMap
+{
+	samplerCube shadowMap;
+	float farPlane;
+	int filterMode; // PCF or VSM. See CommonValues.h
+	bool hasShadowMap; // False when the light got no map from the shadow map pool. It then casts no shadow.
+};
+
+struct Material
+{
+	float specularIntensity;
+	float shininess;
+};
@@ -0,0 +1,53 @@
+// OMNI SHADOW
+// Needs lighting.glsl, and omniShadowMaps declared before it.
+
+// Predefined sample positions to approximate shadow values using the OmniShadowMap. This is PCF.
+// This covers all main key directions. Avoids doing too many samples which slows down our app.
+vec3 sampleOffsetDirections[20] = vec3[]
+(
+	vec3(1, 1, 1), vec3(1, -1, 1), vec3(-1, -1, 1), vec3(-1, 1, 1),
+	vec3(1, 1, -1), vec3(1, -1, -1), vec3(-1, -1, -1), vec3(-1, 1, -1),
+	vec3(1, 1, 0), vec3(1, -1, 0), vec3(-1, -1, 0), vec3(-1, 1, 0),
+	vec3(1, 0, 1), vec3(-1, 0, 1), vec3(1, 0, -1), vec3(-1, 0, -1),
+	vec3(0, 1, 1), vec3(0, -1, 1), vec3(0, -1, -1), vec3(0, 1, -1)
+);
+
+float CalcOmniShadowFactor(PointLight light, int shadowIndex)
+{
+	vec3 fragToLight = fragPos - light.position; // Vector going from fragment to light
+	float currentDepth = length(fragToLight);
+	
+	if(!omniShadowMaps[shadowIndex].hasShadowMap)
+	{
+		return 0.0;
+	}
+	
+	if(omniShadowMaps[shadowIndex].filterMode == SHADOW_FILTER_VSM)
+	{
+		// The moments are stored normalized by the far plane, like the depth.
+		vec2 moments = texture(omniShadowMaps[shadowIndex].shadowMap, fragToLight).rg;
+		return 1.0 - ChebyshevUpperBound(moments, currentDepth / omniShadowMaps[shadowIndex].farPlane);
+	}
+	
+	float shadow = 0.0;
+	float bias = 0.05;
+	float samples = 20; // Amount of samples to take in.
+	// Calculating disk radius
+	// Distance in each direction to go into, using the samples.
+	// Calculated using the camera position so that the closer we get, the more blurred we want it.
+	float viewDistance = length(eyePosition - fragPos); // distance between camera and frag we are rendering
+	float diskRadius = (1.0 + (viewDistance /  omniShadowMaps[shadowIndex].farPlane)) / 25.0; // Scaling the value
+	
+	for(int i = 0; i < samples; i++)
+	{
+		float closestDepth = texture(omniShadowMaps[shadowIndex].shadowMap, fragToLight + sampleOffsetDirections[i] * diskRadius).r; // This samples in the direction by using xyz from our loops.
+		closestDepth *= omniShadowMaps[shadowIndex].farPlane; // Reconverting from the 0 to 1 scale to the actual scale according to our far plane. See the omni shadow map code.
+		if((currentDepth - bias) > closestDepth)
+		{
+			shadow += 1.0;
+		}
+	}
+	
+	shadow /= float(samples); // Taking the average of the samples we took. Here, we do number of samples cubed.
+	return shadow;
+}
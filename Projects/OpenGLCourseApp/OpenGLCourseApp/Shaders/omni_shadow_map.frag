@@ -4,6 +4,8 @@
 
 in vec4 fragPos;
 
+out vec2 moments; // Only kept for variance shadow maps, see directional_shadow_map.frag.
+
 uniform vec3 lightPos;
 uniform float farPlane; // How far we want to render.
 
@@ -12,4 +14,8 @@ void main()
 	float distance = length(fragPos.xyz - lightPos); // distance between the fragment we are trying to render and the light
 	distance = distance / farPlane; // distance normalized, according to the farplane. Will output between 0 and 1.
 	gl_FragDepth = distance;
-}
\ No newline at end of file
+	
+	float dx = dFdx(distance);
+	float dy = dFdy(distance);
+	moments = vec2(distance, distance * distance + 0.25 * (dx * dx + dy * dy));
+}
@@ -3,10 +3,12 @@
 // OMNI SHADOW MAP VERTEX SHADER
 
 layout (location = 0) in vec3 pos; // Position of a vertice
+layout (location = 4) in vec3 positionScale; // Set every draw by Mesh::RenderMesh. See shader.vert.
+layout (location = 5) in vec3 positionOffset;
 
 uniform mat4 model;
 
 void main()
 {	
-	gl_Position = model * vec4(pos, 1.0);
+	gl_Position = model * vec4(positionOffset + pos * positionScale, 1.0);
 }
\ No newline at end of file
@@ -7,219 +7,108 @@ in vec2 texCoord;
 in vec3 normal;
 in vec3 fragPos;
 in vec4 directionalLightSpacePos;
+in float viewDepth;
+flat in uint fragMaterialIndex;
 
 out vec4 colour;
 
 const int MAX_POINT_LIGHTS = 3; // Has to be the same value as in the CommonValues.h file.
+const int MAX_MATERIALS = 64; // Has to be the same value as in the CommonValues.h file.
 
-struct Light
-{
-	vec3 colour;
-	float ambientIntensity;
-	float diffuseIntensity;
-};
+// Size of the light cluster grid. Have to be the same values as in the CommonValues.h file.
+const int CLUSTER_GRID_X = 16;
+const int CLUSTER_GRID_Y = 9;
+const int CLUSTER_GRID_Z = 24;
 
-struct DirectionalLight 
-{
-	Light base; // Somewhat inheritance of the Light struct.
-	vec3 direction;
-};
-
-struct PointLight 
-{
-	Light base; // Somewhat inheritance of the Light struct.
-	vec3 position;
-	float constant;
-	float linear;
-	float exponent;
-};
-
-struct OmniShadowMap
-{
-	samplerCube shadowMap;
-	float farPlane;
-};
-
-struct Material
-{
-	float specularIntensity;
-	float shininess;
-};
+#include "lighting_types.glsl"
 
 uniform int pointLightCount;
 
 uniform DirectionalLight directionalLight;
 uniform PointLight pointLights[MAX_POINT_LIGHTS];
 
-uniform sampler2D theTexture;
+uniform sampler2DArray theTexture; // Every material texture, one per layer. See TextureArray.h.
 uniform sampler2D directionalShadowMap;
+uniform int directionalShadowFilterMode; // PCF or VSM. See CommonValues.h
+uniform vec4 directionalShadowTile; // Where the light's shadow is in directionalShadowMap. xy is the corner, zw the size. (0, 0, 1, 1) unless it is in a shadow atlas.
 uniform OmniShadowMap omniShadowMaps[MAX_POINT_LIGHTS]; // Shadow maps for point lights and spotlights
 
-uniform Material material;
+layout (std140) uniform MaterialBlock
+{
+	vec4 materials[MAX_MATERIALS]; // x: specular intensity, y: shininess, z: texture layer. See MaterialTable.cpp.
+};
+Material material; // This fragment's entry of materials, filled at the start of main.
+
+// Clustered point lights, without shadows. See ClusterGrid.cpp and LightManager.h for how they are stored.
+// clusterLights itself is in cluster_lights.glsl.
+uniform usamplerBuffer clusterRanges; // Per cluster: where its list starts in clusterLightIndices, and how many lights it has.
+uniform usamplerBuffer clusterLightIndices;
+uniform vec2 clusterTileSize; // In pixels.
+uniform vec2 clusterDepthParams; // Depth slice is log(viewDepth) * x - y.
 
 // Position of the eye, of the camera
 uniform vec3 eyePosition;
 
-// Predefined sample positions to approximate shadow values using the OmniShadowMap. This is PCF.
-// This covers all main key directions. Avoids doing too many samples which slows down our app.
-vec3 sampleOffsetDirections[20] = vec3[]
-(
-	vec3(1, 1, 1), vec3(1, -1, 1), vec3(-1, -1, 1), vec3(-1, 1, 1),
-	vec3(1, 1, -1), vec3(1, -1, -1), vec3(-1, -1, -1), vec3(-1, 1, -1),
-	vec3(1, 1, 0), vec3(1, -1, 0), vec3(-1, -1, 0), vec3(-1, 1, 0),
-	vec3(1, 0, 1), vec3(-1, 0, 1), vec3(1, 0, -1), vec3(-1, 0, -1),
-	vec3(0, 1, 1), vec3(0, -1, 1), vec3(0, -1, -1), vec3(0, 1, -1)
-);
-
-float CalcDirectionalShadowFactor(DirectionalLight light)
+#include "lighting.glsl"
+#include "directional_shadow.glsl"
+#include "omni_shadow.glsl"
+#include "cluster_lights.glsl"
+
+vec4 CalcDirectionalLight()
 {
-	// Doing a special operation to get the coordinate system we need, to make them between -1 and 1.
-	vec3 projCoords = directionalLightSpacePos.xyz / directionalLightSpacePos.w;
-	// Converting to a 0 to 1 scale for the shadow map.
-	projCoords = (projCoords * 0.5) + 0.5;
-	
-	float currentDepth = projCoords.z; // How far away the point is from the light, forwards and backwards.
-	
-	// Setting up the shadow bias, to avoid shadow acne phenomenon
-	vec3 newNormal = normalize(normal);
-	vec3 lightDir = normalize(directionalLight.direction); // Dunno if it's directionalLight.direction or light.direction.
-	
-	float bias = max(0.05 * (1.0 - dot(newNormal, lightDir)), 0.0005);
-	
-	// Doing PCF to make the shadows look smoother
-	float shadow = 0.0;
-	
-	// This gives us the size of 1 texel.
-	vec2 texelSize = 1.0 / textureSize(directionalShadowMap, 0);
-	// Now we want to move around to get the average of all texels around our point. to do PCF.
-	// We are iterating from -1 to 1, with 0 as our middle coordinate.
-	// Increasing our min value (-1) for x and y will give higher quality of PCF, but will be exponentially more costly on performance.
-	for(int x = -1; x <= 1; ++x)
-	{
-		for(int y = -1; y <= 1; ++y)
-		{
-			// So this goes into our shadow map, and takes the texture there at the point we are. But we add to that point our CURRENT x and y coords of the for loop (because we are evaluating points around right?)
-			// and we do that for our calculated texel size to get what ONE texel on the shadowmap is.
-			// Using orthogonal view from light source, so only XY will work on our texture. .r means first value, could use .x but standard is .r.
-			float pcfDepth = texture(directionalShadowMap, projCoords.xy + vec2(x, y) * texelSize).r;
-			
-			// Adding this texel value to shadow.
-			
-			// Lifting up the point to slightly above whats on the shadowmap if they are directly on the shadow map.
-			shadow += (currentDepth - bias) > pcfDepth ? 1.0 : 0.0; // Here, 1.0 is full shadow. 0.0 is no shadow.
-		}
-	}
-	
-	// Doing the average of the pixels we went over in the previous for loop.
-	shadow /= 9.0; // 9 because 3 rows (x goes -1, 0, 1) and 3 cols (y goes -1, 0, 1). So 3x3.
-	
-	if(projCoords.z > 1.0) // If point is beyond the far plane of our frustum
-	{
-		shadow = 0.0; // No shadow. Dont do any shadows past our far plane.
-	}
-	
-	return shadow;
+	float shadowFactor = CalcDirectionalShadowFactor(directionalLight);
+	return CalcLightByDirection(directionalLight.base, directionalLight.direction, shadowFactor);
 }
 
-float CalcOmniShadowFactor(PointLight light, int shadowIndex)
+vec4 CalcPointLights()
 {
-	vec3 fragToLight = fragPos - light.position; // Vector going from fragment to light
-	float currentDepth = length(fragToLight);
-	
-	float shadow = 0.0;
-	float bias = 0.05;
-	float samples = 20; // Amount of samples to take in.
-	// Calculating disk radius
-	// Distance in each direction to go into, using the samples.
-	// Calculated using the camera position so that the closer we get, the more blurred we want it.
-	float viewDistance = length(eyePosition - fragPos); // distance between camera and frag we are rendering
-	float diskRadius = (1.0 + (viewDistance /  omniShadowMaps[shadowIndex].farPlane)) / 25.0; // Scaling the value
+	vec4 totalColour = vec4(0, 0, 0, 0);
 	
-	for(int i = 0; i < samples; i++)
+	// Loop over point lights and add them to total colour.
+	// The loop goes to the constant MAX_POINT_LIGHTS, so omniShadowMaps is only ever indexed by a constant once it is unrolled.
+	for(int i = 0; i < MAX_POINT_LIGHTS; i++)
 	{
-		float closestDepth = texture(omniShadowMaps[shadowIndex].shadowMap, fragToLight + sampleOffsetDirections[i] * diskRadius).r; // This samples in the direction by using xyz from our loops.
-		closestDepth *= omniShadowMaps[shadowIndex].farPlane; // Reconverting from the 0 to 1 scale to the actual scale according to our far plane. See the omni shadow map code.
-		if((currentDepth - bias) > closestDepth)
+		if(i >= pointLightCount)
 		{
-			shadow += 1.0;
+			break;
 		}
+		// Out of reach. Skipping it before the shadow lookup, which is the expensive part.
+		if(length(fragPos - pointLights[i].position) > pointLights[i].radius)
+		{
+			continue;
+		}
+		float shadowFactor = CalcOmniShadowFactor(pointLights[i], i); // 1 to 1 relation between point light index and shadow index.
+		totalColour += CalcPointLight(pointLights[i], shadowFactor);
 	}
 	
-	shadow /= float(samples); // Taking the average of the samples we took. Here, we do number of samples cubed.
-	return shadow;
+	return totalColour;
 }
 
-vec4 CalcLightByDirection(Light light, vec3 direction, float shadowFactor)
+vec4 CalcClusteredPointLights()
 {
-	vec4 ambientColour = vec4(light.colour, 1.0f) * light.ambientIntensity;
-
-	// Calculating diffuse lighting
-	
-	// Calculating the value between 0 and 1 that gives how much diffuse light there is, as in how dark the surface gets.
-	// We normalize so that the dot product ONLY takes into account the cos of the angle between the vectors. Normalizing removes the magnitude of each vector from the equation.
-	// And we want no negative values. At minimum, the factor can be 0 (dark).
-	float diffuseFactor = max(dot(normalize(normal), normalize(direction)), 0.0f);
-	
-	vec4 diffuseColor = vec4(light.colour * light.diffuseIntensity * diffuseFactor, 1.0f);
+	vec4 totalColour = vec4(0, 0, 0, 0);
 	
-	// Initialize a specular color as "null". If used at this point, will do nothing.
-	vec4 specularColour = vec4(0, 0, 0, 0);
+	// Finding which cluster we are in. Tile on screen, then depth slice.
+	ivec3 cluster;
+	cluster.xy = clamp(ivec2(gl_FragCoord.xy / clusterTileSize), ivec2(0, 0), ivec2(CLUSTER_GRID_X - 1, CLUSTER_GRID_Y - 1));
+	cluster.z = clamp(int(log(viewDepth) * clusterDepthParams.x - clusterDepthParams.y), 0, CLUSTER_GRID_Z - 1);
+	int clusterIndex = cluster.x + cluster.y * CLUSTER_GRID_X + cluster.z * CLUSTER_GRID_X * CLUSTER_GRID_Y;
 	
-	// If we have diffuse lighting... Then we apply specular lighting. Can't have specular without diffuse.
-	if(diffuseFactor > 0.0f)
+	// Only the lights that reach this cluster.
+	uvec2 range = texelFetch(clusterRanges, clusterIndex).rg;
+	for(uint i = 0u; i < range.y; i++)
 	{
-		vec3 fragToEye = normalize(eyePosition - fragPos);
-		// Vector of where the light is reflected around the normal. We want light to bounce off on the other side of the normal.
-		// Reflect does this. First argument is what we want to reflect, and the second is what we are reflecting around.
-		vec3 reflectedVertex = normalize(reflect(direction, normalize(normal)));
+		int lightIndex = int(texelFetch(clusterLightIndices, int(range.x + i)).r);
 		
-		// Now we find the angle between those 2 vectors. This is why we normalized both of those vectors, so we can get the cos between the two.
-		float specularFactor = dot(fragToEye, reflectedVertex);
-		
-		if(specularFactor > 0.0f)
+		// The cluster is bigger than the fragment. Skipping lights that don't reach this exact spot, before reading the rest of the light.
+		vec3 position = vec3(ClusterLightValue(lightIndex, LIGHT_POSITION_X), ClusterLightValue(lightIndex, LIGHT_POSITION_Y), ClusterLightValue(lightIndex, LIGHT_POSITION_Z));
+		if(length(fragPos - position) > ClusterLightValue(lightIndex, LIGHT_RADIUS))
 		{
-			// Pow applies a power to a number.
-			specularFactor = pow(specularFactor, material.shininess);
-			specularColour = vec4(light.colour * material.specularIntensity * specularFactor, 1.0f);
+			continue;
 		}
-	}
-	
-	return (ambientColour + (1.0 - shadowFactor) * (diffuseColor + specularColour));
-}
-
-vec4 CalcDirectionalLight()
-{
-	float shadowFactor = CalcDirectionalShadowFactor(directionalLight);
-	return CalcLightByDirection(directionalLight.base, directionalLight.direction, shadowFactor);
-}
-
-vec4 CalcPointLight(PointLight pLight, int shadowIndex)
-{
-	// Getting vector from point light to fragment.
-		vec3 direction = fragPos - pLight.position;
-		float distance = length(direction);
-		direction = normalize(direction);
-		
-		float shadowFactor = CalcOmniShadowFactor(pLight, shadowIndex);
-			
-		vec4 colour = CalcLightByDirection(pLight.base, direction, shadowFactor);
 		
-		// Formula to calculate attenuation. See theory.
-		float attenuation = pLight.exponent * distance * distance +
-							pLight.linear * distance +
-							pLight.constant;
-		return (colour / attenuation);
-}
-
-
-vec4 CalcPointLights()
-{
-	vec4 totalColour = vec4(0, 0, 0, 0);
-	
-	// Loop over point lights and add them to total colour.
-	for(int i =0; i < pointLightCount; i++)
-	{
-		totalColour += CalcPointLight(pointLights[i], i); // 1 to 1 relation between point light index and shadow index.
+		PointLight pLight = GetClusterLight(lightIndex);
+		totalColour += CalcPointLight(pLight, 0.0); // No shadows for clustered lights.
 	}
 	
 	return totalColour;
@@ -227,8 +116,12 @@ vec4 CalcPointLights()
 
 void main()
 {	
+	material.specularIntensity = materials[fragMaterialIndex].x;
+	material.shininess = materials[fragMaterialIndex].y;
+	
 	vec4 finalColour = CalcDirectionalLight();
 	finalColour += CalcPointLights();
+	finalColour += CalcClusteredPointLights();
 	
-	colour = texture(theTexture, texCoord) * finalColour;
+	colour = texture(theTexture, vec3(texCoord, materials[fragMaterialIndex].z)) * finalColour;
 }
\ No newline at end of file
@@ -5,41 +5,66 @@
 layout (location = 0) in vec3 pos;
 layout (location = 1) in vec2 tex;
 layout (location = 2) in vec3 norm;
+layout (location = 3) in uint materialIndex; // Not in the meshes. Set once per draw by MaterialTable::UseMaterial.
+layout (location = 4) in vec3 positionScale; // Not in the meshes either. Set every draw by Mesh::RenderMesh, see VertexFormat.
+layout (location = 5) in vec3 positionOffset;
+layout (location = 6) in float octahedralNormal; // 1 when norm.xy is an octahedral normal, 0 when norm is x, y, z.
 
 out vec4 vCol;
 out vec2 texCoord;
 out vec3 normal;
+flat out uint fragMaterialIndex;
 
 // Position of the fragment
 out vec3 fragPos;
 
 out vec4 directionalLightSpacePos; // The position of where the fragment is relative to the light.
+out float viewDepth; // Distance in front of the camera. Picks the depth slice of the light clusters.
+
+invariant gl_Position; // Has to match depth_prepass.vert exactly, the lit pass uses GL_EQUAL after the depth pre-pass.
 
 uniform mat4 model;
 uniform mat4 projection;
 uniform mat4 view;
 uniform mat4 directionalLightTransform;
 
+// Unfolds the lower half of the octahedron back under the upper one. See Mesh::EncodeOctahedral.
+vec3 DecodeOctahedral(vec2 folded)
+{
+	vec3 n = vec3(folded, 1.0 - abs(folded.x) - abs(folded.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return n;
+}
+
 void main()
 {
-	gl_Position = projection * view * model * vec4(pos, 1.0);
+	// Packed positions come as 0 to 1 across the mesh's box. Float ones have a scale of 1 and an offset of 0. Same in depth_prepass.vert.
+	vec3 position = positionOffset + pos * positionScale;
+	vec3 meshNormal = octahedralNormal > 0.5 ? DecodeOctahedral(norm.xy) : norm;
+
+	gl_Position = projection * view * model * vec4(position, 1.0);
 	
-	directionalLightSpacePos = directionalLightTransform * model * vec4(pos, 1.0);
+	directionalLightSpacePos = directionalLightTransform * model * vec4(position, 1.0);
 	
-	vCol = vec4(clamp(pos, 0.0f, 1.0f), 1.0f);
+	vCol = vec4(clamp(position, 0.0f, 1.0f), 1.0f);
 	
 	texCoord = tex;
+	fragMaterialIndex = materialIndex;
 	
 	// Here, we put model to multiply because if our object moves around, the normal has to move to. Normal is in relation to where the model is.
 	// But the normal doesnt really change direction.... unless we rotate or scale an object in one direction. Then, the normal will change and have to be recalculated.
 	// Because rotation and scale happens in the first 3x3 matrix inside the mat4, we convert our mat4 to a mat3 to only keep rotation and scale values.
 	// But also, the rotation changes our norm in a way we want to, but the scaling changes the normal in a way we dont want to!
 	// So we have to avoid scaling, while taking in rotation. The trick to do that is to transpose and inverse the matrix, this reverses the scaling.
-	normal = mat3(transpose(inverse(model))) * norm;
+	normal = mat3(transpose(inverse(model))) * meshNormal;
 	
 	// Just gives you where it is in the world, without taking into care the "view" or camera
 	// We don't need a vec4 though, we need a vec3. So we use Swizzling (using .xyz at the end).
 	// Swizzling will create a vector only using the variables we put in at the end. So will create a vec3(x, y, z).
 	// We could also do sampleVector.xyy to get a vec3(x, y, y).
-	fragPos = (model * vec4(pos, 1.0)).xyz;
+	fragPos = (model * vec4(position, 1.0)).xyz;
+	
+	viewDepth = -(view * vec4(fragPos, 1.0)).z; // The camera looks down -z.
 }
\ No newline at end of file
@@ -0,0 +1,25 @@
+#version 330
+
+// SHADOW BLUR FRAGMENT SHADER
+// One direction of a separable gaussian blur over the moments of a variance shadow map.
+// Ran twice, horizontally then vertically. So 9 + 9 samples instead of 81 for the same 9x9 blur.
+
+in vec2 texCoord;
+
+out vec2 moments;
+
+uniform sampler2D blurSource;
+uniform vec2 blurDirection; // Size of one texel, along the direction we blur. (1/width, 0) or (0, 1/height).
+
+const float weights[5] = float[](0.2270270, 0.1945946, 0.1216216, 0.0540540, 0.0162162); // Gaussian weights, from the center outwards.
+
+void main()
+{	
+	vec2 result = textureLod(blurSource, texCoord, 0.0).rg * weights[0];
+	for(int i = 1; i < 5; i++)
+	{
+		result += textureLod(blurSource, texCoord + blurDirection * i, 0.0).rg * weights[i];
+		result += textureLod(blurSource, texCoord - blurDirection * i, 0.0).rg * weights[i];
+	}
+	moments = result;
+}
@@ -0,0 +1,14 @@
+#version 330
+
+// SHADOW BLUR VERTEX SHADER
+
+out vec2 texCoord;
+
+void main()
+{	
+	// One triangle big enough to cover the whole screen, made from the vertex number. So no vertex buffer is needed.
+	// Vertex 0 -> (0, 0), vertex 1 -> (2, 0), vertex 2 -> (0, 2).
+	vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	texCoord = pos;
+	gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,243 @@
+#include "ShadowAtlas.h"
+
+#include "AtlasShadowMap.h"
+#include "CommonValues.h"
+
+ShadowAtlas::ShadowAtlas()
+{
+	FBO = 0;
+	atlasMap = 0;
+	atlasSize = 0;
+	maximumSize = 0;
+	minimumTileSize = 0;
+}
+
+bool ShadowAtlas::Init(unsigned int maximumSize, unsigned int minimumTileSize)
+{
+	this->maximumSize = maximumSize;
+	this->minimumTileSize = minimumTileSize;
+
+	glGenFramebuffers(1, &FBO);
+
+	// Same as a regular directional shadow map, only bigger. Its size is set in Resize.
+	glGenTextures(1, &atlasMap);
+	glBindTexture(GL_TEXTURE_2D, atlasMap);
+
+	// Tiles are next to each other, so there is no border to clamp to. shader.frag clamps the samples inside the tile instead.
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	return true;
+}
+
+GLuint ShadowAtlas::CalcNeededSize()
+{
+	// Power of 2 squares, biggest first, fill a quadtree without gaps. So they fit as long as their areas add up to the atlas's.
+	GLuint biggest = 0;
+	unsigned long long area = 0;
+	for (size_t i = 0; i < shadowMaps.size(); i++)
+	{
+		GLuint tile = minimumTileSize;
+		while (tile < shadowMaps[i]->GetMaximumSize() && tile < maximumSize)
+		{
+			tile *= 2;
+		}
+		biggest = std::max(biggest, tile);
+		area += (unsigned long long)tile * tile;
+	}
+
+	GLuint size = biggest;
+	while (size < maximumSize && (unsigned long long)size * size < area)
+	{
+		size *= 2;
+	}
+	return size;
+}
+
+bool ShadowAtlas::Resize(GLuint size)
+{
+	if (size == atlasSize)
+	{
+		return true;
+	}
+	atlasSize = size;
+
+	glBindTexture(GL_TEXTURE_2D, atlasMap);
+	glTexImage2D(GL_TEXTURE_2D, 0, ShadowMap::GetFormat(SHADOW_QUALITY, false).depthFormat, atlasSize, atlasSize, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	if (atlasSize == 0)
+	{
+		return true; // Nothing to draw in. Pack hands out no tiles.
+	}
+
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, FBO);
+	glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, atlasMap, 0);
+
+	// Disabling reading colors.
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+
+	GLenum status = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		printf("Shadow atlas Framebuffer Error: %i\n", status);
+		return false;
+	}
+
+	return true;
+}
+
+void ShadowAtlas::Write()
+{
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, FBO);
+}
+
+void ShadowAtlas::Read(GLenum textureUnit)
+{
+	glActiveTexture(textureUnit);
+	glBindTexture(GL_TEXTURE_2D, atlasMap);
+}
+
+void ShadowAtlas::Pack()
+{
+	// Most important lights first, so they get first pick of the big tiles.
+	std::vector<AtlasShadowMap*> sortedMaps = shadowMaps;
+	std::sort(sortedMaps.begin(), sortedMaps.end(), [](AtlasShadowMap* a, AtlasShadowMap* b)
+	{
+		return a->GetImportance() > b->GetImportance();
+	});
+
+	// Starting over with one free square covering the whole atlas.
+	quadNodes.clear();
+	QuadNode root = { 0, 0, atlasSize, false, -1 };
+	quadNodes.push_back(root);
+
+	for (size_t i = 0; i < sortedMaps.size(); i++)
+	{
+		AtlasShadowMap* shadowMap = sortedMaps[i];
+
+		// Wanted size, scaled by importance, rounded down to a power of 2. Never bigger than the light's own resolution.
+		GLfloat wanted = std::min((GLfloat)shadowMap->GetMaximumSize(), (GLfloat)atlasSize) * shadowMap->GetImportance();
+		GLuint size = minimumTileSize;
+		while (size * 2 <= wanted && size * 2 <= atlasSize)
+		{
+			size *= 2;
+		}
+
+		// If the atlas is too full, try smaller and smaller tiles.
+		GLuint x = 0, y = 0;
+		bool found = false;
+		while (!found && size >= minimumTileSize)
+		{
+			found = AllocateTile(0, size, &x, &y);
+			if (!found)
+			{
+				size /= 2;
+			}
+		}
+
+		if (found)
+		{
+			shadowMap->SetTile(x, y, size);
+		}
+		else
+		{
+			shadowMap->SetTile(0, 0, 0); // No room at all. This light casts no shadow this frame.
+		}
+	}
+}
+
+bool ShadowAtlas::AllocateTile(int nodeIndex, GLuint size, GLuint* x, GLuint* y)
+{
+	// Copying, because push_back below can move the nodes around.
+	QuadNode node = quadNodes[nodeIndex];
+
+	if (node.used || node.size < size)
+	{
+		return false;
+	}
+
+	if (node.firstChild < 0)
+	{
+		if (node.size == size)
+		{
+			quadNodes[nodeIndex].used = true;
+			*x = node.x;
+			*y = node.y;
+			return true;
+		}
+
+		// Too big. Splitting in 4 squares of half the size.
+		GLuint half = node.size / 2;
+		int firstChild = (int)quadNodes.size();
+		for (int i = 0; i < 4; i++)
+		{
+			QuadNode child = { node.x + (i % 2) * half, node.y + (i / 2) * half, half, false, -1 };
+			quadNodes.push_back(child);
+		}
+		quadNodes[nodeIndex].firstChild = firstChild;
+		node.firstChild = firstChild;
+	}
+
+	for (int i = 0; i < 4; i++)
+	{
+		if (AllocateTile(node.firstChild + i, size, x, y))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+GLfloat ShadowAtlas::CalcScreenImportance(glm::vec3 boundsCenter, GLfloat boundsRadius, glm::vec3 cameraPosition, GLfloat fieldOfView)
+{
+	GLfloat distance = glm::length(boundsCenter - cameraPosition);
+	if (distance <= boundsRadius)
+	{
+		return 1.0f; // We are inside of it, it covers the whole screen.
+	}
+
+	// Projected radius of the sphere, compared to half the height of the screen.
+	GLfloat projectedRadius = boundsRadius / (distance * tanf(fieldOfView * 0.5f));
+	return std::min(projectedRadius, 1.0f);
+}
+
+void ShadowAtlas::AddShadowMap(AtlasShadowMap* shadowMap)
+{
+	shadowMaps.push_back(shadowMap);
+	Resize(CalcNeededSize());
+}
+
+void ShadowAtlas::RemoveShadowMap(AtlasShadowMap* shadowMap)
+{
+	shadowMaps.erase(std::remove(shadowMaps.begin(), shadowMaps.end(), shadowMap), shadowMaps.end());
+	Resize(CalcNeededSize());
+}
+
+GLuint ShadowAtlas::GetAtlasSize()
+{
+	return atlasSize;
+}
+
+size_t ShadowAtlas::GetMemoryUsage()
+{
+	return (size_t)atlasSize * atlasSize * ShadowMap::GetFormat(SHADOW_QUALITY, false).depthBytes;
+}
+
+ShadowAtlas::~ShadowAtlas()
+{
+	if (FBO)
+	{
+		glDeleteFramebuffers(1, &FBO);
+	}
+	if (atlasMap)
+	{
+		glDeleteTextures(1, &atlasMap);
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdio.h>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+class AtlasShadowMap;
+
+// One big depth texture, shared by many 2D shadow maps. Each map gets a square tile in it, with a power of 2 size.
+// Every light renders in the same frame buffer, so there is no frame buffer or texture switching between lights.
+// Tiles are handed out again every frame by a quadtree, biggest tiles to the most important lights.
+// The atlas is only as big as the maps added to it need, every one at its full size, and grows as more are added.
+class ShadowAtlas
+{
+	public:
+		ShadowAtlas();
+
+		// The texture is made when the first shadow map is added. maximumSize is as big as it will ever grow.
+		bool Init(unsigned int maximumSize, unsigned int minimumTileSize);
+
+		// Binds the atlas frame buffer. The viewport and scissor of the tile are set by the shadow map itself.
+		void Write();
+
+		void Read(GLenum textureUnit);
+
+		// Gives a tile to every registered shadow map, according to its importance. Call once per frame, before the shadow passes.
+		void Pack();
+
+		// How much of the screen a light's shadow covers, between 0 and 1. Uses the bounding sphere of the light's shadow volume.
+		static GLfloat CalcScreenImportance(glm::vec3 boundsCenter, GLfloat boundsRadius, glm::vec3 cameraPosition, GLfloat fieldOfView);
+
+		void AddShadowMap(AtlasShadowMap* shadowMap);
+		void RemoveShadowMap(AtlasShadowMap* shadowMap);
+
+		GLuint GetAtlasSize();
+		size_t GetMemoryUsage(); // In bytes.
+
+		~ShadowAtlas();
+
+	private:
+		GLuint FBO, atlasMap;
+		GLuint atlasSize; // 0 until a shadow map is added.
+		GLuint maximumSize;
+		GLuint minimumTileSize; // Lights never get a smaller tile than this. If there is no room left, they get no tile at all.
+
+		std::vector<AtlasShadowMap*> shadowMaps;
+
+		// A square of the atlas. Split in 4 when a smaller tile is needed inside of it.
+		struct QuadNode
+		{
+			GLuint x, y, size;
+			bool used; // A tile was handed out for this whole square.
+			int firstChild; // Index of the first of the 4 children in quadNodes. -1 when not split.
+		};
+		std::vector<QuadNode> quadNodes;
+
+		bool AllocateTile(int nodeIndex, GLuint size, GLuint* x, GLuint* y);
+
+		// Smallest power of 2 that holds every map's tile at its full size, up to maximumSize.
+		GLuint CalcNeededSize();
+		// Makes the texture that size. What was in it is lost, the shadow passes fill it again every frame.
+		bool Resize(GLuint size);
+};
+
@@ -4,6 +4,14 @@ ShadowMap::ShadowMap()
 {
     FBO = 0;
     shadowMap = 0;
+
+	filterMode = SHADOW_FILTER_MODE;
+	format = GetFormat(SHADOW_QUALITY, false);
+	momentsMap = 0;
+	momentsFBO = 0;
+	blurFBO[0] = blurFBO[1] = 0;
+	blurMap[0] = blurMap[1] = 0;
+	blurVAO = 0;
 }
 
 bool ShadowMap::Init(unsigned int width, unsigned int height)
@@ -15,7 +23,7 @@ bool ShadowMap::Init(unsigned int width, unsigned int height)
 
     glGenTextures(1, &shadowMap);
     glBindTexture(GL_TEXTURE_2D, shadowMap);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    glTexImage2D(GL_TEXTURE_2D, 0, format.depthFormat, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
 
 	// Setting texture parameters
 	glTexParameteri(GL_TEXTURE_2D, // Type of Texture
@@ -40,6 +48,21 @@ bool ShadowMap::Init(unsigned int width, unsigned int height)
 		GL_LINEAR // The value. Here, we could also use GL_LINEAR. It's personnal preference.
 	);
 
+	if (filterMode == SHADOW_FILTER_VSM)
+	{
+		// Variance shadow maps store the depth and the depth squared in a colour texture.
+		// Mipmapped, so far away fragments get a pre-averaged value in one fetch.
+		glGenTextures(1, &momentsMap);
+		glBindTexture(GL_TEXTURE_2D, momentsMap);
+		glTexImage2D(GL_TEXTURE_2D, 0, format.momentsFormat, width, height, 0, GL_RG, GL_FLOAT, nullptr);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+		glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor); // Depth 1, depth squared 1. Fully lit.
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glGenerateMipmap(GL_TEXTURE_2D); // Allocating the mip levels now, so the texture is complete before the first shadow pass.
+	}
+
 	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, FBO);
 	// Connects the frame buffer to the texture, so that when the frame buffer is updated it is rendered in the texture.
 	glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, // Target
@@ -49,9 +72,19 @@ bool ShadowMap::Init(unsigned int width, unsigned int height)
 						   0 // Mipmap level
 		);
 
-	// Disabling reading colors.
-	glDrawBuffer(GL_NONE);
-	glReadBuffer(GL_NONE);
+	if (filterMode == SHADOW_FILTER_VSM)
+	{
+		// The depth map is still used for depth testing, but the moments are what we write out.
+		glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, momentsMap, 0);
+		glDrawBuffer(GL_COLOR_ATTACHMENT0);
+		glReadBuffer(GL_NONE);
+	}
+	else
+	{
+		// Disabling reading colors.
+		glDrawBuffer(GL_NONE);
+		glReadBuffer(GL_NONE);
+	}
 
 	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
 
@@ -61,12 +94,56 @@ bool ShadowMap::Init(unsigned int width, unsigned int height)
 		printf("Shadowmap Framebuffer Error: %i\n", status);
 	}
 
+	if (filterMode == SHADOW_FILTER_VSM)
+	{
+		// Second blur pass writes straight back in the moments, without the depth attached.
+		glGenFramebuffers(1, &momentsFBO);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, momentsFBO);
+		glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, momentsMap, 0);
+		glDrawBuffer(GL_COLOR_ATTACHMENT0);
+
+		InitBlur();
+	}
+
 	// Unbinding buffer
 	//glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
 	return true;
 }
 
+bool ShadowMap::InitBlur()
+{
+	for (size_t i = 0; i < 2; i++)
+	{
+		glGenTextures(1, &blurMap[i]);
+		glBindTexture(GL_TEXTURE_2D, blurMap[i]);
+		glTexImage2D(GL_TEXTURE_2D, 0, format.momentsFormat, shadowWidth, shadowHeight, 0, GL_RG, GL_FLOAT, nullptr);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		glGenFramebuffers(1, &blurFBO[i]);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, blurFBO[i]);
+		glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, blurMap[i], 0);
+		glDrawBuffer(GL_COLOR_ATTACHMENT0);
+
+		GLenum status = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER);
+		if (status != GL_FRAMEBUFFER_COMPLETE)
+		{
+			printf("Shadowmap Blur Framebuffer Error: %i\n", status);
+			return false;
+		}
+	}
+
+	// Core profile refuses to draw without a VAO, even if the vertex shader reads no attributes.
+	glGenVertexArrays(1, &blurVAO);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	return true;
+}
+
 void ShadowMap::Write()
 {
 	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, FBO); // Binding buffer
@@ -75,7 +152,43 @@ void ShadowMap::Write()
 void ShadowMap::Read(GLenum textureUnit)
 {
 	glActiveTexture(textureUnit);
-	glBindTexture(GL_TEXTURE_2D, shadowMap);
+	// Variance shadow maps are read through their moments, not their depth.
+	glBindTexture(GL_TEXTURE_2D, filterMode == SHADOW_FILTER_VSM ? momentsMap : shadowMap);
+}
+
+void ShadowMap::Filter(GLuint blurDirectionLocation, GLenum textureUnit)
+{
+	if (filterMode != SHADOW_FILTER_VSM)
+	{
+		return;
+	}
+
+	// Separable blur. Horizontal from the moments into the temporary map, then vertical back into the moments.
+	BlurPass(momentsMap, blurFBO[0], 1.0f / shadowWidth, 0.0f, blurDirectionLocation, textureUnit);
+	BlurPass(blurMap[0], momentsFBO, 0.0f, 1.0f / shadowHeight, blurDirectionLocation, textureUnit);
+
+	// Rebuilding the mipmaps once here, instead of filtering again for every fragment that reads the map.
+	glBindTexture(GL_TEXTURE_2D, momentsMap);
+	glGenerateMipmap(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void ShadowMap::BlurPass(GLuint sourceMap, GLuint targetFBO, GLfloat xDirection, GLfloat yDirection,
+	GLuint blurDirectionLocation, GLenum textureUnit)
+{
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, targetFBO);
+	glViewport(0, 0, shadowWidth, shadowHeight);
+
+	glActiveTexture(textureUnit);
+	glBindTexture(GL_TEXTURE_2D, sourceMap);
+	glUniform2f(blurDirectionLocation, xDirection, yDirection);
+
+	// No depth attached to the targets, and we want every pixel written.
+	glDisable(GL_DEPTH_TEST);
+	glBindVertexArray(blurVAO);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+	glEnable(GL_DEPTH_TEST);
 }
 
 GLuint ShadowMap::GetShadowWidth()
@@ -88,6 +201,98 @@ GLuint ShadowMap::GetShadowHeight()
     return shadowHeight;
 }
 
+glm::vec4 ShadowMap::GetTileRect()
+{
+	return glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+}
+
+ShadowFilterMode ShadowMap::GetFilterMode()
+{
+	return filterMode;
+}
+
+size_t ShadowMap::GetMemoryUsage()
+{
+	size_t texels = (size_t)shadowWidth * shadowHeight;
+	size_t total = texels * format.depthBytes;
+	if (filterMode == SHADOW_FILTER_VSM)
+	{
+		total += texels * format.momentsBytes * 4 / 3; // Moments, plus a third for the mipmaps.
+		total += texels * format.momentsBytes * 2; // The 2 blur targets.
+	}
+	return total;
+}
+
+ShadowFormat ShadowMap::GetFormat(ShadowQuality quality, bool omni)
+{
+	ShadowFormat result;
+	switch (quality)
+	{
+		case SHADOW_QUALITY_LOW:
+			result.depthFormat = GL_DEPTH_COMPONENT16;
+			result.depthBytes = 2;
+			break;
+		case SHADOW_QUALITY_MEDIUM:
+			// omni_shadow_map.frag writes distance / farPlane, which is linear. 16 bits give farPlane / 65535 of precision everywhere.
+			// Directional maps get a projected depth, which needs more.
+			result.depthFormat = omni ? GL_DEPTH_COMPONENT16 : GL_DEPTH_COMPONENT24;
+			result.depthBytes = omni ? 2 : 4;
+			break;
+		case SHADOW_QUALITY_HIGH:
+		default:
+			result.depthFormat = GL_DEPTH_COMPONENT32F;
+			result.depthBytes = 4;
+			break;
+	}
+
+	// The VSM moments stay 32 bit float in every tier. The second moment is depth squared, and the variance taken out of it in
+	// ChebyshevUpperBound (lighting.glsl) is a tiny difference of two such numbers. Its 0.00002 floor is about one step of a 16 bit
+	// texture, so with fewer bits every surface would come out partly in its own shadow.
+	result.momentsFormat = GL_RG32F;
+	result.momentsBytes = 8;
+	return result;
+}
+
+void ShadowMap::PrintQualityReport(GLuint directionalSize, GLuint omniSize, GLuint screenWidth, GLuint screenHeight)
+{
+	const char* tierNames[] = { "Low", "Medium", "High" };
+	bool vsm = SHADOW_FILTER_MODE == SHADOW_FILTER_VSM;
+	double megabyte = 1024.0 * 1024.0;
+	double directionalTexels = (double)directionalSize * directionalSize;
+	double omniTexels = (double)omniSize * omniSize * 6;
+	double screenPixels = (double)screenWidth * screenHeight;
+
+	printf("Shadow quality tiers (%s, directional %u, omni %u, screen %ux%u):\n",
+		vsm ? "VSM" : "PCF", directionalSize, omniSize, screenWidth, screenHeight);
+	for (int tier = SHADOW_QUALITY_LOW; tier <= SHADOW_QUALITY_HIGH; tier++)
+	{
+		ShadowFormat directional = GetFormat((ShadowQuality)tier, false);
+		ShadowFormat omni = GetFormat((ShadowQuality)tier, true);
+
+		// Memory. Same as GetMemoryUsage.
+		double directionalMemory = directionalTexels * directional.depthBytes;
+		double omniMemory = omniTexels * omni.depthBytes;
+		if (vsm)
+		{
+			directionalMemory += directionalTexels * directional.momentsBytes * (4.0 / 3.0 + 2.0);
+			omniMemory += omniTexels * omni.momentsBytes * 4.0 / 3.0 + (omniTexels / 6.0) * omni.momentsBytes * 2.0;
+		}
+
+		// Written once per shadow update. VSM also writes the moments, then reads and writes them twice more to blur.
+		double directionalWrite = directionalTexels * (directional.depthBytes + (vsm ? directional.momentsBytes * 5.0 : 0.0));
+		double omniWrite = omniTexels * (omni.depthBytes + (vsm ? omni.momentsBytes * 5.0 : 0.0));
+
+		// Read by shader.frag if every pixel of the screen is lit. PCF reads 9 and 20 texels, VSM one bilinear (4 texel) fetch.
+		double directionalRead = screenPixels * (vsm ? 4.0 * directional.momentsBytes : 9.0 * directional.depthBytes);
+		double omniRead = screenPixels * (vsm ? 4.0 * omni.momentsBytes : 20.0 * omni.depthBytes);
+
+		printf("  %-6s directional %6.1f MB (write %6.1f MB, read %6.1f MB per frame) | omni %6.1f MB per light (write %6.1f MB, read %6.1f MB per frame)\n",
+			tierNames[tier],
+			directionalMemory / megabyte, directionalWrite / megabyte, directionalRead / megabyte,
+			omniMemory / megabyte, omniWrite / megabyte, omniRead / megabyte);
+	}
+}
+
 ShadowMap::~ShadowMap()
 {
 	if (FBO)
@@ -98,4 +303,27 @@ ShadowMap::~ShadowMap()
 	{
 		glDeleteTextures(1, &shadowMap);
 	}
+	if (momentsFBO)
+	{
+		glDeleteFramebuffers(1, &momentsFBO);
+	}
+	if (momentsMap)
+	{
+		glDeleteTextures(1, &momentsMap);
+	}
+	for (size_t i = 0; i < 2; i++)
+	{
+		if (blurFBO[i])
+		{
+			glDeleteFramebuffers(1, &blurFBO[i]);
+		}
+		if (blurMap[i])
+		{
+			glDeleteTextures(1, &blurMap[i]);
+		}
+	}
+	if (blurVAO)
+	{
+		glDeleteVertexArrays(1, &blurVAO);
+	}
 }
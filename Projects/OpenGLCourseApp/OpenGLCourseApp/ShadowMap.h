@@ -4,6 +4,19 @@
 
 #include <GL/glew.h>
 
+#include <glm/glm.hpp>
+
+#include "CommonValues.h"
+
+// Texture formats of a shadow map, for one quality tier.
+struct ShadowFormat
+{
+	GLenum depthFormat;
+	GLuint depthBytes; // Per texel, as drivers store it. 24 bit depth is padded to 32.
+	GLenum momentsFormat; // Only for variance shadow maps.
+	GLuint momentsBytes;
+};
+
 class ShadowMap
 {
 	public:
@@ -15,14 +28,46 @@ class ShadowMap
 
 		virtual void Read(GLenum textureUnit);
 
+		// Blurs the moments of a variance shadow map and rebuilds its mipmaps. Call once after each shadow pass.
+		// Does nothing for PCF shadow maps.
+		virtual void Filter(GLuint blurDirectionLocation, GLenum textureUnit);
+
 		virtual GLuint GetShadowWidth();
 		virtual GLuint GetShadowHeight();
 
-		~ShadowMap();
+		// Part of the texture holding this map, in texture coordinates. xy is the corner, zw the size.
+		// The whole texture for a regular shadow map, one tile for a map in a ShadowAtlas.
+		virtual glm::vec4 GetTileRect();
+
+		ShadowFilterMode GetFilterMode();
+
+		// Estimated video memory of the textures of this map, in bytes.
+		virtual size_t GetMemoryUsage();
+
+		// Formats used by a tier. Omni maps write a normalized linear distance, so 16 bits are enough for them sooner.
+		static ShadowFormat GetFormat(ShadowQuality quality, bool omni);
+
+		// Prints the memory and the bandwidth of shadow maps of the given sizes, for every tier, with the current filter mode.
+		static void PrintQualityReport(GLuint directionalSize, GLuint omniSize, GLuint screenWidth, GLuint screenHeight);
+
+		virtual ~ShadowMap();
 
 	protected:
 		GLuint FBO, // frame buffer object.
-			shadowMap; 
+			shadowMap;
 		GLuint shadowWidth, shadowHeight; // Needed for matching the viewport dimensions.
+
+		ShadowFilterMode filterMode;
+		ShadowFormat format;
+
+		// Only used by variance shadow maps.
+		GLuint momentsMap; // Depth and depth squared. This is what shader.frag reads instead of shadowMap.
+		GLuint momentsFBO; // Frame buffer pointing at momentsMap (or at one face of it), without depth. Target of the second blur pass.
+		GLuint blurFBO[2], blurMap[2]; // Temporary targets for the separable blur.
+		GLuint blurVAO; // Empty. The fullscreen triangle is made in shadow_blur.vert.
+
+		bool InitBlur();
+		void BlurPass(GLuint sourceMap, GLuint targetFBO, GLfloat xDirection, GLfloat yDirection,
+			GLuint blurDirectionLocation, GLenum textureUnit);
 };
 
@@ -0,0 +1,155 @@
+#include "ShadowMapPool.h"
+
+#include "PointLight.h"
+
+ShadowMapPool::ShadowMapPool()
+{
+	maxResidentMaps = MAX_POINT_LIGHTS;
+	currentFrame = 0;
+	changed = false;
+}
+
+ShadowMapPool::ShadowMapPool(unsigned int maxResidentMaps)
+{
+	this->maxResidentMaps = maxResidentMaps;
+	currentFrame = 0;
+	changed = false;
+}
+
+void ShadowMapPool::BeginFrame()
+{
+	currentFrame++;
+}
+
+OmniShadowMap* ShadowMapPool::Acquire(PointLight* light)
+{
+	PoolEntry* freeEntry = nullptr;
+	PoolEntry* oldestEntry = nullptr;
+
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		PoolEntry& entry = entries[i];
+		bool sameSize = entry.shadowMap->GetShadowWidth() == light->GetShadowWidth() &&
+			entry.shadowMap->GetShadowHeight() == light->GetShadowHeight();
+
+		if (entry.owner == light)
+		{
+			entry.lastUsedFrame = currentFrame;
+			return entry.shadowMap; // Already has one.
+		}
+		if (!sameSize)
+		{
+			continue;
+		}
+		if (!entry.owner && !freeEntry)
+		{
+			freeEntry = &entry;
+		}
+		// Least recently used, among the maps no one needed yet this frame.
+		if (entry.lastUsedFrame != currentFrame &&
+			(!oldestEntry || entry.lastUsedFrame < oldestEntry->lastUsedFrame))
+		{
+			oldestEntry = &entry;
+		}
+	}
+
+	if (freeEntry)
+	{
+		Assign(*freeEntry, light);
+		return freeEntry->shadowMap;
+	}
+
+	if (entries.size() < maxResidentMaps)
+	{
+		// Only now do we pay for the textures.
+		PoolEntry entry;
+		entry.shadowMap = new OmniShadowMap();
+		entry.shadowMap->Init(light->GetShadowWidth(), light->GetShadowHeight());
+		entry.owner = nullptr;
+		entry.lastUsedFrame = 0;
+		entries.push_back(entry);
+		changed = true;
+
+		Assign(entries.back(), light);
+		return entries.back().shadowMap;
+	}
+
+	if (oldestEntry)
+	{
+		// Taking it away from the light that used it the longest time ago.
+		if (oldestEntry->owner)
+		{
+			oldestEntry->owner->SetShadowMap(nullptr);
+		}
+		changed = true;
+
+		Assign(*oldestEntry, light);
+		return oldestEntry->shadowMap;
+	}
+
+	light->SetShadowMap(nullptr);
+	return nullptr;
+}
+
+void ShadowMapPool::Release(PointLight* light)
+{
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		if (entries[i].owner == light)
+		{
+			entries[i].owner = nullptr; // Keeps its lastUsedFrame, so it is the first to go if we need room.
+		}
+	}
+	light->SetShadowMap(nullptr);
+}
+
+void ShadowMapPool::Assign(PoolEntry& entry, PointLight* light)
+{
+	entry.owner = light;
+	entry.lastUsedFrame = currentFrame;
+	light->SetShadowMap(entry.shadowMap);
+}
+
+size_t ShadowMapPool::GetResidentMemory()
+{
+	size_t total = 0;
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		total += entries[i].shadowMap->GetMemoryUsage();
+	}
+	return total;
+}
+
+void ShadowMapPool::PrintReport()
+{
+	if (!changed)
+	{
+		return;
+	}
+	changed = false;
+
+	unsigned int used = 0;
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		if (entries[i].owner)
+		{
+			used++;
+		}
+	}
+
+	printf("Shadow map pool: %u of %u maps resident, %u in use, %.1f MB\n",
+		(unsigned int)entries.size(), maxResidentMaps, used, GetResidentMemory() / (1024.0 * 1024.0));
+}
+
+ShadowMapPool::~ShadowMapPool()
+{
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		if (entries[i].owner)
+		{
+			entries[i].owner->SetShadowMap(nullptr);
+		}
+		delete entries[i].shadowMap;
+	}
+	entries.clear();
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdio.h>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "OmniShadowMap.h"
+
+class PointLight;
+
+// Owns the cube shadow maps of the point lights. Lights only hold a map while they are visible and cast shadows.
+// Maps are given back to the pool when a light goes off screen, and reused by the next light that needs one.
+// When the pool is full, the map that was used the longest time ago is taken away from its light.
+class ShadowMapPool
+{
+	public:
+		ShadowMapPool();
+		ShadowMapPool(unsigned int maxResidentMaps);
+
+		// Call once per frame, before acquiring maps.
+		void BeginFrame();
+
+		// Gives the light a shadow map for this frame, and sets it on the light. Keeps the one it already had if possible.
+		// Returns nullptr (and the light casts no shadow this frame) if every map is already used this frame.
+		OmniShadowMap* Acquire(PointLight* light);
+
+		// The light doesn't need its map anymore. Stays in the pool for someone else.
+		void Release(PointLight* light);
+
+		size_t GetResidentMemory(); // In bytes. All the maps in the pool, used or not.
+		void PrintReport();
+
+		~ShadowMapPool();
+
+	private:
+		struct PoolEntry
+		{
+			OmniShadowMap* shadowMap;
+			PointLight* owner; // nullptr when free.
+			unsigned long lastUsedFrame;
+		};
+
+		std::vector<PoolEntry> entries;
+		unsigned int maxResidentMaps;
+		unsigned long currentFrame;
+
+		bool changed; // Something was allocated or evicted since the last report.
+
+		void Assign(PoolEntry& entry, PointLight* light);
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <GL/glew.h>
+
+// Loops over many lights (or vertices...) are written once, on top of these. AVX does 8 floats at a time, SSE 4.
+// Which one we get depends on what the compiler is allowed to use, see EnableEnhancedInstructionSet in the project settings.
+#if defined(__AVX__)
+#include <immintrin.h>
+
+typedef __m256 FloatLanes;
+static const unsigned int LANE_COUNT = 8;
+
+static inline FloatLanes LoadLanes(const GLfloat* values) { return _mm256_loadu_ps(values); }
+static inline void StoreLanes(GLfloat* values, FloatLanes a) { _mm256_storeu_ps(values, a); }
+static inline FloatLanes SetLanes(GLfloat value) { return _mm256_set1_ps(value); }
+static inline FloatLanes AddLanes(FloatLanes a, FloatLanes b) { return _mm256_add_ps(a, b); }
+static inline FloatLanes SubLanes(FloatLanes a, FloatLanes b) { return _mm256_sub_ps(a, b); }
+static inline FloatLanes MulLanes(FloatLanes a, FloatLanes b) { return _mm256_mul_ps(a, b); }
+static inline FloatLanes DivLanes(FloatLanes a, FloatLanes b) { return _mm256_div_ps(a, b); }
+static inline FloatLanes SqrtLanes(FloatLanes a) { return _mm256_sqrt_ps(a); }
+static inline FloatLanes MinLanes(FloatLanes a, FloatLanes b) { return _mm256_min_ps(a, b); }
+static inline FloatLanes MaxLanes(FloatLanes a, FloatLanes b) { return _mm256_max_ps(a, b); }
+static inline FloatLanes AndLanes(FloatLanes a, FloatLanes b) { return _mm256_and_ps(a, b); }
+static inline FloatLanes OrLanes(FloatLanes a, FloatLanes b) { return _mm256_or_ps(a, b); }
+static inline FloatLanes LessLanes(FloatLanes a, FloatLanes b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+static inline FloatLanes LessEqualLanes(FloatLanes a, FloatLanes b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+static inline FloatLanes SelectLanes(FloatLanes mask, FloatLanes a, FloatLanes b) { return _mm256_blendv_ps(b, a, mask); } // a where mask is set, b elsewhere.
+static inline int MaskLanes(FloatLanes a) { return _mm256_movemask_ps(a); } // One bit per lane, set where the test passed.
+#else
+#include <xmmintrin.h>
+
+typedef __m128 FloatLanes;
+static const unsigned int LANE_COUNT = 4;
+
+static inline FloatLanes LoadLanes(const GLfloat* values) { return _mm_loadu_ps(values); }
+static inline void StoreLanes(GLfloat* values, FloatLanes a) { _mm_storeu_ps(values, a); }
+static inline FloatLanes SetLanes(GLfloat value) { return _mm_set1_ps(value); }
+static inline FloatLanes AddLanes(FloatLanes a, FloatLanes b) { return _mm_add_ps(a, b); }
+static inline FloatLanes SubLanes(FloatLanes a, FloatLanes b) { return _mm_sub_ps(a, b); }
+static inline FloatLanes MulLanes(FloatLanes a, FloatLanes b) { return _mm_mul_ps(a, b); }
+static inline FloatLanes DivLanes(FloatLanes a, FloatLanes b) { return _mm_div_ps(a, b); }
+static inline FloatLanes SqrtLanes(FloatLanes a) { return _mm_sqrt_ps(a); }
+static inline FloatLanes MinLanes(FloatLanes a, FloatLanes b) { return _mm_min_ps(a, b); }
+static inline FloatLanes MaxLanes(FloatLanes a, FloatLanes b) { return _mm_max_ps(a, b); }
+static inline FloatLanes AndLanes(FloatLanes a, FloatLanes b) { return _mm_and_ps(a, b); }
+static inline FloatLanes OrLanes(FloatLanes a, FloatLanes b) { return _mm_or_ps(a, b); }
+static inline FloatLanes LessLanes(FloatLanes a, FloatLanes b) { return _mm_cmplt_ps(a, b); }
+static inline FloatLanes LessEqualLanes(FloatLanes a, FloatLanes b) { return _mm_cmple_ps(a, b); }
+static inline FloatLanes SelectLanes(FloatLanes mask, FloatLanes a, FloatLanes b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); } // No blendv before SSE4.1.
+static inline int MaskLanes(FloatLanes a) { return _mm_movemask_ps(a); }
+#endif
@@ -0,0 +1,105 @@
+#include "StreamingBuffer.h"
+
+StreamingBuffer::StreamingBuffer()
+{
+	for (unsigned int i = 0; i < MAX_COPIES; i++)
+	{
+		buffers[i] = 0;
+		textures[i] = 0;
+		fences[i] = 0;
+	}
+	copyCount = 0;
+	currentCopy = -1;
+	capacity = 0;
+}
+
+bool StreamingBuffer::Init(GLsizeiptr capacity, GLenum textureFormat, unsigned int copyCount)
+{
+	if (copyCount == 0 || copyCount > MAX_COPIES)
+	{
+		printf("Streaming buffer can't have %u copies, max is %u.\n", copyCount, MAX_COPIES);
+		return false;
+	}
+
+	this->capacity = capacity;
+	this->copyCount = copyCount;
+
+	glGenBuffers(copyCount, buffers);
+	glGenTextures(copyCount, textures);
+	for (unsigned int i = 0; i < copyCount; i++)
+	{
+		glBindBuffer(GL_TEXTURE_BUFFER, buffers[i]);
+		glBufferData(GL_TEXTURE_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+
+		glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+		glTexBuffer(GL_TEXTURE_BUFFER, textureFormat, buffers[i]);
+	}
+
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	return true;
+}
+
+void* StreamingBuffer::Map(GLsizeiptr size)
+{
+	if (size > capacity)
+	{
+		printf("Streaming buffer is too small: %ld bytes for %ld.\n", (long)size, (long)capacity);
+		return nullptr;
+	}
+
+	// Everything that reads the copy we wrote last time has been drawn by now. Fencing it.
+	if (currentCopy >= 0)
+	{
+		fences[currentCopy] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	currentCopy = (currentCopy + 1) % copyCount;
+
+	// Usually done long ago, since it was used copyCount frames back.
+	if (fences[currentCopy])
+	{
+		glClientWaitSync(fences[currentCopy], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+		glDeleteSync(fences[currentCopy]);
+		fences[currentCopy] = 0;
+	}
+
+	glBindBuffer(GL_TEXTURE_BUFFER, buffers[currentCopy]);
+	return glMapBufferRange(GL_TEXTURE_BUFFER, 0, size > 0 ? size : 1,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+}
+
+void StreamingBuffer::Unmap()
+{
+	glBindBuffer(GL_TEXTURE_BUFFER, buffers[currentCopy]);
+	glUnmapBuffer(GL_TEXTURE_BUFFER);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void StreamingBuffer::Read(GLenum textureUnit)
+{
+	glActiveTexture(textureUnit);
+	glBindTexture(GL_TEXTURE_BUFFER, textures[currentCopy >= 0 ? currentCopy : 0]);
+}
+
+GLsizeiptr StreamingBuffer::GetCapacity()
+{
+	return capacity;
+}
+
+StreamingBuffer::~StreamingBuffer()
+{
+	for (unsigned int i = 0; i < copyCount; i++)
+	{
+		if (fences[i])
+		{
+			glDeleteSync(fences[i]);
+		}
+	}
+	if (copyCount > 0)
+	{
+		glDeleteTextures(copyCount, textures);
+		glDeleteBuffers(copyCount, buffers);
+	}
+}
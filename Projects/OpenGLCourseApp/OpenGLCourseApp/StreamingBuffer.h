@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdio.h>
+
+#include <GL/glew.h>
+
+// A texture buffer we write new data into every frame.
+// There are a few copies of it, used in turn, so we never write into one the GPU may still be reading from last frame.
+// A fence tells us when the GPU is done with a copy. Mapping it unsynchronized then skips the driver's own (slower) checks.
+class StreamingBuffer
+{
+	public:
+		StreamingBuffer();
+
+		// capacity in bytes. textureFormat is how the shader sees the data, e.g. GL_R32UI.
+		bool Init(GLsizeiptr capacity, GLenum textureFormat, unsigned int copyCount = 3);
+
+		// Moves to the next copy and gives back a pointer to write size bytes into. Call Unmap before drawing.
+		void* Map(GLsizeiptr size);
+		void Unmap();
+
+		// Binds the copy that was written last.
+		void Read(GLenum textureUnit);
+
+		GLsizeiptr GetCapacity();
+
+		~StreamingBuffer();
+
+	private:
+		static const unsigned int MAX_COPIES = 4;
+
+		GLuint buffers[MAX_COPIES], textures[MAX_COPIES];
+		GLsync fences[MAX_COPIES]; // Placed after the frame that read the copy.
+		unsigned int copyCount;
+		int currentCopy; // -1 before the first Map.
+		GLsizeiptr capacity;
+};
@@ -9,7 +9,7 @@ Texture::Texture()
 	fileLocation = "";
 }
 
-Texture::Texture(char* fileLoc)
+Texture::Texture(const char* fileLoc)
 {
 	textureID = 0;
 	width = 0;
@@ -25,18 +25,40 @@ Texture::~Texture()
 
 void Texture::LoadTexture()
 {
+	// A cooked version of the file is smaller on the GPU, and already has its mipmaps.
+	if (LoadCompressedTexture())
+	{
+		return;
+	}
+
+	// RGB images stay RGB. Anything else (grey, grey + alpha) is widened to RGBA, so it doesn't come out red.
+	int channels = 0;
+	stbi_info(fileLocation.c_str(), &width, &height, &channels);
+	int wantedChannels = channels == 3 ? 3 : 4;
+
 	// Loading the texture data in array. Note, array of char is like an array of bytes (each char is a byte)
-	unsigned char* texData = stbi_load(fileLocation, // Location of the texture file.
-		&height, // Pass by reference. Will be filled with loaded texture height.
+	unsigned char* texData = stbi_load(fileLocation.c_str(), // Location of the texture file.
 		&width, // Pass by reference. Will be filled with loaded texture width.
-		&bitDepth, // Pass by reference. Will be filled with loaded texture bitDepth.
-		0 // Always 0.
+		&height, // Pass by reference. Will be filled with loaded texture height.
+		&channels, // Pass by reference. Will be filled with the channels in the file.
+		wantedChannels // Channels we want in texData.
 	); 
 	if (!texData) // If there is no texData.
 	{
-		printf("Failed to find: %s\n", fileLocation);
+		printf("Failed to find: %s\n", fileLocation.c_str());
 		return;
 	}
+	bitDepth = wantedChannels; // What texData really holds.
+	GLenum format = bitDepth == 3 ? GL_RGB : GL_RGBA;
+
+	// Every mipmap level, made here on the CPU so they come out the same on every driver. See MipmapGenerator.
+	GLuint mipCount = MipmapGenerator::CalcMipCount(width, height);
+	std::vector<unsigned char> levels(MipmapGenerator::CalcMipChainSize(width, height, mipCount, bitDepth));
+	memcpy(levels.data(), texData, (size_t)width * height * bitDepth);
+	MipmapGenerator::BuildMipmaps(levels.data(), width, height, mipCount, bitDepth);
+
+	// For safety, discarding the raw data.
+	stbi_image_free(texData);
 
 	glGenTextures(1, &textureID); // Generating a new texture with our id.
 	glBindTexture(GL_TEXTURE_2D, textureID); // Binding our texture, with type 2D.
@@ -52,33 +74,83 @@ void Texture::LoadTexture()
 	);
 	glTexParameteri(GL_TEXTURE_2D, // Type of Texture
 		GL_TEXTURE_MIN_FILTER, // Which parameter to change. Here, we change the way the texture interacts when we zoom out on it.
-		GL_LINEAR // The value. Here we want to blend the texture.
+		GL_LINEAR_MIPMAP_LINEAR // The value. Here we want to blend the texture, and the 2 closest mipmaps.
 	);
 	glTexParameteri(GL_TEXTURE_2D, // Type of Texture
 		GL_TEXTURE_MAG_FILTER, // Which parameter to change. Here, we change the way the texture interacts when we zoom in on it.
 		GL_LINEAR // The value. Here we want to blend the texture.
 	);
 
-	// Loading the texture to graphics card.
-	glTexImage2D(GL_TEXTURE_2D, // Texture target, what the texture was bound to.
-		0, // Mimap level. This will define the texture for mipmap level 0. Usually, defining for 0 will use same texture across whole range.
-		GL_RGBA,  // Format of stored data. If you're not using RGBA, use RGB.
-		width, // Width of texture
-		height, // Height of texture
-		0, // Always 0. Legacy stuff that is not used anymore.
-		GL_RGBA, // Format of data being loaded. If you're not using RGBA, use RGB.
-		GL_UNSIGNED_BYTE, // Data type of the values.
-		texData // The data itself.
-	);
+	// RGB rows are 3 bytes per texel, so they don't always end on the 4 byte boundary GL expects by default.
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-	// Generate the mipmaps, automatically.
-	glGenerateMipmap(GL_TEXTURE_2D);
+	// Loading the texture to graphics card, one mipmap level at a time.
+	size_t offset = 0;
+	for (GLuint level = 0; level < mipCount; level++)
+	{
+		GLuint levelWidth = MipmapGenerator::GetMipSize(width, level), levelHeight = MipmapGenerator::GetMipSize(height, level);
+		glTexImage2D(GL_TEXTURE_2D, // Texture target, what the texture was bound to.
+			level, // Mimap level this data is for.
+			bitDepth == 3 ? GL_RGB8 : GL_RGBA8,  // Format of stored data.
+			levelWidth, // Width of this level
+			levelHeight, // Height of this level
+			0, // Always 0. Legacy stuff that is not used anymore.
+			format, // Format of data being loaded, RGB or RGBA as loaded above.
+			GL_UNSIGNED_BYTE, // Data type of the values.
+			&levels[offset] // The data itself.
+		);
+		offset += (size_t)levelWidth * levelHeight * bitDepth;
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4); // Back to the default.
 
 	// Unbind texture.
 	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+bool Texture::LoadCompressedTexture()
+{
+	std::string cookedLocation = TextureCooker::GetCookedLocation(fileLocation.c_str());
+	FILE* file = fopen(cookedLocation.c_str(), "rb");
+	if (!file)
+	{
+		return false; // Not cooked, that's fine.
+	}
+	fclose(file);
+
+	TextureCompression compression;
+	GLuint cookedWidth = 0, cookedHeight = 0, mipCount = 0;
+	std::vector<unsigned char> data;
+	if (!TextureCooker::ReadDDS(cookedLocation.c_str(), compression, cookedWidth, cookedHeight, mipCount, data))
+	{
+		return false;
+	}
+	width = cookedWidth;
+	height = cookedHeight;
+	bitDepth = compression == TEXTURE_COMPRESSION_BC1 ? 3 : 4;
+
+	glGenTextures(1, &textureID);
+	glBindTexture(GL_TEXTURE_2D, textureID);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mipCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mipCount - 1); // The file may stop before 1x1.
+
+	// The blocks go to the GPU as they are, one level after the other. No glGenerateMipmap, they were made when cooking.
+	size_t offset = 0;
+	for (GLuint level = 0; level < mipCount; level++)
+	{
+		GLuint levelWidth = std::max(cookedWidth >> level, 1u), levelHeight = std::max(cookedHeight >> level, 1u);
+		size_t levelSize = TextureCooker::GetCompressedSize(levelWidth, levelHeight, compression);
+		glCompressedTexImage2D(GL_TEXTURE_2D, level, TextureCooker::GetFormat(compression), levelWidth, levelHeight, 0, (GLsizei)levelSize, &data[offset]);
+		offset += levelSize;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, 0);
 
-	// For safety, discarding the raw data.
-	stbi_image_free(texData);
+	return true;
 }
 
 void Texture::UseTexture()
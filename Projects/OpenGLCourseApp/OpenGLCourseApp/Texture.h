@@ -1,23 +1,35 @@
 #pragma once
 
+#include <string>
+
 #include <GL/glew.h>
 #include "stb_image.h"
 
+#include "TextureCooker.h"
+#include "MipmapGenerator.h"
+
 class Texture
 {
 	public:
 		Texture();
-		Texture(char* fileLoc);
+		Texture(const char* fileLoc);
 		~Texture();
 
+		// A copy would delete the same GL texture as the original when destroyed. Keep one and share a pointer to it instead.
+		Texture(const Texture&) = delete;
+		Texture& operator=(const Texture&) = delete;
+
 		void LoadTexture();
 		void UseTexture();
 		void ClearTexture();
 
 	private:
+		// Loads a cooked .dds file (see TextureCooker), block compressed with every mipmap already in it.
+		bool LoadCompressedTexture();
+
 		GLuint textureID;
 		int width, height, bitDepth;
 
-		char* fileLocation;
+		std::string fileLocation;
 };
 
@@ -0,0 +1,444 @@
+#include "TextureArray.h"
+
+#include "TextureCooker.h"
+
+TextureArray::TextureArray()
+{
+	textureID = 0;
+	layerSize = 0;
+	compression = TEXTURE_COMPRESSION_NONE;
+	mipCount = 0;
+	baseLevel = 0;
+	allocatedLevel = 0;
+}
+
+TextureArray::TextureArray(GLuint layerSize, TextureCompression compression)
+{
+	textureID = 0;
+	this->layerSize = layerSize;
+	this->compression = compression;
+	mipCount = 0;
+	baseLevel = 0;
+	allocatedLevel = 0;
+}
+
+GLuint TextureArray::AddTexture(const char* fileLocation)
+{
+	fileLocations.push_back(fileLocation);
+	return (GLuint)(fileLocations.size() - 1);
+}
+
+bool TextureArray::Allocate(GLuint firstLevel)
+{
+	if (fileLocations.empty() || layerSize == 0)
+	{
+		return false;
+	}
+
+	mipCount = MipmapGenerator::CalcMipCount(layerSize, layerSize);
+	allocatedLevel = std::min(firstLevel, mipCount - 1);
+	baseLevel = allocatedLevel;
+	GLuint layerCount = (GLuint)fileLocations.size() + 1; // The placeholder is last.
+	layerLevels.assign(layerCount, mipCount);
+
+	glGenTextures(1, &textureID);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+
+	// Same settings as a regular Texture, but mipmaps are used this time.
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, baseLevel);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, mipCount - 1);
+
+	// Room for every layer, from the first level on. The layers are filled later, one at a time.
+	// No data, so a compressed format is fine here too, without glCompressedTexImage3D.
+	for (GLuint level = allocatedLevel; level < mipCount; level++)
+	{
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, level, TextureCooker::GetFormat(compression), GetMipSize(level), GetMipSize(level), layerCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	}
+
+	FillPlaceholder(allocatedLevel, mipCount);
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	return true;
+}
+
+void TextureArray::FillPlaceholder(GLuint firstLevel, GLuint lastLevel)
+{
+	// Plain white, so a loading layer still shows the lighting.
+	std::vector<unsigned char> white(MipmapGenerator::CalcMipChainSize(layerSize, layerSize, mipCount, 4), 255), data;
+	EncodeLayer(white, data);
+	for (GLuint level = firstLevel; level < lastLevel; level++)
+	{
+		UploadRows(level, GetPlaceholderLayer(), 0, GetMipRowCount(level), &data[GetLevelDataOffset(level)]);
+	}
+	layerLevels[GetPlaceholderLayer()] = std::min(layerLevels[GetPlaceholderLayer()], firstLevel);
+}
+
+void TextureArray::AllocateLevels(GLuint level)
+{
+	if (level >= allocatedLevel)
+	{
+		return;
+	}
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+	for (GLuint newLevel = level; newLevel < allocatedLevel; newLevel++)
+	{
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, newLevel, TextureCooker::GetFormat(compression), GetMipSize(newLevel), GetMipSize(newLevel), GetLayerCount() + 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	}
+	FillPlaceholder(level, allocatedLevel);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	allocatedLevel = level;
+}
+
+void TextureArray::FreeLevels(GLuint level)
+{
+	if (level <= allocatedLevel)
+	{
+		return;
+	}
+
+	SetBaseLevel(std::max(baseLevel, level)); // Before the storage goes, so nothing samples a level that isn't there.
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+	for (GLuint oldLevel = allocatedLevel; oldLevel < level; oldLevel++)
+	{
+		// A 0x0 image has no storage. That's the only way to give a level's memory back without recreating the texture.
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, oldLevel, TextureCooker::GetFormat(compression), 0, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	}
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	allocatedLevel = level;
+	for (size_t i = 0; i < layerLevels.size(); i++)
+	{
+		if (layerLevels[i] < level)
+		{
+			layerLevels[i] = level;
+		}
+	}
+}
+
+void TextureArray::SetBaseLevel(GLuint level)
+{
+	baseLevel = level;
+	glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, baseLevel);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+bool TextureArray::Build()
+{
+	if (!Allocate())
+	{
+		return false;
+	}
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+
+	std::vector<unsigned char> data;
+	for (GLuint layer = 0; layer < GetLayerCount(); layer++)
+	{
+		LoadLayerData(layer, data);
+
+		for (GLuint level = 0; level < mipCount; level++)
+		{
+			UploadRows(level, layer, 0, GetMipRowCount(level), &data[GetLevelDataOffset(level)]);
+		}
+		layerLevels[layer] = 0;
+	}
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	return true;
+}
+
+void TextureArray::LoadLayerData(GLuint layer, std::vector<unsigned char>& data)
+{
+	if (compression != TEXTURE_COMPRESSION_NONE)
+	{
+		// A cooked file is already what we need, if it was cooked for this array.
+		std::string cookedLocation = TextureCooker::GetCookedLocation(fileLocations[layer].c_str());
+		TextureCompression cookedCompression;
+		GLuint width = 0, height = 0, cookedMipCount = 0;
+		if (TextureCooker::ReadDDS(cookedLocation.c_str(), cookedCompression, width, height, cookedMipCount, data))
+		{
+			if (cookedCompression == compression && width == layerSize && height == layerSize && cookedMipCount >= mipCount)
+			{
+				data.resize(GetLayerDataSize());
+				return;
+			}
+			printf("%s was cooked for another size or format, compressing %s instead.\n", cookedLocation.c_str(), fileLocations[layer].c_str());
+		}
+	}
+
+	std::vector<unsigned char> image(MipmapGenerator::CalcMipChainSize(layerSize, layerSize, mipCount, 4));
+
+	int width = 0, height = 0, channels = 0;
+	unsigned char* texData = stbi_load(fileLocations[layer].c_str(), &width, &height, &channels, 4); // Always 4 channels, the array is RGBA.
+	if (!texData)
+	{
+		printf("Failed to find: %s\n", fileLocations[layer].c_str());
+		std::fill(image.begin(), image.end(), 255); // Plain white, like the placeholder.
+		EncodeLayer(image, data);
+		return;
+	}
+
+	if (width == (int)layerSize && height == (int)layerSize)
+	{
+		std::copy(texData, texData + layerSize * layerSize * 4, image.begin());
+	}
+	else
+	{
+		printf("Resizing %s from %dx%d to %ux%u for its texture array.\n", fileLocations[layer].c_str(), width, height, layerSize, layerSize);
+		Resize(texData, width, height, image.data(), layerSize, layerSize);
+	}
+	stbi_image_free(texData);
+
+	MipmapGenerator::BuildMipmaps(image.data(), layerSize, layerSize, mipCount, 4);
+	EncodeLayer(image, data);
+}
+
+void TextureArray::EncodeLayer(std::vector<unsigned char>& image, std::vector<unsigned char>& data)
+{
+	if (compression == TEXTURE_COMPRESSION_NONE)
+	{
+		data.swap(image);
+		return;
+	}
+
+	data.resize(GetLayerDataSize());
+	size_t imageOffset = 0, dataOffset = 0;
+	for (GLuint level = 0; level < mipCount; level++)
+	{
+		GLuint size = GetMipSize(level);
+		TextureCooker::CompressImage(&image[imageOffset], size, size, compression, &data[dataOffset]);
+		imageOffset += size * size * 4;
+		dataOffset += GetMipRowCount(level) * GetRowDataSize(level);
+	}
+}
+
+void TextureArray::Resize(const unsigned char* source, int sourceWidth, int sourceHeight,
+	unsigned char* destination, int destinationWidth, int destinationHeight)
+{
+	// Floats in between, so the two passes don't round twice.
+	std::vector<float> input(sourceWidth * sourceHeight * 4);
+	for (size_t i = 0; i < input.size(); i++)
+	{
+		input[i] = source[i];
+	}
+
+	// Rows first, then columns.
+	std::vector<float> rows(destinationWidth * sourceHeight * 4);
+	for (int y = 0; y < sourceHeight; y++)
+	{
+		ResizeLine(&input[y * sourceWidth * 4], sourceWidth, 4, &rows[y * destinationWidth * 4], destinationWidth, 4);
+	}
+
+	std::vector<float> output(destinationWidth * destinationHeight * 4);
+	for (int x = 0; x < destinationWidth; x++)
+	{
+		ResizeLine(&rows[x * 4], sourceHeight, destinationWidth * 4, &output[x * 4], destinationHeight, destinationWidth * 4);
+	}
+
+	for (size_t i = 0; i < output.size(); i++)
+	{
+		destination[i] = (unsigned char)std::min(std::max(output[i] + 0.5f, 0.0f), 255.0f);
+	}
+}
+
+void TextureArray::ResizeLine(const float* source, int sourceCount, int sourceStride, float* destination, int destinationCount, int destinationStride)
+{
+	float scale = (float)sourceCount / destinationCount; // Source texels per destination texel.
+
+	for (int i = 0; i < destinationCount; i++)
+	{
+		float* texel = destination + i * destinationStride;
+
+		if (scale > 1.0f)
+		{
+			// Shrinking. Averaging every source texel the destination texel covers, partly covered ones count partly.
+			float start = i * scale, end = (i + 1) * scale;
+			float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			float totalWeight = 0.0f;
+			for (int s = (int)start; s < sourceCount && (float)s < end; s++)
+			{
+				float weight = std::min(end, (float)(s + 1)) - std::max(start, (float)s);
+				for (int c = 0; c < 4; c++)
+				{
+					sum[c] += source[s * sourceStride + c] * weight;
+				}
+				totalWeight += weight;
+			}
+			for (int c = 0; c < 4; c++)
+			{
+				texel[c] = sum[c] / totalWeight;
+			}
+		}
+		else
+		{
+			// Growing. Blending the 2 closest source texels, measured from their centers.
+			float position = std::min(std::max((i + 0.5f) * scale - 0.5f, 0.0f), (float)(sourceCount - 1));
+			int first = (int)position;
+			int second = std::min(first + 1, sourceCount - 1);
+			float blend = position - first;
+			for (int c = 0; c < 4; c++)
+			{
+				texel[c] = source[first * sourceStride + c] * (1.0f - blend) + source[second * sourceStride + c] * blend;
+			}
+		}
+	}
+}
+
+void TextureArray::UseTexture(GLenum textureUnit)
+{
+	glActiveTexture(textureUnit);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+}
+
+GLuint TextureArray::GetVisibleLayer(GLuint layer)
+{
+	return layer < layerLevels.size() && layerLevels[layer] <= baseLevel ? layer : GetPlaceholderLayer();
+}
+
+void TextureArray::SetLayerReady(GLuint layer, GLuint level)
+{
+	layerLevels[layer] = std::min(layerLevels[layer], level);
+}
+
+bool TextureArray::IsLevelReady(GLuint level)
+{
+	for (GLuint layer = 0; layer < GetLayerCount(); layer++)
+	{
+		if (layerLevels[layer] > level)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void TextureArray::UploadRows(GLuint level, GLuint layer, GLuint firstRow, GLuint rowCount, const void* data)
+{
+	GLuint size = GetMipSize(level);
+	GLuint rowHeight = compression == TEXTURE_COMPRESSION_NONE ? 1 : 4;
+	GLuint y = firstRow * rowHeight;
+	GLuint height = std::min(rowCount * rowHeight, size - y); // The last block row of a level under 4 texels high is cut short.
+
+	if (compression == TEXTURE_COMPRESSION_NONE)
+	{
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, y, layer, size, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, data);
+	}
+	else
+	{
+		glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, y, layer, size, height, 1, TextureCooker::GetFormat(compression),
+			(GLsizei)(rowCount * GetRowDataSize(level)), data);
+	}
+}
+
+GLuint TextureArray::GetTextureID()
+{
+	return textureID;
+}
+
+GLuint TextureArray::GetLayerSize()
+{
+	return layerSize;
+}
+
+GLuint TextureArray::GetLayerCount()
+{
+	return (GLuint)fileLocations.size();
+}
+
+GLuint TextureArray::GetPlaceholderLayer()
+{
+	return (GLuint)fileLocations.size();
+}
+
+GLuint TextureArray::GetMipCount()
+{
+	return mipCount;
+}
+
+GLuint TextureArray::GetBaseLevel()
+{
+	return baseLevel;
+}
+
+GLuint TextureArray::GetAllocatedLevel()
+{
+	return allocatedLevel;
+}
+
+GLuint TextureArray::GetMipSize(GLuint level)
+{
+	return std::max(layerSize >> level, 1u);
+}
+
+GLuint TextureArray::GetMipRowCount(GLuint level)
+{
+	return compression == TEXTURE_COMPRESSION_NONE ? GetMipSize(level) : (GetMipSize(level) + 3) / 4;
+}
+
+size_t TextureArray::GetRowDataSize(GLuint level)
+{
+	if (compression == TEXTURE_COMPRESSION_NONE)
+	{
+		return (size_t)GetMipSize(level) * 4;
+	}
+	return TextureCooker::GetCompressedSize(GetMipSize(level), 4, compression);
+}
+
+size_t TextureArray::GetLayerDataSize()
+{
+	size_t total = 0;
+	for (GLuint level = 0; level < mipCount; level++)
+	{
+		total += GetMipRowCount(level) * GetRowDataSize(level);
+	}
+	return total;
+}
+
+size_t TextureArray::GetLevelDataOffset(GLuint level)
+{
+	size_t offset = 0;
+	for (GLuint previous = 0; previous < level; previous++)
+	{
+		offset += GetMipRowCount(previous) * GetRowDataSize(previous);
+	}
+	return offset;
+}
+
+size_t TextureArray::GetMemoryFrom(GLuint level)
+{
+	return (GetLayerDataSize() - GetLevelDataOffset(level)) * (GetLayerCount() + 1);
+}
+
+TextureCompression TextureArray::GetCompression()
+{
+	return compression;
+}
+
+const char* TextureArray::GetFileLocation(GLuint layer)
+{
+	return fileLocations[layer].c_str();
+}
+
+void TextureArray::ClearTexture()
+{
+	if (textureID)
+	{
+		glDeleteTextures(1, &textureID);
+	}
+	textureID = 0;
+}
+
+TextureArray::~TextureArray()
+{
+	ClearTexture();
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <GL/glew.h>
+
+#include "stb_image.h"
+
+#include "CommonValues.h"
+#include "MipmapGenerator.h"
+
+// Many textures of the same size in one GL_TEXTURE_2D_ARRAY, one per layer. Shaders pick the layer per fragment,
+// so draws with different textures need no texture binding in between, and can end up in the same draw call.
+// Every layer has the same size (the bucket). Images of any other size are resized to it when the array is built.
+//
+// A compressed array (see TextureCooker) reads the cooked .dds next to each image when there is one of the right size and format,
+// and compresses the image itself at load time when there isn't.
+//
+// There is one more layer after the images: a plain white placeholder. Layers that are still loading (see TextureLoader)
+// show it instead, through GetVisibleLayer.
+//
+// The finest levels don't have to be in video memory. Levels above the allocated level have no storage at all,
+// and GL_TEXTURE_BASE_LEVEL keeps the shaders from sampling a level before every layer of it is uploaded. See TextureStreamer.
+class TextureArray
+{
+	public:
+		TextureArray();
+		TextureArray(GLuint layerSize, TextureCompression compression = TEXTURE_COMPRESSION_NONE); // layerSize: width and height of every layer.
+
+		// Queues an image file. Returns the layer it will be in.
+		GLuint AddTexture(const char* fileLocation);
+
+		// Loads every queued image, resizes the ones that don't fit the bucket, and uploads them with their mipmaps. Blocks until done.
+		bool Build();
+
+		// Only makes room for the layers, from firstLevel down to 1x1, and fills the placeholder. The images are uploaded later, by a TextureLoader.
+		bool Allocate(GLuint firstLevel = 0);
+
+		// Reads the image of a layer, resized to the bucket, with every mipmap after it (level 0 first), compressed if the array is.
+		// Safe to call from any thread. Gives a white image if the file can't be read.
+		void LoadLayerData(GLuint layer, std::vector<unsigned char>& data);
+
+		// The layer shaders should sample for a layer: itself once it is uploaded, the placeholder before.
+		GLuint GetVisibleLayer(GLuint layer);
+		// A layer has been uploaded from level down to 1x1.
+		void SetLayerReady(GLuint layer, GLuint level);
+		bool IsLevelReady(GLuint level); // Every image layer has this level and the ones after it.
+
+		// Makes room for the levels from level to the allocated one. They aren't sampled until SetBaseLevel says so.
+		void AllocateLevels(GLuint level);
+		// Drops the storage of every level finer than level, and stops sampling them.
+		void FreeLevels(GLuint level);
+		void SetBaseLevel(GLuint level); // Finest level the shaders sample.
+
+		// Uploads rows of a mip level of a layer, with the array bound. A row is a row of texels, or a row of 4x4 blocks when compressed.
+		// data is a pointer, or an offset when a pixel unpack buffer is bound.
+		void UploadRows(GLuint level, GLuint layer, GLuint firstRow, GLuint rowCount, const void* data);
+
+		void UseTexture(GLenum textureUnit);
+
+		GLuint GetTextureID();
+		GLuint GetLayerSize();
+		GLuint GetLayerCount(); // Image layers, without the placeholder.
+		GLuint GetPlaceholderLayer();
+		GLuint GetMipCount();
+		GLuint GetBaseLevel();
+		GLuint GetAllocatedLevel(); // Finest level with storage.
+		GLuint GetMipSize(GLuint level); // Width and height of a mipmap level.
+		GLuint GetMipRowCount(GLuint level); // Rows, as UploadRows counts them.
+		size_t GetRowDataSize(GLuint level); // Bytes of one of those rows.
+		size_t GetLayerDataSize(); // Bytes of one layer with all its mipmaps, as LoadLayerData gives them.
+		size_t GetLevelDataOffset(GLuint level); // Where a level starts in that data.
+		size_t GetMemoryFrom(GLuint level); // Video memory of every layer, placeholder too, from level down to 1x1.
+		TextureCompression GetCompression();
+		const char* GetFileLocation(GLuint layer);
+
+		void ClearTexture();
+
+		// Resizes an RGBA image. Averages the covered texels when shrinking, blends the nearest 4 when growing.
+		static void Resize(const unsigned char* source, int sourceWidth, int sourceHeight,
+			unsigned char* destination, int destinationWidth, int destinationHeight);
+
+		~TextureArray();
+
+	private:
+		GLuint textureID;
+		GLuint layerSize;
+		TextureCompression compression;
+		GLuint mipCount;
+		GLuint baseLevel, allocatedLevel;
+		std::vector<std::string> fileLocations;
+		std::vector<GLuint> layerLevels; // Finest level uploaded, per layer. mipCount until the layer is loaded.
+
+		void FillPlaceholder(GLuint firstLevel, GLuint lastLevel); // Levels from firstLevel up to, not including, lastLevel.
+
+		static void ResizeLine(const float* source, int sourceCount, int sourceStride, float* destination, int destinationCount, int destinationStride);
+
+		// Compresses RGBA mip levels (as MipmapGenerator lays them out) into data. Just swaps them in when the array isn't compressed.
+		void EncodeLayer(std::vector<unsigned char>& image, std::vector<unsigned char>& data);
+};
@@ -0,0 +1,85 @@
+#include "TextureCache.h"
+
+TextureCache::TextureCache()
+{
+	layerRequests = 0;
+	layerHits = 0;
+}
+
+GLuint TextureCache::GetLayer(TextureArray* textureArray, const char* fileLocation)
+{
+	std::pair<TextureArray*, std::string> key(textureArray, CanonicalPath(fileLocation));
+	layerRequests++;
+
+	auto found = layers.find(key);
+	if (found != layers.end())
+	{
+		layerHits++;
+		return found->second;
+	}
+
+	GLuint layer = textureArray->AddTexture(fileLocation);
+	layers[key] = layer;
+	return layer;
+}
+
+std::string TextureCache::CanonicalPath(const char* fileLocation)
+{
+	// Splitting the path into its folders, dropping "." and going back up for "..".
+	std::vector<std::string> parts;
+	std::string part;
+	bool absolute = fileLocation[0] == '/' || fileLocation[0] == '\\';
+	for (const char* c = fileLocation; ; c++)
+	{
+		if (*c == '/' || *c == '\\' || *c == '\0')
+		{
+			if (part == "..")
+			{
+				// Only if there is a folder to go back out of. A path starting with ".." keeps it.
+				if (!parts.empty() && parts.back() != "..")
+				{
+					parts.pop_back();
+				}
+				else if (!absolute)
+				{
+					parts.push_back(part);
+				}
+			}
+			else if (!part.empty() && part != ".")
+			{
+				parts.push_back(part);
+			}
+			part.clear();
+
+			if (*c == '\0')
+			{
+				break;
+			}
+		}
+		else
+		{
+#ifdef _WIN32
+			part += (char)tolower((unsigned char)*c);
+#else
+			part += *c;
+#endif
+		}
+	}
+
+	std::string path = absolute ? "/" : "";
+	for (size_t i = 0; i < parts.size(); i++)
+	{
+		if (i > 0)
+		{
+			path += '/';
+		}
+		path += parts[i];
+	}
+	return path;
+}
+
+void TextureCache::PrintReport()
+{
+	printf("Texture cache: %u layer requests, %u hits (%.0f%%), %u layers for %u requests\n", layerRequests, layerHits,
+		layerRequests ? 100.0 * layerHits / layerRequests : 0.0, (unsigned int)layers.size(), layerRequests);
+}
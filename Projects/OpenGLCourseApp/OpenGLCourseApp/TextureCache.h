@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdio.h>
+#include <ctype.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+
+#include <GL/glew.h>
+
+#include "TextureArray.h"
+
+// Hands out textures by file path, and only ever loads each file once.
+// Paths are compared after being made canonical, so "Textures/brick.png", "Textures\brick.png" and "./Textures/../Textures/brick.png" are the same file.
+//
+// Textures are layers of a TextureArray, which is how every material texture is drawn. Each file gets
+// one layer per array, whatever the number of objects using it. The array is part of the key, since it decides the size and compression.
+// A layer is handed out as soon as it is asked for, before it is loaded (see TextureLoader), so asking again while it loads
+// doesn't queue it twice.
+// Layers aren't counted or given back: an array's layers are fixed once it is allocated, and live as long as it does.
+class TextureCache
+{
+	public:
+		TextureCache();
+
+		// Has to be called before textureArray is allocated, since that fixes the layers.
+		GLuint GetLayer(TextureArray* textureArray, const char* fileLocation);
+
+		// '/' only, with no "." or ".." left in it. Lowercase on Windows, where paths don't care about case. Elsewhere they do.
+		static std::string CanonicalPath(const char* fileLocation);
+
+		// Requests, how many were already there, and how many files that saved loading.
+		void PrintReport();
+
+	private:
+		std::map<std::pair<TextureArray*, std::string>, GLuint> layers;
+
+		unsigned int layerRequests, layerHits;
+};
@@ -0,0 +1,584 @@
+#include "TextureCooker.h"
+
+#include "TextureArray.h"
+
+// DDS bits we use. The header is 31 dwords after the "DDS " magic.
+static const unsigned int DDS_MAGIC = 0x20534444; // "DDS "
+static const unsigned int DDS_HEADER_SIZE = 124;
+static const unsigned int DDS_PIXEL_FORMAT_SIZE = 32;
+static const unsigned int DDSD_CAPS = 0x1, DDSD_HEIGHT = 0x2, DDSD_WIDTH = 0x4, DDSD_PIXELFORMAT = 0x1000, DDSD_MIPMAPCOUNT = 0x20000, DDSD_LINEARSIZE = 0x80000;
+static const unsigned int DDPF_FOURCC = 0x4;
+static const unsigned int DDSCAPS_COMPLEX = 0x8, DDSCAPS_TEXTURE = 0x1000, DDSCAPS_MIPMAP = 0x400000;
+static const unsigned int FOURCC_DXT1 = 0x31545844; // "DXT1"
+static const unsigned int FOURCC_DXT5 = 0x35545844; // "DXT5"
+
+bool TextureCooker::Run(int argc, char** argv)
+{
+	int first = 0;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--cook-textures") == 0)
+		{
+			first = i + 1;
+			break;
+		}
+	}
+	if (first == 0)
+	{
+		return false;
+	}
+
+	if (argc - first < 3)
+	{
+		printf("Usage: --cook-textures <bc1|bc3> <size> <image files...>\n");
+		return true;
+	}
+
+	TextureCompression compression = TEXTURE_COMPRESSION_NONE;
+	if (strcmp(argv[first], "bc1") == 0)
+	{
+		compression = TEXTURE_COMPRESSION_BC1;
+	}
+	else if (strcmp(argv[first], "bc3") == 0)
+	{
+		compression = TEXTURE_COMPRESSION_BC3;
+	}
+	else
+	{
+		printf("Unknown texture format %s, expected bc1 or bc3.\n", argv[first]);
+		return true;
+	}
+
+	GLuint size = (GLuint)atoi(argv[first + 1]);
+	if (size == 0)
+	{
+		printf("Bad texture size %s.\n", argv[first + 1]);
+		return true;
+	}
+
+	ThreadPool threadPool;
+	threadPool.Init();
+	printf("Cooking on %u threads, SIMD lanes: %u\n", threadPool.GetThreadCount(), LANE_COUNT);
+
+	// With enough files to keep every thread busy, each thread cooks whole files. Otherwise the threads share the work of each file.
+	unsigned int fileCount = (unsigned int)(argc - first - 2);
+	bool filesInParallel = fileCount >= threadPool.GetThreadCount();
+	auto cook = [&](unsigned int i)
+	{
+		const char* source = argv[first + 2 + i];
+		std::string destination = GetCookedLocation(source);
+		CookFile(source, destination.c_str(), compression, size, filesInParallel ? nullptr : &threadPool);
+	};
+
+	if (filesInParallel)
+	{
+		threadPool.ParallelFor(fileCount, cook);
+	}
+	else
+	{
+		for (unsigned int i = 0; i < fileCount; i++)
+		{
+			cook(i);
+		}
+	}
+
+	return true;
+}
+
+bool TextureCooker::CookFile(const char* source, const char* destination, TextureCompression compression, GLuint size, ThreadPool* threadPool)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	int width = 0, height = 0, channels = 0;
+	unsigned char* texData = stbi_load(source, &width, &height, &channels, 4);
+	if (!texData)
+	{
+		printf("Failed to find: %s\n", source);
+		return false;
+	}
+
+	// Every mip level, level 0 first, as TextureArray lays them out.
+	GLuint mipCount = MipmapGenerator::CalcMipCount(size, size);
+	std::vector<unsigned char> image(MipmapGenerator::CalcMipChainSize(size, size, mipCount, 4));
+	if (width == (int)size && height == (int)size)
+	{
+		memcpy(image.data(), texData, size * size * 4);
+	}
+	else
+	{
+		TextureArray::Resize(texData, width, height, image.data(), size, size);
+	}
+	stbi_image_free(texData);
+	MipmapGenerator::BuildMipmaps(image.data(), size, size, mipCount, 4, threadPool);
+
+	std::vector<unsigned char> blocks;
+	size_t imageOffset = 0;
+	for (GLuint level = 0; level < mipCount; level++)
+	{
+		GLuint levelSize = std::max(size >> level, 1u);
+		size_t blockOffset = blocks.size();
+		blocks.resize(blockOffset + GetCompressedSize(levelSize, levelSize, compression));
+		CompressImage(&image[imageOffset], levelSize, levelSize, compression, &blocks[blockOffset], threadPool);
+		imageOffset += levelSize * levelSize * 4;
+	}
+
+	if (!WriteDDS(destination, compression, size, size, mipCount, blocks.data(), blocks.size()))
+	{
+		printf("Failed to write: %s\n", destination);
+		return false;
+	}
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+	printf("Cooked %s to %s: %ux%u, %u mips, %.1f KB instead of %.1f KB as RGBA8, in %.1f ms\n", source, destination, size, size, mipCount,
+		blocks.size() / 1024.0, image.size() / 1024.0, elapsed.count());
+
+	return true;
+}
+
+void TextureCooker::CompressImage(const unsigned char* image, GLuint width, GLuint height, TextureCompression compression,
+	unsigned char* blocks, ThreadPool* threadPool)
+{
+	GLuint blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+	size_t blockSize = GetBlockSize(compression);
+
+	auto compressRow = [&](unsigned int blockY)
+	{
+		BlockTexels texels;
+		for (GLuint blockX = 0; blockX < blocksX; blockX++)
+		{
+			for (GLuint i = 0; i < 16; i++)
+			{
+				GLuint x = std::min(blockX * 4 + (i & 3), width - 1);
+				GLuint y = std::min(blockY * 4 + (i >> 2), height - 1);
+				const unsigned char* texel = &image[(y * width + x) * 4];
+				texels.r[i] = texel[0];
+				texels.g[i] = texel[1];
+				texels.b[i] = texel[2];
+				texels.a[i] = texel[3];
+			}
+			CompressBlock(texels, compression, &blocks[(blockY * blocksX + blockX) * blockSize]);
+		}
+	};
+
+	if (threadPool)
+	{
+		threadPool->ParallelFor(blocksY, compressRow);
+	}
+	else
+	{
+		for (GLuint blockY = 0; blockY < blocksY; blockY++)
+		{
+			compressRow(blockY);
+		}
+	}
+}
+
+void TextureCooker::CompressBlock(const BlockTexels& texels, TextureCompression compression, unsigned char* block)
+{
+	if (compression == TEXTURE_COMPRESSION_BC3)
+	{
+		// BC3 is a BC1 style colour block after an alpha block.
+		CompressAlphaBlock(texels, block);
+		CompressColourBlock(texels, block + 8);
+	}
+	else
+	{
+		CompressColourBlock(texels, block);
+	}
+}
+
+void TextureCooker::CompressColourBlock(const BlockTexels& texels, unsigned char* block)
+{
+	// The colours of a block mostly lie along a line. Finding that line (the principal axis), and putting the end colours at its ends.
+	GLfloat mean[3] = { 0.0f, 0.0f, 0.0f };
+	for (int i = 0; i < 16; i++)
+	{
+		mean[0] += texels.r[i];
+		mean[1] += texels.g[i];
+		mean[2] += texels.b[i];
+	}
+	for (int c = 0; c < 3; c++)
+	{
+		mean[c] /= 16.0f;
+	}
+
+	GLfloat covariance[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f }; // rr, rg, rb, gg, gb, bb
+	for (int i = 0; i < 16; i++)
+	{
+		GLfloat r = texels.r[i] - mean[0], g = texels.g[i] - mean[1], b = texels.b[i] - mean[2];
+		covariance[0] += r * r;
+		covariance[1] += r * g;
+		covariance[2] += r * b;
+		covariance[3] += g * g;
+		covariance[4] += g * b;
+		covariance[5] += b * b;
+	}
+
+	// Power iteration: multiplying any vector by the covariance again and again turns it towards the principal axis.
+	GLfloat axis[3] = { 1.0f, 1.0f, 1.0f };
+	for (int iteration = 0; iteration < 8; iteration++)
+	{
+		GLfloat next[3] = {
+			covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+			covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+			covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2] };
+		GLfloat largest = std::max(std::max(std::fabs(next[0]), std::fabs(next[1])), std::fabs(next[2]));
+		if (largest < 1e-6f)
+		{
+			break; // Every texel is the same colour, any axis will do.
+		}
+		for (int c = 0; c < 3; c++)
+		{
+			axis[c] = next[c] / largest;
+		}
+	}
+
+	// The texels furthest along the axis, each way.
+	int minTexel = 0, maxTexel = 0;
+	GLfloat minDot = 1e30f, maxDot = -1e30f;
+	for (int i = 0; i < 16; i++)
+	{
+		GLfloat dot = texels.r[i] * axis[0] + texels.g[i] * axis[1] + texels.b[i] * axis[2];
+		if (dot < minDot)
+		{
+			minDot = dot;
+			minTexel = i;
+		}
+		if (dot > maxDot)
+		{
+			maxDot = dot;
+			maxTexel = i;
+		}
+	}
+
+	// Pulling the ends in a bit. The extremes are rarer than the colours in between, so the palette fits better that way.
+	GLfloat ends[2][3] = {
+		{ texels.r[maxTexel], texels.g[maxTexel], texels.b[maxTexel] },
+		{ texels.r[minTexel], texels.g[minTexel], texels.b[minTexel] } };
+	for (int c = 0; c < 3; c++)
+	{
+		GLfloat inset = (ends[0][c] - ends[1][c]) / 16.0f;
+		ends[0][c] -= inset;
+		ends[1][c] += inset;
+	}
+
+	unsigned short packed[2] = { PackColour(ends[0]), PackColour(ends[1]) };
+	unsigned int indices[16];
+	GLfloat error = 1e30f;
+
+	// Twice: once with the ends from the axis, once with the ends that best fit the indices the first try picked.
+	for (int attempt = 0; attempt < 2; attempt++)
+	{
+		unsigned short tryPacked[2];
+		if (attempt == 0)
+		{
+			tryPacked[0] = packed[0];
+			tryPacked[1] = packed[1];
+		}
+		else
+		{
+			// Least squares: each texel is (weight * end0 + (1 - weight) * end1), with the weight of its index.
+			static const GLfloat weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+			GLfloat aa = 0.0f, bb = 0.0f, ab = 0.0f;
+			GLfloat ax[3] = { 0.0f, 0.0f, 0.0f }, bx[3] = { 0.0f, 0.0f, 0.0f };
+			for (int i = 0; i < 16; i++)
+			{
+				GLfloat a = weights[indices[i]], b = 1.0f - a;
+				GLfloat texel[3] = { texels.r[i], texels.g[i], texels.b[i] };
+				aa += a * a;
+				bb += b * b;
+				ab += a * b;
+				for (int c = 0; c < 3; c++)
+				{
+					ax[c] += a * texel[c];
+					bx[c] += b * texel[c];
+				}
+			}
+			GLfloat determinant = aa * bb - ab * ab;
+			if (std::fabs(determinant) < 1e-6f)
+			{
+				break; // Every texel picked the same index, nothing to solve.
+			}
+			GLfloat fitted[2][3];
+			for (int c = 0; c < 3; c++)
+			{
+				fitted[0][c] = std::min(std::max((ax[c] * bb - bx[c] * ab) / determinant, 0.0f), 255.0f);
+				fitted[1][c] = std::min(std::max((bx[c] * aa - ax[c] * ab) / determinant, 0.0f), 255.0f);
+			}
+			tryPacked[0] = PackColour(fitted[0]);
+			tryPacked[1] = PackColour(fitted[1]);
+		}
+
+		// The 4 colours the GPU will get out of these ends.
+		GLfloat palette[4][3];
+		UnpackColour(tryPacked[0], palette[0]);
+		UnpackColour(tryPacked[1], palette[1]);
+		for (int c = 0; c < 3; c++)
+		{
+			palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+			palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+		}
+
+		unsigned int tryIndices[16];
+		GLfloat tryError = FindColourIndices(texels, palette, tryIndices);
+		if (tryError < error)
+		{
+			error = tryError;
+			packed[0] = tryPacked[0];
+			packed[1] = tryPacked[1];
+			memcpy(indices, tryIndices, sizeof(indices));
+		}
+	}
+
+	// The 4 colour mode needs the first end to be the larger number. Swapping the ends swaps indices 0 with 1 and 2 with 3.
+	if (packed[0] < packed[1])
+	{
+		std::swap(packed[0], packed[1]);
+		for (int i = 0; i < 16; i++)
+		{
+			indices[i] ^= 1;
+		}
+	}
+	else if (packed[0] == packed[1])
+	{
+		// Equal ends mean 3 colour mode, where index 3 is black. The first end is the only colour needed anyway.
+		for (int i = 0; i < 16; i++)
+		{
+			indices[i] = 0;
+		}
+	}
+
+	unsigned int bits = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		bits |= indices[i] << (i * 2);
+	}
+
+	block[0] = (unsigned char)(packed[0] & 0xFF);
+	block[1] = (unsigned char)(packed[0] >> 8);
+	block[2] = (unsigned char)(packed[1] & 0xFF);
+	block[3] = (unsigned char)(packed[1] >> 8);
+	for (int i = 0; i < 4; i++)
+	{
+		block[4 + i] = (unsigned char)((bits >> (i * 8)) & 0xFF);
+	}
+}
+
+GLfloat TextureCooker::FindColourIndices(const BlockTexels& texels, const GLfloat palette[4][3], unsigned int indices[16])
+{
+	GLfloat bestIndices[16], bestErrors[16];
+
+	for (unsigned int i = 0; i < 16; i += LANE_COUNT)
+	{
+		FloatLanes r = LoadLanes(&texels.r[i]), g = LoadLanes(&texels.g[i]), b = LoadLanes(&texels.b[i]);
+		FloatLanes bestError = SetLanes(1e30f), bestIndex = SetLanes(0.0f);
+
+		for (int p = 0; p < 4; p++)
+		{
+			FloatLanes dr = SubLanes(r, SetLanes(palette[p][0]));
+			FloatLanes dg = SubLanes(g, SetLanes(palette[p][1]));
+			FloatLanes db = SubLanes(b, SetLanes(palette[p][2]));
+			FloatLanes error = AddLanes(AddLanes(MulLanes(dr, dr), MulLanes(dg, dg)), MulLanes(db, db));
+
+			FloatLanes closer = LessLanes(error, bestError);
+			bestError = SelectLanes(closer, error, bestError);
+			bestIndex = SelectLanes(closer, SetLanes((GLfloat)p), bestIndex);
+		}
+
+		StoreLanes(&bestIndices[i], bestIndex);
+		StoreLanes(&bestErrors[i], bestError);
+	}
+
+	GLfloat totalError = 0.0f;
+	for (int i = 0; i < 16; i++)
+	{
+		indices[i] = (unsigned int)bestIndices[i];
+		totalError += bestErrors[i];
+	}
+	return totalError;
+}
+
+void TextureCooker::CompressAlphaBlock(const BlockTexels& texels, unsigned char* block)
+{
+	GLfloat minAlpha = 255.0f, maxAlpha = 0.0f;
+	for (int i = 0; i < 16; i++)
+	{
+		minAlpha = std::min(minAlpha, texels.a[i]);
+		maxAlpha = std::max(maxAlpha, texels.a[i]);
+	}
+
+	// The first end being larger gives the mode with 6 alphas in between the ends.
+	unsigned int ends[2] = { (unsigned int)(maxAlpha + 0.5f), (unsigned int)(minAlpha + 0.5f) };
+	GLfloat palette[8];
+	palette[0] = (GLfloat)ends[0];
+	palette[1] = (GLfloat)ends[1];
+	for (int k = 2; k < 8; k++)
+	{
+		palette[k] = ((8 - k) * palette[0] + (k - 1) * palette[1]) / 7.0f;
+	}
+
+	unsigned long long bits = 0;
+	if (ends[0] != ends[1])
+	{
+		for (int i = 0; i < 16; i++)
+		{
+			unsigned int best = 0;
+			GLfloat bestError = 1e30f;
+			for (unsigned int k = 0; k < 8; k++)
+			{
+				GLfloat error = std::fabs(texels.a[i] - palette[k]);
+				if (error < bestError)
+				{
+					bestError = error;
+					best = k;
+				}
+			}
+			bits |= (unsigned long long)best << (i * 3);
+		}
+	}
+
+	block[0] = (unsigned char)ends[0];
+	block[1] = (unsigned char)ends[1];
+	for (int i = 0; i < 6; i++)
+	{
+		block[2 + i] = (unsigned char)((bits >> (i * 8)) & 0xFF);
+	}
+}
+
+unsigned short TextureCooker::PackColour(const GLfloat colour[3])
+{
+	unsigned int r = (unsigned int)(colour[0] * 31.0f / 255.0f + 0.5f);
+	unsigned int g = (unsigned int)(colour[1] * 63.0f / 255.0f + 0.5f);
+	unsigned int b = (unsigned int)(colour[2] * 31.0f / 255.0f + 0.5f);
+	return (unsigned short)((std::min(r, 31u) << 11) | (std::min(g, 63u) << 5) | std::min(b, 31u));
+}
+
+void TextureCooker::UnpackColour(unsigned short packed, GLfloat colour[3])
+{
+	// Repeating the top bits in the bottom ones, the way the GPU widens them back to 8 bits.
+	unsigned int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+	colour[0] = (GLfloat)((r << 3) | (r >> 2));
+	colour[1] = (GLfloat)((g << 2) | (g >> 4));
+	colour[2] = (GLfloat)((b << 3) | (b >> 2));
+}
+
+size_t TextureCooker::GetBlockSize(TextureCompression compression)
+{
+	switch (compression)
+	{
+		case TEXTURE_COMPRESSION_BC1: return 8;
+		case TEXTURE_COMPRESSION_BC3: return 16;
+		default: return 0;
+	}
+}
+
+size_t TextureCooker::GetCompressedSize(GLuint width, GLuint height, TextureCompression compression)
+{
+	return (size_t)((width + 3) / 4) * ((height + 3) / 4) * GetBlockSize(compression);
+}
+
+GLenum TextureCooker::GetFormat(TextureCompression compression)
+{
+	switch (compression)
+	{
+		case TEXTURE_COMPRESSION_BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		case TEXTURE_COMPRESSION_BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		default: return GL_RGBA8;
+	}
+}
+
+bool TextureCooker::WriteDDS(const char* fileLocation, TextureCompression compression, GLuint width, GLuint height, GLuint mipCount,
+	const unsigned char* data, size_t dataSize)
+{
+	if (compression == TEXTURE_COMPRESSION_NONE)
+	{
+		return false;
+	}
+
+	unsigned int header[32] = {};
+	header[0] = DDS_MAGIC;
+	header[1] = DDS_HEADER_SIZE;
+	header[2] = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+	header[3] = height;
+	header[4] = width;
+	header[5] = (unsigned int)GetCompressedSize(width, height, compression); // Size of the first level.
+	header[7] = mipCount;
+	header[19] = DDS_PIXEL_FORMAT_SIZE;
+	header[20] = DDPF_FOURCC;
+	header[21] = compression == TEXTURE_COMPRESSION_BC1 ? FOURCC_DXT1 : FOURCC_DXT5;
+	header[27] = DDSCAPS_TEXTURE | DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+
+	FILE* file = fopen(fileLocation, "wb");
+	if (!file)
+	{
+		return false;
+	}
+	bool written = fwrite(header, sizeof(header), 1, file) == 1 && fwrite(data, 1, dataSize, file) == dataSize;
+	fclose(file);
+
+	return written;
+}
+
+bool TextureCooker::ReadDDS(const char* fileLocation, TextureCompression& compression, GLuint& width, GLuint& height, GLuint& mipCount,
+	std::vector<unsigned char>& data)
+{
+	FILE* file = fopen(fileLocation, "rb");
+	if (!file)
+	{
+		return false;
+	}
+
+	unsigned int header[32];
+	if (fread(header, sizeof(header), 1, file) != 1 || header[0] != DDS_MAGIC || header[1] != DDS_HEADER_SIZE || !(header[20] & DDPF_FOURCC))
+	{
+		printf("%s is not a DDS file we can read.\n", fileLocation);
+		fclose(file);
+		return false;
+	}
+
+	if (header[21] == FOURCC_DXT1)
+	{
+		compression = TEXTURE_COMPRESSION_BC1;
+	}
+	else if (header[21] == FOURCC_DXT5)
+	{
+		compression = TEXTURE_COMPRESSION_BC3;
+	}
+	else
+	{
+		printf("%s is neither DXT1 (BC1) nor DXT5 (BC3).\n", fileLocation);
+		fclose(file);
+		return false;
+	}
+
+	height = header[3];
+	width = header[4];
+	mipCount = std::max(header[7], 1u);
+
+	size_t dataSize = 0;
+	for (GLuint level = 0; level < mipCount; level++)
+	{
+		dataSize += GetCompressedSize(std::max(width >> level, 1u), std::max(height >> level, 1u), compression);
+	}
+	data.resize(dataSize);
+	bool read = fread(data.data(), 1, dataSize, file) == dataSize;
+	fclose(file);
+
+	if (!read)
+	{
+		printf("%s is cut short.\n", fileLocation);
+	}
+	return read;
+}
+
+std::string TextureCooker::GetCookedLocation(const char* fileLocation)
+{
+	std::string location = fileLocation;
+	size_t dot = location.find_last_of('.');
+	size_t slash = location.find_last_of("/\\");
+	if (dot != std::string::npos && (slash == std::string::npos || dot > slash))
+	{
+		location.erase(dot);
+	}
+	return location + ".dds";
+}
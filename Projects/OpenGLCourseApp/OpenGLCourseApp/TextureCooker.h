@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+
+#include <GL/glew.h>
+
+#include "CommonValues.h"
+#include "SimdLanes.h"
+#include "ThreadPool.h"
+
+// Turns images into block compressed textures ahead of time ("cooking"), so the game only has to copy them to the GPU.
+// BC1 and BC3 cut every 4x4 texels into a block with 2 end colours and, per texel, which mix of the two it is.
+// That is 4 to 8 times smaller than RGBA8, in video memory and in the bandwidth the shaders use to read them.
+//
+// Cooked files are DDS files with every mipmap in them, so nothing needs to be generated at load time either.
+// e.g. OpenGLCourseApp.exe --cook-textures bc1 512 Textures/brick.png Textures/dirt.png
+// writes Textures/brick.dds and Textures/dirt.dds, resized to 512x512. TextureArray picks those over the .png.
+class TextureCooker
+{
+	public:
+		// Cooks the files named by the command line. Returns false if there was nothing to cook.
+		static bool Run(int argc, char** argv);
+
+		// Reads an image, resizes it to size x size, builds its mipmaps (see MipmapGenerator), compresses them and writes them as a DDS file.
+		static bool CookFile(const char* source, const char* destination, TextureCompression compression, GLuint size, ThreadPool* threadPool);
+
+		// Compresses an RGBA image. Sizes that aren't a multiple of 4 repeat their last row and column to fill the edge blocks.
+		// With a thread pool, block rows are split across its threads.
+		static void CompressImage(const unsigned char* image, GLuint width, GLuint height, TextureCompression compression,
+			unsigned char* blocks, ThreadPool* threadPool = nullptr);
+
+		static size_t GetBlockSize(TextureCompression compression); // Bytes per 4x4 block.
+		static size_t GetCompressedSize(GLuint width, GLuint height, TextureCompression compression);
+		static GLenum GetFormat(TextureCompression compression); // The GL internal format.
+
+		static bool WriteDDS(const char* fileLocation, TextureCompression compression, GLuint width, GLuint height, GLuint mipCount,
+			const unsigned char* data, size_t dataSize);
+		static bool ReadDDS(const char* fileLocation, TextureCompression& compression, GLuint& width, GLuint& height, GLuint& mipCount,
+			std::vector<unsigned char>& data);
+
+		// The file a cooked version of an image is looked for in: same name, .dds extension.
+		static std::string GetCookedLocation(const char* fileLocation);
+
+	private:
+		// A 4x4 block of texels, one plane per channel, so lanes can go over 4 or 8 texels at once.
+		struct BlockTexels
+		{
+			GLfloat r[16], g[16], b[16], a[16];
+		};
+
+		static void CompressBlock(const BlockTexels& texels, TextureCompression compression, unsigned char* block);
+
+		// The colour half of a block (all of BC1). The 2 end colours, then 2 bits per texel choosing one of 4 palette colours.
+		static void CompressColourBlock(const BlockTexels& texels, unsigned char* block);
+		// The alpha half of a BC3 block. 2 end alphas, then 3 bits per texel choosing one of 8.
+		static void CompressAlphaBlock(const BlockTexels& texels, unsigned char* block);
+
+		// Picks the closest of the 4 palette colours for every texel. Gives the 2 bit indices and the summed squared error.
+		static GLfloat FindColourIndices(const BlockTexels& texels, const GLfloat palette[4][3], unsigned int indices[16]);
+
+		static unsigned short PackColour(const GLfloat colour[3]); // 8 bit per channel to 5:6:5.
+		static void UnpackColour(unsigned short packed, GLfloat colour[3]);
+};
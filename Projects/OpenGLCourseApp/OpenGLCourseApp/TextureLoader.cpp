@@ -0,0 +1,304 @@
+#include "TextureLoader.h"
+
+TextureLoader::TextureLoader()
+{
+	decodingCount = 0;
+	stopping = false;
+
+	currentJob = nullptr;
+	currentLevel = 0;
+	currentRow = 0;
+	currentOffset = 0;
+
+	nextPBO = 0;
+	chunkSize = 0;
+
+	decodeMilliseconds = 0.0;
+	updateMilliseconds = 0.0;
+	maxUpdateMilliseconds = 0.0;
+	updateFrames = 0;
+	uploadedBytes = 0;
+	loadedLayers = 0;
+}
+
+void TextureLoader::Init(unsigned int threadCount, size_t chunkSize, unsigned int pboCount)
+{
+	this->chunkSize = chunkSize;
+
+	PBOs.resize(pboCount);
+	PBOSizes.assign(pboCount, chunkSize);
+	PBOFences.assign(pboCount, nullptr);
+	glGenBuffers(pboCount, PBOs.data());
+	for (unsigned int i = 0; i < pboCount; i++)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, PBOs[i]);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, chunkSize, nullptr, GL_STREAM_DRAW);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	for (unsigned int i = 0; i < threadCount; i++)
+	{
+		workers.push_back(std::thread(&TextureLoader::WorkerLoop, this));
+	}
+}
+
+void TextureLoader::LoadArray(TextureArray* textureArray)
+{
+	LoadLevels(textureArray, textureArray->GetAllocatedLevel(), textureArray->GetMipCount());
+}
+
+void TextureLoader::LoadLevels(TextureArray* textureArray, GLuint firstLevel, GLuint lastLevel)
+{
+	if (IsIdle())
+	{
+		// A new batch, the clock starts again.
+		startTime = std::chrono::high_resolution_clock::now();
+	}
+
+	for (GLuint layer = 0; layer < textureArray->GetLayerCount(); layer++)
+	{
+		Job* job = new Job();
+		job->textureArray = textureArray;
+		job->layer = layer;
+		job->firstLevel = firstLevel;
+		job->lastLevel = lastLevel;
+		job->failedMaps = 0;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		decodeQueue.push_back(job);
+	}
+	wakeWorkers.notify_all();
+}
+
+void TextureLoader::WorkerLoop()
+{
+	while (true)
+	{
+		Job* job = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wakeWorkers.wait(lock, [this]() { return stopping || !decodeQueue.empty(); });
+			if (stopping)
+			{
+				return;
+			}
+			job = decodeQueue.front();
+			decodeQueue.pop_front();
+			decodingCount++;
+		}
+
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		job->textureArray->LoadLayerData(job->layer, job->data);
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		decodeMilliseconds += elapsed.count();
+		decodedQueue.push_back(job);
+		decodingCount--;
+	}
+}
+
+bool TextureLoader::Update()
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	bool layersReady = false;
+	bool worked = !pendingLayers.empty();
+
+	// Layers the GPU has finished copying. A timeout of 0 only asks, it never waits.
+	for (size_t i = 0; i < pendingLayers.size();)
+	{
+		GLenum status = glClientWaitSync(pendingLayers[i].fence, 0, 0);
+		if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+		{
+			pendingLayers[i].textureArray->SetLayerReady(pendingLayers[i].layer, pendingLayers[i].firstLevel);
+			glDeleteSync(pendingLayers[i].fence);
+			pendingLayers[i] = pendingLayers.back();
+			pendingLayers.pop_back();
+			loadedLayers++;
+			layersReady = true;
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	// At most one chunk per PBO each frame, so one frame never takes more than a few copies.
+	for (unsigned int chunk = 0; chunk < PBOs.size(); chunk++)
+	{
+		if (!currentJob)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (decodedQueue.empty())
+			{
+				break;
+			}
+			currentJob = decodedQueue.front();
+			decodedQueue.pop_front();
+			currentLevel = currentJob->firstLevel;
+			currentRow = 0;
+			currentOffset = currentJob->textureArray->GetLevelDataOffset(currentLevel);
+		}
+
+		worked = true;
+		if (!UploadChunk())
+		{
+			break; // Every PBO is still being read, or one could not be mapped. Trying again next frame.
+		}
+	}
+
+	if (layersReady && IsIdle())
+	{
+		endTime = std::chrono::high_resolution_clock::now();
+	}
+
+	if (worked)
+	{
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+		updateMilliseconds += elapsed.count();
+		maxUpdateMilliseconds = std::max(maxUpdateMilliseconds, elapsed.count());
+		updateFrames++;
+	}
+
+	return layersReady;
+}
+
+bool TextureLoader::UploadChunk()
+{
+	GLuint pbo = nextPBO;
+	if (PBOFences[pbo])
+	{
+		GLenum status = glClientWaitSync(PBOFences[pbo], 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+		{
+			return false;
+		}
+		glDeleteSync(PBOFences[pbo]);
+		PBOFences[pbo] = nullptr;
+	}
+	nextPBO = (nextPBO + 1) % PBOs.size();
+
+	// As many whole rows of the current level as fit in a chunk, at least one.
+	TextureArray* textureArray = currentJob->textureArray;
+	GLuint rowCount = textureArray->GetMipRowCount(currentLevel);
+	size_t rowBytes = textureArray->GetRowDataSize(currentLevel);
+	GLuint rows = std::max((GLuint)(chunkSize / rowBytes), 1u);
+	rows = std::min(rows, rowCount - currentRow);
+	size_t bytes = rows * rowBytes;
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, PBOs[pbo]);
+	if (bytes > PBOSizes[pbo])
+	{
+		// A row wider than a chunk. Growing this PBO to fit it.
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+		PBOSizes[pbo] = bytes;
+	}
+
+	// The fence above says the GPU is done with this PBO, so there is no need for the driver to check again.
+	void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	if (!mapped)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		// Nothing moves on, so the same chunk is tried again next frame. A layer with a hole in it must never be marked ready.
+		currentJob->failedMaps++;
+		if (currentJob->failedMaps < TEXTURE_UPLOAD_MAP_TRIES)
+		{
+			return false;
+		}
+
+		printf("Failed to map a pixel buffer %u times, texture layer %u keeps the placeholder.\n", currentJob->failedMaps, currentJob->layer);
+		delete currentJob;
+		currentJob = nullptr;
+		return false;
+	}
+	currentJob->failedMaps = 0;
+
+	memcpy(mapped, &currentJob->data[currentOffset], bytes);
+	glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+	// With a PBO bound, the data argument is an offset into it, not a pointer.
+	glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray->GetTextureID());
+	textureArray->UploadRows(currentLevel, currentJob->layer, currentRow, rows, (void*)0);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0); // Other texture uploads take pointers, so it must not stay bound.
+
+	PBOFences[pbo] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	uploadedBytes += bytes;
+
+	currentOffset += bytes;
+	currentRow += rows;
+	if (currentRow == rowCount)
+	{
+		currentRow = 0;
+		currentLevel++;
+	}
+
+	if (currentLevel == currentJob->lastLevel)
+	{
+		// Last chunk of the layer. It is ready once the GPU gets past this fence.
+		PendingLayer pending = { textureArray, currentJob->layer, currentJob->firstLevel, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) };
+		pendingLayers.push_back(pending);
+		delete currentJob;
+		currentJob = nullptr;
+	}
+
+	return true;
+}
+
+bool TextureLoader::IsIdle()
+{
+	// Only the GL thread changes currentJob and pendingLayers, the queues need the lock.
+	std::lock_guard<std::mutex> lock(mutex);
+	return decodeQueue.empty() && decodedQueue.empty() && decodingCount == 0 && !currentJob && pendingLayers.empty();
+}
+
+void TextureLoader::PrintReport()
+{
+	std::chrono::duration<double, std::milli> wallTime = endTime - startTime;
+	double megabytes = uploadedBytes / (1024.0 * 1024.0);
+
+	printf("Texture loading: %u layers, %.2f MB in %.1f ms (%.1f MB/s)\n", loadedLayers, megabytes, wallTime.count(),
+		wallTime.count() > 0.0 ? megabytes / (wallTime.count() / 1000.0) : 0.0);
+	printf("  decoding on %u threads: %.1f ms of work\n", (unsigned int)workers.size(), decodeMilliseconds);
+	printf("  main thread: %.2f ms over %u frames, %.2f ms at most in one frame\n", updateMilliseconds, updateFrames, maxUpdateMilliseconds);
+}
+
+TextureLoader::~TextureLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wakeWorkers.notify_all();
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		workers[i].join();
+	}
+
+	for (size_t i = 0; i < decodeQueue.size(); i++)
+	{
+		delete decodeQueue[i];
+	}
+	for (size_t i = 0; i < decodedQueue.size(); i++)
+	{
+		delete decodedQueue[i];
+	}
+	delete currentJob;
+
+	for (size_t i = 0; i < PBOFences.size(); i++)
+	{
+		if (PBOFences[i])
+		{
+			glDeleteSync(PBOFences[i]);
+		}
+	}
+	for (size_t i = 0; i < pendingLayers.size(); i++)
+	{
+		glDeleteSync(pendingLayers[i].fence);
+	}
+	if (!PBOs.empty())
+	{
+		glDeleteBuffers((GLsizei)PBOs.size(), PBOs.data());
+	}
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+
+#include <GL/glew.h>
+
+#include "TextureArray.h"
+
+// Loads the layers of a TextureArray without stopping the frame.
+// Worker threads read and resize the images (the slow part: file reading and decoding). The GL thread then copies them
+// into a few pixel buffer objects, a chunk at a time, and has the driver upload them to the texture from there, so glTexSubImage3D
+// returns right away instead of waiting on the copy. Only a few chunks go up per frame, so a big texture is spread over several frames.
+// A fence after the last chunk of a layer tells us when the GPU has it, and only then does the layer stop showing the placeholder.
+class TextureLoader
+{
+	public:
+		TextureLoader();
+
+		// chunkSize is the size of each pixel buffer, and pboCount how many there are. At most pboCount chunks go up per frame.
+		void Init(unsigned int threadCount = 2, size_t chunkSize = 256 * 1024, unsigned int pboCount = 4);
+
+		// Queues every layer of an allocated array (see TextureArray::Allocate) for loading, every allocated level.
+		void LoadArray(TextureArray* textureArray);
+		// Same, for the levels from firstLevel up to, not including, lastLevel. They have to be allocated.
+		void LoadLevels(TextureArray* textureArray, GLuint firstLevel, GLuint lastLevel);
+
+		// Call once per frame on the GL thread. Uploads what the workers have decoded so far.
+		// Returns true when at least one layer became ready, so whoever points at layers (the MaterialTable) can update.
+		bool Update();
+
+		bool IsIdle(); // Nothing queued, decoding, uploading or waiting on the GPU.
+
+		// Load time, decode time, upload throughput and how long Update held the main thread.
+		void PrintReport();
+
+		~TextureLoader();
+
+	private:
+		struct Job
+		{
+			TextureArray* textureArray;
+			GLuint layer;
+			GLuint firstLevel, lastLevel; // The levels to upload.
+			std::vector<unsigned char> data; // Every mip level, as TextureArray::LoadLayerData gives it.
+			unsigned int failedMaps; // Times in a row the current chunk could not be mapped.
+		};
+
+		struct PendingLayer
+		{
+			TextureArray* textureArray;
+			GLuint layer;
+			GLuint firstLevel;
+			GLsync fence;
+		};
+
+		// Worker side.
+		std::vector<std::thread> workers;
+		std::mutex mutex;
+		std::condition_variable wakeWorkers;
+		std::deque<Job*> decodeQueue, decodedQueue;
+		unsigned int decodingCount;
+		bool stopping;
+
+		// GL side.
+		Job* currentJob; // The layer being uploaded, with where it got to.
+		GLuint currentLevel, currentRow;
+		size_t currentOffset;
+		std::vector<PendingLayer> pendingLayers;
+
+		std::vector<GLuint> PBOs;
+		std::vector<size_t> PBOSizes;
+		std::vector<GLsync> PBOFences; // Set when the PBO was last used, so it isn't overwritten while the GPU still reads from it.
+		unsigned int nextPBO;
+		size_t chunkSize;
+
+		// Stats.
+		std::chrono::high_resolution_clock::time_point startTime, endTime;
+		double decodeMilliseconds; // Summed over the workers.
+		double updateMilliseconds, maxUpdateMilliseconds;
+		unsigned int updateFrames; // Frames Update had something to do.
+		size_t uploadedBytes;
+		unsigned int loadedLayers;
+
+		void WorkerLoop();
+
+		// Uploads the next chunk of currentJob through a free PBO. Returns false if every PBO is still in use, or the PBO could not be mapped.
+		bool UploadChunk();
+};
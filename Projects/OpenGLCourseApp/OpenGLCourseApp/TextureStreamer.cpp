@@ -0,0 +1,181 @@
+#include "TextureStreamer.h"
+
+const unsigned int TextureStreamer::KEEP_FRAMES;
+
+TextureStreamer::TextureStreamer()
+{
+	memoryBudget = 0;
+	textureLoader = nullptr;
+	frame = 0;
+}
+
+void TextureStreamer::Init(size_t memoryBudget, TextureLoader* textureLoader)
+{
+	this->memoryBudget = memoryBudget;
+	this->textureLoader = textureLoader;
+}
+
+void TextureStreamer::AddArray(TextureArray* textureArray)
+{
+	StreamedArray streamed;
+	streamed.textureArray = textureArray;
+	streamed.wantedLevels.assign(textureArray->GetLayerCount(), textureArray->GetMipCount() - 1);
+	streamed.lastNeeded.assign(textureArray->GetLayerCount(), frame);
+	streamed.targetLevel = textureArray->GetAllocatedLevel();
+	arrays.push_back(streamed);
+}
+
+GLfloat TextureStreamer::CalcWantedLevel(GLfloat texelsPerUnit, GLfloat pixelsPerUnit)
+{
+	// Every level halves the texels, so the level is how many times we can halve before there is one texel per pixel.
+	GLfloat texelsPerPixel = texelsPerUnit / pixelsPerUnit;
+	return texelsPerPixel > 1.0f ? log2f(texelsPerPixel) : 0.0f;
+}
+
+void TextureStreamer::RequestLevel(TextureArray* textureArray, GLuint layer, GLfloat level)
+{
+	for (size_t i = 0; i < arrays.size(); i++)
+	{
+		StreamedArray& streamed = arrays[i];
+		if (streamed.textureArray != textureArray || layer >= streamed.wantedLevels.size())
+		{
+			continue;
+		}
+
+		GLuint wanted = (GLuint)std::min(std::max(level, 0.0f), (GLfloat)(textureArray->GetMipCount() - 1));
+		if (wanted <= streamed.wantedLevels[layer] || frame - streamed.lastNeeded[layer] > KEEP_FRAMES)
+		{
+			streamed.wantedLevels[layer] = wanted;
+			streamed.lastNeeded[layer] = frame;
+		}
+		return;
+	}
+}
+
+GLuint TextureStreamer::CalcArrayWantedLevel(StreamedArray& streamed)
+{
+	// Layers nobody asked for in a while only need the smallest level.
+	GLuint wanted = streamed.textureArray->GetMipCount() - 1;
+	for (size_t layer = 0; layer < streamed.wantedLevels.size(); layer++)
+	{
+		if (frame - streamed.lastNeeded[layer] <= KEEP_FRAMES)
+		{
+			wanted = std::min(wanted, streamed.wantedLevels[layer]);
+		}
+	}
+	return wanted;
+}
+
+void TextureStreamer::FitBudget()
+{
+	size_t total = 0;
+	for (size_t i = 0; i < arrays.size(); i++)
+	{
+		arrays[i].targetLevel = CalcArrayWantedLevel(arrays[i]);
+		total += arrays[i].textureArray->GetMemoryFrom(arrays[i].targetLevel);
+	}
+
+	// Over budget: dropping the biggest finest level, one at a time.
+	while (total > memoryBudget)
+	{
+		StreamedArray* largest = nullptr;
+		size_t largestSize = 0;
+		for (size_t i = 0; i < arrays.size(); i++)
+		{
+			TextureArray* textureArray = arrays[i].textureArray;
+			if (arrays[i].targetLevel + 1 >= textureArray->GetMipCount())
+			{
+				continue; // Already down to 1x1.
+			}
+			size_t size = textureArray->GetMemoryFrom(arrays[i].targetLevel) - textureArray->GetMemoryFrom(arrays[i].targetLevel + 1);
+			if (size > largestSize)
+			{
+				largest = &arrays[i];
+				largestSize = size;
+			}
+		}
+
+		if (!largest)
+		{
+			break; // Even the smallest levels don't fit. Nothing more we can drop.
+		}
+		largest->targetLevel++;
+		total -= largestSize;
+	}
+}
+
+bool TextureStreamer::Update()
+{
+	bool changed = false;
+	FitBudget();
+
+	for (size_t i = 0; i < arrays.size(); i++)
+	{
+		TextureArray* textureArray = arrays[i].textureArray;
+		GLuint allocated = textureArray->GetAllocatedLevel();
+		GLuint target = arrays[i].targetLevel;
+
+		// Levels still being uploaded. Nothing else is safe to do to this array until they're done.
+		if (!textureArray->IsLevelReady(allocated))
+		{
+			continue;
+		}
+
+		// Levels that finished streaming in can be sampled now.
+		if (textureArray->GetBaseLevel() > allocated)
+		{
+			textureArray->SetBaseLevel(allocated);
+			changed = true;
+			printf("Texture streaming: %u layer array now sampled from %ux%u.\n", textureArray->GetLayerCount(),
+				textureArray->GetMipSize(allocated), textureArray->GetMipSize(allocated));
+		}
+
+		if (target > allocated)
+		{
+			textureArray->FreeLevels(target);
+			changed = true;
+			printf("Texture streaming: %u layer array evicted down to %ux%u. %.1f KB resident.\n", textureArray->GetLayerCount(),
+				textureArray->GetMipSize(target), textureArray->GetMipSize(target), GetResidentMemory() / 1024.0);
+		}
+		else if (target < allocated && textureLoader)
+		{
+			// Every missing level at once, so each layer is only read once.
+			textureArray->AllocateLevels(target);
+			textureLoader->LoadLevels(textureArray, target, allocated);
+			printf("Texture streaming: %u layer array loading up to %ux%u. %.1f KB resident.\n", textureArray->GetLayerCount(),
+				textureArray->GetMipSize(target), textureArray->GetMipSize(target), GetResidentMemory() / 1024.0);
+		}
+	}
+
+	frame++;
+	return changed;
+}
+
+size_t TextureStreamer::GetResidentMemory()
+{
+	size_t total = 0;
+	for (size_t i = 0; i < arrays.size(); i++)
+	{
+		total += arrays[i].textureArray->GetMemoryFrom(arrays[i].textureArray->GetAllocatedLevel());
+	}
+	return total;
+}
+
+void TextureStreamer::PrintReport()
+{
+	printf("Texture residency: %.1f KB of a %.1f KB budget\n", GetResidentMemory() / 1024.0, memoryBudget / 1024.0);
+	for (size_t i = 0; i < arrays.size(); i++)
+	{
+		TextureArray* textureArray = arrays[i].textureArray;
+		GLuint wanted = CalcArrayWantedLevel(arrays[i]);
+		printf("  %u layers of %ux%u: storage from level %u, sampled from level %u, wanted %u, budget allows %u. %.1f KB (%.1f KB with every level)\n",
+			textureArray->GetLayerCount(), textureArray->GetLayerSize(), textureArray->GetLayerSize(),
+			textureArray->GetAllocatedLevel(), textureArray->GetBaseLevel(), wanted, arrays[i].targetLevel,
+			textureArray->GetMemoryFrom(textureArray->GetAllocatedLevel()) / 1024.0, textureArray->GetMemoryFrom(0) / 1024.0);
+		for (size_t layer = 0; layer < arrays[i].wantedLevels.size(); layer++)
+		{
+			printf("    %s: wants level %u%s\n", textureArray->GetFileLocation((GLuint)layer), arrays[i].wantedLevels[layer],
+				frame - arrays[i].lastNeeded[layer] > KEEP_FRAMES ? " (not seen lately)" : "");
+		}
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdio.h>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include <GL/glew.h>
+
+#include "TextureArray.h"
+#include "TextureLoader.h"
+
+// Keeps only the mip levels that are needed in video memory, within a budget, so the scene can have more texture data than fits.
+// Every frame, whoever draws says which level each visible texture needs (RequestLevel, see CalcWantedLevel), from how big it is on screen.
+// Levels nobody needed for a while are freed, and missing ones are loaded in the background with the TextureLoader.
+// When everything wanted doesn't fit, the textures with the finest levels give up a level first, until it does.
+//
+// A TextureArray has one set of levels for all its layers, so it streams as a whole: the finest level any of its layers wants.
+class TextureStreamer
+{
+	public:
+		TextureStreamer();
+
+		void Init(size_t memoryBudget, TextureLoader* textureLoader);
+
+		// Starts streaming an array. It should be allocated at a small level, see TextureArray::Allocate.
+		void AddArray(TextureArray* textureArray);
+
+		// The level where one texel covers about one pixel, for a texture with texelsPerUnit texels across a unit
+		// that takes pixelsPerUnit pixels on screen.
+		static GLfloat CalcWantedLevel(GLfloat texelsPerUnit, GLfloat pixelsPerUnit);
+
+		// A layer is seen this frame and needs this level. The finest request of the frame counts.
+		void RequestLevel(TextureArray* textureArray, GLuint layer, GLfloat level);
+
+		// Once per frame, after the requests. Frees and loads levels. Returns true when the levels shaders sample changed.
+		bool Update();
+
+		size_t GetResidentMemory(); // Video memory of every level that has storage.
+		void PrintReport();
+
+	private:
+		// Levels wanted less detailed than before only count after this many frames, so looking away for a moment doesn't evict anything.
+		static const unsigned int KEEP_FRAMES = 300;
+
+		struct StreamedArray
+		{
+			TextureArray* textureArray;
+			std::vector<GLuint> wantedLevels; // Per layer.
+			std::vector<unsigned int> lastNeeded; // Frame a layer last asked for its wanted level, or a finer one.
+			GLuint targetLevel; // What the array should have, within the budget.
+		};
+
+		std::vector<StreamedArray> arrays;
+		size_t memoryBudget;
+		TextureLoader* textureLoader;
+		unsigned int frame;
+
+		GLuint CalcArrayWantedLevel(StreamedArray& streamed);
+		void FitBudget(); // Sets the targetLevel of every array.
+};
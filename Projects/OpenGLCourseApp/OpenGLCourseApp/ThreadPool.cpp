@@ -0,0 +1,109 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool()
+{
+	currentTask = nullptr;
+	taskCount = 0;
+	nextTask = 0;
+	busyWorkers = 0;
+	generation = 0;
+	stopping = false;
+}
+
+void ThreadPool::Init(unsigned int threadCount)
+{
+	if (threadCount == 0)
+	{
+		unsigned int cores = std::thread::hardware_concurrency();
+		threadCount = cores > 1 ? cores - 1 : 1;
+	}
+
+	for (unsigned int i = 0; i < threadCount; i++)
+	{
+		workers.push_back(std::thread(&ThreadPool::WorkerLoop, this));
+	}
+}
+
+void ThreadPool::ParallelFor(unsigned int taskCount, const std::function<void(unsigned int)>& task)
+{
+	if (workers.empty())
+	{
+		// Not initialised. Just doing it all here.
+		for (unsigned int i = 0; i < taskCount; i++)
+		{
+			task(i);
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		currentTask = &task;
+		this->taskCount = taskCount;
+		nextTask = 0;
+		busyWorkers = (unsigned int)workers.size();
+		generation++;
+	}
+	wakeWorkers.notify_all();
+
+	RunTasks();
+
+	// Some workers can still be finishing their last task.
+	std::unique_lock<std::mutex> lock(mutex);
+	workDone.wait(lock, [this]() { return busyWorkers == 0; });
+	currentTask = nullptr;
+}
+
+void ThreadPool::RunTasks()
+{
+	// Everyone grabs the next task number until there are none left.
+	for (unsigned int i = nextTask++; i < taskCount; i = nextTask++)
+	{
+		(*currentTask)(i);
+	}
+}
+
+void ThreadPool::WorkerLoop()
+{
+	unsigned long seenGeneration = 0;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wakeWorkers.wait(lock, [this, seenGeneration]() { return stopping || generation != seenGeneration; });
+			if (stopping)
+			{
+				return;
+			}
+			seenGeneration = generation;
+		}
+
+		RunTasks();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			busyWorkers--;
+		}
+		workDone.notify_one();
+	}
+}
+
+unsigned int ThreadPool::GetThreadCount()
+{
+	return (unsigned int)workers.size() + 1;
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wakeWorkers.notify_all();
+
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		workers[i].join();
+	}
+}
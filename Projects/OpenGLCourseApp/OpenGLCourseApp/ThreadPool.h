@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+// A few threads that wait for work, so we don't pay for creating threads every frame.
+// ParallelFor splits a loop across them, and the calling thread helps too.
+class ThreadPool
+{
+	public:
+		ThreadPool();
+
+		// 0 picks one less than the number of cores, since the calling thread works too.
+		void Init(unsigned int threadCount = 0);
+
+		// Runs task(i) for every i from 0 to taskCount - 1, in any order, and returns once they are all done.
+		void ParallelFor(unsigned int taskCount, const std::function<void(unsigned int)>& task);
+
+		unsigned int GetThreadCount(); // Workers plus the calling thread.
+
+		~ThreadPool();
+
+	private:
+		std::vector<std::thread> workers;
+		std::mutex mutex;
+		std::condition_variable wakeWorkers, workDone;
+
+		const std::function<void(unsigned int)>* currentTask;
+		unsigned int taskCount;
+		std::atomic<unsigned int> nextTask;
+		unsigned int busyWorkers;
+		unsigned long generation; // Goes up for every ParallelFor, so workers know there is new work.
+		bool stopping;
+
+		void WorkerLoop();
+		void RunTasks();
+};
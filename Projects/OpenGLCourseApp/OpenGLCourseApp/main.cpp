@@ -1,10 +1,14 @@
 #define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#undef STB_IMAGE_IMPLEMENTATION // The implementation part of stb_image.h has no include guard, and several of our headers include it.
 
 
 #include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
 #include <cmath>
 #include <vector>
+#include <algorithm>
 
 #include <GL\glew.h>
 #include <GLFW\glfw3.h>
@@ -17,19 +21,38 @@
 
 #include "Window.h"
 #include "Mesh.h"
+#include "MeshFile.h"
+#include "MeshImporter.h"
+#include "MeshProcessing.h"
 #include "Shader.h"
 #include "Camera.h"
-#include "Texture.h"
+#include "TextureArray.h"
+#include "TextureLoader.h"
+#include "TextureCooker.h"
+#include "TextureStreamer.h"
+#include "TextureCache.h"
 #include "DirectionalLight.h"
 #include "PointLight.h"
 #include "Material.h"
+#include "MaterialTable.h"
+#include "ShadowAtlas.h"
+#include "ShadowMapPool.h"
+#include "Frustum.h"
+#include "ClusterGrid.h"
+#include "LightManager.h"
+#include "ThreadPool.h"
+#include "Benchmarks.h"
+#include "GBuffer.h"
 
 
 const float toRadians = 3.14159265f / 180.0f;
 
+// The camera's vertical field of view and depth range. Everything that works out how big things are on screen uses these too.
+const GLfloat fieldOfView = 45.0f * toRadians;
+const GLfloat nearPlane = 0.1f, farPlane = 100.0f;
+
 GLuint uniformProjection = 0, uniformModel = 0, uniformView = 0,
 uniformEyePosition = 0,
-uniformSpecularIntensity = 0, uniformShininess = 0,
 uniformDirectionalLightTransform = 0, 
 uniformOmniLightPos = 0, uniformFarPlane =0;
 
@@ -39,22 +62,67 @@ std::vector<Mesh*> meshList;
 std::vector<Shader> shaderList;
 Shader directionalShadowShader;
 Shader omniShadowShader;
+Shader shadowBlurShader;
+Shader depthPrePassShader;
+Shader gBufferShader;
+Shader deferredDirectionalShader;
+Shader deferredPointShader;
 
 Camera camera;
+Frustum cameraFrustum;
 
 // Textures
-Texture brickTexture;
-Texture dirtTexture;
-Texture plainTexture;
+TextureArray materialTextures(MATERIAL_TEXTURE_SIZE, MATERIAL_TEXTURE_COMPRESSION); // Every texture of the scene, one per layer. Bound once, on unit 1.
+TextureLoader textureLoader; // Fills materialTextures in the background while the scene already renders.
+TextureStreamer textureStreamer; // Decides which levels of materialTextures are in video memory. T prints what it holds.
+bool textureReportKeyHeld = false;
+TextureCache textureCache; // Every texture goes through it, so each file is only loaded once however many objects use it.
 
 // Lights
+ShadowAtlas shadowAtlas; // Holds the 2D shadow maps. Point lights use cube maps, so only the directional light is in it for now.
 DirectionalLight mainLight;
 PointLight pointLights[MAX_POINT_LIGHTS];
 unsigned int pointLightCount = 0;
+PointLight visiblePointLights[MAX_POINT_LIGHTS]; // The point lights reaching into the camera frustum this frame. Filled by CullPointLights.
+unsigned int visiblePointLightCount = 0;
+ShadowMapPool omniShadowMapPool(MAX_POINT_LIGHTS); // Gives the point lights their cube maps, only while they are visible.
+LightManager clusteredLights; // Lots of small lights without shadows. Each fragment only shades the ones near it.
+const glm::vec3 clusteredLightsMin(-10.0f, -1.5f, -10.0f), clusteredLightsMax(10.0f, -1.5f, 10.0f); // The box they wander in.
+ClusterGrid clusterGrid;
+ThreadPool threadPool; // For the CPU work we can split, like putting lights in clusters.
 
 // Materials
 Material shinyMaterial;
 Material dullMaterial;
+MaterialTable materialTable;
+
+// Everything opaque we draw. Kept in a list so the main pass can sort it.
+struct SceneObject
+{
+	Mesh* mesh;
+	glm::mat4 model;
+	Material* material;
+	GLuint textureLayer; // In materialTextures.
+	GLuint materialIndex; // Where material and textureLayer are in materialTable.
+	GLuint lod; // Level of detail drawn this frame, see SelectLods.
+	GLuint shadowLod; // The same for shadow maps, which can be coarser.
+};
+std::vector<SceneObject> sceneObjects;
+
+// Deferred shading. Toggled with G.
+bool deferredShading = false;
+bool deferredShadingKeyHeld = false;
+GBuffer gBuffer;
+Mesh* lightVolume; // Sphere drawn over each point light in the deferred path.
+GLuint fullscreenVAO = 0; // Empty. The fullscreen triangle is made in deferred_directional.vert.
+
+// Depth pre-pass. Toggled with P.
+bool depthPrePass = true;
+bool depthPrePassKeyHeld = false;
+GLuint shadedFragmentsQuery = 0; // GL_SAMPLES_PASSED of the lit pass, which is how many times shader.frag ran.
+bool shadedFragmentsQueryPending = false;
+GLuint shadedFragments[3] = { 0, 0, 0 }; // Last count without and with the pre-pass, and of the deferred light passes.
+GLfloat lastShadedFragmentsReport = 0.0f;
 
 GLfloat deltaTime = 0.0f; // Change in time.
 GLfloat lastTime = 0.0f; // What the last time was.
@@ -65,66 +133,8 @@ static const char* vShader = "Shaders/shader.vert";
 // Fragment Shader
 static const char* fShader = "Shaders/shader.frag";
 
-void CalcAverageNormals(unsigned int* indices, unsigned int indiceCount, GLfloat* vertices, unsigned int verticeCount, unsigned int vertexLength, unsigned int normalOffset)
-{
-	// Jumping from triangle to triangle, in the indices table.
-	for (size_t i = 0; i < indiceCount; i += 3)
-	{
-		// vertexLength represents how many values there are in a vertex. In our case, it's 8.
-		// By doing this multiplication, we get straigth to the x,y,z values of a vertex in the vertices[] array.
-		unsigned int in0 = indices[i] * vertexLength;
-		unsigned int in1 = indices[i + 1] * vertexLength;
-		unsigned int in2 = indices[i + 2] * vertexLength;
-
-		// So our above code points to the start of each of the 3 vertex value used in a face.
-
-		// Now, for each vertex, we create 2 lines leading from it, and we do the cross product. This will give us the perfect normal for each vertex!
-		// Creating first line
-		glm::vec3 v1(vertices[in1] - vertices[in0], // Subtracting x values
-			vertices[in1 + 1] - vertices[in0 + 1], // Subtracting y values
-			vertices[in1 + 2] - vertices[in0 + 2] // Subtracting z values
-			);
-		glm::vec3 v2(vertices[in2] - vertices[in0], // Subtracting x values
-			vertices[in2 + 1] - vertices[in0 + 1], // Subtracting y values
-			vertices[in2 + 2] - vertices[in0 + 2] // Subtracting z values
-		);
-		glm::vec3 normal = glm::cross(v1, v2); // Getting the normal
-		normal = glm::normalize(normal); // Normalizing because we just want the direction.
-
-		// Going to the normal values
-		in0 += normalOffset;
-		in1 += normalOffset;
-		in2 += normalOffset;
-
-		// Everytime a vertex is used in one of those normal, we add its X value. Because we are computing the average of all the normals we come up with.
-		vertices[in0] += normal.x;
-		vertices[in0 + 1] += normal.y;
-		vertices[in0 + 2] += normal.z;
-
-		vertices[in1] += normal.x;
-		vertices[in1 + 1] += normal.y;
-		vertices[in1 + 2] += normal.z;
-
-		vertices[in2] += normal.x;
-		vertices[in2 + 1] += normal.y;
-		vertices[in2 + 2] += normal.z;
-	}
-
-	for (size_t i = 0; i < verticeCount / vertexLength; i++)
-	{
-		// Normal offset for this individual vertex
-		unsigned int nOffset = i * vertexLength + normalOffset;
-		glm::vec3 vec(vertices[nOffset], vertices[nOffset + 1], vertices[nOffset + 2]);
-		// Normalizing the normal vector.
-		vec = glm::normalize(vec);
-
-		vertices[nOffset] = vec.x;
-		vertices[nOffset + 1] = vec.y;
-		vertices[nOffset + 2] = vec.z;
-	}
-}
-
-void CreateObjects() 
+// The pyramid, with its normals. Only used to write Models/pyramid.mesh, see WriteSceneMeshes.
+void MakePyramid(std::vector<GLfloat>& pyramidVertices, std::vector<unsigned int>& pyramidIndices)
 {
 	unsigned int indices[] = {
 		0, 3, 1,
@@ -143,6 +153,15 @@ void CreateObjects()
 		0.0f, 1.0f, 0.0f,   0.5f, 1.0f,		0.0f, 0.0f, 0.0f
 	};
 
+	MeshProcessing::CalcNormals(indices, 12, vertices, 32, 8, 5);
+
+	pyramidVertices.assign(vertices, vertices + 32);
+	pyramidIndices.assign(indices, indices + 12);
+}
+
+// The floor of the world. Only used to write Models/floor.mesh, see WriteSceneMeshes.
+void MakeFloor(std::vector<GLfloat>& floorVertexList, std::vector<unsigned int>& floorIndexList)
+{
 	// Indices for the floor of the world.
 	unsigned int floorIndices[] = {
 		0, 2, 1,
@@ -157,19 +176,98 @@ void CreateObjects()
 		10.0f, 0.0f, 10.0f,		10.0f, 10.0f,	0.0f, -1.0f, 0.0f // Bottom right.
 	};
 
-	CalcAverageNormals(indices, 12, vertices, 32, 8, 5);
+	floorVertexList.assign(floorVertices, floorVertices + 32);
+	floorIndexList.assign(floorIndices, floorIndices + 6);
+}
 
-	Mesh *obj1 = new Mesh();
-	obj1->CreateMesh(vertices, indices, 32, 12);
-	meshList.push_back(obj1);
+// --write-scene-meshes writes the meshes of the scene to Models/, from MakePyramid and MakeFloor.
+// Run it again after changing either of them, the program itself only ever reads the files. Returns false if it wasn't asked for.
+bool WriteSceneMeshes(int argc, char** argv)
+{
+	bool asked = false;
+	for (int i = 1; i < argc; i++)
+	{
+		asked = asked || strcmp(argv[i], "--write-scene-meshes") == 0;
+	}
+	if (!asked)
+	{
+		return false;
+	}
 
-	Mesh *obj2 = new Mesh();
-	obj2->CreateMesh(vertices, indices, 32, 12);
-	meshList.push_back(obj2);
+	std::vector<GLfloat> vertices;
+	std::vector<unsigned int> indices;
+	MakePyramid(vertices, indices);
+	bool written = MeshFile::Save("Models/pyramid.mesh", vertices.data(), indices.data(), (unsigned int)vertices.size(), (unsigned int)indices.size());
+	printf("%s Models/pyramid.mesh\n", written ? "Wrote" : "Failed to write");
+
+	MakeFloor(vertices, indices);
+	written = MeshFile::Save("Models/floor.mesh", vertices.data(), indices.data(), (unsigned int)vertices.size(), (unsigned int)indices.size());
+	printf("%s Models/floor.mesh\n", written ? "Wrote" : "Failed to write");
+	return true;
+}
 
-	Mesh* floor = new Mesh();
-	floor->CreateMesh(floorVertices, floorIndices, 32, 6);
+// The mesh in a .mesh file, mapped straight into its buffers.
+Mesh* LoadMesh(const char* fileLocation)
+{
+	Mesh* mesh = MeshFile::LoadMesh(fileLocation);
+	if (!mesh)
+	{
+		printf("Failed to load %s. Run with --write-scene-meshes to make it.\n", fileLocation);
+	}
+	return mesh;
+}
+
+bool CreateObjects() 
+{
+	Mesh *obj1 = LoadMesh("Models/pyramid.mesh");
+	Mesh *obj2 = LoadMesh("Models/pyramid.mesh");
+	Mesh* floor = LoadMesh("Models/floor.mesh");
+	if (!obj1 || !obj2 || !floor)
+	{
+		return false;
+	}
+
+	meshList.push_back(obj1);
+	meshList.push_back(obj2);
 	meshList.push_back(floor);
+	return true;
+}
+
+// Sphere of radius 1 for the deferred light volumes. Its flat faces are pushed out so they never cut inside the real sphere.
+void CreateLightVolume()
+{
+	const int rings = 8, segments = 12;
+	GLfloat scale = 1.0f / (cosf(3.14159265f / segments) * cosf(3.14159265f / (2 * rings)));
+
+	std::vector<GLfloat> vertices;
+	for (int ring = 0; ring <= rings; ring++)
+	{
+		GLfloat theta = 3.14159265f * ring / rings; // From the top down.
+		for (int segment = 0; segment <= segments; segment++)
+		{
+			GLfloat phi = 2.0f * 3.14159265f * segment / segments; // Around.
+			GLfloat vertex[8] = { scale * sinf(theta) * cosf(phi), scale * cosf(theta), scale * sinf(theta) * sinf(phi), // Position
+				0.0f, 0.0f, // No UVs
+				0.0f, 0.0f, 0.0f }; // No normals, the lighting reads them from the G-buffer.
+			vertices.insert(vertices.end(), vertex, vertex + 8);
+		}
+	}
+
+	std::vector<unsigned int> indices;
+	for (int ring = 0; ring < rings; ring++)
+	{
+		for (int segment = 0; segment < segments; segment++)
+		{
+			unsigned int a = ring * (segments + 1) + segment;
+			unsigned int b = a + segments + 1; // Same segment, next ring down.
+			// Counter clockwise seen from outside.
+			unsigned int quad[6] = { a, b + 1, b, a, a + 1, b + 1 };
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+
+	lightVolume = new Mesh();
+	lightVolume->CreateMesh(vertices.data(), indices.data(), vertices.size(), indices.size());
 }
 
 void CreateShaders()
@@ -180,61 +278,245 @@ void CreateShaders()
 
 	directionalShadowShader.CreateFromFiles("shaders/directional_shadow_map.vert", "shaders/directional_shadow_map.frag");
 	omniShadowShader.CreateFromFiles("shaders/omni_shadow_map.vert", "shaders/omni_shadow_map.geom", "shaders/omni_shadow_map.frag");
+	shadowBlurShader.CreateFromFiles("shaders/shadow_blur.vert", "shaders/shadow_blur.frag");
+	depthPrePassShader.CreateFromFiles("shaders/depth_prepass.vert", "shaders/depth_prepass.frag");
+	gBufferShader.CreateFromFiles("shaders/gbuffer.vert", "shaders/gbuffer.frag");
+	deferredDirectionalShader.CreateFromFiles("shaders/deferred_directional.vert", "shaders/deferred_directional.frag");
+	deferredPointShader.CreateFromFiles("shaders/deferred_point.vert", "shaders/deferred_point.frag");
+}
+
+void CreateSceneObjects()
+{
+	SceneObject object;
+	object.lod = 0;
+	object.shadowLod = 0;
+
+	object.mesh = meshList[0];
+	object.model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -2.5f));
+	object.textureLayer = textureCache.GetLayer(&materialTextures, "Textures/brick.png");
+	object.material = &shinyMaterial;
+	object.materialIndex = materialTable.AddMaterial(object.material, object.textureLayer);
+	sceneObjects.push_back(object);
+
+	object.mesh = meshList[1];
+	object.model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 4.0f, -2.5f));
+	object.textureLayer = textureCache.GetLayer(&materialTextures, "Textures/dirt.png");
+	object.material = &dullMaterial;
+	object.materialIndex = materialTable.AddMaterial(object.material, object.textureLayer);
+	sceneObjects.push_back(object);
+
+	object.mesh = meshList[2];
+	object.model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -2.0f, 0.0f));
+	object.textureLayer = textureCache.GetLayer(&materialTextures, "Textures/dirt.png");
+	object.material = &shinyMaterial;
+	object.materialIndex = materialTable.AddMaterial(object.material, object.textureLayer);
+	sceneObjects.push_back(object);
 }
 
-void RenderScene()
+// Small coloured lights scattered just above the floor, slowly drifting around.
+void CreateClusteredLights(unsigned int count)
 {
-	glm::mat4 model(1.0f);
-
-	model = glm::translate(model, glm::vec3(0.0f, 0.0f, -2.5f));
-	glUniformMatrix4fv(uniformModel, 1, GL_FALSE, glm::value_ptr(model));
-	brickTexture.UseTexture();
-	shinyMaterial.UseMaterial(uniformSpecularIntensity, uniformShininess);
-	meshList[0]->RenderMesh();
-
-	model = glm::mat4(1.0f);
-	model = glm::translate(model, glm::vec3(0.0f, 4.0f, -2.5f));
-	glUniformMatrix4fv(uniformModel, 1, GL_FALSE, glm::value_ptr(model));
-	dirtTexture.UseTexture();
-	dullMaterial.UseMaterial(uniformSpecularIntensity, uniformShininess);
-	meshList[1]->RenderMesh();
-
-	model = glm::mat4(1.0f);
-	model = glm::translate(model, glm::vec3(0.0f, -2.0f, 0.0f));
-	glUniformMatrix4fv(uniformModel, 1, GL_FALSE, glm::value_ptr(model));
-	dirtTexture.UseTexture();
-	shinyMaterial.UseMaterial(uniformSpecularIntensity, uniformShininess);
-	meshList[2]->RenderMesh();
+	srand(1234); // Same lights every run.
+	for (unsigned int i = 0; i < count; i++)
+	{
+		GLfloat x = clusteredLightsMin.x + (clusteredLightsMax.x - clusteredLightsMin.x) * rand() / RAND_MAX;
+		GLfloat z = clusteredLightsMin.z + (clusteredLightsMax.z - clusteredLightsMin.z) * rand() / RAND_MAX;
+		GLfloat red = (GLfloat)rand() / RAND_MAX;
+		GLfloat green = (GLfloat)rand() / RAND_MAX;
+		GLfloat blue = (GLfloat)rand() / RAND_MAX;
+
+		// Strong falloff, so each light only reaches a couple of units.
+		LightHandle light = clusteredLights.AddPointLight(glm::vec3(x, clusteredLightsMin.y, z), glm::vec3(red, green, blue),
+														  0.0f, 0.8f,
+														  1.0f, 2.0f, 20.0f);
+
+		// Up to 1 unit per second, along the floor.
+		GLfloat angle = 2.0f * 3.14159265f * rand() / RAND_MAX;
+		GLfloat speed = (GLfloat)rand() / RAND_MAX;
+		clusteredLights.SetVelocity(light, glm::vec3(cosf(angle) * speed, 0.0f, sinf(angle) * speed));
+	}
+}
+
+// Closest objects first. They fill the depth buffer early, so what is behind them fails the depth test before shading.
+void SortSceneFrontToBack(glm::vec3 cameraPosition)
+{
+	std::sort(sceneObjects.begin(), sceneObjects.end(), [cameraPosition](const SceneObject& a, const SceneObject& b)
+	{
+		// The translation of the model matrix, as the center of the object.
+		glm::vec3 aOffset = glm::vec3(a.model[3]) - cameraPosition;
+		glm::vec3 bOffset = glm::vec3(b.model[3]) - cameraPosition;
+		return glm::dot(aOffset, aOffset) < glm::dot(bOffset, bOffset);
+	});
+}
+
+// depthOnly skips the materials and draws from the meshes' positions alone, for the passes that only write depth.
+// Materials and their texture layers come from materialTable, so a draw only sets its material index. No texture binding either.
+// shadowPass draws the coarser levels picked for shadow maps. The depth pre-pass has to draw the same triangles as the lit pass, so it doesn't.
+void RenderScene(bool depthOnly = false, bool shadowPass = false)
+{
+	for (size_t i = 0; i < sceneObjects.size(); i++)
+	{
+		glUniformMatrix4fv(uniformModel, 1, GL_FALSE, glm::value_ptr(sceneObjects[i].model));
+		if (!depthOnly)
+		{
+			MaterialTable::UseMaterial(sceneObjects[i].materialIndex);
+		}
+		if (depthOnly)
+		{
+			sceneObjects[i].mesh->RenderMeshDepth(shadowPass ? sceneObjects[i].shadowLod : sceneObjects[i].lod);
+		}
+		else
+		{
+			sceneObjects[i].mesh->RenderMesh(sceneObjects[i].lod);
+		}
+	}
+}
+
+// How many pixels one model space unit of an object takes on screen, at the closest its bounding sphere can be to the camera.
+// Closer is bigger, so this errs on the side of detail. Also gives that sphere, in world space.
+GLfloat CalcPixelsPerUnit(const SceneObject& object, glm::vec3& center, GLfloat& radius)
+{
+	GLfloat scale = std::max(std::max(glm::length(glm::vec3(object.model[0])), glm::length(glm::vec3(object.model[1]))), glm::length(glm::vec3(object.model[2])));
+	center = glm::vec3(object.model * glm::vec4(object.mesh->GetBoundingCenter(), 1.0f));
+	radius = object.mesh->GetBoundingRadius() * scale;
+
+	GLfloat distance = std::max(glm::length(center - camera.getCameraPosition()) - radius, nearPlane);
+	return scale * mainWindow.getBufferHeight() / (2.0f * distance * tanf(fieldOfView * 0.5f));
+}
+
+// Picks each object's level of detail, the coarsest whose error covers at most LOD_PIXEL_ERROR pixels on screen.
+// Objects out of view too, since they can still cast shadows into it.
+void SelectLods()
+{
+	for (size_t i = 0; i < sceneObjects.size(); i++)
+	{
+		SceneObject& object = sceneObjects[i];
+		glm::vec3 center;
+		GLfloat radius;
+		GLfloat pixelsPerUnit = CalcPixelsPerUnit(object, center, radius);
+		object.lod = object.mesh->SelectLod(pixelsPerUnit, LOD_PIXEL_ERROR);
+		// Shadows are blurred and seen through a shadow map's coarser texels, so their shape can be further off.
+		object.shadowLod = std::max(object.lod, object.mesh->SelectLod(pixelsPerUnit, LOD_PIXEL_ERROR * SHADOW_LOD_ERROR_SCALE));
+	}
+}
+
+// Tells the texture streamer how much detail each visible object's texture needs, from how close it is and how its UVs are spread.
+void RequestTextureLevels()
+{
+	for (size_t i = 0; i < sceneObjects.size(); i++)
+	{
+		SceneObject& object = sceneObjects[i];
+		glm::vec3 center;
+		GLfloat radius;
+		GLfloat pixelsPerUnit = CalcPixelsPerUnit(object, center, radius);
+		if (!cameraFrustum.SphereVisible(center, radius))
+		{
+			continue;
+		}
+
+		// Both per model space unit, so the object's scale cancels out.
+		GLfloat texelsPerUnit = object.mesh->GetUVDensity() * materialTextures.GetLayerSize();
+		textureStreamer.RequestLevel(&materialTextures, object.textureLayer, TextureStreamer::CalcWantedLevel(texelsPerUnit, pixelsPerUnit));
+	}
+}
+
+// Blurs and mipmaps a variance shadow map, right after its shadow pass. Nothing to do for PCF shadow maps.
+void FilterShadowMap(ShadowMap* shadowMap)
+{
+	if (shadowMap->GetFilterMode() != SHADOW_FILTER_VSM)
+	{
+		return;
+	}
+
+	shadowBlurShader.UseShader();
+	shadowBlurShader.SetBlurSource(0);
+	shadowMap->Filter(shadowBlurShader.GetBlurDirectionLocation(), GL_TEXTURE0);
+}
+
+// Hands out the tiles of the shadow atlas for this frame, according to how much of the screen each light's shadow covers.
+void PackShadowAtlas()
+{
+	AtlasShadowMap* mainLightTile = dynamic_cast<AtlasShadowMap*>(mainLight.GetShadowMap());
+	if (mainLightTile)
+	{
+		mainLightTile->SetImportance(mainLight.CalcShadowImportance(camera.getCameraPosition(), fieldOfView));
+	}
+
+	shadowAtlas.Pack();
+}
+
+// Keeps the point lights whose sphere of influence touches the camera frustum. Only those are shaded and get a shadow pass.
+// Visible, shadow casting point lights get a cube map from the pool. The others give theirs back.
+void CullPointLights()
+{
+	omniShadowMapPool.BeginFrame();
+	visiblePointLightCount = 0;
+
+	for (size_t i = 0; i < pointLightCount; i++)
+	{
+		// The light can't light (or shadow) anything further than its radius.
+		bool visible = cameraFrustum.SphereVisible(pointLights[i].GetPosition(), pointLights[i].GetRadius());
+		if (visible && pointLights[i].GetCastsShadows())
+		{
+			omniShadowMapPool.Acquire(&pointLights[i]);
+		}
+		else
+		{
+			omniShadowMapPool.Release(&pointLights[i]);
+		}
+
+		if (visible)
+		{
+			visiblePointLights[visiblePointLightCount++] = pointLights[i]; // Copied after Acquire, so the copy has the cube map too.
+		}
+	}
+
+	omniShadowMapPool.PrintReport();
 }
 
 void DirectionalShadowMapPass(DirectionalLight* light)
 {
+	if (light->GetShadowMap()->GetShadowWidth() == 0)
+	{
+		return; // Got no tile in the shadow atlas this frame.
+	}
+
 	directionalShadowShader.UseShader();
 
 	// Makes sure the frame buffer we use is same size as the viewport. We set up the viewport to do so.
 	glViewport(0, 0, light->GetShadowMap()->GetShadowWidth(), light->GetShadowMap()->GetShadowHeight());
 
 	light->GetShadowMap()->Write(); // Setting the map to write mode.
-	glClear(GL_DEPTH_BUFFER_BIT); // Clear out the buffer.
+	glClearColor(1.0f, 1.0f, 1.0f, 1.0f); // Only used by variance shadow maps. Moments as far away as possible.
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // Clear out the buffer.
 
 	uniformModel = directionalShadowShader.GetModelLocation();
 	directionalShadowShader.SetDirectionalLightTransform(&light->CalculateLightTransform());
 
 	directionalShadowShader.Validate();
-	RenderScene();
+	RenderScene(true, true);
+
+	FilterShadowMap(light->GetShadowMap());
 
+	glDisable(GL_SCISSOR_TEST); // Turned on when writing in a tile of the shadow atlas.
 	glBindFramebuffer(GL_FRAMEBUFFER, 0); // Getting the default buffer
 }
 
 void OmniShadowMapPass(PointLight* light)
 {
+	if (!light->GetShadowMap())
+	{
+		return; // Not visible, or the pool had no map left for it.
+	}
+
 	omniShadowShader.UseShader();
 
 	// Makes sure the frame buffer we use is same size as the viewport. We set up the viewport to do so.
 	glViewport(0, 0, light->GetShadowMap()->GetShadowWidth(), light->GetShadowMap()->GetShadowHeight());
 
 	light->GetShadowMap()->Write(); // Setting the map to write mode.
-	glClear(GL_DEPTH_BUFFER_BIT); // Clear out the buffer.
+	glClearColor(1.0f, 1.0f, 1.0f, 1.0f); // Only used by variance shadow maps. Moments as far away as possible.
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // Clear out the buffer.
 
 	uniformModel = omniShadowShader.GetModelLocation();
 	uniformOmniLightPos = omniShadowShader.GetOmniLightPosLocation();
@@ -245,13 +527,83 @@ void OmniShadowMapPass(PointLight* light)
 	omniShadowShader.SetLightMatrices(light->CalculateLightTransform());
 
 	omniShadowShader.Validate();
-	RenderScene();
+	RenderScene(true, true);
+
+	FilterShadowMap(light->GetShadowMap());
 
 	glBindFramebuffer(GL_FRAMEBUFFER, 0); // Getting the default buffer
 }
 
+// Only fills the depth buffer. The lit pass after it then shades each pixel once, with GL_EQUAL.
+void DepthPrePass(glm::mat4 viewMatrix, glm::mat4 projectionMatrix)
+{
+	depthPrePassShader.UseShader();
+
+	uniformModel = depthPrePassShader.GetModelLocation();
+	glUniformMatrix4fv(depthPrePassShader.GetProjectionLocation(), 1, GL_FALSE, glm::value_ptr(projectionMatrix));
+	glUniformMatrix4fv(depthPrePassShader.GetViewLocation(), 1, GL_FALSE, glm::value_ptr(viewMatrix));
+
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE); // No colour yet.
+	RenderScene(true);
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+	// The depth buffer is final. Only the closest fragment of each pixel passes now.
+	glDepthFunc(GL_EQUAL);
+	glDepthMask(GL_FALSE);
+}
+
+// Where the count of the current render path goes in shadedFragments.
+int ShadedFragmentsSlot()
+{
+	if (deferredShading)
+	{
+		return 2;
+	}
+	return depthPrePass ? 1 : 0;
+}
+
+// Prints how many fragments the lit pass shaded, with and without the depth pre-pass, once per second.
+// The query is read a frame late, when it is ready, so we never wait on the GPU.
+void ReportShadedFragments(GLfloat now)
+{
+	if (shadedFragmentsQueryPending)
+	{
+		GLuint available = 0;
+		glGetQueryObjectuiv(shadedFragmentsQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available)
+		{
+			glGetQueryObjectuiv(shadedFragmentsQuery, GL_QUERY_RESULT, &shadedFragments[ShadedFragmentsSlot()]);
+			shadedFragmentsQueryPending = false;
+		}
+	}
+
+	if (now - lastShadedFragmentsReport >= 1.0f)
+	{
+		lastShadedFragmentsReport = now;
+		GLfloat pixels = (GLfloat)(mainWindow.getBufferWidth() * mainWindow.getBufferHeight());
+		printf("Shaded fragments: %u without pre-pass (%.2f per pixel), %u with pre-pass (%.2f per pixel). Pre-pass is %s, P to toggle.\n",
+			shadedFragments[0], shadedFragments[0] / pixels, shadedFragments[1], shadedFragments[1] / pixels, depthPrePass ? "on" : "off");
+		// Forward fragments run every light, deferred ones a single light. So these are light/pixel pairs, not fragments.
+		printf("Deferred point light fragments: %u (%.2f per pixel). Deferred is %s, G to toggle.\n",
+			shadedFragments[2], shadedFragments[2] / pixels, deferredShading ? "on" : "off");
+	}
+}
+
 void RenderPass(glm::mat4 viewMatrix, glm::mat4 projectionMatrix)
 {
+	glViewport(0, 0, 1366, 768); // Would be cleaner if handled by the Window class, but still. Size matches size of window.
+
+	// Clear the window
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	SortSceneFrontToBack(camera.getCameraPosition());
+
+	if (depthPrePass)
+	{
+		DepthPrePass(viewMatrix, projectionMatrix);
+	}
+
 	// If we just did the shadow pass, we would have the wrong shader attached. SO we attach the right one.
 	shaderList[0].UseShader();
 
@@ -259,52 +611,196 @@ void RenderPass(glm::mat4 viewMatrix, glm::mat4 projectionMatrix)
 	uniformProjection = shaderList[0].GetProjectionLocation();
 	uniformView = shaderList[0].GetViewLocation();
 	uniformEyePosition = shaderList[0].GetEyePositionLocation();
-	uniformSpecularIntensity = shaderList[0].GetSpecularIntensityLocation();
-	uniformShininess = shaderList[0].GetShininessLocation();
-
-	glViewport(0, 0, 1366, 768); // Would be cleaner if handled by the Window class, but still. Size matches size of window.
-
-	// Clear the window
-	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 	glUniformMatrix4fv(uniformProjection, 1, GL_FALSE, glm::value_ptr(projectionMatrix));
 	glUniformMatrix4fv(uniformView, 1, GL_FALSE, glm::value_ptr(viewMatrix)); // Uses the camera to get our view matrix.
 	glUniform3f(uniformEyePosition, camera.getCameraPosition().x, camera.getCameraPosition().y, camera.getCameraPosition().z);
 
 	shaderList[0].SetDirectionalLight(&mainLight);
-	shaderList[0].SetPointLights(pointLights, pointLightCount, 3, 0);
+	shaderList[0].SetPointLights(visiblePointLights, visiblePointLightCount, 3, 0);
+	shaderList[0].SetClusterGrid(&clusterGrid, 3 + MAX_POINT_LIGHTS); // After the omni shadow maps.
 	shaderList[0].SetDirectionalLightTransform(&mainLight.CalculateLightTransform());
 
 	// GL_TEXTURE0 is already bound to our pyramid texture, so we have to use another one.
 	// So with this, theTexture in our Shader will be Texture0 and directionalShadowMap will be Texture1
 	mainLight.GetShadowMap()->Read(GL_TEXTURE2);
-	shaderList[0].SetTexture(1); // 1 is our pyramid texture unit
+	materialTextures.UseTexture(GL_TEXTURE1);
+	shaderList[0].SetTexture(1); // 1 is our material texture array unit
 	shaderList[0].SetDirectionalShadowMap(2); // 2 is our shadow map texture unit.
 
 	shaderList[0].Validate();
+
+	// Counting what passes the depth test, only when last frame's count was read.
+	bool countFragments = !shadedFragmentsQueryPending;
+	if (countFragments)
+	{
+		glBeginQuery(GL_SAMPLES_PASSED, shadedFragmentsQuery);
+	}
+	RenderScene();
+	if (countFragments)
+	{
+		glEndQuery(GL_SAMPLES_PASSED);
+		shadedFragmentsQueryPending = true;
+	}
+
+	// Back to normal, the shadow passes have to write depth.
+	glDepthFunc(GL_LESS);
+	glDepthMask(GL_TRUE);
+}
+
+// Deferred alternative to RenderPass. The scene is drawn once into the G-buffer, then each light is drawn over the pixels it reaches.
+// A pixel costs one G-buffer write plus one shading per light touching it, however many objects were drawn over it.
+void DeferredRenderPass(glm::mat4 viewMatrix, glm::mat4 projectionMatrix)
+{
+	glm::mat4 inverseViewProjection = glm::inverse(projectionMatrix * viewMatrix);
+	glm::vec3 eyePosition = camera.getCameraPosition();
+
+	// Geometry. Only the closest surface of each pixel is kept.
+	gBuffer.Write();
+	glViewport(0, 0, gBuffer.GetWidth(), gBuffer.GetHeight());
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	SortSceneFrontToBack(eyePosition);
+
+	gBufferShader.UseShader();
+	uniformModel = gBufferShader.GetModelLocation();
+	glUniformMatrix4fv(gBufferShader.GetProjectionLocation(), 1, GL_FALSE, glm::value_ptr(projectionMatrix));
+	glUniformMatrix4fv(gBufferShader.GetViewLocation(), 1, GL_FALSE, glm::value_ptr(viewMatrix));
+	materialTextures.UseTexture(GL_TEXTURE1);
+	gBufferShader.SetTexture(1);
+	gBufferShader.Validate();
 	RenderScene();
+
+	// The scene's depth goes in the window, to test the light volumes against.
+	gBuffer.BlitDepth();
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glDepthMask(GL_FALSE);
+
+	// Ambient and directional light, once per pixel. Texture units 2 to 8 are the shadow maps and cluster buffers, so the G-buffer goes after.
+	glDisable(GL_DEPTH_TEST);
+	deferredDirectionalShader.UseShader();
+	deferredDirectionalShader.SetGBuffer(&gBuffer, 9);
+	deferredDirectionalShader.SetInverseViewProjection(&inverseViewProjection);
+	glUniform3f(deferredDirectionalShader.GetEyePositionLocation(), eyePosition.x, eyePosition.y, eyePosition.z);
+	deferredDirectionalShader.SetDirectionalLight(&mainLight);
+	deferredDirectionalShader.SetDirectionalLightTransform(&mainLight.CalculateLightTransform());
+	mainLight.GetShadowMap()->Read(GL_TEXTURE2);
+	deferredDirectionalShader.SetDirectionalShadowMap(2);
+	deferredDirectionalShader.Validate();
+	glBindVertexArray(fullscreenVAO);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+
+	// Point lights, added on top. Drawing the back of each sphere where the scene is in front of it,
+	// which still works when the camera is inside the sphere.
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE);
+	glEnable(GL_DEPTH_TEST);
+	glDepthFunc(GL_GEQUAL);
+	glEnable(GL_CULL_FACE);
+	glCullFace(GL_FRONT);
+
+	deferredPointShader.UseShader();
+	glUniformMatrix4fv(deferredPointShader.GetProjectionLocation(), 1, GL_FALSE, glm::value_ptr(projectionMatrix));
+	glUniformMatrix4fv(deferredPointShader.GetViewLocation(), 1, GL_FALSE, glm::value_ptr(viewMatrix));
+	glUniform3f(deferredPointShader.GetEyePositionLocation(), eyePosition.x, eyePosition.y, eyePosition.z);
+	deferredPointShader.SetGBuffer(&gBuffer, 9);
+	deferredPointShader.SetInverseViewProjection(&inverseViewProjection);
+	deferredPointShader.SetClusterGrid(&clusterGrid, 3 + MAX_POINT_LIGHTS);
+
+	bool countFragments = !shadedFragmentsQueryPending;
+	if (countFragments)
+	{
+		glBeginQuery(GL_SAMPLES_PASSED, shadedFragmentsQuery);
+	}
+
+	// The shadowed lights, one at a time, each with its cube map on unit 3.
+	deferredPointShader.SetUseClusterLights(false);
+	for (size_t i = 0; i < visiblePointLightCount; i++)
+	{
+		deferredPointShader.SetPointLights(&visiblePointLights[i], 1, 3, 0);
+		deferredPointShader.SetLightSphere(visiblePointLights[i].GetPosition(), visiblePointLights[i].GetRadius());
+		deferredPointShader.Validate();
+		lightVolume->RenderMesh();
+	}
+
+	// All the small lights in one draw, one instance each.
+	deferredPointShader.SetUseClusterLights(true);
+	lightVolume->RenderMeshInstanced(clusterGrid.GetLightCount());
+
+	if (countFragments)
+	{
+		glEndQuery(GL_SAMPLES_PASSED);
+		shadedFragmentsQueryPending = true;
+	}
+
+	// Back to normal.
+	glDisable(GL_CULL_FACE);
+	glCullFace(GL_BACK);
+	glDisable(GL_BLEND);
+	glDepthFunc(GL_LESS);
+	glDepthMask(GL_TRUE);
 }
 
-int main() 
+int main(int argc, char** argv)
 {
+	// e.g. --benchmark-clusters. Runs without opening the window.
+	if (Benchmarks::Run(argc, argv))
+	{
+		return 0;
+	}
+
+	// e.g. --cook-textures bc1 512 Textures/brick.png. Also without a window.
+	if (TextureCooker::Run(argc, argv))
+	{
+		return 0;
+	}
+
+	// e.g. --import-mesh Models/teapot.obj Models/teapot.mesh, or --check-import. Also without a window.
+	if (MeshImporter::Run(argc, argv))
+	{
+		return 0;
+	}
+
+	// Remakes Models/pyramid.mesh and Models/floor.mesh. Also without a window.
+	if (WriteSceneMeshes(argc, argv))
+	{
+		return 0;
+	}
+
 	mainWindow = Window(1366, 768); // Standard widescreen.
 	mainWindow.Initialise();
 
-	CreateObjects();
+	if (!CreateObjects())
+	{
+		return 1;
+	}
+	CreateLightVolume();
 	CreateShaders();
+	gBuffer.Init(mainWindow.getBufferWidth(), mainWindow.getBufferHeight());
+	glGenVertexArrays(1, &fullscreenVAO);
 
 	camera = Camera(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), -60.0f, 0.0f, 5.0f, 0.5f);
 
-	// Creating textures
-	brickTexture = Texture("Textures/brick.png");
-	brickTexture.LoadTexture();
+	// Creating Materials
 
-	dirtTexture = Texture("Textures/dirt.png");
-	dirtTexture.LoadTexture();
+	// A shine is usually a form of 2, a power of 2. 32 is common for the average shiny object.
+	shinyMaterial = Material(4.0f, 256);
+	dullMaterial = Material(0.3f, 4);
+
+	// The objects ask the texture cache for their textures, so that has to happen before the texture array is allocated.
+	materialTable.Init();
+	CreateSceneObjects();
+	textureCache.PrintReport();
 
-	plainTexture = Texture("Textures/plain.png");
-	plainTexture.LoadTexture();
+	// Creating textures. All in one array, each on its own layer.
+	materialTextures.Allocate(TEXTURE_STREAMING_FIRST_LEVEL); // Small to start with. Everything shows the white placeholder until its image is loaded.
+	textureLoader.Init();
+	textureLoader.LoadArray(&materialTextures);
+	textureStreamer.Init(TEXTURE_MEMORY_BUDGET, &textureLoader);
+	textureStreamer.AddArray(&materialTextures);
 
 	// Creating lights
 	mainLight = DirectionalLight(2048, 2048,
@@ -312,7 +808,19 @@ int main()
 								 0.0f, 0.0f,
 								 0.0f, -15.0f, -10.0f);
 	// Initializing shadow map
-	mainLight.InitShadowMap();
+	// The atlas only holds depth, so variance shadow maps keep their own textures.
+	// It grows with the maps added to it, up to 4096. Only the 2048 directional map for now.
+	shadowAtlas.Init(4096, 256);
+	ShadowMap::PrintQualityReport(2048, 1024, mainWindow.getBufferWidth(), mainWindow.getBufferHeight());
+	if (SHADOW_FILTER_MODE == SHADOW_FILTER_PCF)
+	{
+		mainLight.InitShadowMap(&shadowAtlas);
+	}
+	else
+	{
+		mainLight.InitShadowMap();
+	}
+	printf("Shadow atlas: %u, %.1f MB\n", shadowAtlas.GetAtlasSize(), shadowAtlas.GetMemoryUsage() / (1024.0 * 1024.0));
 
 	
 	pointLights[0] = PointLight(1024, 1024,
@@ -321,7 +829,6 @@ int main()
 								0.0f, 1.0f,
 								0.0f, 0.0f, 0.0f,
 								0.3f, 0.2f, 0.1f);
-	//pointLights[0].InitShadowMap();
 	pointLightCount++;
 
 	pointLights[1] = PointLight(1024, 1024,
@@ -330,19 +837,20 @@ int main()
 								0.0f, 1.0f,
 								-4.0f, 2.0f, 0.0f,
 								0.3f, 0.1f, 0.1f);
-	//pointLights[1].InitShadowMap();
 	pointLightCount++;
 
 	GLuint uniformProjection = 0, uniformModel = 0, uniformView = 0, uniformEyePosition = 0,
 		uniformSpecularIntensity = 0, uniformShininess = 0;
 
-	// Creating Materials
+	materialTable.Upload(&materialTextures);
+	glGenQueries(1, &shadedFragmentsQuery);
 
-	// A shine is usually a form of 2, a power of 2. 32 is common for the average shiny object.
-	shinyMaterial = Material(4.0f, 256);
-	dullMaterial = Material(0.3f, 4);
+	glm::mat4 projection = glm::perspective(fieldOfView, (GLfloat)mainWindow.getBufferWidth() / mainWindow.getBufferHeight(), nearPlane, farPlane);
 
-	glm::mat4 projection = glm::perspective(glm::radians(45.0f), (GLfloat)mainWindow.getBufferWidth() / mainWindow.getBufferHeight(), 0.1f, 100.0f);
+	CreateClusteredLights(256);
+	threadPool.Init();
+	clusterGrid.Init(fieldOfView, (GLfloat)mainWindow.getBufferWidth() / mainWindow.getBufferHeight(), nearPlane, farPlane,
+		mainWindow.getBufferWidth(), mainWindow.getBufferHeight(), &threadPool); // Same as the projection.
 
 	lastTime = glfwGetTime(); // Initializing the time.
 
@@ -360,13 +868,77 @@ int main()
 		camera.keyControl(mainWindow.getKeys(), deltaTime);
 		// Handle camera control with mouse
 		camera.mouseControl(mainWindow.getXChange(), mainWindow.getYChange());
+
+		// Toggling the depth pre-pass, once per key press. The pending count belongs to the old mode, so it is read first.
+		bool prePassKey = mainWindow.getKeys()[GLFW_KEY_P];
+		if (prePassKey && !depthPrePassKeyHeld)
+		{
+			if (shadedFragmentsQueryPending)
+			{
+				glGetQueryObjectuiv(shadedFragmentsQuery, GL_QUERY_RESULT, &shadedFragments[ShadedFragmentsSlot()]);
+				shadedFragmentsQueryPending = false;
+			}
+			depthPrePass = !depthPrePass;
+		}
+		depthPrePassKeyHeld = prePassKey;
+
+		// Same for the deferred path.
+		bool deferredKey = mainWindow.getKeys()[GLFW_KEY_G];
+		if (deferredKey && !deferredShadingKeyHeld)
+		{
+			if (shadedFragmentsQueryPending)
+			{
+				glGetQueryObjectuiv(shadedFragmentsQuery, GL_QUERY_RESULT, &shadedFragments[ShadedFragmentsSlot()]);
+				shadedFragmentsQueryPending = false;
+			}
+			deferredShading = !deferredShading;
+		}
+		deferredShadingKeyHeld = deferredKey;
 		
+		// Texture layers that finished loading replace the placeholder.
+		if (textureLoader.Update())
+		{
+			materialTable.Upload(&materialTextures);
+			if (textureLoader.IsIdle())
+			{
+				textureLoader.PrintReport();
+			}
+		}
+
+		cameraFrustum.Update(projection * camera.calculateViewMatrix());
+
+		// Fewer triangles and coarser texture levels for what is far away.
+		SelectLods();
+		RequestTextureLevels();
+		if (textureStreamer.Update())
+		{
+			materialTable.Upload(&materialTextures);
+		}
+		bool textureReportKey = mainWindow.getKeys()[GLFW_KEY_T];
+		if (textureReportKey && !textureReportKeyHeld)
+		{
+			textureStreamer.PrintReport();
+		}
+		textureReportKeyHeld = textureReportKey;
+
+		PackShadowAtlas();
+		CullPointLights();
 		DirectionalShadowMapPass(&mainLight); // Doing a directional shadow map pass for this light.
-		for (size_t i = 0; i < pointLightCount; i++)
+		for (size_t i = 0; i < visiblePointLightCount; i++)
 		{
-			OmniShadowMapPass(&pointLights[i]);
+			OmniShadowMapPass(&visiblePointLights[i]);
 		}	
-		RenderPass(camera.calculateViewMatrix(), projection);
+		clusteredLights.Integrate(deltaTime, clusteredLightsMin, clusteredLightsMax);
+		clusterGrid.Update(&clusteredLights, camera.calculateViewMatrix());
+		if (deferredShading)
+		{
+			DeferredRenderPass(camera.calculateViewMatrix(), projection);
+		}
+		else
+		{
+			RenderPass(camera.calculateViewMatrix(), projection);
+		}
+		ReportShadedFragments(now);
 
 		glUseProgram(0);
 